@@ -62,11 +62,13 @@ TextLine TextBlock::line(int line) const
 
 void TextBlock::appendLine(const QString &textOfLine)
 {
+    invalidateCaches();
     m_lines.push_back(TextLine::create(textOfLine));
 }
 
 void TextBlock::clearLines()
 {
+    invalidateCaches();
     m_lines.clear();
 }
 
@@ -83,8 +85,38 @@ void TextBlock::text(QString &text) const
     }
 }
 
+const QVector<QString> &TextBlock::lineTexts() const
+{
+    if (!m_lineTextsValid) {
+        // only references to the line texts, edits copy them on write
+        m_lineTexts.reserve(m_lines.size());
+        for (const TextLine &textLine : m_lines) {
+            m_lineTexts.append(textLine->text());
+        }
+        m_lineTextsValid = true;
+    }
+
+    return m_lineTexts;
+}
+
+TextBracketBalance TextBlock::bracketBalance(quint32 bracketClass) const
+{
+    if (!m_bracketBalancesValid) {
+        for (const TextLine &textLine : m_lines) {
+            for (const TextBracket &bracket : textLine->brackets()) {
+                m_bracketBalances[bracket.bracketClass()].append(bracket.opening);
+            }
+        }
+        m_bracketBalancesValid = true;
+    }
+
+    return m_bracketBalances.value(bracketClass);
+}
+
 void TextBlock::wrapLine(const KTextEditor::Cursor &position, int fixStartLinesStartIndex)
 {
+    invalidateCaches();
+
     // calc internal line
     int line = position.line() - startLine();
 
@@ -193,6 +225,11 @@ void TextBlock::wrapLine(const KTextEditor::Cursor &position, int fixStartLinesS
 
 void TextBlock::unwrapLine(int line, TextBlock *previousBlock, int fixStartLinesStartIndex)
 {
+    invalidateCaches();
+    if (previousBlock) {
+        previousBlock->invalidateCaches();
+    }
+
     // calc internal line
     line = line - startLine();
 
@@ -370,6 +407,8 @@ void TextBlock::unwrapLine(int line, TextBlock *previousBlock, int fixStartLines
 
 void TextBlock::insertText(const KTextEditor::Cursor &position, const QString &text)
 {
+    invalidateCaches();
+
     // calc internal line
     int line = position.line() - startLine();
 
@@ -443,6 +482,8 @@ void TextBlock::insertText(const KTextEditor::Cursor &position, const QString &t
 
 void TextBlock::removeText(const KTextEditor::Range &range, QString &removedText)
 {
+    invalidateCaches();
+
     // calc internal line
     int line = range.start().line() - startLine();
 
@@ -523,6 +564,8 @@ void TextBlock::debugPrint(int blockIndex) const
 
 TextBlock *TextBlock::splitBlock(int fromLine)
 {
+    invalidateCaches();
+
     // half the block
     int linesOfNewBlock = lines() - fromLine;
 
@@ -566,6 +609,9 @@ TextBlock *TextBlock::splitBlock(int fromLine)
 
 void TextBlock::mergeBlock(TextBlock *targetBlock)
 {
+    invalidateCaches();
+    targetBlock->invalidateCaches();
+
     // move cursors, do this first, now still lines() count is correct for target
     for (TextCursor *cursor : m_cursors) {
         cursor->m_line = cursor->lineInBlock() + targetBlock->lines();
@@ -611,6 +657,7 @@ void TextBlock::deleteBlockContent()
     }
 
     // kill lines
+    invalidateCaches();
     m_lines.clear();
 }
 
@@ -635,6 +682,7 @@ void TextBlock::clearBlockContent(TextBlock *targetBlock)
     }
 
     // kill lines
+    invalidateCaches();
     m_lines.clear();
 }
 
@@ -23,6 +23,7 @@
 
 #include <unordered_set>
 
+#include <QHash>
 #include <QSet>
 #include <QVector>
 
@@ -104,6 +105,32 @@ public:
      */
     void text(QString &text) const;
 
+    /**
+     * Texts of all lines of this block, to be shared by TextSnapshot instances.
+     * Built on first use after a change of this block.
+     * @return line texts
+     */
+    const QVector<QString> &lineTexts() const;
+
+    /**
+     * The brackets of the given class in this block that find no partner inside it.
+     * Built for all classes on first use after a change of this block.
+     * @param bracketClass class of the brackets, see TextBracket::bracketClass()
+     * @return balance of the brackets
+     */
+    TextBracketBalance bracketBalance(quint32 bracketClass) const;
+
+    /**
+     * Drop the bracket balances, must be done after the attributes of the lines changed.
+     */
+    void invalidateBracketBalances()
+    {
+        if (m_bracketBalancesValid) {
+            m_bracketBalances.clear();
+            m_bracketBalancesValid = false;
+        }
+    }
+
     /**
      * Wrap line at given cursor position.
      * @param position line/column as cursor where to wrap
@@ -239,12 +266,38 @@ public:
         }
     }
 
+private:
+    /**
+     * Drop the shared line texts and the bracket balances, must be done before the lines are changed.
+     * Without snapshots left, the lines are the only owners of their texts again and change them in place.
+     */
+    void invalidateCaches()
+    {
+        if (m_lineTextsValid) {
+            m_lineTexts = QVector<QString>();
+            m_lineTextsValid = false;
+        }
+        invalidateBracketBalances();
+    }
+
 private:
     /**
      * parent text buffer
      */
     TextBuffer *m_buffer;
 
+    /**
+     * texts of all lines for snapshots, see lineTexts()
+     */
+    mutable QVector<QString> m_lineTexts;
+    mutable bool m_lineTextsValid = false;
+
+    /**
+     * unmatched brackets per bracket class, see bracketBalance()
+     */
+    mutable QHash<quint32, TextBracketBalance> m_bracketBalances;
+    mutable bool m_bracketBalancesValid = false;
+
     /**
      * Lines contained in this buffer. These are shared pointers.
      * We need no sharing, use STL.
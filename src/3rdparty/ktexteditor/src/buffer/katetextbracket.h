@@ -0,0 +1,171 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_TEXTBRACKET_H
+#define KATE_TEXTBRACKET_H
+
+#include <QChar>
+#include <QtGlobal>
+
+namespace Kate
+{
+/**
+ * One bracket of a text line, see TextLineData::brackets().
+ *
+ * Brackets only pair up with brackets of the same class, that is of the same
+ * kind and with the same highlighting attribute. A parenthesis inside a string
+ * never closes one in the code around it.
+ */
+class TextBracket
+{
+public:
+    /**
+     * Kinds of brackets.
+     */
+    enum Kind { Round = 0, Square = 1, Curly = 2 };
+
+    /**
+     * Kind of the given character.
+     * @param c character to check
+     * @return kind of the bracket, -1 if @p c is no bracket
+     */
+    static int kind(QChar c)
+    {
+        switch (c.unicode()) {
+        case '(':
+        case ')':
+            return Round;
+        case '[':
+        case ']':
+            return Square;
+        case '{':
+        case '}':
+            return Curly;
+        }
+        return -1;
+    }
+
+    /**
+     * Is the given character an opening bracket?
+     */
+    static bool isOpening(QChar c)
+    {
+        return c == QLatin1Char('(') || c == QLatin1Char('[') || c == QLatin1Char('{');
+    }
+
+    /**
+     * Class of the brackets of the given kind and attribute.
+     */
+    static quint32 bracketClass(int kind, short attribute)
+    {
+        return (quint32(quint16(attribute)) << 2) | quint32(kind);
+    }
+
+    TextBracket() = default;
+
+    TextBracket(int _offset, short _attribute, int _kind, bool _opening)
+        : offset(_offset)
+        , attribute(_attribute)
+        , kind(quint8(_kind))
+        , opening(_opening)
+    {
+    }
+
+    /**
+     * Class of this bracket.
+     */
+    quint32 bracketClass() const
+    {
+        return bracketClass(kind, attribute);
+    }
+
+    /**
+     * column of the bracket
+     */
+    int offset = 0;
+
+    /**
+     * highlighting attribute of the bracket
+     */
+    short attribute = 0;
+
+    /**
+     * kind of the bracket
+     */
+    quint8 kind = Round;
+
+    /**
+     * opening or closing bracket?
+     */
+    bool opening = false;
+};
+
+/**
+ * The brackets of one class in a range of text that find no partner inside it.
+ * The unmatched closing brackets all come in front of the unmatched opening ones.
+ *
+ * Balances of consecutive ranges combine with append(), this is associative,
+ * which lets TextBuffer keep them in segment trees over its blocks.
+ */
+class TextBracketBalance
+{
+public:
+    /**
+     * Append one more bracket at the end of the range.
+     * @param openingBracket opening or closing bracket?
+     */
+    void append(bool openingBracket)
+    {
+        if (openingBracket) {
+            ++opening;
+        } else if (opening > 0) {
+            --opening;
+        } else {
+            ++closing;
+        }
+    }
+
+    /**
+     * Append the balance of the range directly behind this one.
+     * Its closing brackets match our opening ones first.
+     */
+    void append(const TextBracketBalance &other)
+    {
+        const int matched = qMin(opening, other.closing);
+        closing += other.closing - matched;
+        opening += other.opening - matched;
+    }
+
+    /**
+     * closing brackets without opening one in front of them
+     */
+    int closing = 0;
+
+    /**
+     * opening brackets without closing one behind them
+     */
+    int opening = 0;
+};
+}
+
+Q_DECLARE_TYPEINFO(Kate::TextBracket, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(Kate::TextBracketBalance, Q_PRIMITIVE_TYPE);
+
+#endif
@@ -45,6 +45,8 @@
 #include <QFileInfo>
 #include <QTemporaryFile>
 
+#include <limits>
+
 #if 0
 #define BUFFER_DEBUG qCDebug(LOG_KTE)
 #else
@@ -144,6 +146,7 @@ void TextBuffer::clear()
 
     // insert one block with one empty line
     m_blocks.append(newBlock);
+    invalidateBracketTrees();
 
     // reset lines and last used block
     m_lines = 1;
@@ -187,6 +190,178 @@ QString TextBuffer::text() const
     return text;
 }
 
+TextSnapshot TextBuffer::snapshot() const
+{
+    TextSnapshot snapshot;
+    snapshot.m_revision = m_revision;
+    snapshot.m_lines = m_lines;
+
+    // share the line texts of all blocks
+    snapshot.m_blocks.reserve(m_blocks.size());
+    snapshot.m_blockStartLines.reserve(m_blocks.size());
+    for (TextBlock *block : qAsConst(m_blocks)) {
+        snapshot.m_blocks.append(block->lineTexts());
+        snapshot.m_blockStartLines.append(block->startLine());
+    }
+
+    return snapshot;
+}
+
+namespace
+{
+/**
+ * Find the first block in [begin, end) below @p node that holds the partner of the bracket searched.
+ * Blocks are visited in search direction, @p depth counts the brackets in between still waiting for
+ * their partner, it is updated for all blocks skipped.
+ * @return index of the found block, -1 if none
+ */
+int findBracketBlock(const QVector<TextBracketBalance> &tree, int node, int nodeBegin, int nodeEnd, int begin, int end, bool forward, int &depth)
+{
+    if (nodeEnd <= begin || end <= nodeBegin) {
+        return -1;
+    }
+
+    if (begin <= nodeBegin && nodeEnd <= end) {
+        // searching forward, the partner is one of the closing brackets, backward one of the opening ones
+        const TextBracketBalance &balance = tree.at(node);
+        const int partners = forward ? balance.closing : balance.opening;
+        if (partners <= depth) {
+            depth += (forward ? balance.opening : balance.closing) - partners;
+            return -1;
+        }
+
+        if (nodeEnd - nodeBegin == 1) {
+            return nodeBegin;
+        }
+    }
+
+    const int middle = (nodeBegin + nodeEnd) / 2;
+    if (forward) {
+        const int found = findBracketBlock(tree, 2 * node, nodeBegin, middle, begin, end, forward, depth);
+        return (found >= 0) ? found : findBracketBlock(tree, 2 * node + 1, middle, nodeEnd, begin, end, forward, depth);
+    }
+
+    const int found = findBracketBlock(tree, 2 * node + 1, middle, nodeEnd, begin, end, forward, depth);
+    return (found >= 0) ? found : findBracketBlock(tree, 2 * node, nodeBegin, middle, begin, end, forward, depth);
+}
+}
+
+KTextEditor::Cursor TextBuffer::findUnmatchedBracket(const KTextEditor::Cursor &position, QChar bracket, short attribute, int limitLine) const
+{
+    const int kind = TextBracket::kind(bracket);
+    if (kind < 0 || position.line() < 0 || position.line() >= lines()) {
+        return KTextEditor::Cursor::invalid();
+    }
+
+    const quint32 bracketClass = TextBracket::bracketClass(kind, attribute);
+    const bool forward = !TextBracket::isOpening(bracket);
+    limitLine = forward ? qMin(limitLine, lines() - 1) : qMax(limitLine, 0);
+    if (forward ? limitLine < position.line() : limitLine > position.line()) {
+        return KTextEditor::Cursor::invalid();
+    }
+
+    // brackets of the class passed so far, still waiting for their partner
+    int depth = 0;
+
+    // scan the lines of one block from the given position on, up to the limit
+    auto searchBlock = [&](int index, int line, int column) {
+        const TextBlock *block = m_blocks.at(index);
+        const int firstLine = forward ? line : qMax(block->startLine(), limitLine);
+        const int lastLine = forward ? qMin(block->startLine() + block->lines() - 1, limitLine) : line;
+        for (; firstLine <= line && line <= lastLine; line += forward ? 1 : -1) {
+            const QVector<TextBracket> &brackets = block->line(line)->brackets();
+            for (int i = 0; i < brackets.size(); ++i) {
+                const TextBracket &candidate = brackets.at(forward ? i : brackets.size() - 1 - i);
+                if ((forward ? candidate.offset < column : candidate.offset >= column) || candidate.bracketClass() != bracketClass) {
+                    continue;
+                }
+
+                if (candidate.opening != forward) {
+                    if (depth == 0) {
+                        return KTextEditor::Cursor(line, candidate.offset);
+                    }
+                    --depth;
+                } else {
+                    ++depth;
+                }
+            }
+            column = forward ? 0 : std::numeric_limits<int>::max();
+        }
+        return KTextEditor::Cursor::invalid();
+    };
+
+    int index = blockForLine(position.line());
+    const KTextEditor::Cursor found = searchBlock(index, position.line(), position.column());
+    const int limitIndex = blockForLine(limitLine);
+    if (found.isValid() || (forward ? limitIndex <= index : limitIndex >= index)) {
+        return found;
+    }
+
+    // skip the whole blocks in between with the tree, the one holding the partner or the limit is scanned
+    const QVector<TextBracketBalance> &tree = bracketTree(bracketClass);
+    index = findBracketBlock(tree, 1, 0, tree.size() / 2, forward ? index + 1 : limitIndex + 1, forward ? limitIndex : index, forward, depth);
+    if (index < 0) {
+        index = limitIndex;
+    }
+
+    const TextBlock *block = m_blocks.at(index);
+    return forward ? searchBlock(index, block->startLine(), 0) : searchBlock(index, block->startLine() + block->lines() - 1, std::numeric_limits<int>::max());
+}
+
+void TextBuffer::invalidateBracketBalances(int startLine, int endLine)
+{
+    startLine = qMax(startLine, 0);
+    endLine = qMin(endLine, lines() - 1);
+    if (startLine > endLine) {
+        return;
+    }
+
+    for (int index = blockForLine(startLine); index < m_blocks.size() && m_blocks.at(index)->startLine() <= endLine; ++index) {
+        m_blocks.at(index)->invalidateBracketBalances();
+        bracketsChanged(index);
+    }
+}
+
+const QVector<TextBracketBalance> &TextBuffer::bracketTree(quint32 bracketClass) const
+{
+    // update the leaves of the changed blocks and their ancestors in all trees
+    if (!m_bracketChangedBlocks.isEmpty()) {
+        for (auto it = m_bracketTrees.begin(); it != m_bracketTrees.end(); ++it) {
+            QVector<TextBracketBalance> &tree = it.value();
+            const int leaves = tree.size() / 2;
+            for (int index : qAsConst(m_bracketChangedBlocks)) {
+                int node = leaves + index;
+                tree[node] = m_blocks.at(index)->bracketBalance(it.key());
+                for (node /= 2; node > 0; node /= 2) {
+                    tree[node] = tree.at(2 * node);
+                    tree[node].append(tree.at(2 * node + 1));
+                }
+            }
+        }
+        m_bracketChangedBlocks.clear();
+    }
+
+    auto it = m_bracketTrees.find(bracketClass);
+    if (it == m_bracketTrees.end()) {
+        int leaves = 1;
+        while (leaves < m_blocks.size()) {
+            leaves *= 2;
+        }
+
+        QVector<TextBracketBalance> tree(2 * leaves);
+        for (int index = 0; index < m_blocks.size(); ++index) {
+            tree[leaves + index] = m_blocks.at(index)->bracketBalance(bracketClass);
+        }
+        for (int node = leaves - 1; node > 0; --node) {
+            tree[node] = tree.at(2 * node);
+            tree[node].append(tree.at(2 * node + 1));
+        }
+        it = m_bracketTrees.insert(bracketClass, tree);
+    }
+
+    return it.value();
+}
+
 bool TextBuffer::startEditing()
 {
     // increment transaction counter
@@ -274,6 +449,9 @@ void TextBuffer::wrapLine(const KTextEditor::Cursor &position)
         m_editingMaximalLineChanged = position.line() + 1;
     }
 
+    // the bracket trees need the new balance of the block
+    bracketsChanged(blockIndex);
+
     // balance the changed block if needed
     balanceBlock(blockIndex);
 
@@ -309,9 +487,13 @@ void TextBuffer::unwrapLine(int line)
     m_blocks.at(blockIndex)->unwrapLine(line, (blockIndex > 0) ? m_blocks.at(blockIndex - 1) : nullptr, firstLineInBlock ? (blockIndex - 1) : blockIndex);
     --m_lines;
 
+    // the bracket trees need the new balance of the block, and of the one in front, if it got our first line
+    bracketsChanged(blockIndex);
+
     // decrement index for later fixup, if we modified the block in front of the found one
     if (firstLineInBlock) {
         --blockIndex;
+        bracketsChanged(blockIndex);
     }
 
     // remember changes
@@ -355,6 +537,7 @@ void TextBuffer::insertText(const KTextEditor::Cursor &position, const QString &
 
     // let the block handle the insertText
     m_blocks.at(blockIndex)->insertText(position, text);
+    bracketsChanged(blockIndex);
 
     // remember changes
     ++m_revision;
@@ -400,6 +583,7 @@ void TextBuffer::removeText(const KTextEditor::Range &range)
     // let the block handle the removeText, retrieve removed text
     QString text;
     m_blocks.at(blockIndex)->removeText(range, text);
+    bracketsChanged(blockIndex);
 
     // remember changes
     ++m_revision;
@@ -520,6 +704,7 @@ void TextBuffer::balanceBlock(int index)
         TextBlock *newBlock = blockToBalance->splitBlock(halfSize);
         Q_ASSERT(newBlock);
         m_blocks.insert(m_blocks.begin() + index + 1, newBlock);
+        invalidateBracketTrees();
 
         // split is done
         return;
@@ -547,6 +732,7 @@ void TextBuffer::balanceBlock(int index)
     // delete old block
     delete blockToBalance;
     m_blocks.erase(m_blocks.begin() + index);
+    invalidateBracketTrees();
 }
 
 void TextBuffer::debugPrint(const QString &title) const
@@ -560,7 +746,54 @@ void TextBuffer::debugPrint(const QString &title) const
     }
 }
 
+struct TextBuffer::PendingLoad {
+    PendingLoad(const QString &filename, KEncodingProber::ProberType proberType, bool enforceTextCodec)
+        : filename(filename)
+        , file(filename, proberType)
+        , rounds(enforceTextCodec ? 1 : 4)
+    {
+    }
+
+    /**
+     * file we load and its loader
+     */
+    const QString filename;
+    TextLoader file;
+
+    /**
+     * triple play, maximal three loading rounds
+     * 0) use the given encoding, be done, if no encoding errors happen
+     * 1) use BOM to decided if Unicode or if that fails, use encoding prober, if no encoding errors happen, be done
+     * 2) use fallback encoding, be done, if no encoding errors happen
+     * 3) use again given encoding, be done in any case
+     * with enforced codec, only round 0 is done
+     */
+    const int rounds;
+    int round = -1;
+
+    /**
+     * results of the load, reported by continueLoad()
+     */
+    bool encodingErrors = false;
+    bool tooLongLinesWrapped = false;
+    int longestLineLoaded = 0;
+};
+
 bool TextBuffer::load(const QString &filename, bool &encodingErrors, bool &tooLongLinesWrapped, int &longestLineLoaded, bool enforceTextCodec)
+{
+    beginLoad(filename, enforceTextCodec);
+
+    // read the complete file in one go
+    LoadStatus status = LoadRunning;
+    while (status == LoadRunning) {
+        status = continueLoad(std::numeric_limits<int>::max(), encodingErrors, tooLongLinesWrapped, longestLineLoaded);
+    }
+
+    // file loading worked, modulo encoding problems
+    return status == LoadFinished;
+}
+
+void TextBuffer::beginLoad(const QString &filename, bool enforceTextCodec)
 {
     // fallback codec must exist
     Q_ASSERT(m_fallbackTextCodec);
@@ -571,143 +804,189 @@ bool TextBuffer::load(const QString &filename, bool &encodingErrors, bool &tooLo
     /**
      * first: clear buffer in any case!
      */
+    m_pendingLoad.reset();
     clear();
 
     /**
      * construct the file loader for the given file, with correct prober type
      */
-    Kate::TextLoader file(filename, m_encodingProberType);
+    m_pendingLoad.reset(new PendingLoad(filename, m_encodingProberType, enforceTextCodec));
+}
+
+bool TextBuffer::startLoadRound()
+{
+    PendingLoad &load = *m_pendingLoad;
+    ++load.round;
 
     /**
-     * triple play, maximal three loading rounds
-     * 0) use the given encoding, be done, if no encoding errors happen
-     * 1) use BOM to decided if Unicode or if that fails, use encoding prober, if no encoding errors happen, be done
-     * 2) use fallback encoding, be done, if no encoding errors happen
-     * 3) use again given encoding, be done in any case
+     * the lines of the last round might be displayed already, clear properly to move all cursors away from them
      */
-    for (int i = 0; i < (enforceTextCodec ? 1 : 4); ++i) {
-        /**
-         * kill all blocks beside first one
-         */
-        for (int b = 1; b < m_blocks.size(); ++b) {
-            TextBlock *block = m_blocks.at(b);
-            block->clearLines();
-            delete block;
-        }
-        m_blocks.resize(1);
+    if (load.round > 0) {
+        // keep what the caller set up for this load, clear() resets it
+        const bool generateByteOrderMark = m_generateByteOrderMark;
+        const QString mimeTypeForFilterDev = m_mimeTypeForFilterDev;
+        clear();
+        m_generateByteOrderMark = generateByteOrderMark;
+        m_mimeTypeForFilterDev = mimeTypeForFilterDev;
+    }
 
-        /**
-         * remove lines in first block
-         */
-        m_blocks.last()->clearLines();
-        m_lines = 0;
+    /**
+     * remove lines in first block
+     */
+    m_blocks.last()->clearLines();
+    m_lines = 0;
 
-        /**
-         * try to open file, with given encoding
-         * in round 0 + 3 use the given encoding from user
-         * in round 1 use 0, to trigger detection
-         * in round 2 use fallback
-         */
-        QTextCodec *codec = m_textCodec;
-        if (i == 1) {
-            codec = nullptr;
-        } else if (i == 2) {
-            codec = m_fallbackTextCodec;
-        }
+    /**
+     * try to open file, with given encoding
+     * in round 0 + 3 use the given encoding from user
+     * in round 1 use 0, to trigger detection
+     * in round 2 use fallback
+     */
+    QTextCodec *codec = m_textCodec;
+    if (load.round == 1) {
+        codec = nullptr;
+    } else if (load.round == 2) {
+        codec = m_fallbackTextCodec;
+    }
 
-        if (!file.open(codec)) {
-            // create one dummy textline, in any case
-            m_blocks.last()->appendLine(QString());
-            m_lines++;
-            return false;
+    if (!load.file.open(codec)) {
+        // create one dummy textline, in any case
+        m_blocks.last()->appendLine(QString());
+        m_lines++;
+        return false;
+    }
+
+    load.encodingErrors = false;
+    return true;
+}
+
+TextBuffer::LoadStatus TextBuffer::continueLoad(int maximalLines, bool &encodingErrors, bool &tooLongLinesWrapped, int &longestLineLoaded)
+{
+    // not allowed during editing, the lines are appended without any history
+    Q_ASSERT(m_editingTransactions == 0);
+    Q_ASSERT(m_pendingLoad);
+
+    PendingLoad &load = *m_pendingLoad;
+    LoadStatus status = LoadRunning;
+    if (load.round < 0 && !startLoadRound()) {
+        status = LoadFailed;
+    }
+
+    // read in lines, never return with an empty buffer after a new round started
+    int linesRead = 0;
+    while (status == LoadRunning && (linesRead < maximalLines || m_lines == 0)) {
+        // file completely read, either without encoding errors or in the last round
+        if (load.file.eof()) {
+            if (!load.encodingErrors) {
+                // remember used codec, might change bom setting
+                setTextCodec(load.file.textCodec());
+            }
+            status = LoadFinished;
+            break;
         }
 
-        // read in all lines...
-        encodingErrors = false;
-        while (!file.eof()) {
-            // read line
-            int offset = 0, length = 0;
-            bool currentError = !file.readLine(offset, length);
-            encodingErrors = encodingErrors || currentError;
-
-            // bail out on encoding error, if not last round!
-            if (encodingErrors && i < (enforceTextCodec ? 0 : 3)) {
-                BUFFER_DEBUG << "Failed try to load file" << filename << "with codec" << (file.textCodec() ? file.textCodec()->name() : "(null)");
-                break;
+        // read line
+        int offset = 0, length = 0;
+        bool currentError = !load.file.readLine(offset, length);
+        load.encodingErrors = load.encodingErrors || currentError;
+
+        // bail out on encoding error, if not last round!
+        if (load.encodingErrors && load.round < load.rounds - 1) {
+            BUFFER_DEBUG << "Failed try to load file" << load.filename << "with codec" << (load.file.textCodec() ? load.file.textCodec()->name() : "(null)");
+            if (!startLoadRound()) {
+                status = LoadFailed;
             }
+            continue;
+        }
 
-            // get Unicode data for this line
-            const QChar *unicodeData = file.unicode() + offset;
+        // get Unicode data for this line
+        const QChar *unicodeData = load.file.unicode() + offset;
 
-            if (longestLineLoaded < length)
-                longestLineLoaded = length;
+        if (load.longestLineLoaded < length)
+            load.longestLineLoaded = length;
 
+        /**
+         * split lines, if too large
+         */
+        do {
             /**
-             * split lines, if too large
+             * calculate line length
              */
-            do {
+            int lineLength = length;
+            if ((m_lineLengthLimit > 0) && (lineLength > m_lineLengthLimit)) {
                 /**
-                 * calculate line length
+                 * search for place to wrap
                  */
-                int lineLength = length;
-                if ((m_lineLengthLimit > 0) && (lineLength > m_lineLengthLimit)) {
+                int spacePosition = m_lineLengthLimit - 1;
+                for (int testPosition = m_lineLengthLimit - 1; (testPosition >= 0) && (testPosition >= (m_lineLengthLimit - (m_lineLengthLimit / 10))); --testPosition) {
                     /**
-                     * search for place to wrap
+                     * wrap place found?
                      */
-                    int spacePosition = m_lineLengthLimit - 1;
-                    for (int testPosition = m_lineLengthLimit - 1; (testPosition >= 0) && (testPosition >= (m_lineLengthLimit - (m_lineLengthLimit / 10))); --testPosition) {
-                        /**
-                         * wrap place found?
-                         */
-                        if (unicodeData[testPosition].isSpace() || unicodeData[testPosition].isPunct()) {
-                            spacePosition = testPosition;
-                            break;
-                        }
+                    if (unicodeData[testPosition].isSpace() || unicodeData[testPosition].isPunct()) {
+                        spacePosition = testPosition;
+                        break;
                     }
-
-                    /**
-                     * wrap the line
-                     */
-                    lineLength = spacePosition + 1;
-                    length -= lineLength;
-                    tooLongLinesWrapped = true;
-                } else {
-                    /**
-                     * be done after this round
-                     */
-                    length = 0;
                 }
 
                 /**
-                 * construct new text line with content from file
-                 * move data pointer
+                 * wrap the line
                  */
-                QString textLine(unicodeData, lineLength);
-                unicodeData += lineLength;
-
+                lineLength = spacePosition + 1;
+                length -= lineLength;
+                load.tooLongLinesWrapped = true;
+            } else {
                 /**
-                 * ensure blocks aren't too large
+                 * be done after this round
                  */
-                if (m_blocks.last()->lines() >= m_blockSize) {
-                    m_blocks.append(new TextBlock(this, m_blocks.last()->startLine() + m_blocks.last()->lines()));
-                }
+                length = 0;
+            }
 
-                /**
-                 * append line to last block
-                 */
-                m_blocks.last()->appendLine(textLine);
-                ++m_lines;
-            } while (length > 0);
-        }
+            /**
+             * construct new text line with content from file
+             * move data pointer
+             */
+            QString textLine(unicodeData, lineLength);
+            unicodeData += lineLength;
 
-        // if no encoding error, break out of reading loop
-        if (!encodingErrors) {
-            // remember used codec, might change bom setting
-            setTextCodec(file.textCodec());
-            break;
-        }
+            /**
+             * ensure blocks aren't too large
+             */
+            if (m_blocks.last()->lines() >= m_blockSize) {
+                m_blocks.append(new TextBlock(this, m_blocks.last()->startLine() + m_blocks.last()->lines()));
+                invalidateBracketTrees();
+            }
+
+            /**
+             * append line to last block
+             */
+            m_blocks.last()->appendLine(textLine);
+            ++m_lines;
+            ++linesRead;
+        } while (length > 0);
+    }
+
+    // report the results so far
+    encodingErrors = load.encodingErrors;
+    tooLongLinesWrapped = tooLongLinesWrapped || load.tooLongLinesWrapped;
+    longestLineLoaded = qMax(longestLineLoaded, load.longestLineLoaded);
+
+    if (status == LoadRunning) {
+        emit loadProgress(qMin(load.file.bytesRead(), load.file.fileSize()), load.file.fileSize());
+    } else if (status == LoadFinished) {
+        finishLoad();
+    } else {
+        m_pendingLoad.reset();
     }
 
+    return status;
+}
+
+void TextBuffer::finishLoad()
+{
+    // the load is over before anybody gets notified about it
+    const std::unique_ptr<PendingLoad> load(std::move(m_pendingLoad));
+    TextLoader &file = load->file;
+
     // save checksum of file on disk
     setDigest(file.digest());
 
@@ -728,7 +1007,7 @@ bool TextBuffer::load(const QString &filename, bool &encodingErrors, bool &tooLo
     Q_ASSERT(m_lines > 0);
 
     // report CODEC + ERRORS
-    BUFFER_DEBUG << "Loaded file " << filename << "with codec" << m_textCodec->name() << (encodingErrors ? "with" : "without") << "encoding errors";
+    BUFFER_DEBUG << "Loaded file " << load->filename << "with codec" << m_textCodec->name() << (load->encodingErrors ? "with" : "without") << "encoding errors";
 
     // report BOM
     BUFFER_DEBUG << (file.byteOrderMarkFound() ? "Found" : "Didn't find") << "byte order mark";
@@ -737,10 +1016,15 @@ bool TextBuffer::load(const QString &filename, bool &encodingErrors, bool &tooLo
     BUFFER_DEBUG << "used filter device for mime-type" << m_mimeTypeForFilterDev;
 
     // emit success
-    emit loaded(filename, encodingErrors);
+    emit loaded(load->filename, load->encodingErrors);
+}
 
-    // file loading worked, modulo encoding problems
-    return true;
+void TextBuffer::cancelLoad()
+{
+    // the lines read so far stay, they were appended without any signals,
+    // whoever follows the content must start over like after clear()
+    m_pendingLoad.reset();
+    emit cleared();
 }
 
 const QByteArray &TextBuffer::digest() const
@@ -21,6 +21,7 @@
 #ifndef KATE_TEXTBUFFER_H
 #define KATE_TEXTBUFFER_H
 
+#include <QHash>
 #include <QObject>
 #include <QSet>
 #include <QString>
@@ -34,8 +35,11 @@
 #include "katetextcursor.h"
 #include "katetexthistory.h"
 #include "katetextrange.h"
+#include "katetextsnapshot.h"
 #include <ktexteditor_export.h>
 
+#include <memory>
+
 // encoding prober
 #include <KEncodingProber>
 
@@ -207,6 +211,63 @@ public:
      */
     virtual bool load(const QString &filename, bool &encodingErrors, bool &tooLongLinesWrapped, int &longestLineLoaded, bool enforceTextCodec);
 
+    /**
+     * Result of one step of an incremental load, see beginLoad() and continueLoad().
+     */
+    enum LoadStatus {
+        /**
+         * lines are left, call continueLoad() again
+         */
+        LoadRunning,
+
+        /**
+         * file completely read, loaded() got emitted
+         */
+        LoadFinished,
+
+        /**
+         * file could not be opened, buffer holds one empty line
+         */
+        LoadFailed
+    };
+
+    /**
+     * Start to load the given file incrementally. This will first clear the buffer,
+     * the lines are then read by continueLoad(). In between, the buffer holds the lines
+     * read so far and can be displayed, but must not be edited.
+     * Before calling this, setTextCodec must have been used to set codec!
+     * @param filename file to open
+     * @param enforceTextCodec enforce to use only the set text codec
+     */
+    void beginLoad(const QString &filename, bool enforceTextCodec);
+
+    /**
+     * Read further lines of the load started by beginLoad() and append them to the buffer.
+     * If encoding errors show up, the buffer is cleared again and reading restarts
+     * with the next codec, like load() does.
+     * @param maximalLines read at most this many lines of the file
+     * @param encodingErrors were there problems occurred while decoding the file?
+     * @param tooLongLinesWrapped were too long lines found and wrapped?
+     * @param longestLineLoaded the longest line in the file (before wrapping)
+     * @return LoadRunning as long as lines are left, else the result of the load
+     */
+    LoadStatus continueLoad(int maximalLines, bool &encodingErrors, bool &tooLongLinesWrapped, int &longestLineLoaded);
+
+    /**
+     * Stop the load started by beginLoad(), the lines read so far stay in the buffer.
+     * Emits cleared(), as these lines were never announced.
+     */
+    void cancelLoad();
+
+    /**
+     * Is a load started by beginLoad() still running?
+     * @return load running?
+     */
+    bool isLoading() const
+    {
+        return bool(m_pendingLoad);
+    }
+
     /**
      * Save the current buffer content to the given file.
      * Before calling this, setTextCodec and setFallbackTextCodec must have been used to set codec!
@@ -249,6 +310,37 @@ public:
      */
     QString text() const;
 
+    /**
+     * Take an immutable snapshot of the current text, to be read from other threads.
+     * Costs O(blocks) plus the lines of the blocks changed since the last snapshot.
+     * @return snapshot of the current revision
+     */
+    TextSnapshot snapshot() const;
+
+    /**
+     * Find the first bracket of the class of @p bracket whose partner is not between it and @p position.
+     * A closing bracket is searched forward, starting at @p position, an opening one is searched backward,
+     * starting in front of @p position. Brackets only pair up with brackets of the same kind and attribute.
+     *
+     * The blocks in between are skipped in O(log n) with segment trees over their bracket balances,
+     * only the lines of the first and the last block searched are scanned.
+     * The caller must ensure the attributes of all lines searched are up-to-date.
+     *
+     * @param position position to start the search at
+     * @param bracket bracket to search for
+     * @param attribute attribute of the bracket
+     * @param limitLine the search never passes this line
+     * @return position of the bracket, invalid if none found
+     */
+    KTextEditor::Cursor findUnmatchedBracket(const KTextEditor::Cursor &position, QChar bracket, short attribute, int limitLine) const;
+
+    /**
+     * Drop the bracket balances of the given lines, must be done after their attributes changed.
+     * @param startLine first line with changed attributes
+     * @param endLine last line with changed attributes
+     */
+    void invalidateBracketBalances(int startLine, int endLine);
+
     /**
      * Start an editing transaction, the wrapLine/unwrapLine/insertText and removeText functions
      * are only allowed to be called inside a editing transaction.
@@ -372,6 +464,7 @@ Q_SIGNALS:
     /**
      * Buffer got cleared. This is emitted when constructor or load have called clear() internally,
      * or when the user of the buffer has called clear() itself.
+     * cancelLoad() emits it, too, the lines read so far are kept without being announced.
      */
     void cleared();
 
@@ -382,6 +475,14 @@ Q_SIGNALS:
      */
     void loaded(const QString &filename, bool encodingErrors);
 
+    /**
+     * Incremental load made progress, emitted by continueLoad().
+     * For compressed files, the read bytes are decompressed ones and capped to the file size.
+     * @param bytesRead bytes of the file read so far
+     * @param bytesTotal size of the file
+     */
+    void loadProgress(qint64 bytesRead, qint64 bytesTotal);
+
     /**
      * Buffer saved successfully a file
      * @param filename file which was saved
@@ -431,6 +532,22 @@ private:
      */
     enum class SaveResult { Failed = 0, MissingPermissions, Success };
 
+    /**
+     * State of a load started by beginLoad()
+     */
+    struct PendingLoad;
+
+    /**
+     * Clear the buffer and open the file for the next round of the running load.
+     * @return false if the file could not be opened, the buffer then holds one empty line
+     */
+    bool startLoadRound();
+
+    /**
+     * Take over codec, eol mode and checksum of the completely read file, emits loaded().
+     */
+    void finishLoad();
+
     /**
      * Find block containing given line.
      * @param line we want to find block for this line
@@ -438,6 +555,34 @@ private:
      */
     int blockForLine(int line) const;
 
+    /**
+     * Segment tree over the bracket balances of all blocks for the given bracket class.
+     * Built on first use, updated for the blocks changed since, see findUnmatchedBracket().
+     * @param bracketClass class of the brackets, see TextBracket::bracketClass()
+     * @return tree nodes, node 1 is the root, the children of node i are 2i and 2i + 1
+     */
+    const QVector<TextBracketBalance> &bracketTree(quint32 bracketClass) const;
+
+    /**
+     * Remember the given block for an update of the bracket trees.
+     * @param index index of the changed block
+     */
+    void bracketsChanged(int index)
+    {
+        if (!m_bracketTrees.isEmpty()) {
+            m_bracketChangedBlocks.insert(index);
+        }
+    }
+
+    /**
+     * Drop the bracket trees, must be done if blocks are added or removed.
+     */
+    void invalidateBracketTrees()
+    {
+        m_bracketTrees.clear();
+        m_bracketChangedBlocks.clear();
+    }
+
     /**
      * Fix start lines of all blocks after the given one
      * @param startBlock index of block from which we start to fix
@@ -575,6 +720,16 @@ private:
      */
     QVector<TextBlock *> m_blocks;
 
+    /**
+     * segment trees over the bracket balances of the blocks, per bracket class searched, see bracketTree()
+     */
+    mutable QHash<quint32, QVector<TextBracketBalance>> m_bracketTrees;
+
+    /**
+     * indices of the blocks changed since the bracket trees were updated
+     */
+    mutable QSet<int> m_bracketChangedBlocks;
+
     /**
      * Number of lines in buffer
      */
@@ -668,6 +823,11 @@ private:
      */
     int m_lineLengthLimit;
 
+    /**
+     * Load started by beginLoad(), if still running
+     */
+    std::unique_ptr<PendingLoad> m_pendingLoad;
+
     /**
      * For unit-testing purposes only.
      */
@@ -495,6 +495,21 @@ int TextFolding::visibleLineToLine(int visibleLine) const
     return line;
 }
 
+QVector<QPair<int, int>> TextFolding::hiddenLines() const
+{
+    /**
+     * the folded ranges are sorted and never nested
+     */
+    QVector<QPair<int, int>> lines;
+    lines.reserve(m_foldedFoldingRanges.size());
+    for (FoldingRange *range : m_foldedFoldingRanges) {
+        if (range->end->line() > range->start->line()) {
+            lines.append(qMakePair(range->start->line() + 1, range->end->line()));
+        }
+    }
+    return lines;
+}
+
 QVector<QPair<qint64, TextFolding::FoldingRangeFlags>> TextFolding::foldingRangesStartingOnLine(int line) const
 {
     /**
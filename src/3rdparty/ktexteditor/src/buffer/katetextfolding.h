@@ -150,6 +150,14 @@ public:
      */
     int visibleLineToLine(int visibleLine) const;
 
+    /**
+     * Line spans hidden by folded ranges, the lines behind the start line of each
+     * outermost folded range up to its end line.
+     * O(n) for n == number of folded ranges
+     * @return pairs of first and last hidden line, sorted
+     */
+    QVector<QPair<int, int>> hiddenLines() const;
+
     /**
      * Queries which folding ranges start at the given line and returns the id + flags for all
      * of them. Very fast if nothing is folded, else binary search.
@@ -21,6 +21,41 @@
 #include "katetexthistory.h"
 #include "katetextbuffer.h"
 
+#include <limits>
+
+namespace
+{
+/**
+ * line tree key of entries that change no cursor at all
+ */
+const int noLine = std::numeric_limits<int>::max();
+
+/**
+ * Search the leaf with the smallest (or largest, if @p reverse) index in [@p from, @p to] with a key <= @p line
+ * below @p node, which covers the leaves [@p nodeBegin, @p nodeEnd].
+ */
+qint64 findLeaf(const std::vector<int> &tree, size_t node, qint64 nodeBegin, qint64 nodeEnd, qint64 from, qint64 to, int line, bool reverse)
+{
+    // nothing of interest below this node?
+    if (nodeEnd < from || nodeBegin > to || tree[node] > line) {
+        return -1;
+    }
+
+    if (nodeBegin == nodeEnd) {
+        return nodeBegin;
+    }
+
+    const qint64 middle = (nodeBegin + nodeEnd) / 2;
+    if (reverse) {
+        const qint64 leaf = findLeaf(tree, 2 * node + 1, middle + 1, nodeEnd, from, to, line, reverse);
+        return (leaf >= 0) ? leaf : findLeaf(tree, 2 * node, nodeBegin, middle, from, to, line, reverse);
+    }
+
+    const qint64 leaf = findLeaf(tree, 2 * node, nodeBegin, middle, from, to, line, reverse);
+    return (leaf >= 0) ? leaf : findLeaf(tree, 2 * node + 1, middle + 1, nodeEnd, from, to, line, reverse);
+}
+}
+
 namespace Kate
 {
 TextHistory::TextHistory(TextBuffer &buffer)
@@ -53,6 +88,59 @@ void TextHistory::clear()
 
     // first entry will again belong to first revision
     m_firstHistoryEntryRevision = 0;
+
+    rebuildLineTrees();
+}
+
+qint64 TextHistory::memoryUsage() const
+{
+    return qint64(m_historyEntries.capacity() * sizeof(Entry) + (m_forwardLineTree.capacity() + m_reverseLineTree.capacity()) * sizeof(int));
+}
+
+void TextHistory::rebuildLineTrees()
+{
+    // a bit of space ahead, appending entries needs no rebuild for a while
+    m_lineTreeLeaves = 64;
+    while (m_lineTreeLeaves < m_historyEntries.size() * 2) {
+        m_lineTreeLeaves *= 2;
+    }
+
+    m_forwardLineTree.assign(2 * m_lineTreeLeaves, noLine);
+    m_reverseLineTree.assign(2 * m_lineTreeLeaves, noLine);
+    for (size_t i = 0; i < m_historyEntries.size(); ++i) {
+        m_forwardLineTree[m_lineTreeLeaves + i] = m_historyEntries[i].forwardLine();
+        m_reverseLineTree[m_lineTreeLeaves + i] = m_historyEntries[i].reverseLine();
+    }
+
+    for (size_t node = m_lineTreeLeaves - 1; node > 0; --node) {
+        m_forwardLineTree[node] = qMin(m_forwardLineTree[2 * node], m_forwardLineTree[2 * node + 1]);
+        m_reverseLineTree[node] = qMin(m_reverseLineTree[2 * node], m_reverseLineTree[2 * node + 1]);
+    }
+}
+
+void TextHistory::updateLineTrees(size_t index)
+{
+    if (index >= m_lineTreeLeaves) {
+        rebuildLineTrees();
+        return;
+    }
+
+    size_t node = m_lineTreeLeaves + index;
+    m_forwardLineTree[node] = m_historyEntries[index].forwardLine();
+    m_reverseLineTree[node] = m_historyEntries[index].reverseLine();
+    for (node /= 2; node > 0; node /= 2) {
+        m_forwardLineTree[node] = qMin(m_forwardLineTree[2 * node], m_forwardLineTree[2 * node + 1]);
+        m_reverseLineTree[node] = qMin(m_reverseLineTree[2 * node], m_reverseLineTree[2 * node + 1]);
+    }
+}
+
+qint64 TextHistory::findEntry(qint64 from, qint64 to, int line, bool reverse) const
+{
+    if (from > to) {
+        return -1;
+    }
+
+    return findLeaf(reverse ? m_reverseLineTree : m_forwardLineTree, 1, 0, qint64(m_lineTreeLeaves) - 1, from, to, line, reverse);
 }
 
 void TextHistory::setLastSavedRevision()
@@ -127,6 +215,7 @@ void TextHistory::addEntry(const Entry &entry)
          * remember edit
          */
         m_historyEntries.front() = entry;
+        updateLineTrees(0);
 
         /**
          * be done...
@@ -138,6 +227,7 @@ void TextHistory::addEntry(const Entry &entry)
      * ok, we have more than one entry or the entry is referenced, just add up new entries
      */
     m_historyEntries.push_back(entry);
+    updateLineTrees(m_historyEntries.size() - 1);
 }
 
 void TextHistory::lockRevision(qint64 revision)
@@ -198,10 +288,35 @@ void TextHistory::unlockRevision(qint64 revision)
 
             // patch first entry revision
             m_firstHistoryEntryRevision += unreferencedEdits;
+
+            // entry indices changed
+            rebuildLineTrees();
         }
     }
 }
 
+int TextHistory::Entry::forwardLine() const
+{
+    // see the early returns of transformCursor()
+    return (type == NoChange) ? noLine : line;
+}
+
+int TextHistory::Entry::reverseLine() const
+{
+    // see the early returns of reverseTransformCursor()
+    switch (type) {
+    case WrapLine:
+        return line + 1;
+    case UnwrapLine:
+        return line - 1;
+    case InsertText:
+    case RemoveText:
+        return line;
+    default:
+        return noLine;
+    }
+}
+
 void TextHistory::Entry::transformCursor(int &cursorLine, int &cursorColumn, bool moveOnInsert) const
 {
     /**
@@ -492,13 +607,18 @@ void TextHistory::transformCursor(int &line, int &column, KTextEditor::MovingCur
     /**
      * forward or reverse transform?
      */
+    /**
+     * only visit the entries able to change the cursor, all others are skipped in O(log n)
+     */
     if (toRevision > fromRevision) {
-        for (int rev = fromRevision - m_firstHistoryEntryRevision + 1; rev <= (toRevision - m_firstHistoryEntryRevision); ++rev) {
+        const qint64 last = toRevision - m_firstHistoryEntryRevision;
+        for (qint64 rev = findEntry(fromRevision - m_firstHistoryEntryRevision + 1, last, line, false); rev >= 0; rev = findEntry(rev + 1, last, line, false)) {
             const Entry &entry = m_historyEntries.at(rev);
             entry.transformCursor(line, column, moveOnInsert);
         }
     } else {
-        for (int rev = fromRevision - m_firstHistoryEntryRevision; rev >= (toRevision - m_firstHistoryEntryRevision + 1); --rev) {
+        const qint64 first = toRevision - m_firstHistoryEntryRevision + 1;
+        for (qint64 rev = findEntry(first, fromRevision - m_firstHistoryEntryRevision, line, true); rev >= 0; rev = findEntry(first, rev - 1, line, true)) {
             const Entry &entry = m_historyEntries.at(rev);
             entry.reverseTransformCursor(line, column, moveOnInsert);
         }
@@ -556,9 +676,11 @@ void TextHistory::transformRange(KTextEditor::Range &range, KTextEditor::MovingR
 
     /**
      * forward or reverse transform?
+     * the first entry is always visited, it normalizes empty ranges, later only the entries able to change a cursor
      */
     if (toRevision > fromRevision) {
-        for (int rev = fromRevision - m_firstHistoryEntryRevision + 1; rev <= (toRevision - m_firstHistoryEntryRevision); ++rev) {
+        const qint64 last = toRevision - m_firstHistoryEntryRevision;
+        for (qint64 rev = fromRevision - m_firstHistoryEntryRevision + 1; rev >= 0; rev = findEntry(rev + 1, last, qMax(startLine, endLine), false)) {
             const Entry &entry = m_historyEntries.at(rev);
 
             entry.transformCursor(startLine, startColumn, moveOnInsertStart);
@@ -578,7 +700,8 @@ void TextHistory::transformRange(KTextEditor::Range &range, KTextEditor::MovingR
             }
         }
     } else {
-        for (int rev = fromRevision - m_firstHistoryEntryRevision; rev >= (toRevision - m_firstHistoryEntryRevision + 1); --rev) {
+        const qint64 first = toRevision - m_firstHistoryEntryRevision + 1;
+        for (qint64 rev = fromRevision - m_firstHistoryEntryRevision; rev >= 0; rev = findEntry(first, rev - 1, qMax(startLine, endLine), true)) {
             const Entry &entry = m_historyEntries.at(rev);
 
             entry.reverseTransformCursor(startLine, startColumn, moveOnInsertStart);
@@ -89,6 +89,12 @@ public:
      */
     void transformRange(KTextEditor::Range &range, KTextEditor::MovingRange::InsertBehaviors insertBehaviors, KTextEditor::MovingRange::EmptyBehavior emptyBehavior, qint64 fromRevision, qint64 toRevision = -1);
 
+    /**
+     * Approximate number of bytes used by the history, it grows with the edits done since the oldest locked revision.
+     * @return memory usage in bytes
+     */
+    qint64 memoryUsage() const;
+
 private:
     /**
      * Class representing one entry in the editing history.
@@ -112,6 +118,16 @@ private:
          */
         void reverseTransformCursor(int &line, int &column, bool moveOnInsert) const;
 
+        /**
+         * transformCursor() can only change cursors in lines >= this line
+         */
+        int forwardLine() const;
+
+        /**
+         * reverseTransformCursor() can only change cursors in lines >= this line
+         */
+        int reverseLine() const;
+
         /**
          * Types of entries, matching editing primitives of buffer and placeholder
          */
@@ -210,6 +226,28 @@ private:
      */
     void addEntry(const Entry &entry);
 
+    /**
+     * Rebuild the line trees for all entries, needed after entries got removed in front.
+     */
+    void rebuildLineTrees();
+
+    /**
+     * Update the line trees for the entry with the given index.
+     * @param index index of the entry in m_historyEntries
+     */
+    void updateLineTrees(size_t index);
+
+    /**
+     * Search the entry with the smallest (or largest, if @p reverse) index in [@p from, @p to]
+     * that can change a cursor in a line <= @p line, in O(log n).
+     * @param from first entry index to consider
+     * @param to last entry index to consider
+     * @param line largest line of the cursors to transform
+     * @param reverse search the entry for a reverse transformation, from the back
+     * @return index of the entry, -1 if none
+     */
+    qint64 findEntry(qint64 from, qint64 to, int line, bool reverse) const;
+
 private:
     /**
      * TextBuffer this history belongs to
@@ -231,6 +269,20 @@ private:
      * offset for the first entry in m_history, to which revision it really belongs?
      */
     qint64 m_firstHistoryEntryRevision;
+
+    /**
+     * minimum of Entry::forwardLine() and Entry::reverseLine() over the entries,
+     * as implicit binary trees: the root is at 1, the children of node n at 2n and 2n + 1,
+     * the leaf for entry i at m_lineTreeLeaves + i.
+     * Transformations use them to skip runs of entries that leave a cursor unchanged.
+     */
+    std::vector<int> m_forwardLineTree;
+    std::vector<int> m_reverseLineTree;
+
+    /**
+     * number of leaves of the line trees, a power of two
+     */
+    size_t m_lineTreeLeaves = 0;
 };
 
 }
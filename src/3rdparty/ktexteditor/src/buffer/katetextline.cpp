@@ -192,6 +192,8 @@ int TextLineData::virtualLength(int tabWidth) const
 
 void TextLineData::addAttribute(const Attribute &attribute)
 {
+    m_bracketsValid = false;
+
     // try to append to previous range, if same attribute value
     if (!m_attributesList.isEmpty() && (m_attributesList.back().attributeValue == attribute.attributeValue) && ((m_attributesList.back().offset + m_attributesList.back().length) == attribute.offset)) {
         m_attributesList.back().length += attribute.length;
@@ -201,6 +203,34 @@ void TextLineData::addAttribute(const Attribute &attribute)
     m_attributesList.append(attribute);
 }
 
+const QVector<TextBracket> &TextLineData::brackets() const
+{
+    if (m_bracketsValid) {
+        return m_brackets;
+    }
+
+    m_brackets.clear();
+
+    // the attributes are sorted by offset, walk them along with the text
+    auto attribute = m_attributesList.cbegin();
+    const QChar *unicode = m_text.unicode();
+    for (int offset = 0; offset < m_text.length(); ++offset) {
+        const int kind = TextBracket::kind(unicode[offset]);
+        if (kind < 0) {
+            continue;
+        }
+
+        while (attribute != m_attributesList.cend() && attribute->offset + attribute->length <= offset) {
+            ++attribute;
+        }
+        const short value = (attribute != m_attributesList.cend() && attribute->offset <= offset) ? attribute->attributeValue : 0;
+        m_brackets.append(TextBracket(offset, value, kind, TextBracket::isOpening(unicode[offset])));
+    }
+
+    m_bracketsValid = true;
+    return m_brackets;
+}
+
 short TextLineData::attribute(int pos) const
 {
     auto found = std::upper_bound(m_attributesList.cbegin(), m_attributesList.cend(), pos, [](const int &p, const Attribute &x) { return p < x.offset + x.length; });
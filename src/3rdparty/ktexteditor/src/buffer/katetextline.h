@@ -29,6 +29,8 @@
 
 #include <KSyntaxHighlighting/State>
 
+#include "katetextbracket.h"
+
 namespace Kate
 {
 /**
@@ -395,6 +397,7 @@ public:
     {
         m_attributesList.clear();
         m_foldings.clear();
+        m_bracketsValid = false;
     }
 
     /**
@@ -425,6 +428,13 @@ public:
         m_foldings.emplace_back(offset, folding);
     }
 
+    /**
+     * Accessor to the brackets of this line, together with their attributes.
+     * Collected on first use after a change of the text or the attributes.
+     * @return brackets of this line, sorted by offset
+     */
+    const QVector<TextBracket> &brackets() const;
+
     /**
      * Gets the attribute at the given position
      * use KRenderer::attributes  to get the KTextAttribute for this.
@@ -455,6 +465,7 @@ private:
      */
     QString &textReadWrite()
     {
+        m_bracketsValid = false;
         return m_text;
     }
 
@@ -474,6 +485,12 @@ private:
      */
     std::vector<Folding> m_foldings;
 
+    /**
+     * brackets of this line, see brackets()
+     */
+    mutable QVector<TextBracket> m_brackets;
+    mutable bool m_bracketsValid = false;
+
     /**
      * current highlighting state
      */
@@ -64,6 +64,7 @@ public:
         , m_firstRead(true)
         , m_proberType(proberType)
         , m_fileSize(0)
+        , m_bytesRead(0)
     {
         // try to get mimetype for on the fly decompression, don't rely on filename!
         QFile testMime(filename);
@@ -103,6 +104,7 @@ public:
         m_converterState = new QTextCodec::ConverterState(QTextCodec::DefaultConversion);
         m_bomFound = false;
         m_firstRead = true;
+        m_bytesRead = 0;
 
         // init the hash with the git header
         const QString header = QStringLiteral("blob %1").arg(m_fileSize);
@@ -209,6 +211,8 @@ public:
 
                     // if any text is there, append it....
                     if (c > 0) {
+                        m_bytesRead += c;
+
                         // update hash sum
                         m_digest.addData(m_buffer.data(), c);
 
@@ -377,6 +381,25 @@ public:
         return !encodingError;
     }
 
+    /**
+     * Bytes read from the file since the last open().
+     * For compressed files these are decompressed bytes.
+     * @return bytes read
+     */
+    qint64 bytesRead() const
+    {
+        return m_bytesRead;
+    }
+
+    /**
+     * Size of the file on disk, for compressed files the compressed size.
+     * @return file size
+     */
+    qint64 fileSize() const
+    {
+        return m_fileSize;
+    }
+
     QByteArray digest()
     {
         return m_digest.result();
@@ -400,6 +423,7 @@ private:
     bool m_firstRead;
     KEncodingProber::ProberType m_proberType;
     quint64 m_fileSize;
+    qint64 m_bytesRead;
 };
 
 }
@@ -0,0 +1,51 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "katetextsnapshot.h"
+
+#include <algorithm>
+
+namespace Kate
+{
+QString TextSnapshot::line(int line) const
+{
+    if (line < 0 || line >= m_lines) {
+        return QString();
+    }
+
+    // last block starting at or before the line, empty blocks share the start line of their successor
+    const int block = std::upper_bound(m_blockStartLines.begin(), m_blockStartLines.end(), line) - m_blockStartLines.begin() - 1;
+    Q_ASSERT(block >= 0 && line - m_blockStartLines.at(block) < m_blocks.at(block).size());
+    return m_blocks.at(block).at(line - m_blockStartLines.at(block));
+}
+
+QString TextSnapshot::text() const
+{
+    QString text;
+    forEachLine([&text](int line, const QString &lineText) {
+        if (line > 0) {
+            text.append(QLatin1Char('\n'));
+        }
+        text.append(lineText);
+    });
+    return text;
+}
+
+}
@@ -0,0 +1,123 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_TEXTSNAPSHOT_H
+#define KATE_TEXTSNAPSHOT_H
+
+#include <QString>
+#include <QVector>
+
+#include <ktexteditor_export.h>
+
+namespace Kate
+{
+class TextBuffer;
+
+/**
+ * Immutable snapshot of the text of a TextBuffer at one revision.
+ *
+ * A snapshot shares the line texts of the buffer blocks, taking one costs O(blocks)
+ * plus the lines of the blocks changed since the last snapshot. Later edits of the
+ * buffer copy the changed lines on write and never alter a snapshot.
+ *
+ * Snapshots are cheap to copy. All members are const and can be used from any thread,
+ * e.g. to search or index the text in the background while the document is edited.
+ * The shared texts are released when the last copy of a snapshot is dropped.
+ */
+class KTEXTEDITOR_EXPORT TextSnapshot
+{
+    friend class TextBuffer;
+
+public:
+    /**
+     * Construct an empty snapshot, without lines.
+     */
+    TextSnapshot() = default;
+
+    /**
+     * Revision of the buffer this snapshot was taken at.
+     * @return revision, -1 for an empty snapshot
+     */
+    qint64 revision() const
+    {
+        return m_revision;
+    }
+
+    /**
+     * Number of lines of the snapshot.
+     * @return number of lines
+     */
+    int lines() const
+    {
+        return m_lines;
+    }
+
+    /**
+     * Retrieve the text of a line, in O(log blocks).
+     * @param line wanted line number
+     * @return text of the line, empty for invalid lines
+     */
+    QString line(int line) const;
+
+    /**
+     * Retrieve the complete text of the snapshot.
+     * @return text, lines separated by '\n'
+     */
+    QString text() const;
+
+    /**
+     * Call @p func with line number and text of each line, in order.
+     * @param func function taking (int line, const QString &text)
+     */
+    template<typename Func> void forEachLine(Func func) const
+    {
+        int line = 0;
+        for (const QVector<QString> &block : m_blocks) {
+            for (const QString &text : block) {
+                func(line++, text);
+            }
+        }
+    }
+
+private:
+    /**
+     * line texts of all blocks, shared with the blocks of the buffer
+     */
+    QVector<QVector<QString>> m_blocks;
+
+    /**
+     * start line of each block
+     */
+    QVector<int> m_blockStartLines;
+
+    /**
+     * revision the snapshot was taken at
+     */
+    qint64 m_revision = -1;
+
+    /**
+     * number of lines
+     */
+    int m_lines = 0;
+};
+
+}
+
+#endif
@@ -37,10 +37,22 @@
 #include <QMultiMap>
 #include <QTextEdit>
 #include <QTimer>
-#include <QVarLengthArray>
 
 using namespace KTextEditor;
 
+/**
+ * Lower case @p text character by character. Unlike QString::toLower(),
+ * this keeps the length and thereby all offsets into @p text valid.
+ */
+static QString toLowerPerCharacter(const QString &text)
+{
+    QString lower(text.size(), Qt::Uninitialized);
+    for (int i = 0; i < text.size(); ++i) {
+        lower[i] = text.at(i).toLower();
+    }
+    return lower;
+}
+
 /// A helper-class for handling completion-models with hierarchical grouping/optimization
 class HierarchicalModelHandler
 {
@@ -980,6 +992,7 @@ void KateCompletionModel::setCurrentCompletion(KTextEditor::CodeCompletionModel
 
     if (!hasCompletionModel()) {
         m_currentMatch[model] = completion;
+        m_currentMatchLower[model] = toLowerPerCharacter(completion);
         return;
     }
 
@@ -997,6 +1010,7 @@ void KateCompletionModel::setCurrentCompletion(KTextEditor::CodeCompletionModel
     // qCDebug(LOG_KTE) << model << "Old match: " << m_currentMatch[model] << ", new: " << completion << ", type: " << changeType;
 
     m_currentMatch[model] = completion;
+    m_currentMatchLower[model] = toLowerPerCharacter(completion);
 
     const bool resetModel = (changeType != Narrow);
     if (resetModel) {
@@ -1092,19 +1106,21 @@ QString KateCompletionModel::commonPrefix(QModelIndex selectedIndex) const
 
 void KateCompletionModel::changeCompletions(Group *g, changeTypes changeType, bool notifyModel)
 {
-    if (changeType != Narrow) {
-        g->filtered = g->prefilter;
-        // In the "Broaden" or "Change" case, just re-filter everything,
-        // and don't notify the model. The model is notified afterwards through a reset().
-    }
+    // In the "Broaden" or "Change" case, just re-filter everything,
+    // and don't notify the model. The model is notified afterwards through a reset().
+    // When narrowing, only the items of the previous filtered set can still match.
+    // The source is only read, so only the surviving items get copied.
+    const QList<KateCompletionModel::Item> &source = (changeType != Narrow) ? g->prefilter : g->filtered;
 
     // This code determines what of the filtered items still fit, and computes the ranges that were removed, giving
     // them to beginRemoveRows(..) in batches
 
     QList<KateCompletionModel::Item> newFiltered;
+    newFiltered.reserve(source.size());
     int deleteUntil = -1; // In each state, the range [currentRow+1, deleteUntil] needs to be deleted
-    for (int currentRow = g->filtered.count() - 1; currentRow >= 0; --currentRow) {
-        if (g->filtered[currentRow].match()) {
+    for (int currentRow = source.count() - 1; currentRow >= 0; --currentRow) {
+        Item item = source.at(currentRow);
+        if (item.match()) {
             // This row does not need to be deleted, which means that currentRow+1 to deleteUntil need to be deleted now
             if (deleteUntil != -1 && notifyModel) {
                 beginRemoveRows(indexForGroup(g), currentRow + 1, deleteUntil);
@@ -1112,7 +1128,7 @@ void KateCompletionModel::changeCompletions(Group *g, changeTypes changeType, bo
             }
             deleteUntil = -1;
 
-            newFiltered.prepend(g->filtered[currentRow]);
+            newFiltered.append(item);
         } else {
             if (deleteUntil == -1) {
                 deleteUntil = currentRow; // Mark that this row needs to be deleted
@@ -1125,6 +1141,8 @@ void KateCompletionModel::changeCompletions(Group *g, changeTypes changeType, bo
         endRemoveRows();
     }
 
+    // collected back to front
+    std::reverse(newFiltered.begin(), newFiltered.end());
     g->filtered = newFiltered;
     hideOrShowGroup(g, notifyModel);
 }
@@ -1532,6 +1550,45 @@ Qt::CaseSensitivity KateCompletionModel::sortingCaseSensitivity() const
     return m_sortingCaseSensitivity;
 }
 
+/**
+ * Offsets of the abbreviation letters in @p word: the uppercase letters and the
+ * letters after underscores, including the first letter.
+ */
+static QVector<int> abbreviationOffsets(const QString &word)
+{
+    QVector<int> offsets;
+    bool haveUnderscore = true;
+    for (int i = 0; i < word.size(); i++) {
+        const QChar c = word.at(i);
+        if (c == QLatin1Char('_')) {
+            haveUnderscore = true;
+        } else if (haveUnderscore || c.isUpper()) {
+            offsets.append(i);
+            haveUnderscore = false;
+        }
+    }
+    return offsets;
+}
+
+/**
+ * Offsets of the word beginnings inside @p word, ignoring the start of @p word.
+ * A position is a word beginning if the previous character was an underscore
+ * or if the current character is uppercase. Subsequent uppercase characters do not count,
+ * to handle the special case of UPPER_CASE_VARS properly.
+ */
+static QVector<int> wordBeginnings(const QString &word)
+{
+    QVector<int> offsets;
+    for (int i = 1; i < word.size(); i++) {
+        const QChar c = word.at(i);
+        const QChar prev = word.at(i - 1);
+        if (prev == QLatin1Char('_') || (c.isUpper() && !prev.isUpper())) {
+            offsets.append(i);
+        }
+    }
+    return offsets;
+}
+
 KateCompletionModel::Item::Item(bool doInitialMatch, KateCompletionModel *m, const HierarchicalModelHandler &handler, ModelRow sr)
     : model(m)
     , m_sourceRow(sr)
@@ -1545,46 +1602,32 @@ KateCompletionModel::Item::Item(bool doInitialMatch, KateCompletionModel *m, con
     QModelIndex nameSibling = sr.second.sibling(sr.second.row(), CodeCompletionModel::Name);
     m_nameColumn = nameSibling.data(Qt::DisplayRole).toString();
 
+    m_nameColumnLower = toLowerPerCharacter(m_nameColumn);
+    m_abbreviationOffsets = abbreviationOffsets(m_nameColumn);
+    m_wordBeginnings = wordBeginnings(m_nameColumn);
+
+    updateSortKey(model->currentCompletion(m_sourceRow.first));
+
     if (doInitialMatch) {
         filter();
         match();
     }
 }
 
-bool KateCompletionModel::Item::operator<(const Item &rhs) const
+void KateCompletionModel::Item::updateSortKey(const QString &match)
 {
-    int ret = 0;
-
-    // qCDebug(LOG_KTE) << c1 << " c/w " << c2 << " -> " << (model->isSortingReverse() ? ret > 0 : ret < 0) << " (" << ret << ")";
-
-    if (m_unimportant && !rhs.m_unimportant) {
-        return false;
-    }
-
-    if (!m_unimportant && rhs.m_unimportant) {
-        return true;
-    }
+    // from most to least significant: unimportant items last, then ordered by the match type
+    // (the enum is ordered in the order items should be displayed), then case sensitive prefix matches first
+    m_sortKey = (m_unimportant ? 16 : 0) | (int(matchCompletion) << 1) | (m_nameColumn.startsWith(match, Qt::CaseSensitive) ? 0 : 1);
+}
 
-    if (matchCompletion < rhs.matchCompletion) {
-        // enums are ordered in the order items should be displayed
-        return true;
-    }
-    if (matchCompletion > rhs.matchCompletion) {
-        return false;
+bool KateCompletionModel::Item::operator<(const Item &rhs) const
+{
+    if (m_sortKey != rhs.m_sortKey) {
+        return m_sortKey < rhs.m_sortKey;
     }
 
-    if (ret == 0) {
-        const QString &filter = rhs.model->currentCompletion(rhs.m_sourceRow.first);
-        bool thisStartWithFilter = m_nameColumn.startsWith(filter, Qt::CaseSensitive);
-        bool rhsStartsWithFilter = rhs.m_nameColumn.startsWith(filter, Qt::CaseSensitive);
-
-        if (thisStartWithFilter && !rhsStartsWithFilter) {
-            return true;
-        }
-        if (rhsStartsWithFilter && !thisStartWithFilter) {
-            return false;
-        }
-    }
+    int ret = 0;
 
     if (model->isSortingByInheritanceDepth()) {
         ret = inheritanceDepth - rhs.inheritanceDepth;
@@ -1894,21 +1937,17 @@ bool KateCompletionModel::shouldMatchHideCompletionList() const
     return doHide;
 }
 
-static inline QChar toLowerIfInsensitive(QChar c, Qt::CaseSensitivity caseSensitive)
-{
-    return (caseSensitive == Qt::CaseInsensitive) ? c.toLower() : c;
-}
-
-static inline bool matchesAbbreviationHelper(const QString &word, const QString &typed, const QVarLengthArray<int, 32> &offsets, Qt::CaseSensitivity caseSensitive, int &depth, int atWord = -1, int i = 0)
+// word and typed are already lower case for case insensitive matching
+static inline bool matchesAbbreviationHelper(const QString &word, const QString &typed, const QVector<int> &offsets, int &depth, int atWord = -1, int i = 0)
 {
     int atLetter = 1;
     for (; i < typed.size(); i++) {
-        const QChar c = toLowerIfInsensitive(typed.at(i), caseSensitive);
+        const QChar c = typed.at(i);
         bool haveNextWord = offsets.size() > atWord + 1;
         bool canCompare = atWord != -1 && word.size() > offsets.at(atWord) + atLetter;
-        if (canCompare && c == toLowerIfInsensitive(word.at(offsets.at(atWord) + atLetter), caseSensitive)) {
+        if (canCompare && c == word.at(offsets.at(atWord) + atLetter)) {
             // the typed letter matches a letter after the current word beginning
-            if (!haveNextWord || c != toLowerIfInsensitive(word.at(offsets.at(atWord + 1)), caseSensitive)) {
+            if (!haveNextWord || c != word.at(offsets.at(atWord + 1))) {
                 // good, simple case, no conflict
                 atLetter += 1;
                 continue;
@@ -1921,14 +1960,14 @@ static inline bool matchesAbbreviationHelper(const QString &word, const QString
                 return false;
             }
             // the letter matches both the next word beginning and the next character in the word
-            if (haveNextWord && matchesAbbreviationHelper(word, typed, offsets, caseSensitive, depth, atWord + 1, i + 1)) {
+            if (haveNextWord && matchesAbbreviationHelper(word, typed, offsets, depth, atWord + 1, i + 1)) {
                 // resolving the conflict by taking the next word's first character worked, fine
                 return true;
             }
             // otherwise, continue by taking the next letter in the current word.
             atLetter += 1;
             continue;
-        } else if (haveNextWord && c == toLowerIfInsensitive(word.at(offsets.at(atWord + 1)), caseSensitive)) {
+        } else if (haveNextWord && c == word.at(offsets.at(atWord + 1))) {
             // the typed letter matches the next word beginning
             atWord++;
             atLetter = 1;
@@ -1941,18 +1980,19 @@ static inline bool matchesAbbreviationHelper(const QString &word, const QString
     return true;
 }
 
-bool KateCompletionModel::matchesAbbreviation(const QString &word, const QString &typed, Qt::CaseSensitivity caseSensitive)
+// word and typed are already lower case for case insensitive matching, offsets are the abbreviationOffsets() of word
+static bool matchesAbbreviationPrepared(const QString &word, const QString &typed, const QVector<int> &offsets)
 {
     // A mismatch is very likely for random even for the first letter,
     // thus this optimization makes sense.
-    if (toLowerIfInsensitive(word.at(0), caseSensitive) != toLowerIfInsensitive(typed.at(0), caseSensitive)) {
+    if (word.at(0) != typed.at(0)) {
         return false;
     }
 
     // First, check if all letters are contained in the word in the right order.
     int atLetter = 0;
     for (const QChar c : typed) {
-        while (toLowerIfInsensitive(c, caseSensitive) != toLowerIfInsensitive(word.at(atLetter), caseSensitive)) {
+        while (c != word.at(atLetter)) {
             atLetter += 1;
             if (atLetter >= word.size()) {
                 return false;
@@ -1960,39 +2000,31 @@ bool KateCompletionModel::matchesAbbreviation(const QString &word, const QString
         }
     }
 
-    bool haveUnderscore = true;
-    QVarLengthArray<int, 32> offsets;
     // We want to make "KComplM" match "KateCompletionModel"; this means we need
     // to allow parts of the typed text to be not part of the actual abbreviation,
     // which consists only of the uppercased / underscored letters (so "KCM" in this case).
     // However it might be ambiguous whether a letter is part of such a word or part of
     // the following abbreviation, so we need to find all possible word offsets first,
     // then compare.
-    for (int i = 0; i < word.size(); i++) {
-        const QChar c = word.at(i);
-        if (c == QLatin1Char('_')) {
-            haveUnderscore = true;
-        } else if (haveUnderscore || c.isUpper()) {
-            offsets.append(i);
-            haveUnderscore = false;
-        }
-    }
     int depth = 0;
-    return matchesAbbreviationHelper(word, typed, offsets, caseSensitive, depth);
+    return matchesAbbreviationHelper(word, typed, offsets, depth);
 }
 
-static inline bool containsAtWordBeginning(const QString &word, const QString &typed, Qt::CaseSensitivity caseSensitive)
+bool KateCompletionModel::matchesAbbreviation(const QString &word, const QString &typed, Qt::CaseSensitivity caseSensitive)
 {
-    for (int i = 1; i < word.size(); i++) {
-        // The current position is a word beginning if the previous character was an underscore
-        // or if the current character is uppercase. Subsequent uppercase characters do not count,
-        // to handle the special case of UPPER_CASE_VARS properly.
-        const QChar c = word.at(i);
-        const QChar prev = word.at(i - 1);
-        if (!(prev == QLatin1Char('_') || (c.isUpper() && !prev.isUpper()))) {
-            continue;
-        }
-        if (word.midRef(i).startsWith(typed, caseSensitive)) {
+    // the offsets must be computed on the original word, lower casing drops the uppercase letters
+    const QVector<int> offsets = abbreviationOffsets(word);
+    if (caseSensitive == Qt::CaseInsensitive) {
+        return matchesAbbreviationPrepared(toLowerPerCharacter(word), toLowerPerCharacter(typed), offsets);
+    }
+    return matchesAbbreviationPrepared(word, typed, offsets);
+}
+
+// word and typed are already lower case for case insensitive matching, offsets are the wordBeginnings() of word
+static inline bool containsAtWordBeginning(const QString &word, const QString &typed, const QVector<int> &offsets)
+{
+    for (int i : offsets) {
+        if (word.midRef(i).startsWith(typed)) {
             return true;
         }
     }
@@ -2007,38 +2039,47 @@ KateCompletionModel::Item::MatchType KateCompletionModel::Item::match()
 
     // Hehe, everything matches nothing! (ie. everything matches a blank string)
     if (match.isEmpty()) {
+        updateSortKey(match);
         return PerfectMatch;
     }
     if (m_nameColumn.isEmpty()) {
+        updateSortKey(match);
         return NoMatch;
     }
 
-    matchCompletion = (m_nameColumn.startsWith(match, model->matchCaseSensitivity()) ? StartsWithMatch : NoMatch);
+    // compare the prepared lower case variants if case insensitive
+    const bool insensitive = model->matchCaseSensitivity() == Qt::CaseInsensitive;
+    const QString &name = insensitive ? m_nameColumnLower : m_nameColumn;
+    const QString typed = insensitive ? model->currentCompletionLower(m_sourceRow.first) : match;
+
+    matchCompletion = (name.startsWith(typed) ? StartsWithMatch : NoMatch);
     if (matchCompletion == NoMatch) {
         // if no match, try for "contains"
         // Only match when the occurrence is at a "word" beginning, marked by
         // an underscore or a capital. So Foo matches BarFoo and Bar_Foo, but not barfoo.
-        // Starting at 1 saves looking at the beginning of the word, that was already checked above.
-        if (containsAtWordBeginning(m_nameColumn, match, model->matchCaseSensitivity())) {
+        // The beginning of the word was already checked above.
+        if (containsAtWordBeginning(name, typed, m_wordBeginnings)) {
             matchCompletion = ContainsMatch;
         }
     }
 
-    if (matchCompletion == NoMatch && !m_nameColumn.isEmpty() && !match.isEmpty()) {
+    if (matchCompletion == NoMatch) {
         // if still no match, try abbreviation matching
-        if (matchesAbbreviation(m_nameColumn, match, model->matchCaseSensitivity())) {
+        if (matchesAbbreviationPrepared(name, typed, m_abbreviationOffsets)) {
             matchCompletion = AbbreviationMatch;
         }
     }
 
     if (matchCompletion && match.length() == m_nameColumn.length()) {
-        if (model->matchCaseSensitivity() == Qt::CaseInsensitive && model->exactMatchCaseSensitivity() == Qt::CaseSensitive && !m_nameColumn.startsWith(match, Qt::CaseSensitive)) {
+        if (insensitive && model->exactMatchCaseSensitivity() == Qt::CaseSensitive && !m_nameColumn.startsWith(match, Qt::CaseSensitive)) {
+            updateSortKey(match);
             return matchCompletion;
         }
         matchCompletion = PerfectMatch;
         m_haveExactMatch = true;
     }
 
+    updateSortKey(match);
     return matchCompletion;
 }
 
@@ -2141,6 +2182,11 @@ QString KateCompletionModel::currentCompletion(KTextEditor::CodeCompletionModel
     return m_currentMatch.value(model);
 }
 
+QString KateCompletionModel::currentCompletionLower(KTextEditor::CodeCompletionModel *model) const
+{
+    return m_currentMatchLower.value(model);
+}
+
 Qt::CaseSensitivity KateCompletionModel::matchCaseSensitivity() const
 {
     return m_matchCaseSensitivity;
@@ -2205,6 +2251,7 @@ void KateCompletionModel::removeCompletionModel(CodeCompletionModel *model)
 
     beginResetModel();
     m_currentMatch.remove(model);
+    m_currentMatchLower.remove(model);
 
     clearGroups();
 
@@ -2431,6 +2478,7 @@ void KateCompletionModel::clearCompletionModels()
     m_completionModels.clear();
 
     m_currentMatch.clear();
+    m_currentMatchLower.clear();
 
     clearGroups();
     endResetModel();
@@ -25,6 +25,7 @@
 #include <QAbstractProxyModel>
 #include <QList>
 #include <QPair>
+#include <QVector>
 
 #include <ktexteditor/codecompletionmodel.h>
 
@@ -250,11 +251,19 @@ private:
         }
 
     private:
+        // Recomputes m_sortKey for the given completion string
+        void updateSortKey(const QString &match);
+
         KateCompletionModel *model;
         ModelRow m_sourceRow;
 
         mutable QString m_nameColumn;
 
+        // Precomputed at construction, so matching does not need to touch single characters again
+        QString m_nameColumnLower;
+        QVector<int> m_abbreviationOffsets;
+        QVector<int> m_wordBeginnings;
+
         int inheritanceDepth;
 
         // True when currently matching completion string
@@ -264,6 +273,9 @@ private:
         bool m_haveExactMatch;
         bool m_unimportant;
 
+        // Unimportance, match type and prefix match packed for cheap sorting, updated by match()
+        int m_sortKey;
+
         QString completionSortingName() const;
     };
 
@@ -350,12 +362,16 @@ private:
 
     static bool matchesAbbreviation(const QString &word, const QString &typed, Qt::CaseSensitivity caseSensitive);
 
+    /// The current completion of \a model in lower case, for case insensitive matching
+    QString currentCompletionLower(KTextEditor::CodeCompletionModel *model) const;
+
     bool m_hasGroups = false;
 
     // ### Runtime state
     // General
     QList<KTextEditor::CodeCompletionModel *> m_completionModels;
     QMap<KTextEditor::CodeCompletionModel *, QString> m_currentMatch;
+    QMap<KTextEditor::CodeCompletionModel *, QString> m_currentMatchLower;
 
     // Column merging
     QList<QList<int>> m_columnMerges;
@@ -27,6 +27,7 @@
 #include "kateglobal.h"
 #include "katepartdebug.h"
 #include "kateview.h"
+#include "katewordindex.h"
 
 #include <ktexteditor/movingrange.h>
 #include <ktexteditor/range.h>
@@ -43,13 +44,15 @@
 
 #include <QAction>
 #include <QCheckBox>
+#include <QHash>
 #include <QLabel>
 #include <QLayout>
 #include <QRegularExpression>
-#include <QSet>
 #include <QSpinBox>
 #include <QString>
 
+#include <algorithm>
+
 // END
 
 /// Amount of characters the document may have to enable automatic invocation (1MB)
@@ -69,8 +72,9 @@ KateWordCompletionModel::~KateWordCompletionModel()
 
 void KateWordCompletionModel::saveMatches(KTextEditor::View *view, const KTextEditor::Range &range)
 {
+    // the index delivers the words already sorted
     m_matches = allMatches(view, range);
-    m_matches.sort();
+    m_matchesPrefix = view->document()->text(range);
 }
 
 QVariant KateWordCompletionModel::data(const QModelIndex &index, int role) const
@@ -184,6 +188,11 @@ bool KateWordCompletionModel::shouldStartCompletion(KTextEditor::View *view, con
 
 bool KateWordCompletionModel::shouldAbortCompletion(KTextEditor::View *view, const KTextEditor::Range &range, const QString &currentCompletion)
 {
+    // the matches lack the words for a shorter prefix, start over
+    if (!currentCompletion.startsWith(m_matchesPrefix, Qt::CaseInsensitive)) {
+        return true;
+    }
+
     if (m_automatic) {
         KTextEditor::ViewPrivate *v = qobject_cast<KTextEditor::ViewPrivate *>(view);
         if (currentCompletion.length() < v->config()->wordCompletionMinimalWordLength()) {
@@ -201,42 +210,63 @@ void KateWordCompletionModel::completionInvoked(KTextEditor::View *view, const K
 }
 
 /**
- * Scan throughout the entire document for possible completions,
- * ignoring any dublets and words shorter than configured and/or
- * reasonable minimum length.
+ * Remove the words from @p words that only occur where the user is typing:
+ * the word ending at the end of @p range and the one around the cursor.
+ * @p words must be sorted.
  */
-QStringList KateWordCompletionModel::allMatches(KTextEditor::View *view, const KTextEditor::Range &range) const
+static void removeWordsBeingTyped(QStringList &words, KTextEditor::ViewPrivate *view, const KTextEditor::Range &range)
 {
-    QSet<QString> result;
-    const int minWordSize = qMax(2, qobject_cast<KTextEditor::ViewPrivate *>(view)->config()->wordCompletionMinimalWordLength());
-    const int lines = view->document()->lines();
-    for (int line = 0; line < lines; line++) {
-        const QString &text = view->document()->line(line);
-        int wordBegin = 0;
-        int offset = 0;
-        const int end = text.size();
-        const bool cursorLine = view->cursorPosition().line() == line;
-        while (offset < end) {
-            const QChar c = text.at(offset);
-            // increment offset when at line end, so we take the last character too
-            if ((! c.isLetterOrNumber() && c != QLatin1Char('_')) || (offset == end - 1 && offset++)) {
-                if (offset - wordBegin > minWordSize && (line != range.end().line() || offset != range.end().column())) {
-                    /**
-                     * don't add the word we are inside with cursor!
-                     */
-                    if (!cursorLine || (view->cursorPosition().column() < wordBegin || view->cursorPosition().column() > offset)) {
-                        result.insert(text.mid(wordBegin, offset - wordBegin));
-                    }
-                }
-                wordBegin = offset + 1;
-            }
-            if (c.isSpace()) {
-                wordBegin = offset + 1;
-            }
-            offset += 1;
+    const KTextEditor::Cursor cursor = view->cursorPosition();
+    const QString text = view->doc()->line(cursor.line());
+
+    QHash<QString, int> typedCount;
+    KateWordIndex::forEachWord(text, [&](int start, int length) {
+        const bool atRangeEnd = cursor.line() == range.end().line() && start + length == range.end().column();
+        const bool atCursor = cursor.column() >= start && cursor.column() <= start + length;
+        if (atRangeEnd || atCursor) {
+            ++typedCount[text.mid(start, length)];
+        }
+    });
+
+    // drop the word if there are no other occurrences, neither here nor in other documents
+    KateWordIndex *index = view->doc()->wordIndex();
+    KateWordDictionary *dictionary = KTextEditor::EditorPrivate::self()->wordDictionary();
+    for (auto it = typedCount.constBegin(); it != typedCount.constEnd(); ++it) {
+        if (index->count(it.key()) > it.value() || dictionary->documentCount(it.key()) > 1) {
+            continue;
+        }
+        auto word = std::lower_bound(words.begin(), words.end(), it.key());
+        if (word != words.end() && *word == it.key()) {
+            words.erase(word);
         }
     }
-    return result.values();
+}
+
+/**
+ * Fetch the words of all open documents from the global word dictionary
+ * that start with the text inside @p range in any case, the completion
+ * filters them further while typing. Ignores any dublets and words shorter
+ * than configured and/or reasonable minimum length.
+ */
+QStringList KateWordCompletionModel::allMatches(KTextEditor::View *view, const KTextEditor::Range &range) const
+{
+    KTextEditor::ViewPrivate *v = qobject_cast<KTextEditor::ViewPrivate *>(view);
+    const int minWordSize = qMax(2, v->config()->wordCompletionMinimalWordLength());
+    QStringList result = KTextEditor::EditorPrivate::self()->wordDictionary()->wordsWithPrefix(view->document()->text(range), minWordSize, Qt::CaseInsensitive);
+    removeWordsBeingTyped(result, v, range);
+    return result;
+}
+
+/**
+ * Like allMatches(), but only the words starting with the text inside @p range in the same case.
+ */
+QStringList KateWordCompletionModel::prefixMatches(KTextEditor::View *view, const KTextEditor::Range &range) const
+{
+    KTextEditor::ViewPrivate *v = qobject_cast<KTextEditor::ViewPrivate *>(view);
+    const int minWordSize = qMax(2, v->config()->wordCompletionMinimalWordLength());
+    QStringList result = KTextEditor::EditorPrivate::self()->wordDictionary()->wordsWithPrefix(view->document()->text(range), minWordSize);
+    removeWordsBeingTyped(result, v, range);
+    return result;
 }
 
 void KateWordCompletionModel::executeCompletionItem(KTextEditor::View *view, const KTextEditor::Range &word, const QModelIndex &index) const
@@ -391,7 +421,7 @@ void KateWordCompletionView::shellComplete()
 {
     KTextEditor::Range r = range();
 
-    QStringList matches = m_dWCompletionModel->allMatches(m_view, r);
+    QStringList matches = m_dWCompletionModel->prefixMatches(m_view, r);
 
     if (matches.size() == 0) {
         return;
@@ -71,11 +71,13 @@ public:
     bool shouldHideItemsWithEqualNames() const override;
 
     QStringList allMatches(KTextEditor::View *view, const KTextEditor::Range &range) const;
+    QStringList prefixMatches(KTextEditor::View *view, const KTextEditor::Range &range) const;
 
     void executeCompletionItem(KTextEditor::View *view, const KTextEditor::Range &word, const QModelIndex &index) const override;
 
 private:
     QStringList m_matches;
+    QString m_matchesPrefix; ///< the matches are the words starting with this
     bool m_automatic;
 };
 
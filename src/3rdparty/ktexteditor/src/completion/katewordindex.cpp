@@ -0,0 +1,215 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "katewordindex.h"
+#include "katebuffer.h"
+#include "katedocument.h"
+#include "kateglobal.h"
+
+// BEGIN KateWordDictionary
+QString KateWordDictionary::ref(const QString &word)
+{
+    auto it = m_documentCounts.find(word);
+    if (it == m_documentCounts.end()) {
+        it = m_documentCounts.insert(word, 0);
+    }
+    ++it.value();
+    return it.key();
+}
+
+void KateWordDictionary::deref(const QString &word)
+{
+    auto it = m_documentCounts.find(word);
+    Q_ASSERT(it != m_documentCounts.end());
+    if (--it.value() == 0) {
+        m_documentCounts.erase(it);
+    }
+}
+
+int KateWordDictionary::documentCount(const QString &word) const
+{
+    return m_documentCounts.value(word, 0);
+}
+
+QStringList KateWordDictionary::wordsWithPrefix(const QString &prefix, int minWordSize, Qt::CaseSensitivity caseSensitivity)
+{
+    indexAllDocuments();
+
+    // all words with the given prefix follow each other in the sorted map,
+    // if case insensitive, there is one such run per case of the first character
+    QStringList starts(prefix);
+    if (caseSensitivity == Qt::CaseInsensitive && !prefix.isEmpty()) {
+        const QChar first = prefix.at(0);
+        starts = QStringList{QString(first.toLower()), QString(first.toUpper()), QString(first.toTitleCase())};
+        starts.sort();
+        starts.removeDuplicates();
+    }
+
+    // the runs are visited in sorted order, so are the results
+    QStringList result;
+    for (const QString &start : qAsConst(starts)) {
+        for (auto it = m_documentCounts.lowerBound(start); it != m_documentCounts.constEnd() && it.key().startsWith(start); ++it) {
+            if (it.key().size() > minWordSize && it.key().startsWith(prefix, caseSensitivity)) {
+                result.append(it.key());
+            }
+        }
+    }
+    return result;
+}
+
+void KateWordDictionary::indexAllDocuments()
+{
+    const auto documents = KTextEditor::EditorPrivate::self()->kateDocuments();
+    for (KTextEditor::DocumentPrivate *document : documents) {
+        document->wordIndex()->ensureValid();
+    }
+}
+// END KateWordDictionary
+
+// BEGIN KateWordIndex
+KateWordIndex::KateWordIndex(KTextEditor::DocumentPrivate *document)
+    : QObject(document)
+    , m_document(document)
+    , m_dictionary(KTextEditor::EditorPrivate::self()->wordDictionary())
+{
+    KateBuffer &buffer = m_document->buffer();
+
+    // load and clear bypass the edit signals, just rebuild on next use
+    connect(&buffer, SIGNAL(cleared()), this, SLOT(invalidate()));
+    connect(&buffer, SIGNAL(loaded(QString, bool)), this, SLOT(invalidate()));
+
+    // keep the per-line word lists aligned with the lines of the buffer
+    connect(&buffer, SIGNAL(lineWrapped(KTextEditor::Cursor)), this, SLOT(wrapLine(KTextEditor::Cursor)));
+    connect(&buffer, SIGNAL(lineUnwrapped(int)), this, SLOT(unwrapLine(int)));
+
+    // re-tokenize the touched lines once per transaction
+    connect(&buffer, SIGNAL(editingFinished()), this, SLOT(editingFinished()));
+}
+
+KateWordIndex::~KateWordIndex()
+{
+    invalidate();
+}
+
+int KateWordIndex::count(const QString &word)
+{
+    ensureValid();
+    return m_wordCounts.value(word, 0);
+}
+
+void KateWordIndex::invalidate()
+{
+    // one dereference per distinct word of this document
+    for (auto it = m_wordCounts.constBegin(); it != m_wordCounts.constEnd(); ++it) {
+        m_dictionary->deref(it.key());
+    }
+
+    m_valid = false;
+    m_lineWords.clear();
+    m_wordCounts.clear();
+}
+
+void KateWordIndex::wrapLine(const KTextEditor::Cursor &position)
+{
+    if (!m_valid) {
+        return;
+    }
+
+    // new line starts empty, both lines are re-tokenized at the end of the transaction
+    m_lineWords.insert(position.line() + 1, QStringList());
+}
+
+void KateWordIndex::unwrapLine(int line)
+{
+    if (!m_valid) {
+        return;
+    }
+
+    // the text of the line moved to line - 1, which is re-tokenized at the end of the transaction
+    removeWords(m_lineWords.at(line));
+    m_lineWords.remove(line);
+}
+
+void KateWordIndex::editingFinished()
+{
+    const KateBuffer &buffer = m_document->buffer();
+    if (!m_valid || !buffer.editingChangedBuffer()) {
+        return;
+    }
+
+    Q_ASSERT(m_lineWords.size() == buffer.lines());
+    updateLines(buffer.editingMinimalLineChanged(), buffer.editingMaximalLineChanged());
+}
+
+void KateWordIndex::ensureValid()
+{
+    if (m_valid) {
+        return;
+    }
+
+    m_lineWords.fill(QStringList(), m_document->buffer().lines());
+    m_valid = true;
+    updateLines(0, m_lineWords.size() - 1);
+}
+
+void KateWordIndex::updateLines(int startLine, int endLine)
+{
+    const KateBuffer &buffer = m_document->buffer();
+    for (int line = startLine; line <= endLine; ++line) {
+        const Kate::TextLine textLine = buffer.line(line);
+        const QString &text = textLine->string();
+
+        QStringList words;
+        forEachWord(text, [&words, &text](int start, int length) {
+            words.append(text.mid(start, length));
+        });
+
+        // add before remove, unchanged words keep their dictionary entry
+        addWords(words);
+        removeWords(m_lineWords.at(line));
+        m_lineWords[line] = words;
+    }
+}
+
+void KateWordIndex::addWords(QStringList &words)
+{
+    // let the line lists share the strings of the dictionary
+    for (QString &word : words) {
+        auto it = m_wordCounts.find(word);
+        if (it == m_wordCounts.end()) {
+            it = m_wordCounts.insert(m_dictionary->ref(word), 0);
+        }
+        ++it.value();
+        word = it.key();
+    }
+}
+
+void KateWordIndex::removeWords(const QStringList &words)
+{
+    for (const QString &word : words) {
+        auto it = m_wordCounts.find(word);
+        Q_ASSERT(it != m_wordCounts.end());
+        if (--it.value() == 0) {
+            m_dictionary->deref(it.key());
+            m_wordCounts.erase(it);
+        }
+    }
+}
+// END KateWordIndex
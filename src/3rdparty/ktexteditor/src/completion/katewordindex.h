@@ -0,0 +1,199 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_WORDINDEX_H
+#define KATE_WORDINDEX_H
+
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <ktexteditor/cursor.h>
+
+namespace KTextEditor
+{
+class DocumentPrivate;
+}
+
+/**
+ * Dictionary of the words of all open documents, shared by all views.
+ *
+ * Each document's KateWordIndex references every distinct word it contains once,
+ * the dictionary keeps the number of documents containing each word in a sorted map.
+ * The map keys are the only copies of the word strings, the per-document indices
+ * share them. Closing a document dereferences its distinct words only.
+ */
+class KateWordDictionary
+{
+public:
+    /**
+     * Reference the given word for one more document.
+     * @param word word to reference
+     * @return the shared copy of the word
+     */
+    QString ref(const QString &word);
+
+    /**
+     * Release the reference of one document on the given word.
+     * The word is dropped if no document contains it anymore.
+     * @param word word to dereference
+     */
+    void deref(const QString &word);
+
+    /**
+     * Number of open documents containing the given word.
+     * @param word word to look up
+     * @return document count, 0 if the word is unknown
+     */
+    int documentCount(const QString &word) const;
+
+    /**
+     * All distinct words of all open documents starting with @p prefix and having more
+     * than @p minWordSize characters. Runs in O(log n + k) for k words visited, these are
+     * the results if case sensitive, else all words starting with the first character in any case.
+     * @param prefix wanted prefix
+     * @param minWordSize words must be longer than this
+     * @param caseSensitivity how to compare the prefix
+     * @return words in sorted order
+     */
+    QStringList wordsWithPrefix(const QString &prefix, int minWordSize, Qt::CaseSensitivity caseSensitivity = Qt::CaseSensitive);
+
+private:
+    /**
+     * Let all open documents index their words, documents already indexed are skipped.
+     */
+    void indexAllDocuments();
+
+private:
+    /**
+     * all words, sorted, with the number of documents containing them
+     */
+    QMap<QString, int> m_documentCounts;
+};
+
+/**
+ * Index of all words of one document, feeding the global KateWordDictionary.
+ *
+ * For every line the words found in it are remembered, all words are reference
+ * counted in one map. The index is built lazily on first use and then kept
+ * up-to-date by re-tokenizing only the lines touched by each editing transaction.
+ *
+ * A word is a maximal run of letters, numbers and underscores with at least
+ * MinimalWordLength characters.
+ */
+class KateWordIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Shortest word that is indexed, the completion never offers shorter ones.
+     */
+    static const int MinimalWordLength = 3;
+
+    /**
+     * Construct the index for the given document.
+     * Nothing is scanned before the first query.
+     * @param document document to index, will be our parent
+     */
+    explicit KateWordIndex(KTextEditor::DocumentPrivate *document);
+
+    /**
+     * Destruct the index, releases all words in the global dictionary.
+     */
+    ~KateWordIndex() override;
+
+    /**
+     * Number of occurrences of the given word inside the document.
+     * @param word word to look up
+     * @return reference count, 0 if the word is unknown
+     */
+    int count(const QString &word);
+
+    /**
+     * Build the index for the whole document, if it is not valid.
+     */
+    void ensureValid();
+
+    /**
+     * Call @p func with start column and length of each word in @p text.
+     * This is the tokenizer used for the index, exported to keep the rest of the
+     * word completion consistent with it.
+     */
+    template<typename Func> static void forEachWord(const QString &text, Func func)
+    {
+        const int end = text.size();
+        int wordBegin = -1;
+        for (int offset = 0; offset <= end; ++offset) {
+            const bool wordChar = offset < end && (text.at(offset).isLetterOrNumber() || text.at(offset) == QLatin1Char('_'));
+            if (wordChar && wordBegin < 0) {
+                wordBegin = offset;
+            } else if (!wordChar && wordBegin >= 0) {
+                if (offset - wordBegin >= MinimalWordLength) {
+                    func(wordBegin, offset - wordBegin);
+                }
+                wordBegin = -1;
+            }
+        }
+    }
+
+private Q_SLOTS:
+    void invalidate();
+    void wrapLine(const KTextEditor::Cursor &position);
+    void unwrapLine(int line);
+    void editingFinished();
+
+private:
+    /**
+     * Re-tokenize the given lines and update the reference counts.
+     */
+    void updateLines(int startLine, int endLine);
+
+    void addWords(QStringList &words);
+    void removeWords(const QStringList &words);
+
+private:
+    KTextEditor::DocumentPrivate *const m_document;
+
+    /**
+     * global dictionary we feed
+     */
+    KateWordDictionary *const m_dictionary;
+
+    /**
+     * words per line, aligned with the lines of the buffer
+     */
+    QVector<QStringList> m_lineWords;
+
+    /**
+     * all words of this document with their reference count
+     */
+    QHash<QString, int> m_wordCounts;
+
+    /**
+     * is the index in sync with the buffer?
+     */
+    bool m_valid = false;
+};
+
+#endif
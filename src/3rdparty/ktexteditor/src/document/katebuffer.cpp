@@ -53,6 +53,8 @@ KateBuffer::KateBuffer(KTextEditor::DocumentPrivate *doc)
     , m_brokenEncoding(false)
     , m_tooLongLinesWrapped(false)
     , m_longestLineLoaded(0)
+    , m_tooLongLineLimit(0)
+    , m_tooLongLineCount(0)
     , m_highlight(nullptr)
     , m_tabWidth(8)
     , m_lineHighlighted(0)
@@ -140,12 +142,13 @@ void KateBuffer::clear()
     m_brokenEncoding = false;
     m_tooLongLinesWrapped = false;
     m_longestLineLoaded = 0;
+    m_tooLongLineCount = 0;
 
     // back to line 0 with hl
     m_lineHighlighted = 0;
 }
 
-bool KateBuffer::openFile(const QString &m_file, bool enforceTextCodec)
+Kate::TextBuffer::LoadStatus KateBuffer::openFile(const QString &m_file, bool enforceTextCodec)
 {
     // first: setup fallback and normal encoding
     setEncodingProberType(KateGlobalConfig::global()->proberType());
@@ -158,8 +161,8 @@ bool KateBuffer::openFile(const QString &m_file, bool enforceTextCodec)
     // NOTE: we do not remove trailing spaces on load. This was discussed
     //       over the years again and again. bugs: 306926, 239077, ...
 
-    // line length limit
-    setLineLengthLimit(m_doc->lineLengthLimit());
+    // keep all lines as they are, too long ones are only laid out around the visible part by the renderer
+    setLineLengthLimit(0);
 
     // then, try to load the file
     m_brokenEncoding = false;
@@ -182,7 +185,7 @@ bool KateBuffer::openFile(const QString &m_file, bool enforceTextCodec)
         // remember error
         m_doc->m_openingError = true;
         m_doc->m_openingErrorMessage = i18n("The file %1 does not exist.", m_doc->url().toString());
-        return true;
+        return LoadFinished;
     }
 
     /**
@@ -191,14 +194,33 @@ bool KateBuffer::openFile(const QString &m_file, bool enforceTextCodec)
      */
     if (!QFileInfo(m_file).isFile()) {
         clear();
-        return false;
+        return LoadFailed;
     }
 
     /**
      * try to load
      */
-    if (!load(m_file, m_brokenEncoding, m_tooLongLinesWrapped, m_longestLineLoaded, enforceTextCodec)) {
-        return false;
+    beginLoad(m_file, enforceTextCodec);
+    return LoadRunning;
+}
+
+Kate::TextBuffer::LoadStatus KateBuffer::continueOpenFile(int maximalLines)
+{
+    const LoadStatus status = continueLoad(maximalLines, m_brokenEncoding, m_tooLongLinesWrapped, m_longestLineLoaded);
+    if (status == LoadRunning) {
+        return status;
+    }
+
+    // whatever was read, without any too long line there is nothing to count
+    m_tooLongLineLimit = m_doc->config()->lineLengthLimit();
+    if (isTooLong(m_longestLineLoaded)) {
+        countTooLongLines();
+    } else {
+        m_tooLongLineCount = 0;
+    }
+
+    if (status != LoadFinished) {
+        return status;
     }
 
     // save back encoding
@@ -215,7 +237,7 @@ bool KateBuffer::openFile(const QString &m_file, bool enforceTextCodec)
     }
 
     // okay, loading did work
-    return true;
+    return LoadFinished;
 }
 
 bool KateBuffer::canEncode()
@@ -289,11 +311,50 @@ void KateBuffer::ensureHighlighted(int line, int lookAhead)
     doHighlight(m_lineHighlighted, end, false);
 }
 
+int KateBuffer::highlightedLines() const
+{
+    if (!m_highlight || m_highlight->noHighlighting()) {
+        return lines();
+    }
+
+    return qMin(m_lineHighlighted, lines());
+}
+
+void KateBuffer::setTooLongLineLimit(int lineLengthLimit)
+{
+    if (lineLengthLimit == m_tooLongLineLimit) {
+        return;
+    }
+
+    m_tooLongLineLimit = lineLengthLimit;
+    countTooLongLines();
+}
+
+void KateBuffer::countTooLongLines()
+{
+    m_tooLongLineCount = 0;
+    if (m_tooLongLineLimit <= 0) {
+        return;
+    }
+
+    for (int i = 0; i < lines(); ++i) {
+        if (isTooLong(line(i)->length())) {
+            ++m_tooLongLineCount;
+        }
+    }
+}
+
 void KateBuffer::wrapLine(const KTextEditor::Cursor &position)
 {
+    const bool wasTooLong = m_tooLongLineLimit > 0 && isTooLong(line(position.line())->length());
+
     // call original
     Kate::TextBuffer::wrapLine(position);
 
+    if (m_tooLongLineLimit > 0) {
+        m_tooLongLineCount += int(isTooLong(line(position.line())->length())) + int(isTooLong(line(position.line() + 1)->length())) - int(wasTooLong);
+    }
+
     if (m_lineHighlighted > position.line() + 1) {
         m_lineHighlighted++;
     }
@@ -301,14 +362,42 @@ void KateBuffer::wrapLine(const KTextEditor::Cursor &position)
 
 void KateBuffer::unwrapLine(int line)
 {
+    const int wereTooLong = (m_tooLongLineLimit > 0) ? int(isTooLong(this->line(line - 1)->length())) + int(isTooLong(this->line(line)->length())) : 0;
+
     // reimplemented, so first call original
     Kate::TextBuffer::unwrapLine(line);
 
+    if (m_tooLongLineLimit > 0) {
+        m_tooLongLineCount += int(isTooLong(this->line(line - 1)->length())) - wereTooLong;
+    }
+
     if (m_lineHighlighted > line) {
         --m_lineHighlighted;
     }
 }
 
+void KateBuffer::insertText(const KTextEditor::Cursor &position, const QString &text)
+{
+    const bool wasTooLong = m_tooLongLineLimit > 0 && isTooLong(line(position.line())->length());
+
+    Kate::TextBuffer::insertText(position, text);
+
+    if (m_tooLongLineLimit > 0 && !wasTooLong && isTooLong(line(position.line())->length())) {
+        ++m_tooLongLineCount;
+    }
+}
+
+void KateBuffer::removeText(const KTextEditor::Range &range)
+{
+    const bool wasTooLong = m_tooLongLineLimit > 0 && isTooLong(line(range.start().line())->length());
+
+    Kate::TextBuffer::removeText(range);
+
+    if (wasTooLong && !isTooLong(line(range.start().line())->length())) {
+        --m_tooLongLineCount;
+    }
+}
+
 void KateBuffer::setTabWidth(int w)
 {
     if ((m_tabWidth != w) && (m_tabWidth > 0)) {
@@ -416,6 +505,9 @@ void KateBuffer::doHighlight(int startLine, int endLine, bool invalidate)
         textLine = nextLine;
     }
 
+    // the attributes of the brackets might have changed
+    invalidateBracketBalances(startLine, current_line - 1);
+
     /**
      * perhaps we need to adjust the maximal highlighted line
      */
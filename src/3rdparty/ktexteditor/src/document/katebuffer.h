@@ -112,12 +112,21 @@ public:
     void clear() override;
 
     /**
-     * Open a file, use the given filename
+     * Open a file, use the given filename.
+     * This only starts the load, the lines are read by continueOpenFile().
      * @param m_file filename to open
      * @param enforceTextCodec enforce to use only the set text codec
-     * @return success
+     * @return LoadRunning if lines are to be read, else success or failure
      */
-    bool openFile(const QString &m_file, bool enforceTextCodec);
+    LoadStatus openFile(const QString &m_file, bool enforceTextCodec);
+
+    /**
+     * Read further lines of the file opened by openFile().
+     * On success, encoding, eol mode and bom are stored back into the document config.
+     * @param maximalLines read at most this many lines of the file
+     * @return LoadRunning while lines are left, else success or failure
+     */
+    LoadStatus continueOpenFile(int maximalLines);
 
     /**
      * Did encoding errors occur on load?
@@ -142,6 +151,21 @@ public:
         return m_longestLineLoaded;
     }
 
+    /**
+     * Are there lines longer than the line length limit? Kept up to date while editing.
+     * @return too long lines present?
+     */
+    bool hasTooLongLines() const
+    {
+        return m_tooLongLineCount > 0;
+    }
+
+    /**
+     * Set the limit for hasTooLongLines(), the lines are counted anew if it changed.
+     * @param lineLengthLimit lines longer than this are too long, none are if <= 0
+     */
+    void setTooLongLineLimit(int lineLengthLimit);
+
     /**
      * Can the current codec handle all chars
      * @return chars can be encoded
@@ -181,6 +205,13 @@ public:
      */
     void ensureHighlighted(int line, int lookAhead = 64);
 
+    /**
+     * Number of lines from the start of the buffer whose highlighting is up to date.
+     * Without highlighting, the attributes of all lines are final.
+     * @return number of highlighted lines
+     */
+    int highlightedLines() const;
+
     /**
      * Return the total number of lines in the buffer.
      */
@@ -201,6 +232,19 @@ public:
      */
     void wrapLine(const KTextEditor::Cursor &position) override;
 
+    /**
+     * Insert text at given cursor position.
+     * @param position position where to insert text
+     * @param text text to insert
+     */
+    void insertText(const KTextEditor::Cursor &position, const QString &text) override;
+
+    /**
+     * Remove text at given range.
+     * @param range range of text to remove, must be on one line only.
+     */
+    void removeText(const KTextEditor::Range &range) override;
+
 public:
     inline int tabWidth() const
     {
@@ -247,6 +291,19 @@ private:
      */
     void doHighlight(int from, int to, bool invalidate);
 
+    /**
+     * Count the lines longer than m_tooLongLineLimit.
+     */
+    void countTooLongLines();
+
+    /**
+     * Is a line of the given length longer than m_tooLongLineLimit?
+     */
+    bool isTooLong(int length) const
+    {
+        return m_tooLongLineLimit > 0 && length > m_tooLongLineLimit;
+    }
+
 Q_SIGNALS:
     /**
      * Emitted when the highlighting of a certain range has
@@ -276,6 +333,16 @@ private:
      */
     int m_longestLineLoaded;
 
+    /**
+     * lines longer than this are too long, none are if <= 0
+     */
+    int m_tooLongLineLimit;
+
+    /**
+     * number of lines longer than m_tooLongLineLimit
+     */
+    int m_tooLongLineCount;
+
     /**
      * current highlighting mode or 0
      */
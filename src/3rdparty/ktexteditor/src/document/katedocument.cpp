@@ -33,6 +33,7 @@
 #include "katedialogs.h"
 #include "kateglobal.h"
 #include "katehighlight.h"
+#include "katelinediff.h"
 #include "katemodemanager.h"
 #include "katepartdebug.h"
 #include "kateplaintextsearch.h"
@@ -47,6 +48,7 @@
 #include "kateundomanager.h"
 #include "katevariableexpansionmanager.h"
 #include "kateview.h"
+#include "katewordindex.h"
 #include "printing/kateprinter.h"
 #include "spellcheck/ontheflycheck.h"
 #include "spellcheck/prefixstore.h"
@@ -60,8 +62,10 @@
 #include <KTextEditor/DocumentCursor>
 
 #include <KCodecs>
+#include <KCompressionDevice>
 #include <KConfigGroup>
 #include <KFileItem>
+#include <KFilterDev>
 #include <KIO/Job>
 #include <KIO/JobUiDelegate>
 #include <KJobWidgets>
@@ -77,6 +81,7 @@
 #include <QApplication>
 #include <QClipboard>
 #include <QCryptographicHash>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileDialog>
 #include <QMap>
@@ -88,6 +93,7 @@
 #include <QTimer>
 
 #include <cmath>
+#include <limits>
 
 #if LIBGIT2_FOUND
 #include <git2.h>
@@ -278,6 +284,11 @@ KTextEditor::DocumentPrivate::DocumentPrivate(bool bSingleViewMode, bool bReadOn
     m_autoReloadThrottle.setInterval(KTextEditor::EditorPrivate::self()->unitTestMode() ? 50 : 3000);
     connect(&m_autoReloadThrottle, &QTimer::timeout, this, &DocumentPrivate::onModOnHdAutoReload);
 
+    // incremental load of large files, one slice of lines per event loop iteration
+    m_incrementalLoadTimer.setInterval(0);
+    connect(&m_incrementalLoadTimer, SIGNAL(timeout()), this, SLOT(continueIncrementalLoad()));
+    connect(m_buffer, SIGNAL(loadProgress(qint64, qint64)), this, SLOT(slotLoadProgress(qint64, qint64)));
+
     /**
      * load handling
      * this is needed to ensure we signal the user if a file ist still loading
@@ -928,6 +939,52 @@ bool KTextEditor::DocumentPrivate::insertLines(int line, const QStringList &text
     return success;
 }
 
+bool KTextEditor::DocumentPrivate::replaceLines(int fromLine, int toLine, const QStringList &lines)
+{
+    if (!isReadWrite()) {
+        return false;
+    }
+
+    if (fromLine < 0 || toLine < fromLine || toLine > lastLine()) {
+        return false;
+    }
+
+    // skip the unchanged lines at both ends
+    const int oldCount = toLine - fromLine + 1;
+    int head = 0;
+    while (head < oldCount && head < lines.size() && line(fromLine + head) == lines.at(head)) {
+        ++head;
+    }
+    int tail = 0;
+    while (tail < oldCount - head && tail < lines.size() - head && line(toLine - tail) == lines.at(lines.size() - 1 - tail)) {
+        ++tail;
+    }
+    if (head + tail == oldCount && head + tail == lines.size()) {
+        return true;
+    }
+
+    const int from = fromLine + head;
+    const int to = toLine - tail;
+    const QStringList newLines = lines.mid(head, lines.size() - head - tail);
+
+    editStart();
+    bool success;
+    if (from > to) {
+        // only new lines in front of line from
+        success = insertLines(from, newLines);
+    } else if (!newLines.isEmpty()) {
+        success = replaceText(KTextEditor::Range(from, 0, to, lineLength(to)), newLines, false);
+    } else if (to < lastLine()) {
+        success = removeText(KTextEditor::Range(from, 0, to + 1, 0));
+    } else if (from > 0) {
+        success = removeText(KTextEditor::Range(from - 1, lineLength(from - 1), to, lineLength(to)));
+    } else {
+        success = removeText(KTextEditor::Range(from, 0, to, lineLength(to)));
+    }
+    editEnd();
+    return success;
+}
+
 bool KTextEditor::DocumentPrivate::removeLine(int line)
 {
     if (!isReadWrite()) {
@@ -1073,6 +1130,11 @@ bool KTextEditor::DocumentPrivate::editEnd()
         view->editEnd(m_buffer->editTagStart(), m_buffer->editTagEnd(), m_buffer->editTagFrom());
     }
 
+    // the edit might have created the first or removed the last too long line
+    if (hasTooLongLines() != m_dynWordWrapHasTooLongLines) {
+        updateDynWordWrapForTooLongLines();
+    }
+
     if (m_buffer->editChanged()) {
         setModified(true);
         emit textChanged(this);
@@ -2195,6 +2257,7 @@ void KTextEditor::DocumentPrivate::clearMarks()
 void KTextEditor::DocumentPrivate::setMarkPixmap(MarkInterface::MarkTypes type, const QPixmap &pixmap)
 {
     m_markIcons.insert(type, QVariant::fromValue(pixmap));
+    ++m_markIconsRevision;
 }
 
 void KTextEditor::DocumentPrivate::setMarkDescription(MarkInterface::MarkTypes type, const QString &description)
@@ -2237,6 +2300,7 @@ uint KTextEditor::DocumentPrivate::editableMarks() const
 void KTextEditor::DocumentPrivate::setMarkIcon(MarkInterface::MarkTypes markType, const QIcon &icon)
 {
     m_markIcons.insert(markType, QVariant::fromValue(icon));
+    ++m_markIconsRevision;
 }
 
 QIcon KTextEditor::DocumentPrivate::markIcon(MarkInterface::MarkTypes markType) const
@@ -2305,33 +2369,52 @@ void KTextEditor::DocumentPrivate::showAndSetOpeningErrorAccess()
 }
 // END: error
 
-void KTextEditor::DocumentPrivate::openWithLineLengthLimitOverride()
+int KTextEditor::DocumentPrivate::lineLengthLimit() const
 {
-    // raise line length limit to the next power of 2
-    const int longestLine = m_buffer->longestLineLoaded();
-    int newLimit = pow(2, ceil(log2(longestLine)));
-    if (newLimit <= longestLine) {
-        newLimit *= 2;
-    }
+    return config()->lineLengthLimit();
+}
 
-    // do the raise
-    config()->setLineLengthLimit(newLimit);
+bool KTextEditor::DocumentPrivate::hasTooLongLines() const
+{
+    return m_buffer->hasTooLongLines();
+}
 
-    // just reload
-    m_buffer->clear();
-    openFile();
-    if (!m_openingError) {
-        setReadWrite(true);
-        m_readWriteStateBeforeLoading = true;
+void KTextEditor::DocumentPrivate::updateDynWordWrapForTooLongLines()
+{
+    // too long lines are laid out in windows, that needs horizontal scrolling, see KateRenderer::layoutLine()
+    m_dynWordWrapHasTooLongLines = hasTooLongLines();
+    for (auto view : qAsConst(m_views)) {
+        if (m_dynWordWrapHasTooLongLines && view->config()->dynWordWrap()) {
+            view->config()->setDynWordWrap(false);
+            m_viewsWithoutDynWordWrap.insert(view);
+        } else if (!m_dynWordWrapHasTooLongLines && m_viewsWithoutDynWordWrap.remove(view) && !view->config()->dynWordWrap()) {
+            view->config()->setDynWordWrap(true);
+        }
     }
 }
 
-int KTextEditor::DocumentPrivate::lineLengthLimit() const
+// BEGIN KParts::ReadWrite stuff
+namespace
 {
-    return config()->lineLengthLimit();
+/**
+ * lines read per step of an incremental load and time after which a slice ends
+ */
+const int incrementalLoadLines = 4096;
+const qint64 incrementalLoadSliceMilliseconds = 20;
+
+Kate::TextBuffer::LoadStatus loadSlice(KateBuffer &buffer)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Kate::TextBuffer::LoadStatus status;
+    do {
+        status = buffer.continueOpenFile(incrementalLoadLines);
+    } while (status == Kate::TextBuffer::LoadRunning && !timer.hasExpired(incrementalLoadSliceMilliseconds));
+    return status;
+}
 }
 
-// BEGIN KParts::ReadWrite stuff
 bool KTextEditor::DocumentPrivate::openFile()
 {
     /**
@@ -2370,14 +2453,87 @@ bool KTextEditor::DocumentPrivate::openFile()
         setEncoding(currentEncoding);
     }
 
-    bool success = m_buffer->openFile(localFilePath(), (m_reloading && m_userSetEncodingForNextReload));
+    Kate::TextBuffer::LoadStatus status = m_buffer->openFile(localFilePath(), (m_reloading && m_userSetEncodingForNextReload));
+
+    //
+    // large files are shown after the first slice of lines, the rest is read from the event loop
+    // not for reloads, they restore cursors and marks right after openFile() is done
+    //
+    const qint64 incrementalLoadLimit = qint64(config()->incrementalLoadLimit()) * 1024 * 1024;
+    if (status == Kate::TextBuffer::LoadRunning && m_documentState == DocumentLoading && !m_reloading && incrementalLoadLimit > 0 &&
+        QFileInfo(localFilePath()).size() >= incrementalLoadLimit) {
+        status = loadSlice(*m_buffer);
+        if (status == Kate::TextBuffer::LoadRunning) {
+            // no editing before the file is complete, slotCompleted() will not restore the read-write mode before
+            m_loadedFileSize = -1;
+            setReadWrite(false);
+            m_incrementalLoadTimer.start();
+            QTimer::singleShot(1000, this, SLOT(slotTriggerLoadingMessage()));
+
+            for (auto view : qAsConst(m_views)) {
+                view->setCursorPosition(KTextEditor::Cursor());
+                view->updateView(true);
+            }
+            return true;
+        }
+    }
+
+    while (status == Kate::TextBuffer::LoadRunning) {
+        status = m_buffer->continueOpenFile(std::numeric_limits<int>::max());
+    }
+
+    return finishOpenFile(status == Kate::TextBuffer::LoadFinished, true);
+}
+
+void KTextEditor::DocumentPrivate::continueIncrementalLoad()
+{
+    const Kate::TextBuffer::LoadStatus status = loadSlice(*m_buffer);
+    if (status == Kate::TextBuffer::LoadRunning) {
+        // let the views pick up the new lines
+        for (auto view : qAsConst(m_views)) {
+            view->updateView(true);
+        }
+        return;
+    }
+
+    m_incrementalLoadTimer.stop();
+    const bool success = finishOpenFile(status == Kate::TextBuffer::LoadFinished, false);
+
+    // like KParts does after a synchronous openFile(), restores the read-write mode
+    if (success) {
+        slotCompleted();
+    } else {
+        slotCanceled();
+    }
+}
+
+void KTextEditor::DocumentPrivate::slotLoadProgress(qint64 bytesRead, qint64 bytesTotal)
+{
+    const int percent = bytesTotal > 0 ? int(bytesRead * 100 / bytesTotal) : 100;
+    emit loadingProgress(this, percent);
+
+    if (m_loadingMessage) {
+        m_loadingMessage->setText(i18n("The file <a href=\"%1\">%2</a> is still loading (%3%).", url().toDisplayString(QUrl::PreferLocalFile), url().fileName(), percent));
+    }
+}
+
+void KTextEditor::DocumentPrivate::cancelIncrementalLoad()
+{
+    m_incrementalLoadTimer.stop();
+    m_buffer->cancelLoad();
+}
 
+bool KTextEditor::DocumentPrivate::finishOpenFile(bool success, bool resetViews)
+{
     //
     // yeah, success
     // read variables
     //
     if (success) {
         readVariables();
+        rememberLoadedFileState();
+    } else {
+        m_loadedFileSize = -1;
     }
 
     //
@@ -2385,7 +2541,9 @@ bool KTextEditor::DocumentPrivate::openFile()
     //
     for (auto view : qAsConst(m_views)) {
         // This is needed here because inserting the text moves the view's start position (it is a MovingCursor)
-        view->setCursorPosition(KTextEditor::Cursor());
+        if (resetViews) {
+            view->setCursorPosition(KTextEditor::Cursor());
+        }
         view->updateView(true);
     }
 
@@ -2434,34 +2592,18 @@ bool KTextEditor::DocumentPrivate::openFile()
             QString::fromLatin1(m_buffer->textCodec()->name()));
     }
 
-    // warn: too long lines
-    if (m_buffer->tooLongLinesWrapped()) {
-        // this file can't be saved again without modifications
-        setReadWrite(false);
-        m_readWriteStateBeforeLoading = false;
-        QPointer<KTextEditor::Message> message = new KTextEditor::Message(i18n("The file %1 was opened and contained lines longer than the configured Line Length Limit (%2 characters).<br />"
-                                                                               "The longest of those lines was %3 characters long<br/>"
-                                                                               "Those lines were wrapped and the document is set to read-only mode, as saving will modify its content.",
+    // inform: too long lines, they are kept as they are, but only laid out around the visible part
+    if (hasTooLongLines()) {
+        QPointer<KTextEditor::Message> message = new KTextEditor::Message(i18n("The file %1 contains lines longer than the configured Line Length Limit (%2 characters).<br />"
+                                                                               "The longest of those lines is %3 characters long.<br />"
+                                                                               "Those lines are only laid out around the visible part and dynamic word wrap is turned off for this document.",
                                                                                this->url().toDisplayString(QUrl::PreferLocalFile),
                                                                                config()->lineLengthLimit(),
                                                                                m_buffer->longestLineLoaded()),
-                                                                          KTextEditor::Message::Warning);
-        QAction *increaseAndReload = new QAction(i18n("Temporarily raise limit and reload file"), message);
-        connect(increaseAndReload, SIGNAL(triggered()), this, SLOT(openWithLineLengthLimitOverride()));
-        message->addAction(increaseAndReload, true);
+                                                                          KTextEditor::Message::Information);
         message->addAction(new QAction(i18n("Close"), message), true);
         message->setWordWrap(true);
         postMessage(message);
-
-        // remember error
-        m_openingError = true;
-        m_openingErrorMessage = i18n(
-            "The file %1 was opened and contained lines longer than the configured Line Length Limit (%2 characters).<br/>"
-            "The longest of those lines was %3 characters long<br/>"
-            "Those lines were wrapped and the document is set to read-only mode, as saving will modify its content.",
-            this->url().toDisplayString(QUrl::PreferLocalFile),
-            config()->lineLengthLimit(),
-            m_buffer->longestLineLoaded());
     }
 
     //
@@ -2554,6 +2696,7 @@ bool KTextEditor::DocumentPrivate::saveFile()
 
     // update the checksum
     createDigest();
+    rememberLoadedFileState();
 
     // add m_file again to dirwatch
     activateDirWatch();
@@ -2832,6 +2975,12 @@ bool KTextEditor::DocumentPrivate::closeUrl()
         return false;
     }
 
+    // stop a still running incremental load, back to idle
+    if (m_buffer->isLoading()) {
+        cancelIncrementalLoad();
+        slotCompleted();
+    }
+
     // Tell the world that we're about to go ahead with the close
     if (!m_reloading) {
         emit aboutToClose(this);
@@ -2925,6 +3074,11 @@ void KTextEditor::DocumentPrivate::setReadWrite(bool rw)
         return;
     }
 
+    // no editing of a file still loading
+    if (rw && m_buffer->isLoading()) {
+        return;
+    }
+
     KParts::ReadWritePart::setReadWrite(rw);
 
     for (auto view : qAsConst(m_views)) {
@@ -2997,6 +3151,7 @@ void KTextEditor::DocumentPrivate::removeView(KTextEditor::View *view)
     Q_ASSERT(m_views.contains(view));
     m_views.remove(view);
     m_viewsCache.removeAll(view);
+    m_viewsWithoutDynWordWrap.remove(static_cast<KTextEditor::ViewPrivate *>(view));
 
     if (activeView() == view) {
         setActiveView(nullptr);
@@ -3382,7 +3537,7 @@ void KTextEditor::DocumentPrivate::backspace(KTextEditor::ViewPrivate *view, con
                     beginCursor.setColumn(col - 2);
                 }
             } else {
-                beginCursor.setColumn(view->textLayout(c)->previousCursorPosition(c.column()));
+                beginCursor.setColumn(view->previousCursorPosition(c));
             }
             removeText(KTextEditor::Range(beginCursor, endCursor));
             // in most cases cursor is moved by removeText, but we should do it manually
@@ -3430,7 +3585,7 @@ void KTextEditor::DocumentPrivate::del(KTextEditor::ViewPrivate *view, const KTe
     }
 
     if (c.column() < (int)m_buffer->plainLine(c.line())->length()) {
-        KTextEditor::Cursor endCursor(c.line(), view->textLayout(c)->nextCursorPosition(c.column()));
+        KTextEditor::Cursor endCursor(c.line(), view->nextCursorPosition(c));
         removeText(KTextEditor::Range(c, endCursor));
     } else if (c.line() < lastLine()) {
         removeText(KTextEditor::Range(c.line(), c.column(), c.line() + 1, 0));
@@ -4135,6 +4290,7 @@ void KTextEditor::DocumentPrivate::joinLines(uint first, uint last)
 void KTextEditor::DocumentPrivate::tagLines(int start, int end)
 {
     for (auto view : qAsConst(m_views)) {
+        view->invalidateDecorations(start, end);
         view->tagLines(start, end, true);
     }
 }
@@ -4189,43 +4345,63 @@ KTextEditor::Range KTextEditor::DocumentPrivate::findMatchingBracket(const KText
         return KTextEditor::Range::invalid();
     }
 
-    const int searchDir = isStartBracket(bracket) ? 1 : -1;
-    uint nesting = 0;
-
-    const int minLine = qMax(range.start().line() - maxLines, 0);
-    const int maxLine = qMin(range.start().line() + maxLines, documentEnd().line());
-
+    // only brackets highlighted like this one are its partners
     range.setEnd(range.start());
-    KTextEditor::DocumentCursor cursor(this);
-    cursor.setPosition(range.start());
-    int validAttr = kateTextLine(cursor.line())->attribute(cursor.column());
+    const short attribute = kateTextLine(range.start().line())->attribute(range.start().column());
 
-    while (cursor.line() >= minLine && cursor.line() <= maxLine) {
-        if (!cursor.move(searchDir)) {
+    if (isStartBracket(bracket)) {
+        const KTextEditor::Cursor match = findClosingBracket(KTextEditor::Cursor(range.start().line(), range.start().column() + 1), opposite, attribute, range.start().line() + maxLines);
+        if (!match.isValid()) {
+            return KTextEditor::Range::invalid();
+        }
+        range.setEnd(match);
+    } else {
+        // all lines in front are highlighted already, search them all
+        const KTextEditor::Cursor match = m_buffer->findUnmatchedBracket(range.start(), opposite, attribute, 0);
+        if (!match.isValid()) {
             return KTextEditor::Range::invalid();
         }
+        range.setStart(match);
+    }
 
-        Kate::TextLine textLine = kateTextLine(cursor.line());
-        if (textLine->attribute(cursor.column()) == validAttr) {
-            // Check for match
-            QChar c = textLine->at(cursor.column());
-            if (c == opposite) {
-                if (nesting == 0) {
-                    if (searchDir > 0) { // forward
-                        range.setEnd(cursor.toCursor());
-                    } else {
-                        range.setStart(cursor.toCursor());
-                    }
-                    return range;
-                }
-                nesting--;
-            } else if (c == bracket) {
-                nesting++;
-            }
+    return range;
+}
+
+KTextEditor::Range KTextEditor::DocumentPrivate::findEnclosingBrackets(const KTextEditor::Cursor &position, short attribute, int maxLines)
+{
+    if (maxLines < 0 || position.line() < 0 || position.line() >= lines()) {
+        return KTextEditor::Range::invalid();
+    }
+
+    // the nearest opening bracket in front of the position that is not closed in front of it
+    m_buffer->ensureHighlighted(position.line());
+    KTextEditor::Cursor start = KTextEditor::Cursor::invalid();
+    QChar bracket;
+    for (const QChar candidate : {QLatin1Char('('), QLatin1Char('['), QLatin1Char('{')}) {
+        const KTextEditor::Cursor found = m_buffer->findUnmatchedBracket(position, candidate, attribute, 0);
+        if (found.isValid() && (!start.isValid() || start < found)) {
+            start = found;
+            bracket = candidate;
         }
     }
 
-    return KTextEditor::Range::invalid();
+    if (!start.isValid()) {
+        return KTextEditor::Range::invalid();
+    }
+
+    const KTextEditor::Cursor end = findClosingBracket(KTextEditor::Cursor(start.line(), start.column() + 1), matchingBracket(bracket), attribute, position.line() + maxLines);
+    return end.isValid() ? KTextEditor::Range(start, end) : KTextEditor::Range::invalid();
+}
+
+KTextEditor::Cursor KTextEditor::DocumentPrivate::findClosingBracket(const KTextEditor::Cursor &from, QChar bracket, short attribute, int maxLine)
+{
+    // search the lines highlighted so far, highlight more lines up to maxLine only if that fails
+    KTextEditor::Cursor end = m_buffer->findUnmatchedBracket(from, bracket, attribute, m_buffer->highlightedLines() - 1);
+    if (!end.isValid() && m_buffer->highlightedLines() <= qMin(maxLine, lines() - 1)) {
+        m_buffer->ensureHighlighted(maxLine, 0);
+        end = m_buffer->findUnmatchedBracket(from, bracket, attribute, maxLine);
+    }
+    return end;
 }
 
 // helper: remove \r and \n from visible document name (bug #170876)
@@ -4422,6 +4598,13 @@ bool KTextEditor::DocumentPrivate::documentReload()
 
     emit aboutToReload(this);
 
+    // cheap paths: only append what was appended on disk, or apply what changed
+    // not for a file still loading, its lines are incomplete
+    if (!m_buffer->isLoading() && (reloadAppendedLines() || reloadChangedLines())) {
+        emit reloaded(this);
+        return true;
+    }
+
     QList<KateDocumentTmpMark> tmp;
 
     for (QHash<int, KTextEditor::Mark *>::const_iterator i = m_marks.constBegin(); i != m_marks.constEnd(); ++i) {
@@ -4439,11 +4622,12 @@ bool KTextEditor::DocumentPrivate::documentReload()
 
     m_storedVariables.clear();
 
-    // save cursor positions for all views
+    // save cursor positions and folding for all views
     QHash<KTextEditor::ViewPrivate *, KTextEditor::Cursor> cursorPositions;
     for (auto it = m_views.constBegin(); it != m_views.constEnd(); ++it) {
         auto v = it.value();
         cursorPositions.insert(v, v->cursorPosition());
+        v->saveFoldingState();
     }
 
     m_reloading = true;
@@ -4475,11 +4659,225 @@ bool KTextEditor::DocumentPrivate::documentReload()
     }
     setHighlightingMode(hl_mode);
 
+    for (auto view : qAsConst(m_views)) {
+        view->applyFoldingState();
+    }
+
     emit reloaded(this);
 
     return true;
 }
 
+bool KTextEditor::DocumentPrivate::reloadChangedLines()
+{
+    // we need the same encoding as before and must be allowed to edit
+    if (!url().isLocalFile() || m_userSetEncodingForNextReload || !isReadWrite() || m_buffer->brokenEncoding() || m_buffer->tooLongLinesWrapped()) {
+        return false;
+    }
+
+    const QString fileName = localFilePath();
+    if (!QFileInfo(fileName).isFile()) {
+        return false;
+    }
+
+    // load the file on disk into a buffer of its own, like KateBuffer::openFile() would
+    Kate::TextBuffer diskBuffer(nullptr);
+    diskBuffer.setEncodingProberType(KateGlobalConfig::global()->proberType());
+    diskBuffer.setFallbackTextCodec(KateGlobalConfig::global()->fallbackCodec());
+    diskBuffer.setTextCodec(m_buffer->textCodec());
+    diskBuffer.setEndOfLineMode(Kate::TextBuffer::eolUnknown);
+    diskBuffer.setLineLengthLimit(0);
+
+    bool encodingErrors = false;
+    bool tooLongLinesWrapped = false;
+    int longestLineLoaded = 0;
+    if (!diskBuffer.load(fileName, encodingErrors, tooLongLinesWrapped, longestLineLoaded, true) || encodingErrors || tooLongLinesWrapped) {
+        return false;
+    }
+
+    // the next save must write the format of the file on disk, a changed end of line mode, byte order mark
+    // or final newline needs the full reload to pick it up
+    const QStringList oldLines = KateLineDiff::lines(*m_buffer);
+    const QStringList newLines = KateLineDiff::lines(diskBuffer);
+    const bool eolChanged = config()->allowEolDetection() && diskBuffer.endOfLineMode() != Kate::TextBuffer::eolUnknown && diskBuffer.endOfLineMode() != config()->eol();
+    if (eolChanged || diskBuffer.generateByteOrderMark() != config()->bom() || oldLines.last().isEmpty() != newLines.last().isEmpty()) {
+        return false;
+    }
+
+    const QVector<KateLineDiff::Hunk> hunks = KateLineDiff::diff(oldLines, newLines);
+
+    // apply the hunks from the back, the lines of the ones before stay valid
+    // like loading, without undo and without static word wrap
+    m_undoManager->reloadStart();
+    for (int h = hunks.size() - 1; h >= 0; --h) {
+        const KateLineDiff::Hunk &hunk = hunks.at(h);
+
+        // lines present on both sides are changed in place, only the differing middle of them
+        const int changedLines = qMin(hunk.oldCount, hunk.newCount);
+        for (int i = 0; i < changedLines; ++i) {
+            const QString &oldLine = oldLines.at(hunk.oldStart + i);
+            const QString &newLine = newLines.at(hunk.newStart + i);
+            int prefix = 0;
+            while (prefix < oldLine.size() && prefix < newLine.size() && oldLine.at(prefix) == newLine.at(prefix)) {
+                ++prefix;
+            }
+            int suffix = 0;
+            while (suffix < oldLine.size() - prefix && suffix < newLine.size() - prefix && oldLine.at(oldLine.size() - 1 - suffix) == newLine.at(newLine.size() - 1 - suffix)) {
+                ++suffix;
+            }
+            editRemoveText(hunk.oldStart + i, prefix, oldLine.size() - prefix - suffix);
+            editInsertText(hunk.oldStart + i, prefix, newLine.mid(prefix, newLine.size() - prefix - suffix));
+        }
+
+        if (hunk.oldCount > changedLines) {
+            editRemoveLines(hunk.oldStart + changedLines, hunk.oldStart + hunk.oldCount - 1);
+        }
+        for (int i = changedLines; i < hunk.newCount; ++i) {
+            editInsertLine(hunk.oldStart + i, newLines.at(hunk.newStart + i));
+        }
+    }
+    m_undoManager->reloadEnd();
+
+    // the document is the file on disk again, including the lines around the changed ones, which the edits might have flagged
+    for (const KateLineDiff::Hunk &hunk : hunks) {
+        clearLineModifications(hunk.newStart - 1, hunk.newStart + hunk.newCount);
+    }
+    m_buffer->setDigest(diskBuffer.digest());
+    rememberLoadedFileState();
+    m_undoManager->clearUndo();
+    m_undoManager->clearRedo();
+    setModified(false);
+
+    // the modelines and variables might have changed with the lines
+    readVariables();
+
+    if (m_modOnHd) {
+        m_modOnHd = false;
+        m_modOnHdReason = OnDiskUnmodified;
+        m_prevModOnHdReason = OnDiskUnmodified;
+        emit modifiedOnDisk(this, m_modOnHd, m_modOnHdReason);
+    }
+
+    return true;
+}
+
+namespace
+{
+/**
+ * bytes at the end of the loaded part of a file that must stay unchanged to follow it
+ */
+const qint64 followTailSize = 64 * 1024;
+
+QByteArray fileTailDigest(QFile &file, qint64 size)
+{
+    const qint64 start = qMax<qint64>(0, size - followTailSize);
+    if (!file.seek(start)) {
+        return QByteArray();
+    }
+    return QCryptographicHash::hash(file.read(size - start), QCryptographicHash::Sha1);
+}
+}
+
+void KTextEditor::DocumentPrivate::clearLineModifications(int startLine, int endLine)
+{
+    for (int line = qMax(0, startLine); line <= qMin(endLine, lastLine()); ++line) {
+        Kate::TextLine textLine = m_buffer->plainLine(line);
+        textLine->markAsModified(false);
+        textLine->markAsSavedOnDisk(false);
+    }
+}
+
+void KTextEditor::DocumentPrivate::rememberLoadedFileState()
+{
+    m_loadedFileSize = -1;
+    m_loadedTailDigest.clear();
+
+    if (!url().isLocalFile()) {
+        return;
+    }
+
+    QFile file(localFilePath());
+    if (file.open(QIODevice::ReadOnly)) {
+        m_loadedFileSize = file.size();
+        m_loadedTailDigest = fileTailDigest(file, m_loadedFileSize);
+    }
+}
+
+bool KTextEditor::DocumentPrivate::reloadAppendedLines()
+{
+    // appended bytes can only be decoded on their own for uncompressed files in codecs with single byte newlines
+    QTextCodec *codec = m_buffer->textCodec();
+    if (m_loadedFileSize < 0 || !url().isLocalFile() || isModified() || !isReadWrite() || m_userSetEncodingForNextReload || m_buffer->brokenEncoding() || codec->fromUnicode(QStringLiteral("\n")) != "\n") {
+        return false;
+    }
+
+    const QString fileName = localFilePath();
+    if (KFilterDev::compressionTypeForMimeType(QMimeDatabase().mimeTypeForFile(fileName).name()) != KCompressionDevice::None) {
+        return false;
+    }
+
+    // the file must have grown and the part we know must be unchanged
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly) || file.size() <= m_loadedFileSize || fileTailDigest(file, m_loadedFileSize) != m_loadedTailDigest) {
+        return false;
+    }
+
+    // take complete lines only, a partial last line is picked up with the next change
+    bool endedWithNewline = false;
+    if (m_loadedFileSize > 0 && file.seek(m_loadedFileSize - 1)) {
+        endedWithNewline = file.read(1) == "\n";
+    }
+    QByteArray data = file.readAll();
+    data.truncate(data.lastIndexOf('\n') + 1);
+    if (data.isEmpty()) {
+        return true;
+    }
+
+    QString text = codec->toUnicode(data);
+    text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+    text.replace(QLatin1Char('\r'), QLatin1Char('\n'));
+
+    // the document might lack the final empty line, e.g. after saving with a newline added at the end
+    if (endedWithNewline && !line(lastLine()).isEmpty()) {
+        text.prepend(QLatin1Char('\n'));
+    }
+
+    // like loading, without undo and without static word wrap
+    m_undoManager->reloadStart();
+    int firstAppendedLine = lastLine();
+    insertText(documentEnd(), text);
+
+    // bound the memory for ever growing files
+    const int lineLimit = config()->followLineLimit();
+    if (lineLimit > 0 && lines() > lineLimit) {
+        const int removedLines = lines() - lineLimit;
+        editRemoveLines(0, removedLines - 1);
+        // the new first line might have been flagged by the removal
+        firstAppendedLine = qMax(0, firstAppendedLine - removedLines);
+        clearLineModifications(0, 0);
+    }
+    m_undoManager->reloadEnd();
+
+    // the appended lines match the file on disk, keep its digest up to date for later change checks and the swap file
+    clearLineModifications(firstAppendedLine, lastLine());
+    createDigest();
+    m_undoManager->clearUndo();
+    m_undoManager->clearRedo();
+    setModified(false);
+
+    m_loadedFileSize += data.size();
+    m_loadedTailDigest = fileTailDigest(file, m_loadedFileSize);
+
+    if (m_modOnHd) {
+        m_modOnHd = false;
+        m_modOnHdReason = OnDiskUnmodified;
+        m_prevModOnHdReason = OnDiskUnmodified;
+        emit modifiedOnDisk(this, m_modOnHd, m_modOnHdReason);
+    }
+
+    return true;
+}
+
 bool KTextEditor::DocumentPrivate::documentSave()
 {
     if (!url().isValid() || !isReadWrite()) {
@@ -4595,6 +4993,12 @@ void KTextEditor::DocumentPrivate::updateConfig()
     // set tab width there, too
     m_buffer->setTabWidth(config()->tabWidth());
 
+    // a changed line length limit changes which lines are too long
+    m_buffer->setTooLongLineLimit(config()->lineLengthLimit());
+    if (hasTooLongLines() != m_dynWordWrapHasTooLongLines) {
+        updateDynWordWrapForTooLongLines();
+    }
+
     // update all views, does tagAll and updateView...
     for (auto view : qAsConst(m_views)) {
         view->updateDocumentConfig();
@@ -4636,6 +5040,9 @@ void KTextEditor::DocumentPrivate::readVariables(bool onlyViewAndRenderer)
         }
     }
 
+    // the variables might have turned dynamic word wrap on again
+    updateDynWordWrapForTooLongLines();
+
     if (!onlyViewAndRenderer) {
         m_config->configEnd();
     }
@@ -5470,6 +5877,13 @@ void KTextEditor::DocumentPrivate::slotStarted(KIO::Job *job)
 
 void KTextEditor::DocumentPrivate::slotCompleted()
 {
+    /**
+     * incremental load still running, continueIncrementalLoad() will complete it
+     */
+    if (m_buffer->isLoading()) {
+        return;
+    }
+
     /**
      * if were loading, reset back to old read-write mode before loading
      * and kill the possible loading message
@@ -5533,9 +5947,9 @@ void KTextEditor::DocumentPrivate::slotTriggerLoadingMessage()
     m_loadingMessage->setPosition(KTextEditor::Message::TopInView);
 
     /**
-     * if around job: add cancel action
+     * if around job or incremental load: add cancel action
      */
-    if (m_loadingJob) {
+    if (m_loadingJob || m_buffer->isLoading()) {
         QAction *cancel = new QAction(i18n("&Abort Loading"), nullptr);
         connect(cancel, SIGNAL(triggered()), this, SLOT(slotAbortLoading()));
         m_loadingMessage->addAction(cancel);
@@ -5549,6 +5963,30 @@ void KTextEditor::DocumentPrivate::slotTriggerLoadingMessage()
 
 void KTextEditor::DocumentPrivate::slotAbortLoading()
 {
+    /**
+     * incremental load: keep the lines read so far, read-only, saving would truncate the file
+     */
+    if (m_buffer->isLoading()) {
+        cancelIncrementalLoad();
+        m_readWriteStateBeforeLoading = false;
+
+        m_openingError = true;
+        m_openingErrorMessage = i18n("Loading of the file %1 was aborted, only its first %2 lines are shown.", url().toDisplayString(QUrl::PreferLocalFile), lines());
+        QPointer<KTextEditor::Message> message = new KTextEditor::Message(i18n("Loading of the file %1 was aborted, only its first %2 lines are shown.<br />"
+                                                                               "It is set to read-only mode, as saving would truncate it.",
+                                                                               url().toDisplayString(QUrl::PreferLocalFile),
+                                                                               lines()),
+                                                                          KTextEditor::Message::Warning);
+        message->setWordWrap(true);
+        postMessage(message);
+
+        // the partial content is all there is, like after a completed load
+        emit textChanged(this);
+        emit loaded(this);
+        slotCompleted();
+        return;
+    }
+
     /**
      * no job, no work
      */
@@ -5977,6 +6415,14 @@ Kate::SwapFile *KTextEditor::DocumentPrivate::swapFile()
     return m_swapfile;
 }
 
+KateWordIndex *KTextEditor::DocumentPrivate::wordIndex()
+{
+    if (!m_wordIndex) {
+        m_wordIndex = new KateWordIndex(this);
+    }
+    return m_wordIndex;
+}
+
 /**
  * \return \c -1 if \c line or \c column invalid, otherwise one of
  * standard style attribute number
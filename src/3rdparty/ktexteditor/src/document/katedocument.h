@@ -70,6 +70,7 @@ class KateDocumentConfig;
 class KateHighlighting;
 class KateUndoManager;
 class KateOnTheFlyChecker;
+class KateWordIndex;
 class KateDocumentTest;
 
 class KateAutoIndent;
@@ -185,6 +186,13 @@ public Q_SLOTS:
     }
 
 public:
+    /**
+     * Replace the whole lines \p fromLine to \p toLine by \p lines in one transaction.
+     * Unchanged lines at both ends are skipped, e.g. for a trim of mostly clean text.
+     * @return success, false for an invalid line range or a read-only document
+     */
+    bool replaceLines(int fromLine, int toLine, const QStringList &lines);
+
     bool isEditingTransactionRunning() const override;
     QString text(const KTextEditor::Range &range, bool blockwise = false) const override;
     QStringList textLines(const KTextEditor::Range &range, bool block = false) const override;
@@ -584,6 +592,7 @@ Q_SIGNALS:
 private:
     QHash<int, KTextEditor::Mark *> m_marks;
     QHash<int, QVariant> m_markIcons; // QPixmap or QIcon, KF6: remove QPixmap support
+    uint m_markIconsRevision = 0;
     QHash<int, QString> m_markDescriptions;
     uint m_editableMarks = markType01;
 
@@ -596,6 +605,14 @@ public Q_SLOTS:
 public:
     QIcon markIcon(MarkInterface::MarkTypes markType) const override;
 
+    /**
+     * Changes whenever a mark icon or pixmap is set, for caches of painted marks.
+     */
+    uint markIconsRevision() const
+    {
+        return m_markIconsRevision;
+    }
+
     // KTextEditor::PrintInterface
     //
 public Q_SLOTS:
@@ -779,9 +796,27 @@ public:
     };
     void delayAutoReload();
 
+Q_SIGNALS:
+    /**
+     * A file larger than the incremental load limit is still loading, the lines read so far are shown.
+     * @param document document loading the file
+     * @param percent estimated part of the file read
+     */
+    void loadingProgress(KTextEditor::Document *document, int percent);
+
 private Q_SLOTS:
     void autoReloadToggled(bool b);
 
+    /**
+     * Read the next slice of lines of an incremental load, finish the load after the last one.
+     */
+    void continueIncrementalLoad();
+
+    /**
+     * Forward the progress of the buffer to loadingProgress() and the loading message.
+     */
+    void slotLoadProgress(qint64 bytesRead, qint64 bytesTotal);
+
 private:
     void activateDirWatch(const QString &useFileName = QString());
     void deactivateDirWatch();
@@ -794,6 +829,25 @@ private:
      */
     bool createBackupFile();
 
+    /**
+     * Everything to do after the file was read: read variables, update views, report problems.
+     * @param success was the file read?
+     * @param resetViews move all views to the document start, not wanted after an incremental
+     *        load, the user could already navigate the file
+     * @return success
+     */
+    bool finishOpenFile(bool success, bool resetViews);
+
+    /**
+     * Stop a running incremental load, the lines read so far stay in the buffer.
+     */
+    void cancelIncrementalLoad();
+
+    /**
+     * drives an incremental load from the event loop, see openFile()
+     */
+    QTimer m_incrementalLoadTimer;
+
 public:
     /**
      * Type chars in a view.
@@ -948,8 +1002,33 @@ private:
     bool removeStartLineCommentFromSelection(KTextEditor::ViewPrivate *view, int attrib = 0);
 
 public:
+    /**
+     * Find the partner of the bracket at @p start, see the comment in front of the implementation.
+     * Brackets only pair up with brackets of the same kind and attribute. The lines highlighted
+     * so far are searched with the bracket index of the buffer, regardless of their distance.
+     * @param start cursor position next to the bracket
+     * @param maxLines highlight at most this many lines behind @p start to find the partner
+     * @return range from the opening to the closing bracket, invalid if there is none
+     */
     KTextEditor::Range findMatchingBracket(const KTextEditor::Cursor &start, int maxLines);
 
+    /**
+     * Find the innermost pair of brackets around @p position.
+     * Brackets of all kinds count, as long as they have the attribute @p attribute.
+     * @param position position inside the brackets
+     * @param attribute attribute of the brackets, e.g. of the ones of the surrounding code
+     * @param maxLines highlight at most this many lines behind @p position to find the closing bracket
+     * @return range from the opening to the closing bracket, invalid if there is none
+     */
+    KTextEditor::Range findEnclosingBrackets(const KTextEditor::Cursor &position, short attribute, int maxLines);
+
+private:
+    /**
+     * Search forward for the closing bracket of the given class not closing anything opened behind @p from.
+     * @param maxLine highlight at most up to this line if the lines highlighted so far hold no match
+     */
+    KTextEditor::Cursor findClosingBracket(const KTextEditor::Cursor &from, QChar bracket, short attribute, int maxLine);
+
 public:
     QString documentName() const override
     {
@@ -1061,6 +1140,34 @@ private:
      */
     bool createDigest();
 
+    /**
+     * Reload by applying only the lines that differ on disk as one editing transaction.
+     * Highlighting, folding, marks and moving cursors/ranges of unchanged lines survive.
+     *
+     * @return whether the reload was done, false if a full reload is needed
+     */
+    bool reloadChangedLines();
+
+    /**
+     * Reload a file that only grew since it was loaded, like a log file, by appending
+     * the new complete lines, like "tail -f". Beyond the configured follow line limit,
+     * the oldest lines are dropped.
+     *
+     * @return whether the reload was done, false if the file changed otherwise
+     */
+    bool reloadAppendedLines();
+
+    /**
+     * Clear the modification flags of the given lines after a reload, they match the file on disk.
+     */
+    void clearLineModifications(int startLine, int endLine);
+
+    /**
+     * Remember size and tail of the file on disk, reloadAppendedLines() uses them to
+     * detect that the file was only appended to.
+     */
+    void rememberLoadedFileState();
+
     /**
      * create a string for the modonhd warnings, giving the reason.
      */
@@ -1148,6 +1255,12 @@ private:
      */
     bool m_reloading = false;
 
+    /**
+     * size of the file when it was loaded or saved and digest of its last bytes, -1 if unknown
+     */
+    qint64 m_loadedFileSize = -1;
+    QByteArray m_loadedTailDigest;
+
 public Q_SLOTS:
     void slotQueryClose_save(bool *handled, bool *abortClosing);
 
@@ -1308,6 +1421,16 @@ private:
 public:
     Kate::SwapFile *swapFile();
 
+private:
+    KateWordIndex *m_wordIndex = nullptr;
+
+public:
+    /**
+     * Index of the words in this document, used by the word completion.
+     * Created on first use.
+     */
+    KateWordIndex *wordIndex();
+
     // helpers for scripting and codefolding
     int defStyleNum(int line, int column);
     bool isComment(int line, int column);
@@ -1408,12 +1531,32 @@ private:
 
 public:
     /**
-     * reads the line length limit from config, if it is not overridden
+     * reads the line length limit from config, lines longer than it are only
+     * laid out around the visible part, see KateRenderer::layoutLine()
      */
     int lineLengthLimit() const;
 
-public Q_SLOTS:
-    void openWithLineLengthLimitOverride();
+    /**
+     * Does the document contain lines longer than the line length limit?
+     */
+    bool hasTooLongLines() const;
+
+private:
+    /**
+     * Turn dynamic word wrap off in all views if there are too long lines,
+     * else turn it on again in the views it was turned off in.
+     */
+    void updateDynWordWrapForTooLongLines();
+
+    /**
+     * hasTooLongLines() for which dynamic word wrap was updated last
+     */
+    bool m_dynWordWrapHasTooLongLines = false;
+
+    /**
+     * views with dynamic word wrap turned off for too long lines
+     */
+    QSet<KTextEditor::ViewPrivate *> m_viewsWithoutDynWordWrap;
 
 private:
     /**
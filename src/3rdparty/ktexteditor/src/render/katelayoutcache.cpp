@@ -21,6 +21,7 @@
 
 #include "katelayoutcache.h"
 
+#include <QElapsedTimer>
 #include <QtAlgorithms>
 
 #include "katebuffer.h"
@@ -38,6 +39,81 @@ bool lessThan(const KateLineLayoutMap::LineLayoutPair &lhs, const KateLineLayout
     return lhs.first < rhs.first;
 }
 
+/**
+ * Milliseconds spent on counting view lines per slice while the event loop is idle.
+ */
+const int ViewLineCountSliceTime = 10;
+
+/**
+ * Sum of the values in [start, end) of the given per-line table, without the hidden lines.
+ */
+qint64 visibleSum(const KateFenwickTree &table, int start, int end, const QVector<QPair<int, int>> &hiddenLines)
+{
+    qint64 sum = table.sum(start, end);
+    for (const auto &lines : hiddenLines) {
+        if (lines.first >= end) {
+            break;
+        }
+        sum -= table.sum(qMax(lines.first, start), qMin(lines.second + 1, end));
+    }
+    return sum;
+}
+
+/**
+ * Find the view line @p offset view lines away from the first one of the visible line @p realLine.
+ * With the counts of lines never laid out being lower bounds, the line found is never closer to
+ * @p realLine than the real target.
+ * @return real line of the view line, -1 if outside of the document
+ */
+int findViewLine(const KateFenwickTree &counts, int realLine, int offset, const QVector<QPair<int, int>> &hiddenLines, int &viewLine)
+{
+    // offset of the wanted view line, counted from the start of the document including hidden lines
+    qint64 target = -1;
+    if (offset >= 0) {
+        qint64 rest = offset;
+        int start = realLine;
+        for (const auto &lines : hiddenLines) {
+            if (lines.second < start) {
+                continue;
+            }
+            const qint64 count = counts.sum(start, lines.first);
+            if (rest < count) {
+                break;
+            }
+            rest -= count;
+            start = lines.second + 1;
+        }
+        if (rest < counts.sum(start, counts.size())) {
+            target = counts.prefixSum(start) + rest;
+        }
+    } else {
+        qint64 rest = -qint64(offset);
+        int end = realLine;
+        for (int i = hiddenLines.size() - 1; i >= 0; --i) {
+            const auto &lines = hiddenLines.at(i);
+            if (lines.first >= end) {
+                continue;
+            }
+            const qint64 count = counts.sum(lines.second + 1, end);
+            if (rest <= count) {
+                break;
+            }
+            rest -= count;
+            end = lines.first;
+        }
+        if (rest <= counts.prefixSum(end)) {
+            target = counts.prefixSum(end) - rest;
+        }
+    }
+
+    if (target < 0) {
+        return -1;
+    }
+
+    const int line = counts.findIndex(target);
+    viewLine = int(target - counts.prefixSum(line));
+    return line;
+}
 }
 
 // BEGIN KateLineLayoutMap
@@ -101,6 +177,29 @@ void KateLineLayoutMap::relayoutLines(int startRealLine, int endRealLine)
     }
 }
 
+void KateLineLayoutMap::invalidateDecorations(int startRealLine, int endRealLine)
+{
+    LineLayoutMap::iterator start = std::lower_bound(m_lineLayouts.begin(), m_lineLayouts.end(), LineLayoutPair(startRealLine, KateLineLayoutPtr()), lessThan);
+    LineLayoutMap::iterator end = std::upper_bound(start, m_lineLayouts.end(), LineLayoutPair(endRealLine, KateLineLayoutPtr()), lessThan);
+
+    while (start != end) {
+        (*start).second->invalidateDecorations();
+        (*start).second->setLayoutDirty();
+        ++start;
+    }
+}
+
+QVector<KateLineLayoutPtr> KateLineLayoutMap::windowsNotCovering(int startX, int endX) const
+{
+    QVector<KateLineLayoutPtr> layouts;
+    for (const LineLayoutPair &pair : m_lineLayouts) {
+        if (pair.second->isValid() && !pair.second->windowCovers(startX, endX)) {
+            layouts.append(pair.second);
+        }
+    }
+    return layouts;
+}
+
 void KateLineLayoutMap::slotEditDone(int fromLine, int toLine, int shiftAmount)
 {
     LineLayoutMap::iterator start = std::lower_bound(m_lineLayouts.begin(), m_lineLayouts.end(), LineLayoutPair(fromLine, KateLineLayoutPtr()), lessThan);
@@ -120,6 +219,7 @@ void KateLineLayoutMap::slotEditDone(int fromLine, int toLine, int shiftAmount)
         m_lineLayouts.erase(start, end);
     } else {
         for (it = start; it != end; ++it) {
+            (*it).second->invalidateDecorations();
             (*it).second->setLayoutDirty();
         }
     }
@@ -143,6 +243,10 @@ KateLayoutCache::KateLayoutCache(KateRenderer *renderer, QObject *parent)
 {
     Q_ASSERT(m_renderer);
 
+    m_viewLineCountTimer.setSingleShot(true);
+    m_viewLineCountTimer.setInterval(2 * ViewLineCountSliceTime);
+    connect(&m_viewLineCountTimer, SIGNAL(timeout()), this, SLOT(countViewLines()));
+
     /**
      * connect to all possible editing primitives
      */
@@ -150,6 +254,12 @@ KateLayoutCache::KateLayoutCache(KateRenderer *renderer, QObject *parent)
     connect(&m_renderer->doc()->buffer(), SIGNAL(lineUnwrapped(int)), this, SLOT(unwrapLine(int)));
     connect(&m_renderer->doc()->buffer(), SIGNAL(textInserted(KTextEditor::Cursor, QString)), this, SLOT(insertText(KTextEditor::Cursor, QString)));
     connect(&m_renderer->doc()->buffer(), SIGNAL(textRemoved(KTextEditor::Range, QString)), this, SLOT(removeText(KTextEditor::Range)));
+
+    /**
+     * load and clear bypass the edit signals
+     */
+    connect(&m_renderer->doc()->buffer(), SIGNAL(cleared()), this, SLOT(resetViewLineCounts()));
+    connect(&m_renderer->doc()->buffer(), SIGNAL(loaded(QString, bool)), this, SLOT(resetViewLineCounts()));
 }
 
 void KateLayoutCache::updateViewCache(const KTextEditor::Cursor &startPos, int newViewLineCount, int viewLinesScrolled)
@@ -296,12 +406,14 @@ KateLineLayoutPtr KateLayoutCache::line(int realLine, int virtualLine)
         if (!l->isValid()) {
             l->setUsePlainTextLine(acceptDirtyLayouts());
             l->textLine(!acceptDirtyLayouts());
-            m_renderer->layoutLine(l, wrap() ? m_viewWidth : -1, enableLayoutCache);
+            m_renderer->layoutLine(l, wrap() ? m_viewWidth : -1, enableLayoutCache, m_startX);
+            setViewLineCount(realLine, l->viewLineCount());
         } else if (l->isLayoutDirty() && !acceptDirtyLayouts()) {
             // reset textline
             l->setUsePlainTextLine(false);
             l->textLine(true);
-            m_renderer->layoutLine(l, wrap() ? m_viewWidth : -1, enableLayoutCache);
+            m_renderer->layoutLine(l, wrap() ? m_viewWidth : -1, enableLayoutCache, m_startX);
+            setViewLineCount(realLine, l->viewLineCount());
         }
 
         Q_ASSERT(l->isValid() && (!l->isLayoutDirty() || acceptDirtyLayouts()));
@@ -322,8 +434,9 @@ KateLineLayoutPtr KateLayoutCache::line(int realLine, int virtualLine)
         l->setUsePlainTextLine(true);
     }
 
-    m_renderer->layoutLine(l, wrap() ? m_viewWidth : -1, enableLayoutCache);
+    m_renderer->layoutLine(l, wrap() ? m_viewWidth : -1, enableLayoutCache, m_startX);
     Q_ASSERT(l->isValid());
+    setViewLineCount(realLine, l->viewLineCount());
 
     if (acceptDirtyLayouts()) {
         l->setLayoutDirty(true);
@@ -374,6 +487,23 @@ int KateLayoutCache::viewWidth() const
     return m_viewWidth;
 }
 
+bool KateLayoutCache::setStartX(int startX)
+{
+    m_startX = startX;
+    if (wrap()) {
+        return false;
+    }
+
+    // the layouts are shared with the view cache, lay them out in place
+    const QVector<KateLineLayoutPtr> layouts = m_lineLayouts.windowsNotCovering(startX, startX + m_viewWidth);
+    for (const KateLineLayoutPtr &l : layouts) {
+        const bool layoutDirty = l->isLayoutDirty();
+        m_renderer->layoutLine(l, -1, enableLayoutCache, startX);
+        l->setLayoutDirty(layoutDirty);
+    }
+    return !layouts.isEmpty();
+}
+
 /**
  * This returns the view line upon which realCursor is situated.
  * The view line is the number of lines in the view from the first line
@@ -433,25 +563,21 @@ int KateLayoutCache::displayViewLine(const KTextEditor::Cursor &virtualCursor, b
     }
 
     int ret = -(int)viewLine(viewCacheStart());
-    bool forwards = (work < virtualCursor);
-
-    // FIXME switch to using ranges? faster?
-    if (forwards) {
-        while (work.line() != virtualCursor.line()) {
-            ret += viewLineCount(m_renderer->folding().visibleLineToLine(work.line()));
-            work.setLine(work.line() + 1);
-            if (limitToVisible && ret > limit) {
-                return -1;
-            }
+
+    // the view lines of the lines in between come from the view line counts
+    const int startRealLine = m_renderer->folding().visibleLineToLine(work.line());
+    const int realLine = m_renderer->folding().visibleLineToLine(virtualCursor.line());
+    if (work.line() < virtualCursor.line()) {
+        ret += viewLinesBetween(startRealLine, realLine, limitToVisible ? limit - ret : std::numeric_limits<int>::max());
+        if (limitToVisible && ret > limit) {
+            return -1;
         }
-    } else {
-        while (work.line() != virtualCursor.line()) {
-            work.setLine(work.line() - 1);
-            ret -= viewLineCount(m_renderer->folding().visibleLineToLine(work.line()));
-            if (limitToVisible && ret < 0) {
-                return -1;
-            }
+    } else if (work.line() > virtualCursor.line()) {
+        // lines in front of the view are never visible
+        if (limitToVisible) {
+            return -1;
         }
+        ret -= viewLinesBetween(realLine, startRealLine);
     }
 
     // final difference
@@ -500,24 +626,46 @@ void KateLayoutCache::viewCacheDebugOutput() const
 void KateLayoutCache::wrapLine(const KTextEditor::Cursor &position)
 {
     m_lineLayouts.slotEditDone(position.line(), position.line() + 1, 1);
+
+    // the buffer has one line more than the view line counts
+    if (m_viewLineCounts.size() + 1 == m_renderer->doc()->lines()) {
+        m_viewLineCounts.insert(position.line() + 1, 1, 1);
+        m_unknownViewLineCounts.insert(position.line() + 1, 1, 1);
+    }
+    invalidateViewLineCount(position.line());
 }
 
 void KateLayoutCache::unwrapLine(int line)
 {
     m_lineLayouts.slotEditDone(line - 1, line, -1);
+
+    // the buffer has one line less than the view line counts
+    if (m_viewLineCounts.size() - 1 == m_renderer->doc()->lines()) {
+        m_viewLineCounts.remove(line, 1);
+        m_unknownViewLineCounts.remove(line, 1);
+    }
+    invalidateViewLineCount(line - 1);
 }
 
 void KateLayoutCache::insertText(const KTextEditor::Cursor &position, const QString &)
 {
     m_lineLayouts.slotEditDone(position.line(), position.line(), 0);
+    invalidateViewLineCount(position.line());
 }
 
 void KateLayoutCache::removeText(const KTextEditor::Range &range)
 {
     m_lineLayouts.slotEditDone(range.start().line(), range.start().line(), 0);
+    invalidateViewLineCount(range.start().line());
 }
 
 void KateLayoutCache::clear()
+{
+    clearLayouts();
+    resetViewLineCounts();
+}
+
+void KateLayoutCache::clearLayouts()
 {
     m_textLayouts.clear();
     m_lineLayouts.clear();
@@ -529,6 +677,7 @@ void KateLayoutCache::setViewWidth(int width)
     bool wider = width > m_viewWidth;
 
     m_viewWidth = width;
+    resetViewLineCounts();
 
     m_lineLayouts.clear();
     m_startPos = KTextEditor::Cursor(-1, -1);
@@ -561,6 +710,11 @@ void KateLayoutCache::relayoutLines(int startRealLine, int endRealLine)
     m_lineLayouts.relayoutLines(startRealLine, endRealLine);
 }
 
+void KateLayoutCache::invalidateDecorations(int startRealLine, int endRealLine)
+{
+    m_lineLayouts.invalidateDecorations(startRealLine, endRealLine);
+}
+
 bool KateLayoutCache::acceptDirtyLayouts()
 {
     return m_acceptDirtyLayouts;
@@ -570,3 +724,148 @@ void KateLayoutCache::setAcceptDirtyLayouts(bool accept)
 {
     m_acceptDirtyLayouts = accept;
 }
+
+// BEGIN view line counts
+int KateLayoutCache::viewLinesBetween(int startRealLine, int endRealLine, int limit)
+{
+    if (startRealLine >= endRealLine || !ensureViewLineCountsValid()) {
+        return 0;
+    }
+
+    // lines never laid out count one view line, that is a lower bound
+    const QVector<QPair<int, int>> hiddenLines = m_renderer->folding().hiddenLines();
+    const qint64 lowerBound = visibleSum(m_viewLineCounts, startRealLine, endRealLine, hiddenLines);
+    if (lowerBound > limit || visibleSum(m_unknownViewLineCounts, startRealLine, endRealLine, hiddenLines) == 0) {
+        return int(lowerBound);
+    }
+
+    ensureViewLineCounts(startRealLine, endRealLine, hiddenLines);
+    return int(visibleSum(m_viewLineCounts, startRealLine, endRealLine, hiddenLines));
+}
+
+int KateLayoutCache::moveViewLines(int realLine, int offset, int &viewLine)
+{
+    if (!ensureViewLineCountsValid()) {
+        return -1;
+    }
+
+    // with lower bounds for the lines never laid out, the real target lies between realLine and the line found
+    const QVector<QPair<int, int>> hiddenLines = m_renderer->folding().hiddenLines();
+    const int line = findViewLine(m_viewLineCounts, realLine, offset, hiddenLines, viewLine);
+    if (offset >= 0) {
+        ensureViewLineCounts(realLine, (line < 0) ? m_viewLineCounts.size() : line + 1, hiddenLines);
+    } else {
+        ensureViewLineCounts(qMax(line, 0), realLine, hiddenLines);
+    }
+
+    return findViewLine(m_viewLineCounts, realLine, offset, hiddenLines, viewLine);
+}
+
+int KateLayoutCache::layoutViewLineCount(int realLine)
+{
+    // a cached layout does it, as long as it is up-to-date
+    if (m_lineLayouts.contains(realLine)) {
+        const KateLineLayoutPtr &l = m_lineLayouts[realLine];
+        if (l->isValid() && !l->isLayoutDirty()) {
+            return l->viewLineCount();
+        }
+    }
+
+    // no need to highlight the line just for wrapping it, the count is corrected once it is laid out for real
+    KateLineLayoutPtr l(new KateLineLayout(*m_renderer));
+    l->setLine(realLine);
+    l->setUsePlainTextLine(true);
+    m_renderer->layoutLine(l, m_viewWidth, false);
+    return l->viewLineCount();
+}
+
+void KateLayoutCache::setViewLineCount(int realLine, int count)
+{
+    if (!wrap() || m_viewLineCounts.size() != m_renderer->doc()->lines()) {
+        return;
+    }
+
+    m_viewLineCounts.setValue(realLine, count);
+    m_unknownViewLineCounts.setValue(realLine, 0);
+}
+
+void KateLayoutCache::invalidateViewLineCount(int realLine)
+{
+    if (m_viewLineCounts.size() != m_renderer->doc()->lines()) {
+        return;
+    }
+
+    m_viewLineCounts.setValue(realLine, 1);
+    m_unknownViewLineCounts.setValue(realLine, 1);
+    if (wrap()) {
+        m_viewLineCountTimer.start();
+    }
+}
+
+void KateLayoutCache::ensureViewLineCounts(int startRealLine, int endRealLine, const QVector<QPair<int, int>> &hiddenLines)
+{
+    // lay out the unknown lines of [start, end) one by one, they are found in O(log n) each
+    auto layoutUnknownLines = [this](int start, int end) {
+        while (start < end && m_unknownViewLineCounts.sum(start, end) > 0) {
+            const int line = m_unknownViewLineCounts.findIndex(m_unknownViewLineCounts.prefixSum(start));
+            setViewLineCount(line, layoutViewLineCount(line));
+            start = line + 1;
+        }
+    };
+
+    int start = startRealLine;
+    for (const auto &lines : hiddenLines) {
+        if (lines.first >= endRealLine) {
+            break;
+        }
+        layoutUnknownLines(start, qMin(lines.first, endRealLine));
+        start = qMax(start, lines.second + 1);
+    }
+    layoutUnknownLines(start, endRealLine);
+}
+
+bool KateLayoutCache::ensureViewLineCountsValid()
+{
+    if (!wrap() || m_viewWidth <= 0) {
+        return false;
+    }
+
+    const int lines = m_renderer->doc()->lines();
+    if (m_viewLineCounts.size() != lines) {
+        m_viewLineCounts.fill(1, lines);
+        m_unknownViewLineCounts.fill(1, lines);
+        m_viewLineCountTimer.start();
+    }
+    return true;
+}
+
+void KateLayoutCache::resetViewLineCounts()
+{
+    // filled on next use, at the then current width
+    m_viewLineCounts.fill(1, 0);
+    m_unknownViewLineCounts.fill(1, 0);
+    if (wrap()) {
+        m_viewLineCountTimer.start();
+    }
+}
+
+void KateLayoutCache::countViewLines()
+{
+    if (!ensureViewLineCountsValid()) {
+        return;
+    }
+
+    // one slice now, the next one once the event loop had its turn
+    QElapsedTimer timer;
+    timer.start();
+    while (m_unknownViewLineCounts.sum() > 0) {
+        if (timer.hasExpired(ViewLineCountSliceTime)) {
+            m_viewLineCountTimer.start();
+            return;
+        }
+
+        const int line = m_unknownViewLineCounts.findIndex(0);
+        setViewLineCount(line, layoutViewLineCount(line));
+    }
+}
+// END
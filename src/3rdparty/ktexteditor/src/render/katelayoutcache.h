@@ -23,11 +23,15 @@
 #define KATELAYOUTCACHE_H
 
 #include <QPair>
+#include <QTimer>
 
 #include <ktexteditor/range.h>
 
+#include "katefenwicktree.h"
 #include "katetextlayout.h"
 
+#include <limits>
+
 class KateRenderer;
 
 class KateLineLayoutMap
@@ -47,6 +51,10 @@ public:
 
     inline void relayoutLines(int startRealLine, int endRealLine);
 
+    inline void invalidateDecorations(int startRealLine, int endRealLine);
+
+    inline QVector<KateLineLayoutPtr> windowsNotCovering(int startX, int endX) const;
+
     inline void slotEditDone(int fromLine, int toLine, int shiftAmount);
 
     KateLineLayoutPtr &operator[](int i);
@@ -70,6 +78,12 @@ private:
  * caches for separate views of the same document, even for view and printer
  * (if the renderer is made to support rendering onto different targets).
  *
+ * With dynamic word wrap, the number of view lines of every line is kept in a
+ * prefix-sum table, which maps between real lines and view lines in O(log n).
+ * The counts are filled in whenever a line is laid out and for the remaining
+ * lines in short slices while the event loop is idle. Edits only invalidate
+ * the counts of the lines they touch.
+ *
  * @author Hamish Rodda \<rodda@kde.org\>
  */
 
@@ -82,9 +96,21 @@ public:
 
     void clear();
 
+    /**
+     * Drop all layouts, but keep the view line counts, they follow the edits on their own.
+     */
+    void clearLayouts();
+
     int viewWidth() const;
     void setViewWidth(int width);
 
+    /**
+     * Set the x position of the left edge of the visible area, without dynamic word wrap.
+     * Windowed lines not covering the new visible area are laid out again, see KateLineLayout::isWindowed().
+     * @return true if any line was laid out again
+     */
+    bool setStartX(int startX);
+
     bool wrap() const;
     void setWrap(bool wrap);
 
@@ -131,6 +157,9 @@ public:
 
     void relayoutLines(int startRealLine, int endRealLine);
 
+    // drop the cached decorations of the lines, their highlighting or ranges changed
+    void invalidateDecorations(int startRealLine, int endRealLine);
+
     // find the index of the last view line for a specific line
     int lastViewLine(int realLine);
     // find the view line of cursor c (0 = same line, 1 = down one, etc.)
@@ -140,13 +169,61 @@ public:
     void viewCacheDebugOutput() const;
     // END
 
+    // BEGIN methods to do with the view line counts of all lines
+    /**
+     * Number of view lines of the visible lines in [startRealLine, endRealLine).
+     * Lines never laid out at the current width are laid out now, the counts of
+     * all other lines are summed up in O(log n).
+     * @param limit if a lower bound of the result already passes this, it is returned without laying out any line
+     */
+    int viewLinesBetween(int startRealLine, int endRealLine, int limit = std::numeric_limits<int>::max());
+
+    /**
+     * Move @p offset view lines away from the first view line of the visible line @p realLine,
+     * backward for negative offsets. Only lines never laid out at the current width are laid out.
+     * @param viewLine set to the view line reached inside the returned line
+     * @return the real line reached, -1 if the move leaves the document
+     */
+    int moveViewLines(int realLine, int offset, int &viewLine);
+    // END
+
 private Q_SLOTS:
     void wrapLine(const KTextEditor::Cursor &position);
     void unwrapLine(int line);
     void insertText(const KTextEditor::Cursor &position, const QString &text);
     void removeText(const KTextEditor::Range &range);
 
+    void resetViewLineCounts();
+    void countViewLines();
+
 private:
+    /**
+     * Number of view lines of the given line at the current width, laid out without caching if needed.
+     */
+    int layoutViewLineCount(int realLine);
+
+    /**
+     * Remember the view line count of a line laid out at the current width.
+     */
+    void setViewLineCount(int realLine, int count);
+
+    /**
+     * Forget the view line count of the given line.
+     */
+    void invalidateViewLineCount(int realLine);
+
+    /**
+     * Lay out the lines in [startRealLine, endRealLine) never laid out at the current width,
+     * skipping the lines hidden by folding.
+     */
+    void ensureViewLineCounts(int startRealLine, int endRealLine, const QVector<QPair<int, int>> &hiddenLines);
+
+    /**
+     * Is the view line count table in sync with the lines of the document?
+     * An empty table is filled, a table out of sync is reset.
+     */
+    bool ensureViewLineCountsValid();
+
     KateRenderer *m_renderer;
 
     /**
@@ -162,8 +239,24 @@ private:
     mutable QVector<KateTextLayout> m_textLayouts;
 
     int m_viewWidth;
+    int m_startX = 0;
     bool m_wrap;
     bool m_acceptDirtyLayouts;
+
+    /**
+     * view lines per real line at the current width, lines never laid out count 1
+     */
+    KateFenwickTree m_viewLineCounts;
+
+    /**
+     * 1 for every line never laid out at the current width, 0 for all others
+     */
+    KateFenwickTree m_unknownViewLineCounts;
+
+    /**
+     * counts the view lines of the remaining lines while the event loop is idle
+     */
+    QTimer m_viewLineCountTimer;
 };
 
 #endif
@@ -56,6 +56,8 @@ void KateLineLayout::clear()
     // not touching dirty
     delete m_layout;
     m_layout = nullptr;
+    m_windowed = false;
+    invalidateDecorations();
     // not touching layout dirty
 }
 
@@ -139,6 +141,7 @@ void KateLineLayout::setLayout(QTextLayout *layout)
     }
 
     m_layoutDirty = !m_layout;
+    m_windowed = false;
     m_dirtyList.clear();
     if (m_layout)
         for (int i = 0; i < qMax(1, m_layout->lineCount()); ++i) {
@@ -191,6 +194,10 @@ KateTextLayout KateLineLayout::viewLine(int viewLine) const
 
 int KateLineLayout::width() const
 {
+    if (m_windowed) {
+        return int(cursorToX(length()));
+    }
+
     int width = 0;
 
     for (int i = 0; i < m_layout->lineCount(); ++i) {
@@ -249,6 +256,117 @@ void KateLineLayout::setUsePlainTextLine(bool plain)
     m_usePlainTextLine = plain;
 }
 
+bool KateLineLayout::isWindowed() const
+{
+    return m_windowed;
+}
+
+void KateLineLayout::setWindow(int startColumn, int endColumn, qreal columnWidth)
+{
+    Q_ASSERT(m_layout && m_layout->lineCount() == 1);
+
+    m_windowed = true;
+    m_layoutStartColumn = startColumn;
+    m_layoutEndColumn = endColumn;
+    m_columnWidth = columnWidth;
+}
+
+int KateLineLayout::layoutStartColumn() const
+{
+    return m_windowed ? m_layoutStartColumn : 0;
+}
+
+int KateLineLayout::layoutEndColumn() const
+{
+    return m_windowed ? m_layoutEndColumn : length();
+}
+
+qreal KateLineLayout::layoutStartX() const
+{
+    return m_windowed ? m_layoutStartColumn * m_columnWidth : 0;
+}
+
+bool KateLineLayout::windowCovers(int startX, int endX) const
+{
+    if (!m_windowed) {
+        return true;
+    }
+
+    // the window ends at the line ends count as covering everything beyond them
+    return (m_layoutStartColumn == 0 || layoutStartX() <= startX)
+        && (m_layoutEndColumn == length() || layoutStartX() + m_layout->lineAt(0).naturalTextWidth() >= endX);
+}
+
+qreal KateLineLayout::cursorToX(int column) const
+{
+    Q_ASSERT(m_windowed);
+
+    if (column < m_layoutStartColumn) {
+        return column * m_columnWidth;
+    }
+
+    const QTextLine line = m_layout->lineAt(0);
+    if (column > m_layoutEndColumn) {
+        return layoutStartX() + line.naturalTextWidth() + (column - m_layoutEndColumn) * m_columnWidth;
+    }
+
+    return layoutStartX() + line.cursorToX(column - m_layoutStartColumn);
+}
+
+int KateLineLayout::xToCursor(qreal x) const
+{
+    Q_ASSERT(m_windowed);
+
+    const qreal startX = layoutStartX();
+    if (x < startX) {
+        return qMax(0, qRound(x / m_columnWidth));
+    }
+
+    const QTextLine line = m_layout->lineAt(0);
+    const qreal endX = startX + line.naturalTextWidth();
+    if (x > endX) {
+        return qMin(length(), m_layoutEndColumn + qRound((x - endX) / m_columnWidth));
+    }
+
+    return m_layoutStartColumn + line.xToCursor(x - startX);
+}
+
+int KateLineLayout::nextCursorPosition(int column) const
+{
+    if (!m_windowed) {
+        return m_layout->nextCursorPosition(column);
+    }
+
+    // outside of the window, only keep surrogate pairs together
+    if (column < m_layoutStartColumn || column >= m_layoutEndColumn) {
+        const QString &text = textLine()->string();
+        if (column + 1 < text.size() && text.at(column).isHighSurrogate() && text.at(column + 1).isLowSurrogate()) {
+            return column + 2;
+        }
+        return qMin(column + 1, text.size());
+    }
+
+    return m_layoutStartColumn + m_layout->nextCursorPosition(column - m_layoutStartColumn);
+}
+
+int KateLineLayout::previousCursorPosition(int column) const
+{
+    if (!m_windowed) {
+        return m_layout->previousCursorPosition(column);
+    }
+
+    // outside of the window, only keep surrogate pairs together
+    if (column <= m_layoutStartColumn || column > m_layoutEndColumn) {
+        const QString &text = textLine()->string();
+        if (column > 1 && column <= text.size() && text.at(column - 1).isLowSurrogate() && text.at(column - 2).isHighSurrogate()) {
+            return column - 2;
+        }
+        return qMax(column - 1, 0);
+    }
+
+    return m_layoutStartColumn + m_layout->previousCursorPosition(column - m_layoutStartColumn);
+}
+
 bool KateLineLayout::isRightToLeft() const
 {
     if (!m_layout) {
@@ -257,3 +375,25 @@ bool KateLineLayout::isRightToLeft() const
 
     return m_layout->textOption().textDirection() == Qt::RightToLeft;
 }
+
+bool KateLineLayout::hasDecorations() const
+{
+    return m_decorationsValid;
+}
+
+const QVector<QTextLayout::FormatRange> &KateLineLayout::decorations() const
+{
+    return m_decorations;
+}
+
+void KateLineLayout::setDecorations(const QVector<QTextLayout::FormatRange> &decorations)
+{
+    m_decorations = decorations;
+    m_decorationsValid = true;
+}
+
+void KateLineLayout::invalidateDecorations()
+{
+    m_decorations.clear();
+    m_decorationsValid = false;
+}
@@ -24,12 +24,13 @@
 
 #include <QExplicitlySharedDataPointer>
 #include <QSharedData>
+#include <QTextLayout>
+#include <QVector>
 
 #include "katetextline.h"
 
 #include <ktexteditor/cursor.h>
 
-class QTextLayout;
 namespace KTextEditor
 {
 class DocumentPrivate;
@@ -104,6 +105,68 @@ public:
     bool usePlainTextLine() const;
     void setUsePlainTextLine(bool plain = true);
 
+    /**
+     * Lines longer than the line length limit are not shaped as a whole without
+     * dynamic word wrap. The layout() then only holds the columns of a window
+     * around the visible part, columns outside of it are mapped to x positions
+     * with a fixed column width. Such lines always have exactly one view line.
+     */
+    bool isWindowed() const;
+
+    /**
+     * Set the columns [startColumn, endColumn) held by layout(), must be called after setLayout().
+     * @param columnWidth width of one column outside of the window
+     */
+    void setWindow(int startColumn, int endColumn, qreal columnWidth);
+
+    /**
+     * First column held by layout(), 0 for lines laid out as a whole.
+     */
+    int layoutStartColumn() const;
+
+    /**
+     * Column behind the last one held by layout().
+     */
+    int layoutEndColumn() const;
+
+    /**
+     * x position of layoutStartColumn().
+     */
+    qreal layoutStartX() const;
+
+    /**
+     * Does the window show everything between the x positions @p startX and @p endX?
+     * Always true for lines laid out as a whole.
+     */
+    bool windowCovers(int startX, int endX) const;
+
+    /**
+     * x position of a column of a windowed line, see KateTextLayout::cursorToX().
+     */
+    qreal cursorToX(int column) const;
+
+    /**
+     * Column at the x position of a windowed line, see KateTextLayout::xToCursor().
+     */
+    int xToCursor(qreal x) const;
+
+    /**
+     * Cursor positions next to @p column, like QTextLayout::nextCursorPosition()
+     * and QTextLayout::previousCursorPosition(), but for all columns of windowed lines.
+     */
+    int nextCursorPosition(int column) const;
+    int previousCursorPosition(int column) const;
+
+    /**
+     * Formats of the highlighting and of the ranges with attributes, as computed by
+     * KateRenderer::decorationsForLine(). Unlike the layout they survive relayouts,
+     * e.g. for a changed selection or a moved window, until invalidateDecorations().
+     */
+    bool hasDecorations() const;
+    const QVector<QTextLayout::FormatRange> &decorations() const;
+    void setDecorations(const QVector<QTextLayout::FormatRange> &decorations);
+    void invalidateDecorations();
+
 private:
     // Disable copy
     KateLineLayout(const KateLineLayout &copy);
@@ -121,6 +184,14 @@ private:
 
     bool m_layoutDirty;
     bool m_usePlainTextLine;
+
+    bool m_windowed = false;
+    int m_layoutStartColumn = 0;
+    int m_layoutEndColumn = 0;
+    qreal m_columnWidth = 0;
+
+    QVector<QTextLayout::FormatRange> m_decorations;
+    bool m_decorationsValid = false;
 };
 
 typedef QExplicitlySharedDataPointer<KateLineLayout> KateLineLayoutPtr;
@@ -45,10 +45,42 @@
 #include <QTextLine>
 #include <QtMath> // qCeil
 
+#include <algorithm>
+
 static const QChar tabChar(QLatin1Char('\t'));
 static const QChar spaceChar(QLatin1Char(' '));
 static const QChar nbSpaceChar(0xa0); // non-breaking space
 
+namespace
+{
+/**
+ * Windows of long lines start and end at multiples of this many columns.
+ * The window spans the chunk in front of the visible one up to the chunk behind it.
+ */
+const int WindowChunkLength = 4096;
+
+/**
+ * Number of interned formats of merged attributes, before they are dropped and interned anew.
+ */
+const int MaximalMergedFormatCount = 1024;
+
+/**
+ * Restrict the format ranges of a whole line to the columns [start, end) and make them relative to @p start.
+ */
+QVector<QTextLayout::FormatRange> windowFormats(const QVector<QTextLayout::FormatRange> &formats, int start, int end)
+{
+    QVector<QTextLayout::FormatRange> result;
+    for (const QTextLayout::FormatRange &format : formats) {
+        const int formatStart = qMax(format.start, start);
+        const int formatEnd = qMin(format.start + format.length, end);
+        if (formatStart < formatEnd) {
+            result.append(QTextLayout::FormatRange {formatStart - start, formatEnd - formatStart, format.format});
+        }
+    }
+    return result;
+}
+}
+
 KateRenderer::KateRenderer(KTextEditor::DocumentPrivate *doc, Kate::TextFolding &folding, KTextEditor::ViewPrivate *view)
     : m_doc(doc)
     , m_folding(folding)
@@ -83,6 +115,7 @@ KateRenderer::~KateRenderer()
 void KateRenderer::updateAttributes()
 {
     m_attributes = m_doc->highlight()->attributes(config()->schema());
+    clearMergedFormats();
 }
 
 KTextEditor::Attribute::Ptr KateRenderer::attribute(uint pos) const
@@ -374,7 +407,8 @@ static bool rangeLessThanForRenderer(const Kate::TextRange *a, const Kate::TextR
     return false;
 }
 
-QVector<QTextLayout::FormatRange> KateRenderer::decorationsForLine(const Kate::TextLine &textLine, int line, bool selectionsOnly, bool completionHighlight, bool completionSelected) const
+QVector<QTextLayout::FormatRange>
+KateRenderer::decorationsForLine(const Kate::TextLine &textLine, int line, bool selectionsOnly, bool completionHighlight, bool completionSelected, int startColumn, int endColumn) const
 {
     // limit number of attributes we can highlight in reasonable time
     const int limitOfRanges = 1024;
@@ -390,10 +424,14 @@ QVector<QTextLayout::FormatRange> KateRenderer::decorationsForLine(const Kate::T
     }
 
     // Add the inbuilt highlighting to the list, limit with limitOfRanges
+    // the attributes are sorted, start with the first one reaching into the wanted columns
     RenderRangeVector renderRanges;
     if (!al.isEmpty()) {
         auto &currentRange = renderRanges.pushNewRange();
-        for (int i = 0; i < std::min(al.count(), limitOfRanges); ++i) {
+        const int first = std::lower_bound(al.begin(), al.end(), startColumn, [](const Kate::TextLineData::Attribute &attribute, int column) {
+                              return attribute.offset + attribute.length <= column;
+                          }) - al.begin();
+        for (int i = first; i < std::min(al.count(), first + limitOfRanges) && (endColumn < 0 || al[i].offset < endColumn); ++i) {
             if (al[i].length > 0 && al[i].attributeValue > 0) {
                 currentRange.addRange(KTextEditor::Range(KTextEditor::Cursor(line, al[i].offset), al[i].length), specificAttribute(al[i].attributeValue));
             }
@@ -438,7 +476,8 @@ QVector<QTextLayout::FormatRange> KateRenderer::decorationsForLine(const Kate::T
     }
 
     // Add selection highlighting if we're creating the selection decorations
-    if ((m_view && selectionsOnly && showSelections() && m_view->selection()) || (completionHighlight && completionSelected) || (m_view && m_view->blockSelection())) {
+    const bool withSelection = (m_view && selectionsOnly && showSelections() && m_view->selection()) || (completionHighlight && completionSelected) || (m_view && m_view->blockSelection());
+    if (withSelection) {
         auto &currentRange = renderRanges.pushNewRange();
 
         // Set up the selection background attribute TODO: move this elsewhere, eg. into the config?
@@ -483,6 +522,12 @@ QVector<QTextLayout::FormatRange> KateRenderer::decorationsForLine(const Kate::T
         endPosition = KTextEditor::Cursor(line + 1, 0);
     }
 
+    // only the wanted columns
+    currentPosition = qMax(currentPosition, KTextEditor::Cursor(line, startColumn));
+    if (endColumn >= 0 && endColumn < textLine->length()) {
+        endPosition = qMin(endPosition, KTextEditor::Cursor(line, endColumn));
+    }
+
     // Main iterative loop.  This walks through each set of highlighting ranges, and stops each
     // time the highlighting changes.  It then creates the corresponding QTextLayout::FormatRanges.
     QVector<QTextLayout::FormatRange> newHighlight;
@@ -496,6 +541,9 @@ QVector<QTextLayout::FormatRange> KateRenderer::decorationsForLine(const Kate::T
         }
 
         KTextEditor::Cursor nextPosition = renderRanges.nextBoundary();
+        if (endPosition.line() == line) {
+            nextPosition = qMin(nextPosition, endPosition);
+        }
 
         // Create the format range and populate with the correct start, length and format info
         QTextLayout::FormatRange fr;
@@ -509,13 +557,18 @@ QVector<QTextLayout::FormatRange> KateRenderer::decorationsForLine(const Kate::T
             fr.length = textLine->length() - currentPosition.column() + 1;
         }
 
-        KTextEditor::Attribute::Ptr a = renderRanges.generateAttribute();
-        if (a) {
-            fr.format = *a;
+        // the selection attribute is changed in place above, never intern formats merged with it
+        if (selectionsOnly || withSelection) {
+            KTextEditor::Attribute::Ptr a = renderRanges.generateAttribute();
+            if (a) {
+                fr.format = *a;
 
-            if (selectionsOnly) {
-                assignSelectionBrushesFromAttribute(fr, *a);
+                if (selectionsOnly) {
+                    assignSelectionBrushesFromAttribute(fr, *a);
+                }
             }
+        } else {
+            fr.format = mergedFormat(renderRanges);
         }
 
         newHighlight.append(fr);
@@ -526,6 +579,39 @@ QVector<QTextLayout::FormatRange> KateRenderer::decorationsForLine(const Kate::T
     return newHighlight;
 }
 
+void KateRenderer::clearMergedFormats()
+{
+    m_mergedFormats.clear();
+}
+
+QTextCharFormat KateRenderer::mergedFormat(const RenderRangeVector &renderRanges) const
+{
+    renderRanges.currentAttributes(m_currentAttributes);
+    Q_ASSERT(!m_currentAttributes.isEmpty());
+
+    // a single attribute needs no merging
+    if (m_currentAttributes.size() == 1) {
+        return *m_currentAttributes.first();
+    }
+
+    const auto it = m_mergedFormats.constFind(m_currentAttributes);
+    if (it != m_mergedFormats.constEnd()) {
+        return it->format;
+    }
+
+    // ranges come and go, don't keep their attributes alive forever
+    if (m_mergedFormats.size() >= MaximalMergedFormatCount) {
+        m_mergedFormats.clear();
+    }
+
+    MergedFormat merged;
+    merged.format = *renderRanges.generateAttribute();
+    for (KTextEditor::Attribute *attribute : qAsConst(m_currentAttributes)) {
+        merged.attributes.append(KTextEditor::Attribute::Ptr(attribute));
+    }
+    return m_mergedFormats.insert(m_currentAttributes, merged)->format;
+}
+
 void KateRenderer::assignSelectionBrushesFromAttribute(QTextLayout::FormatRange &target, const KTextEditor::Attribute &attribute) const
 {
     if (attribute.hasProperty(SelectedForeground)) {
@@ -587,6 +673,10 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
             }
         }
 
+        // windowed lines only hold the columns from layoutStartColumn() on
+        const int layoutStartColumn = range->layoutStartColumn();
+        const QPointF layoutPosition(range->layoutStartX() - xStart, 0);
+
         QVector<QTextLayout::FormatRange> additionalFormats;
         if (range->length() > 0) {
             // We may have changed the pen, be absolutely sure it gets set back to
@@ -595,11 +685,16 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
             paint.setPen(attribute(KTextEditor::dsNormal)->foreground().color());
             // Draw the text :)
             if (drawSelection) {
-                additionalFormats = decorationsForLine(range->textLine(), range->line(), true);
-                range->layout()->draw(&paint, QPoint(-xStart, 0), additionalFormats);
+                if (range->isWindowed()) {
+                    additionalFormats = decorationsForLine(range->textLine(), range->line(), true, false, false, layoutStartColumn, range->layoutEndColumn());
+                    additionalFormats = windowFormats(additionalFormats, layoutStartColumn, range->layoutEndColumn());
+                } else {
+                    additionalFormats = decorationsForLine(range->textLine(), range->line(), true);
+                }
+                range->layout()->draw(&paint, layoutPosition, additionalFormats);
 
             } else {
-                range->layout()->draw(&paint, QPoint(-xStart, 0));
+                range->layout()->draw(&paint, layoutPosition);
             }
         }
 
@@ -612,16 +707,19 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
         for (int i = 0; i < range->viewLineCount(); ++i) {
             KateTextLayout line = range->viewLine(i);
 
+            // the formats are relative to the start of the layout
+            const int endCol = line.endCol() - layoutStartColumn;
+
             bool haveBackground = false;
             // Determine the background to use, if any, for the end of this view line
             backgroundBrushSet = false;
             while (it2.hasNext()) {
                 const QTextLayout::FormatRange &fr = it2.peekNext();
-                if (fr.start > line.endCol()) {
+                if (fr.start > endCol) {
                     break;
                 }
 
-                if (fr.start + fr.length > line.endCol()) {
+                if (fr.start + fr.length > endCol) {
                     if (fr.format.hasProperty(QTextFormat::BackgroundBrush)) {
                         backgroundBrushSet = true;
                         backgroundBrush = fr.format.background();
@@ -636,11 +734,11 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
 
             while (!haveBackground && it.hasNext()) {
                 const QTextLayout::FormatRange &fr = it.peekNext();
-                if (fr.start > line.endCol()) {
+                if (fr.start > endCol) {
                     break;
                 }
 
-                if (fr.start + fr.length > line.endCol()) {
+                if (fr.start + fr.length > endCol) {
                     if (fr.format.hasProperty(QTextFormat::BackgroundBrush)) {
                         backgroundBrushSet = true;
                         backgroundBrush = fr.format.background();
@@ -695,10 +793,10 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
             // draw an open box to mark non-breaking spaces
             const QString &text = range->textLine()->string();
             int y = lineHeight() * i + fm.ascent() - fm.strikeOutPos();
-            int nbSpaceIndex = text.indexOf(nbSpaceChar, line.lineLayout().xToCursor(xStart));
+            int nbSpaceIndex = text.indexOf(nbSpaceChar, line.xToCursor(xStart));
 
             while (nbSpaceIndex != -1 && nbSpaceIndex < line.endCol()) {
-                int x = line.lineLayout().cursorToX(nbSpaceIndex);
+                int x = line.cursorToX(nbSpaceIndex);
                 if (x > xEnd) {
                     break;
                 }
@@ -708,9 +806,9 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
 
             // draw tab stop indicators
             if (showTabs()) {
-                int tabIndex = text.indexOf(tabChar, line.lineLayout().xToCursor(xStart));
+                int tabIndex = text.indexOf(tabChar, line.xToCursor(xStart));
                 while (tabIndex != -1 && tabIndex < line.endCol()) {
-                    int x = line.lineLayout().cursorToX(tabIndex);
+                    int x = line.cursorToX(tabIndex);
                     if (x > xEnd) {
                         break;
                     }
@@ -722,10 +820,17 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
             // draw trailing spaces
             if (showSpaces() != KateDocumentConfig::None) {
                 int spaceIndex = line.endCol() - 1;
+                int firstIndex = line.startCol();
                 const int trailingPos = showSpaces() == KateDocumentConfig::All ? 0 : qMax(range->textLine()->lastChar(), 0);
 
+                // only check the visible columns of windowed lines, they can be very long
+                if (range->isWindowed()) {
+                    spaceIndex = qMin(spaceIndex, line.xToCursor(xEnd));
+                    firstIndex = qMax(firstIndex, line.xToCursor(xStart) - 1);
+                }
+
                 if (spaceIndex >= trailingPos) {
-                    for (; spaceIndex >= line.startCol(); --spaceIndex) {
+                    for (; spaceIndex >= firstIndex; --spaceIndex) {
                         if (!text.at(spaceIndex).isSpace()) {
                             if (showSpaces() == KateDocumentConfig::Trailing)
                                 break;
@@ -735,9 +840,9 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
 
                         if (text.at(spaceIndex) != QLatin1Char('\t') || !showTabs()) {
                             if (range->layout()->textOption().alignment() == Qt::AlignRight) { // Draw on left for RTL lines
-                                paintSpace(paint, line.lineLayout().cursorToX(spaceIndex) - xStart - spaceWidth() / 2.0, y);
+                                paintSpace(paint, line.cursorToX(spaceIndex) - xStart - spaceWidth() / 2.0, y);
                             } else {
-                                paintSpace(paint, line.lineLayout().cursorToX(spaceIndex) - xStart + spaceWidth() / 2.0, y);
+                                paintSpace(paint, line.cursorToX(spaceIndex) - xStart + spaceWidth() / 2.0, y);
                             }
                         }
                     }
@@ -748,12 +853,12 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
                 const int y = lineHeight() * i + fm.ascent();
 
                 static const QRegularExpression nonPrintableSpacesRegExp(QStringLiteral("[\\x{2000}-\\x{200F}\\x{2028}-\\x{202F}\\x{205F}-\\x{2064}\\x{206A}-\\x{206F}]"));
-                QRegularExpressionMatchIterator i = nonPrintableSpacesRegExp.globalMatch(text, line.lineLayout().xToCursor(xStart));
+                QRegularExpressionMatchIterator i = nonPrintableSpacesRegExp.globalMatch(text, line.xToCursor(xStart));
 
                 while (i.hasNext()) {
                     const int charIndex = i.next().capturedStart();
 
-                    const int x = line.lineLayout().cursorToX(charIndex);
+                    const int x = line.cursorToX(charIndex);
                     if (x > xEnd) {
                         break;
                     }
@@ -774,7 +879,11 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
         if (drawCaret() && cursor && range->includesCursor(*cursor)) {
             int caretWidth, lineWidth = 2;
             QColor color;
-            QTextLine line = range->layout()->lineForTextPosition(qMin(cursor->column(), range->length()));
+
+            // column of the caret inside the layout, windowed lines might not hold it
+            const int layoutColumn = cursor->column() - layoutStartColumn;
+            const bool caretInLayout = layoutColumn >= 0 && cursor->column() <= range->layoutEndColumn();
+            QTextLine line = caretInLayout ? range->layout()->lineForTextPosition(qMin(cursor->column(), range->length()) - layoutStartColumn) : QTextLine();
 
             // Determine the caret's style
             caretStyles style = caretStyle();
@@ -782,8 +891,8 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
             // Make the caret the desired width
             if (style == Line) {
                 caretWidth = lineWidth;
-            } else if (line.isValid() && cursor->column() < range->length()) {
-                caretWidth = int(line.cursorToX(cursor->column() + 1) - line.cursorToX(cursor->column()));
+            } else if (line.isValid() && cursor->column() < range->layoutEndColumn()) {
+                caretWidth = int(line.cursorToX(layoutColumn + 1) - line.cursorToX(layoutColumn));
                 if (caretWidth < 0) {
                     caretWidth = -caretWidth;
                 }
@@ -800,7 +909,7 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
                 // search for the FormatRange that includes the cursor
                 const auto formatRanges = range->layout()->formats();
                 for (const QTextLayout::FormatRange &r : formatRanges) {
-                    if ((r.start <= cursor->column()) && ((r.start + r.length) > cursor->column())) {
+                    if ((r.start <= layoutColumn) && ((r.start + r.length) > layoutColumn)) {
                         // check for Qt::NoBrush, as the returned color is black() and no invalid QColor
                         QBrush foregroundBrush = r.format.foreground();
                         if (foregroundBrush != Qt::NoBrush) {
@@ -833,10 +942,10 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
                 break;
             }
 
-            if (cursor->column() <= range->length()) {
-                range->layout()->drawCursor(&paint, QPoint(-xStart, 0), cursor->column(), caretWidth);
+            if (caretInLayout && cursor->column() <= range->length()) {
+                range->layout()->drawCursor(&paint, layoutPosition, layoutColumn, caretWidth);
             } else {
-                // Off the end of the line... must be block mode. Draw the caret ourselves.
+                // Off the end of the line... must be block mode. Or outside of the window of a windowed line. Draw the caret ourselves.
                 const KateTextLayout &lastLine = range->viewLine(range->viewLineCount() - 1);
                 int x = cursorToX(lastLine, KTextEditor::Cursor(range->line(), cursor->column()), true);
                 if ((x >= xStart) && (x <= xEnd)) {
@@ -867,7 +976,7 @@ void KateRenderer::paintTextLine(QPainter &paint, KateLineLayoutPtr range, int x
 
             // Determine the position where to paint the note.
             // We start by getting the x coordinate of cursor placed to the column.
-            qreal x = range->viewLine(viewLine).lineLayout().cursorToX(column) - xStart;
+            qreal x = range->viewLine(viewLine).cursorToX(column) - xStart;
             int textLength = range->length();
             if (column == 0 || column < textLength) {
                 // If the note is inside text or at the beginning, then there is a hole in the text where the
@@ -996,18 +1105,40 @@ qreal KateRenderer::spaceWidth() const
     return m_fontMetrics.horizontalAdvance(spaceChar);
 }
 
-void KateRenderer::layoutLine(KateLineLayoutPtr lineLayout, int maxwidth, bool cacheLayout) const
+void KateRenderer::layoutLine(KateLineLayoutPtr lineLayout, int maxwidth, bool cacheLayout, int startX) const
 {
     // if maxwidth == -1 we have no wrap
 
     Kate::TextLine textLine = lineLayout->textLine();
     Q_ASSERT(textLine);
 
+    // without wrapping, shape only a window of columns of too long lines around the visible part
+    // columns outside of the window are one space wide, like the ones past the end of line
+    const int lineLengthLimit = m_doc->lineLengthLimit();
+    const bool windowed = (maxwidth == -1) && (lineLengthLimit > 0) && (textLine->length() > lineLengthLimit) && !isLineRightToLeft(lineLayout);
+    int windowStart = 0;
+    int windowEnd = textLine->length();
+    if (windowed) {
+        const int chunk = int(qMax(0, startX) / spaceWidth()) / WindowChunkLength;
+        windowStart = qMin(qMax(0, chunk - 1) * WindowChunkLength, textLine->length());
+        windowEnd = qMin((chunk + 2) * WindowChunkLength, textLine->length());
+
+        // never split surrogate pairs
+        const QString &text = textLine->string();
+        if (windowStart > 0 && windowStart < text.size() && text.at(windowStart).isLowSurrogate()) {
+            --windowStart;
+        }
+        if (windowEnd < text.size() && text.at(windowEnd).isLowSurrogate()) {
+            ++windowEnd;
+        }
+    }
+    const QString text = windowed ? textLine->string().mid(windowStart, windowEnd - windowStart) : textLine->string();
+
     QTextLayout *l = lineLayout->layout();
     if (!l) {
-        l = new QTextLayout(textLine->string(), m_font);
+        l = new QTextLayout(text, m_font);
     } else {
-        l->setText(textLine->string());
+        l->setText(text);
         l->setFont(m_font);
     }
 
@@ -1043,7 +1174,20 @@ void KateRenderer::layoutLine(KateLineLayoutPtr lineLayout, int maxwidth, bool c
     l->setTextOption(opt);
 
     // Syntax highlighting, inbuilt and arbitrary
-    QVector<QTextLayout::FormatRange> decorations = decorationsForLine(textLine, lineLayout->line());
+    // the line layout keeps them until its highlighting or ranges change, block selections are part of them and change too often
+    // windows of long lines only get the decorations of their columns, these are cheap to create and differ per window
+    const bool cacheDecorations = !windowed && !(m_view && m_view->blockSelection()) && !lineLayout->usePlainTextLine();
+    QVector<QTextLayout::FormatRange> decorations;
+    if (cacheDecorations && lineLayout->hasDecorations()) {
+        decorations = lineLayout->decorations();
+    } else if (windowed) {
+        decorations = decorationsForLine(textLine, lineLayout->line(), false, false, false, windowStart, windowEnd);
+    } else {
+        decorations = decorationsForLine(textLine, lineLayout->line());
+        if (cacheDecorations) {
+            lineLayout->setDecorations(decorations);
+        }
+    }
 
     int firstLineOffset = 0;
 
@@ -1058,8 +1202,10 @@ void KateRenderer::layoutLine(KateLineLayoutPtr lineLayout, int maxwidth, bool c
             // If it is inside the text, we use absolute letter spacing to create space for it between the two letters.
             // If it is outside of the text, we don't have to make space for it.
             if (column == 0) {
-                firstLineOffset = width;
-            } else if (column < l->text().length()) {
+                if (windowStart == 0) {
+                    firstLineOffset = width;
+                }
+            } else if (column < textLine->length()) {
                 QTextCharFormat text_char_format;
                 text_char_format.setFontLetterSpacing(width);
                 text_char_format.setFontLetterSpacingType(QFont::AbsoluteSpacing);
@@ -1067,6 +1213,9 @@ void KateRenderer::layoutLine(KateLineLayoutPtr lineLayout, int maxwidth, bool c
             }
         }
     }
+    if (windowed) {
+        decorations = windowFormats(decorations, windowStart, windowEnd);
+    }
     l->setFormats(decorations);
 
     // Begin layouting
@@ -1120,6 +1269,9 @@ void KateRenderer::layoutLine(KateLineLayoutPtr lineLayout, int maxwidth, bool c
     l->endLayout();
 
     lineLayout->setLayout(l);
+    if (windowed) {
+        lineLayout->setWindow(windowStart, windowEnd, spaceWidth());
+    }
 }
 
 // 1) QString::isRightToLeft() sux
@@ -1176,7 +1328,7 @@ int KateRenderer::cursorToX(const KateTextLayout &range, const KTextEditor::Curs
 
     int x;
     if (range.lineLayout().width() > 0) {
-        x = (int)range.lineLayout().cursorToX(pos.column());
+        x = (int)range.cursorToX(pos.column());
     } else {
         x = 0;
     }
@@ -1192,7 +1344,7 @@ int KateRenderer::cursorToX(const KateTextLayout &range, const KTextEditor::Curs
 KTextEditor::Cursor KateRenderer::xToCursor(const KateTextLayout &range, int x, bool returnPastLine) const
 {
     Q_ASSERT(range.isValid());
-    KTextEditor::Cursor ret(range.line(), range.lineLayout().xToCursor(x));
+    KTextEditor::Cursor ret(range.line(), range.xToCursor(x));
 
     // TODO wrong for RTL lines?
     if (returnPastLine && range.endCol(true) == -1 && x > range.width() + range.xOffset()) {
@@ -31,6 +31,7 @@
 #include <QFlags>
 #include <QFont>
 #include <QFontMetricsF>
+#include <QHash>
 #include <QTextLine>
 
 namespace KTextEditor
@@ -43,6 +44,7 @@ class ViewPrivate;
 }
 class KateRendererConfig;
 class KateRenderRange;
+class RenderRangeVector;
 namespace Kate
 {
 class TextFolding;
@@ -283,8 +285,12 @@ public:
 
     /**
      * Text width & height calculation functions...
+     *
+     * Without wrapping, lines longer than the line length limit of the document
+     * are only shaped in a window of columns around @p startX, see KateLineLayout::isWindowed().
+     * @param startX x position of the left edge of the visible area
      */
-    void layoutLine(KateLineLayoutPtr line, int maxwidth = -1, bool cacheLayout = false) const;
+    void layoutLine(KateLineLayoutPtr line, int maxwidth = -1, bool cacheLayout = false, int startX = 0) const;
 
     /**
      * This is a smaller QString::isRightToLeft(). It's also marked as internal to kate
@@ -302,8 +308,22 @@ public:
      * The ultimate decoration creation function.
      *
      * \param selectionsOnly return decorations for selections and/or dynamic highlighting.
+     * \param startColumn first column to decorate, for the window of a long line
+     * \param endColumn column behind the last one to decorate, -1 for the end of the line
+     */
+    QVector<QTextLayout::FormatRange> decorationsForLine(const Kate::TextLine &textLine,
+                                                         int line,
+                                                         bool selectionsOnly = false,
+                                                         bool completionHighlight = false,
+                                                         bool completionSelected = false,
+                                                         int startColumn = 0,
+                                                         int endColumn = -1) const;
+
+    /**
+     * Forget the interned formats of merged attributes, must be done when the
+     * attributes of ranges might have been changed in place.
      */
-    QVector<QTextLayout::FormatRange> decorationsForLine(const Kate::TextLine &textLine, int line, bool selectionsOnly = false, bool completionHighlight = false, bool completionSelected = false) const;
+    void clearMergedFormats();
 
     // Width calculators
     qreal spaceWidth() const;
@@ -411,6 +431,12 @@ private:
 
     void assignSelectionBrushesFromAttribute(QTextLayout::FormatRange &target, const KTextEditor::Attribute &attribute) const;
 
+    /**
+     * Format of the attributes the render ranges are at, merged like RenderRangeVector::generateAttribute().
+     * Merged formats are interned, instead of merging the attributes again for every span.
+     */
+    QTextCharFormat mergedFormat(const RenderRangeVector &renderRanges) const;
+
     // update font height
     void updateFontHeight();
 
@@ -437,6 +463,17 @@ private:
 
     QVector<KTextEditor::Attribute::Ptr> m_attributes;
 
+    /**
+     * interned formats of merged attributes, keyed by the attributes in merge order,
+     * the references on them keep the keys valid
+     */
+    struct MergedFormat {
+        QTextCharFormat format;
+        QVector<KTextEditor::Attribute::Ptr> attributes;
+    };
+    mutable QHash<QVector<KTextEditor::Attribute *>, MergedFormat> m_mergedFormats;
+    mutable QVector<KTextEditor::Attribute *> m_currentAttributes;
+
     /**
      * Configuration
      */
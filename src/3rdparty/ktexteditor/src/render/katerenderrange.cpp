@@ -122,7 +122,7 @@ bool NormalRenderRange::advanceTo(const KTextEditor::Cursor &pos)
     return false;
 }
 
-KTextEditor::Attribute::Ptr NormalRenderRange::currentAttribute() const
+const KTextEditor::Attribute::Ptr &NormalRenderRange::currentAttribute() const
 {
     return m_currentAttribute;
 }
@@ -192,3 +192,13 @@ KTextEditor::Attribute::Ptr RenderRangeVector::generateAttribute() const
 
     return a;
 }
+
+void RenderRangeVector::currentAttributes(QVector<KTextEditor::Attribute *> &attributes) const
+{
+    attributes.clear();
+    for (auto &r : m_ranges) {
+        if (const auto &a = r.currentAttribute()) {
+            attributes.append(a.data());
+        }
+    }
+}
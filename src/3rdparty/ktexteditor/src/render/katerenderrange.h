@@ -25,6 +25,8 @@
 #include <ktexteditor/attribute.h>
 #include <ktexteditor/range.h>
 
+#include <QVector>
+
 #include <utility>
 #include <vector>
 
@@ -37,7 +39,7 @@ public:
 
     KTextEditor::Cursor nextBoundary() const;
     bool advanceTo(const KTextEditor::Cursor &pos);
-    KTextEditor::Attribute::Ptr currentAttribute() const;
+    const KTextEditor::Attribute::Ptr &currentAttribute() const;
 
 private:
     std::vector<std::pair<KTextEditor::Range, KTextEditor::Attribute::Ptr>> m_ranges;
@@ -53,6 +55,12 @@ public:
     void advanceTo(const KTextEditor::Cursor &pos);
     bool hasAttribute() const;
     KTextEditor::Attribute::Ptr generateAttribute() const;
+
+    /**
+     * Collect the attributes generateAttribute() would merge, in merge order.
+     * Together they identify the merged attribute without creating it.
+     */
+    void currentAttributes(QVector<KTextEditor::Attribute *> &attributes) const;
     NormalRenderRange &pushNewRange();
     bool isEmpty() const
     {
@@ -65,6 +65,24 @@ int KateTextLayout::xOffset() const
     return startX() ? m_lineLayout->shiftX() : 0;
 }
 
+qreal KateTextLayout::cursorToX(int column) const
+{
+    if (m_lineLayout->isWindowed()) {
+        return m_lineLayout->cursorToX(column);
+    }
+
+    return m_textLayout.cursorToX(column);
+}
+
+int KateTextLayout::xToCursor(qreal x) const
+{
+    if (m_lineLayout->isWindowed()) {
+        return m_lineLayout->xToCursor(x);
+    }
+
+    return m_textLayout.xToCursor(x);
+}
+
 void KateTextLayout::debugOutput() const
 {
     qCDebug(LOG_KTE) << "KateTextLayout: " << m_lineLayout << " valid " << isValid() << " line " << m_lineLayout->line() << " (" << line() << ") cols [" << startCol() << " -> " << endCol() << "] x [" << startX() << " -> " << endX()
@@ -158,7 +176,7 @@ int KateTextLayout::endCol(bool indicateEOL) const
             return -1;
         }
 
-    return startCol() + m_textLayout.textLength();
+    return startCol() + length();
 }
 
 KTextEditor::Cursor KateTextLayout::end(bool indicateEOL) const
@@ -172,6 +190,11 @@ int KateTextLayout::length() const
         return 0;
     }
 
+    // the only view line of windowed lines spans all columns
+    if (m_lineLayout->isWindowed()) {
+        return m_lineLayout->length();
+    }
+
     return m_textLayout.textLength();
 }
 
@@ -214,7 +237,7 @@ int KateTextLayout::endX() const
         return 0;
     }
 
-    return startX() + (int)m_textLayout.naturalTextWidth();
+    return startX() + width();
 }
 
 int KateTextLayout::width() const
@@ -223,6 +246,10 @@ int KateTextLayout::width() const
         return 0;
     }
 
+    if (m_lineLayout->isWindowed()) {
+        return m_lineLayout->width();
+    }
+
     return (int)m_textLayout.naturalTextWidth();
 }
 
@@ -83,6 +83,18 @@ public:
 
     int xOffset() const;
 
+    /**
+     * x position of the given column, like lineLayout().cursorToX(), but for all
+     * columns of windowed lines, see KateLineLayout::isWindowed().
+     */
+    qreal cursorToX(int column) const;
+
+    /**
+     * Column at the given x position, like lineLayout().xToCursor(), but for all
+     * columns of windowed lines, see KateLineLayout::isWindowed().
+     */
+    int xToCursor(qreal x) const;
+
     bool isRightToLeft() const;
 
     bool includesCursor(const KTextEditor::Cursor &realCursor) const;
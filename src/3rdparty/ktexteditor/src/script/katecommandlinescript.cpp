@@ -62,7 +62,7 @@ bool KateCommandLineScript::callFunction(const QString &cmd, const QStringList &
         arguments << QJSValue(arg);
     }
 
-    QJSValue result = command.call(arguments);
+    QJSValue result = call(command, arguments);
     // error during the calling?
     if (result.isError()) {
         errorMessage = backtrace(result, i18n("Error calling %1", cmd));
@@ -127,7 +127,7 @@ bool KateCommandLineScript::help(KTextEditor::View *view, const QString &cmd, QS
     QJSValueList arguments;
     arguments << QJSValue(cmd);
 
-    QJSValue result = helpFunction.call(arguments);
+    QJSValue result = call(helpFunction, arguments);
 
     // error during the calling?
     if (result.isError()) {
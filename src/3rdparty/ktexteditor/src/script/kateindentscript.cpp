@@ -75,7 +75,7 @@ QPair<int, int> KateIndentScript::indent(KTextEditor::ViewPrivate *view, const K
     arguments << QJSValue(indentWidth);
     arguments << (typedCharacter.isNull() ? QJSValue(QString()) : QJSValue(QString(typedCharacter)));
     // get the required indent
-    QJSValue result = indentFunction.call(arguments);
+    QJSValue result = call(indentFunction, arguments);
     // error during the calling?
     if (result.isError()) {
         displayBacktrace(result, QStringLiteral("Error calling indent()"));
@@ -0,0 +1,948 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "katenativeindenter.h"
+
+#include "katedocument.h"
+#include "kateindentscript.h"
+#include "kateview.h"
+
+#include <QRegularExpression>
+
+namespace
+{
+/**
+ * Compile a regular expression of the scripts.
+ * In JavaScript \s also matches the Unicode spaces and . excludes the line and paragraph
+ * separators, spell both out to match exactly what the script matches.
+ */
+QRegularExpression jsRegExp(const char *pattern)
+{
+    static const QLatin1String spaces("\\t\\n\\x{0B}\\f\\r \\x{A0}\\x{1680}\\x{2000}-\\x{200A}\\x{2028}\\x{2029}\\x{202F}\\x{205F}\\x{3000}\\x{FEFF}");
+
+    const QString source = QString::fromLatin1(pattern);
+    QString translated;
+    bool inClass = false;
+    for (int i = 0; i < source.size(); ++i) {
+        const QChar c = source.at(i);
+        if (c == QLatin1Char('\\') && i + 1 < source.size()) {
+            const QChar escaped = source.at(++i);
+            if (escaped == QLatin1Char('s') && inClass) {
+                translated += spaces;
+            } else if (escaped == QLatin1Char('s')) {
+                translated += QLatin1Char('[');
+                translated += spaces;
+                translated += QLatin1Char(']');
+            } else if (escaped == QLatin1Char('S') && !inClass) {
+                translated += QLatin1String("[^");
+                translated += spaces;
+                translated += QLatin1Char(']');
+            } else {
+                translated += c;
+                translated += escaped;
+            }
+        } else if (c == QLatin1Char('.') && !inClass) {
+            translated += QLatin1String("[^\\n\\r\\x{2028}\\x{2029}]");
+        } else {
+            if (c == QLatin1Char('[')) {
+                inClass = true;
+            } else if (c == QLatin1Char(']')) {
+                inClass = false;
+            }
+            translated += c;
+        }
+    }
+    return QRegularExpression(translated);
+}
+
+/**
+ * String.charAt(), a null character if out of range.
+ */
+QChar jsCharAt(const QString &string, int index)
+{
+    return (index >= 0 && index < string.size()) ? string.at(index) : QChar();
+}
+
+/**
+ * The trim functions of string.js, they only strip spaces and tabs.
+ */
+bool isBlank(QChar c)
+{
+    return c == QLatin1Char(' ') || c == QLatin1Char('\t');
+}
+
+QString ltrim(const QString &string)
+{
+    int start = 0;
+    while (start < string.size() && isBlank(string.at(start))) {
+        ++start;
+    }
+    return string.mid(start);
+}
+
+QString rtrim(const QString &string)
+{
+    int end = string.size();
+    while (end > 0 && isBlank(string.at(end - 1))) {
+        --end;
+    }
+    return string.left(end);
+}
+
+QString trim(const QString &string)
+{
+    return ltrim(rtrim(string));
+}
+
+// BEGIN KateCStyleIndenter
+/**
+ * Port of cstyle.js, using the configuration the script ships with.
+ */
+class KateCStyleIndenter : public KateNativeIndenter
+{
+public:
+    QString triggerCharacters() const override
+    {
+        return QStringLiteral("{})/:;#");
+    }
+
+protected:
+    int computeIndent(int line, int indentWidth, QChar typedCharacter) override
+    {
+        m_indentWidth = indentWidth;
+        m_mode = m_document.document()->highlightingModeAt(KTextEditor::Cursor(line, m_document.lineLength(line)));
+        const bool alignOnly = typedCharacter.isNull();
+
+        if (typedCharacter != QLatin1Char('\n') && !alignOnly) {
+            return processChar(line, typedCharacter);
+        }
+
+        return indentLine(line, alignOnly);
+    }
+
+private:
+    static const bool IndentCase = true;
+    static const bool IndentNamespace = true;
+    static const bool AutoInsertStar = true;
+    static const bool SnapSlash = true;
+    static const bool AutoInsertSlashes = false;
+    static const int AccessModifiers = 0;
+    static const int LineDelimiter = 50;
+
+    QChar charAt(int line, int column)
+    {
+        return m_document.document()->characterAt(KTextEditor::Cursor(line, column));
+    }
+
+    QChar firstChar(int line)
+    {
+        const QString c = m_document.firstChar(line);
+        return c.isEmpty() ? QChar() : c.at(0);
+    }
+
+    QChar lastChar(int line)
+    {
+        const QString c = m_document.lastChar(line);
+        return c.isEmpty() ? QChar() : c.at(0);
+    }
+
+    int findLeftBrace(int line, int column)
+    {
+        KTextEditor::Cursor cursor = m_document.anchorInternal(line, column, QLatin1Char('{'));
+        if (cursor.isValid()) {
+            const KTextEditor::Cursor parenthesisCursor = tryParenthesisBeforeBrace(cursor.line(), cursor.column());
+            if (parenthesisCursor.isValid()) {
+                cursor = parenthesisCursor;
+            }
+            return m_document.firstVirtualColumn(cursor.line());
+        }
+
+        return -1;
+    }
+
+    int lastNonEmptyLine(int line)
+    {
+        while (true) {
+            line = m_document.prevNonEmptyLine(line);
+            if (line == -1) {
+                return -1;
+            }
+            const QString string = ltrim(m_document.line(line));
+            if (string.startsWith(QLatin1String("//")) || string.startsWith(QLatin1Char('#'))) {
+                --line;
+                continue;
+            }
+            break;
+        }
+
+        return line;
+    }
+
+    KTextEditor::Cursor tryParenthesisBeforeBrace(int line, int column)
+    {
+        const int firstColumn = m_document.firstColumn(line);
+        while (column > firstColumn && m_document.isSpace(line, --column)) {
+        }
+        if (charAt(line, column) == QLatin1Char(')')) {
+            return m_document.anchorInternal(line, column, QLatin1Char('('));
+        }
+        return KTextEditor::Cursor::invalid();
+    }
+
+    int trySwitchStatement(int line)
+    {
+        static const QRegularExpression caseLabel = jsRegExp("^\\s*(default\\s*|case\\b.*):");
+        static const QRegularExpression switchStatement = jsRegExp("^\\s*switch\\b");
+
+        QString currentString = m_document.line(line);
+        if (!caseLabel.match(currentString).hasMatch()) {
+            return -1;
+        }
+
+        int indentation = -1;
+        int lineDelimiter = LineDelimiter;
+        int currentLine = line;
+
+        while (currentLine > 0 && lineDelimiter > 0) {
+            --currentLine;
+            --lineDelimiter;
+            if (m_document.firstColumn(currentLine) == -1) {
+                continue;
+            }
+
+            currentString = m_document.line(currentLine);
+            if (caseLabel.match(currentString).hasMatch()) {
+                indentation = m_document.firstVirtualColumn(currentLine);
+                break;
+            } else if (switchStatement.match(currentString).hasMatch()) {
+                indentation = m_document.firstVirtualColumn(currentLine);
+                if (IndentCase) {
+                    indentation += m_indentWidth;
+                }
+                break;
+            }
+        }
+
+        return indentation;
+    }
+
+    int tryAccessModifiers(int line)
+    {
+        static const QRegularExpression accessModifier = jsRegExp("^\\s*((public|protected|private)\\s*(slots|Q_SLOTS)?|(signals|Q_SIGNALS)\\s*):\\s*$");
+
+        if (!accessModifier.match(m_document.line(line)).hasMatch()) {
+            return -1;
+        }
+
+        const KTextEditor::Cursor cursor = m_document.anchorInternal(line, 0, QLatin1Char('{'));
+        if (!cursor.isValid()) {
+            return -1;
+        }
+
+        return m_document.firstVirtualColumn(cursor.line()) + AccessModifiers * m_indentWidth;
+    }
+
+    int tryCComment(int line)
+    {
+        int currentLine = m_document.prevNonEmptyLine(line - 1);
+        if (currentLine < 0) {
+            return -1;
+        }
+
+        int indentation = -1;
+
+        // we found a */, search the opening /* and return its indentation level
+        if (m_document.endsWith(currentLine, QStringLiteral("*/"), true)) {
+            const KTextEditor::Cursor cursor = m_document.rfindInternal(currentLine, m_document.lastColumn(currentLine), QStringLiteral("/*"));
+            if (cursor.isValid() && cursor.column() == m_document.firstColumn(cursor.line())) {
+                indentation = m_document.firstVirtualColumn(cursor.line());
+            }
+            return indentation;
+        }
+
+        // inbetween was an empty line, so do not copy the "*" character
+        if (currentLine != line - 1) {
+            return -1;
+        }
+
+        const int firstPos = m_document.firstColumn(currentLine);
+        const QChar char1 = charAt(currentLine, firstPos);
+        const QChar char2 = charAt(currentLine, firstPos + 1);
+        const QString currentString = m_document.line(currentLine);
+
+        if (char1 == QLatin1Char('/') && char2 == QLatin1Char('*') && !currentString.contains(QLatin1String("*/"))) {
+            indentation = m_document.firstVirtualColumn(currentLine);
+            if (AutoInsertStar) {
+                // only add '*', if there is none yet.
+                indentation += 1;
+                if (firstChar(line) != QLatin1Char('*')) {
+                    m_document.insertText(line, m_view->cursorPosition().column(), QStringLiteral("*"));
+                }
+                if (!m_document.isSpace(line, m_document.firstColumn(line) + 1) && !m_document.endsWith(line, QStringLiteral("*/"), true)) {
+                    m_document.insertText(line, m_document.firstColumn(line) + 1, QStringLiteral(" "));
+                }
+            }
+        } else if (char1 == QLatin1Char('*')) {
+            int commentLine = currentLine;
+            while (commentLine >= 0 && firstChar(commentLine) == QLatin1Char('*') && !m_document.endsWith(commentLine, QStringLiteral("*/"), true)) {
+                --commentLine;
+            }
+            if (commentLine < 0) {
+                indentation = m_document.firstVirtualColumn(currentLine);
+            } else if (m_document.startsWith(commentLine, QStringLiteral("/*"), true) && !m_document.endsWith(commentLine, QStringLiteral("*/"), true)) {
+                // found a /*, and all succeeding lines start with a *, so it's a comment block
+                indentation = m_document.firstVirtualColumn(currentLine);
+
+                // only add '*', if there is none yet.
+                if (AutoInsertStar && firstChar(line) != QLatin1Char('*')) {
+                    m_document.insertText(line, m_view->cursorPosition().column(), QStringLiteral("*"));
+                    if (!m_document.isSpace(line, m_document.firstColumn(line) + 1)) {
+                        m_document.insertText(line, m_document.firstColumn(line) + 1, QStringLiteral(" "));
+                    }
+                }
+            }
+        }
+
+        return indentation;
+    }
+
+    int tryCppComment(int line)
+    {
+        const int currentLine = line - 1;
+        if (currentLine < 0 || !AutoInsertSlashes) {
+            return -1;
+        }
+
+        int indentation = -1;
+
+        // allowed are: //, ///, //! ///<, //!< and ////...
+        if (m_document.startsWith(currentLine, QStringLiteral("//"), true)) {
+            static const QRegularExpression slashes = jsRegExp("^\\s*(\\/\\/)");
+            static const QRegularExpression docSlashes = jsRegExp("^\\s*(\\/\\/[\\/!][<]?\\s*)");
+            static const QRegularExpression plainSlashes = jsRegExp("^\\s*(\\/\\/\\s*)");
+
+            const int firstPos = m_document.firstColumn(currentLine);
+            const QString currentString = m_document.line(currentLine);
+
+            const QChar char3 = jsCharAt(currentString, firstPos + 2);
+            const QChar char4 = jsCharAt(currentString, firstPos + 3);
+            indentation = m_document.firstVirtualColumn(currentLine);
+
+            const QRegularExpression &prefix = (char3 == QLatin1Char('/') && char4 == QLatin1Char('/'))
+                ? slashes
+                : ((char3 == QLatin1Char('/') || char3 == QLatin1Char('!')) ? docSlashes : plainSlashes);
+            m_document.insertText(line, m_view->cursorPosition().column(), prefix.match(currentString).captured(1));
+        }
+
+        return indentation;
+    }
+
+    bool isNamespace(int line, int column)
+    {
+        static const QRegularExpression namespaceStart = jsRegExp("^\\s*namespace\\b");
+
+        if (m_document.firstColumn(line) == column && line > 0) {
+            --line;
+        }
+        return namespaceStart.match(m_document.line(line)).hasMatch();
+    }
+
+    int tryBrace(int line)
+    {
+        static const QRegularExpression openBrace = jsRegExp("\\{[^\\}]*$");
+
+        const int currentLine = lastNonEmptyLine(line - 1);
+        if (currentLine < 0) {
+            return -1;
+        }
+
+        const int lastPos = m_document.lastColumn(currentLine);
+        int indentation = -1;
+
+        const int matchColumn = openBrace.match(m_document.line(currentLine)).capturedStart();
+        if (matchColumn != -1 && m_document.isCode(currentLine, matchColumn)) {
+            const KTextEditor::Cursor cursor = tryParenthesisBeforeBrace(currentLine, lastPos);
+            if (cursor.isValid()) {
+                indentation = m_document.firstVirtualColumn(cursor.line()) + m_indentWidth;
+            } else {
+                indentation = m_document.firstVirtualColumn(currentLine);
+                if (IndentNamespace || !isNamespace(currentLine, lastPos)) {
+                    // take its indentation and add one indentation level
+                    indentation += m_indentWidth;
+                }
+            }
+        }
+
+        return indentation;
+    }
+
+    int tryCKeywords(int line, bool isBrace)
+    {
+        static const QRegularExpression keyword =
+            jsRegExp("^\\s*(if\\b|for|do\\b|while|switch|[}]?\\s*else|((private|public|protected|case|default|signals|Q_SIGNALS).*:))");
+
+        int currentLine = lastNonEmptyLine(line - 1);
+        if (currentLine < 0) {
+            return -1;
+        }
+
+        // if line ends with ')', find the '(' and check this line then.
+        int lastPos = m_document.lastColumn(currentLine);
+        KTextEditor::Cursor cursor = KTextEditor::Cursor::invalid();
+        if (charAt(currentLine, lastPos) == QLatin1Char(')')) {
+            cursor = m_document.anchorInternal(currentLine, lastPos, QLatin1Char('('));
+        }
+        if (cursor.isValid()) {
+            currentLine = cursor.line();
+        }
+
+        // found non-empty line
+        QString currentString = m_document.line(currentLine);
+        if (!keyword.match(currentString).hasMatch()) {
+            return -1;
+        }
+        lastPos = m_document.lastColumn(currentLine);
+        QChar lastChar = jsCharAt(currentString, lastPos);
+        int indentation = -1;
+
+        // ignore trailing comments see: https://bugs.kde.org/show_bug.cgi?id=189339
+        const int commentPos = currentString.indexOf(QLatin1String("//"));
+        if (commentPos != -1) {
+            currentString = rtrim(currentString.left(commentPos));
+            lastChar = jsCharAt(currentString, currentString.size() - 1);
+        }
+
+        // try to ignore lines like: if (a) b; or if (a) { b; }
+        if (lastChar != QLatin1Char(';') && lastChar != QLatin1Char('}')) {
+            // take its indentation and add one indentation level
+            indentation = m_document.firstVirtualColumn(currentLine);
+            if (!isBrace) {
+                indentation += m_indentWidth;
+            }
+        } else if (lastChar == QLatin1Char(';')) {
+            cursor = m_document.anchorInternal(currentLine, lastPos, QLatin1Char('('));
+            if (cursor.isValid()) {
+                indentation = m_document.toVirtualColumn(cursor.line(), cursor.column() + 1);
+            }
+        }
+
+        return indentation;
+    }
+
+    int tryCondition(int line)
+    {
+        static const QRegularExpression condition = jsRegExp("^\\s*(if\\b|[}]?\\s*else|do\\b|while\\b|for)");
+        static const QRegularExpression braceLessCondition = jsRegExp("^\\s*(if\\b|[}]?\\s*else|do\\b|while\\b|for)[^{]*$");
+
+        int currentLine = lastNonEmptyLine(line - 1);
+        if (currentLine < 0) {
+            return -1;
+        }
+
+        // found non-empty line
+        QString currentString = m_document.line(currentLine);
+        const QChar lastChar = jsCharAt(currentString, m_document.lastColumn(currentLine));
+        int indentation = -1;
+
+        if (lastChar == QLatin1Char(';') && !condition.match(currentString).hasMatch()) {
+            // look for a line that starts with if/for/while, that has one indent level less
+            const int currentIndentation = m_document.firstVirtualColumn(currentLine);
+            if (currentIndentation == 0) {
+                return -1;
+            }
+
+            int lineDelimiter = 10;
+            while (currentLine > 0 && lineDelimiter > 0) {
+                --currentLine;
+                --lineDelimiter;
+                const int firstPosVirtual = m_document.firstVirtualColumn(currentLine);
+                if (firstPosVirtual == -1) {
+                    continue;
+                }
+
+                if (firstPosVirtual < currentIndentation) {
+                    currentString = m_document.line(currentLine);
+                    if (braceLessCondition.match(currentString).hasMatch()) {
+                        indentation = firstPosVirtual;
+                    }
+                    break;
+                } else if (currentLine == 0 || lineDelimiter == 0) {
+                    return indentation;
+                }
+            }
+        }
+
+        return indentation;
+    }
+
+    int tryStatement(int line)
+    {
+        static const QRegularExpression statementEnd = jsRegExp("^(.*)(,|\"|'|\\))(;?)\\s*[\\.+]?\\s*(\\/\\/.*|\\/\\*.*\\*\\/\\s*)?$");
+        static const QRegularExpression include = jsRegExp("^#include");
+        static const QRegularExpression useStrict = jsRegExp("'use strict'");
+
+        int currentLine = lastNonEmptyLine(line - 1);
+        if (currentLine < 0) {
+            return -1;
+        }
+
+        int indentation = -1;
+        QString currentString = m_document.line(currentLine);
+        if (currentString.endsWith(QLatin1Char('('))) {
+            // increase indent level
+            return m_document.firstVirtualColumn(currentLine) + m_indentWidth;
+        }
+        const bool alignOnSingleQuote = m_mode == QLatin1String("PHP/PHP") || m_mode == QLatin1String("JavaScript");
+
+        // align on strings "..."\n => below the opening quote
+        const QRegularExpressionMatch result = statementEnd.match(currentString);
+        if (result.hasMatch()) {
+            const int anchorColumn = result.capturedLength(1);
+            const QString closing = result.captured(2);
+            const bool alignOnAnchor = result.capturedLength(3) == 0 && closing != QLatin1String(")");
+
+            // search for opening ", ' or (
+            KTextEditor::Cursor cursor = KTextEditor::Cursor::invalid();
+            if (closing == QLatin1String("\"") || (alignOnSingleQuote && closing == QLatin1String("'"))) {
+                const QChar quote = closing.at(0);
+                while (true) {
+                    // the script keeps the length of the first match for all lines
+                    int i = anchorColumn - 1;
+                    for (; i >= 0; --i) {
+                        if (jsCharAt(currentString, i) == quote && (i == 0 || jsCharAt(currentString, i - 1) != QLatin1Char('\\'))) {
+                            // also make sure that this is not a line like '#include "..."'
+                            if (include.match(currentString).hasMatch() || useStrict.match(currentString).hasMatch()) {
+                                return indentation;
+                            }
+                            cursor = KTextEditor::Cursor(currentLine, i);
+                            break;
+                        }
+                    }
+                    if (!alignOnAnchor && currentLine) {
+                        // skip the quote, whitespace and stuff like + or . (for PHP, JavaScript, ...)
+                        for (--i; i >= 0; --i) {
+                            const QChar c = jsCharAt(currentString, i);
+                            if (c != QLatin1Char(' ') && c != QLatin1Char('\t') && c != QLatin1Char('.') && c != QLatin1Char('+')) {
+                                break;
+                            }
+                        }
+                        if (i > 0) {
+                            // there's something in this line, use its indentation
+                            break;
+                        }
+                        // go to previous line
+                        --currentLine;
+                        currentString = m_document.line(currentLine);
+                    } else {
+                        break;
+                    }
+                }
+            } else if (closing == QLatin1String(",") && !currentString.contains(QLatin1Char('('))) {
+                // assume a function call: check for '(' brace
+                const int currentIndentation = m_document.firstVirtualColumn(currentLine);
+                const KTextEditor::Cursor braceCursor = m_document.anchorInternal(currentLine, anchorColumn, QLatin1Char('('));
+
+                if (!braceCursor.isValid() || currentIndentation < braceCursor.column()) {
+                    indentation = currentIndentation;
+                } else {
+                    indentation = braceCursor.column() + 1;
+                    while (m_document.isSpace(braceCursor.line(), indentation)) {
+                        ++indentation;
+                    }
+                }
+            } else {
+                cursor = m_document.anchorInternal(currentLine, anchorColumn, QLatin1Char('('));
+            }
+
+            if (cursor.isValid()) {
+                currentLine = cursor.line();
+                if (alignOnAnchor) {
+                    int column = cursor.column();
+                    bool inc = false;
+                    if (closing != QLatin1String("\"") && closing != QLatin1String("'")) {
+                        // place one column after the opening parens
+                        ++column;
+                        inc = true;
+                    }
+                    const int lastColumn = m_document.lastColumn(currentLine);
+                    while (column < lastColumn && m_document.isSpace(currentLine, column)) {
+                        ++column;
+                        inc = true;
+                    }
+                    indentation = inc ? m_document.toVirtualColumn(currentLine, column) : m_document.firstVirtualColumn(currentLine);
+                } else {
+                    indentation = m_document.firstVirtualColumn(currentLine);
+                }
+            }
+        } else if (rtrim(currentString).endsWith(QLatin1Char(';'))) {
+            indentation = m_document.firstVirtualColumn(currentLine);
+        }
+
+        return indentation;
+    }
+
+    int tryMatchedAnchor(int line, bool alignOnly)
+    {
+        const QChar c = firstChar(line);
+        if (c != QLatin1Char('}') && c != QLatin1Char(')') && c != QLatin1Char(']')) {
+            return -1;
+        }
+        // we pressed enter in e.g. ()
+        const KTextEditor::Cursor closingAnchor = m_document.anchorInternal(line, 0, c);
+        if (!closingAnchor.isValid()) {
+            return -1;
+        }
+        if (alignOnly) {
+            // when aligning only, don't be too smart and just take the indent level of the open anchor
+            return m_document.firstVirtualColumn(closingAnchor.line());
+        }
+        const QChar previousLastChar = lastChar(line - 1);
+        const bool charsMatch = (previousLastChar == QLatin1Char('(') && c == QLatin1Char(')')) || (previousLastChar == QLatin1Char('{') && c == QLatin1Char('}'))
+            || (previousLastChar == QLatin1Char('[') && c == QLatin1Char(']'));
+        int indentation = -1;
+        if (!charsMatch && c != QLatin1Char('}')) {
+            // check whether the last line has the expected indentation, if not use it instead
+            // and place the closing anchor on the level of the opening anchor
+            const int expectedIndentation = m_document.firstVirtualColumn(closingAnchor.line()) + m_indentWidth;
+            const int actualIndentation = m_document.firstVirtualColumn(line - 1);
+            if (expectedIndentation <= actualIndentation) {
+                if (previousLastChar == QLatin1Char(',')) {
+                    m_document.insertText(line, m_document.firstColumn(line), QStringLiteral("\n"));
+                    m_view->setCursorPosition(KTextEditor::Cursor(line, actualIndentation));
+                    // indent closing anchor
+                    const int anchorColumn = m_document.toVirtualColumn(closingAnchor.line(), closingAnchor.column());
+                    m_document.document()->indent(KTextEditor::Range(line + 1, 0, line + 1, 1), anchorColumn / m_indentWidth);
+                    // make sure we add spaces to align perfectly on closing anchor,
+                    // the script computes the column from an undefined value, which inserts at 0
+                    const int padding = anchorColumn % m_indentWidth;
+                    if (padding > 0) {
+                        m_document.insertText(line + 1, 0, QString(padding, QLatin1Char(' ')));
+                    }
+                    indentation = actualIndentation;
+                } else if (expectedIndentation == actualIndentation) {
+                    // otherwise don't add a new line, just use indentation of closing anchor line
+                    indentation = m_document.firstVirtualColumn(closingAnchor.line());
+                } else {
+                    // otherwise don't add a new line, just align on closing anchor
+                    indentation = m_document.toVirtualColumn(closingAnchor.line(), closingAnchor.column());
+                }
+                return indentation;
+            }
+        }
+        // we pressed enter between (), [] or before a curly brace,
+        // increase indentation and place closing anchor on the next line
+        indentation = m_document.firstVirtualColumn(closingAnchor.line());
+        m_document.insertText(line, m_document.firstColumn(line), QStringLiteral("\n"));
+        m_view->setCursorPosition(KTextEditor::Cursor(line, indentation));
+        m_document.document()->indent(KTextEditor::Range(line + 1, 0, line + 1, 1), indentation / m_indentWidth);
+        return indentation + m_indentWidth;
+    }
+
+    int indentLine(int line, bool alignOnly)
+    {
+        const QChar first = firstChar(line);
+
+        int filler = tryMatchedAnchor(line, alignOnly);
+        if (filler == -1) {
+            filler = tryCComment(line);
+        }
+        if (filler == -1 && !alignOnly) {
+            filler = tryCppComment(line);
+        }
+        if (filler == -1) {
+            filler = trySwitchStatement(line);
+        }
+        if (filler == -1) {
+            filler = tryAccessModifiers(line);
+        }
+        if (filler == -1) {
+            filler = tryBrace(line);
+        }
+        if (filler == -1) {
+            filler = tryCKeywords(line, first == QLatin1Char('{'));
+        }
+        if (filler == -1) {
+            filler = tryCondition(line);
+        }
+        if (filler == -1) {
+            filler = tryStatement(line);
+        }
+
+        return filler;
+    }
+
+    int processChar(int line, QChar c)
+    {
+        if (c == QLatin1Char(';') || !triggerCharacters().contains(c)) {
+            return -2;
+        }
+
+        const int column = m_view->cursorPosition().column();
+        const int firstPos = m_document.firstColumn(line);
+        const int prevFirstPos = m_document.firstColumn(line - 1);
+        const int lastPos = m_document.lastColumn(line);
+
+        if (firstPos == column - 1 && c == QLatin1Char('{')) {
+            int filler = tryBrace(line);
+            if (filler == -1) {
+                filler = tryCKeywords(line, true);
+            }
+            if (filler == -1) {
+                filler = tryCComment(line); // checks, whether we had a "*/"
+            }
+            if (filler == -1) {
+                filler = tryStatement(line);
+            }
+            return filler == -1 ? -2 : filler;
+        } else if (firstPos == column - 1 && c == QLatin1Char('}') && charAt(line, column - 1) == QLatin1Char('}')) {
+            // unindent after closing brace, but not when brace is auto inserted (i.e., behind cursor)
+            const int indentation = findLeftBrace(line, firstPos);
+            return indentation == -1 ? -2 : indentation;
+        } else if (firstPos == column - 1 && c == QLatin1Char('}') && firstPos > prevFirstPos) {
+            // align indentation to previous line when creating new block with auto brackets enabled
+            return prevFirstPos;
+        } else if (SnapSlash && c == QLatin1Char('/') && lastPos == column - 1) {
+            // try to snap the string "* /" to "*/"
+            static const QRegularExpression starSlash = jsRegExp("^(\\s*)\\*\\s+\\/\\s*$");
+            const QRegularExpressionMatch match = starSlash.match(m_document.line(line));
+            if (match.hasMatch()) {
+                const QString currentString = match.captured(1) + QLatin1String("*/");
+                m_document.editBegin();
+                m_document.removeLine(line);
+                m_document.insertLine(line, currentString);
+                m_view->setCursorPosition(KTextEditor::Cursor(line, currentString.size()));
+                m_document.editEnd();
+            }
+            return -2;
+        } else if (c == QLatin1Char(':')) {
+            int filler = trySwitchStatement(line);
+            if (filler == -1) {
+                filler = tryAccessModifiers(line);
+            }
+            return filler == -1 ? -2 : filler;
+        } else if (c == QLatin1Char(')') && firstPos == column - 1) {
+            // align on start of identifier of function call
+            static const QRegularExpression identifier = jsRegExp("\\b(\\w+)\\s*$");
+            const KTextEditor::Cursor openParen = m_document.anchorInternal(line, column - 1, QLatin1Char('('));
+            if (openParen.isValid()) {
+                // strip starting from opening paren
+                const QString callLine = m_document.line(openParen.line()).left(qMax(0, openParen.column() - 1));
+                const int indentation = identifier.match(callLine).capturedStart();
+                if (indentation != -1) {
+                    return m_document.toVirtualColumn(openParen.line(), indentation);
+                }
+            }
+        } else if (firstPos == column - 1 && c == QLatin1Char('#')
+                   && (m_mode == QLatin1String("C") || m_mode == QLatin1String("C++") || m_mode == QLatin1String("ISO C++"))) {
+            // always put preprocessor stuff upfront
+            return 0;
+        }
+        return -2;
+    }
+
+private:
+    int m_indentWidth = 4;
+    QString m_mode;
+};
+// END KateCStyleIndenter
+
+// BEGIN KatePythonIndenter
+/**
+ * Port of python.js.
+ */
+class KatePythonIndenter : public KateNativeIndenter
+{
+public:
+    QString triggerCharacters() const override
+    {
+        return QString();
+    }
+
+protected:
+    int computeIndent(int line, int indentWidth, QChar) override
+    {
+        // don't ever act on document's first line or after an empty line
+        if (line == 0 || m_document.line(line - 1).isEmpty()) {
+            return -2;
+        }
+        const QString lastLine = getCode(line - 1);
+        const QChar lastChar = jsCharAt(lastLine, lastLine.size() - 1);
+
+        // indent when opening bracket or backslash is at the end the previous line
+        if ((!lastChar.isNull() && openings().contains(lastChar)) || lastChar == QLatin1Char('\\')) {
+            return m_document.firstVirtualColumn(line - 1) + indentWidth;
+        }
+        int indent = calcBracketIndent(line, indentWidth);
+        if (lastLine.endsWith(QLatin1Char(':'))) {
+            if (indent > -1) {
+                indent += indentWidth;
+            } else {
+                indent = m_document.firstVirtualColumn(line - 1) + indentWidth;
+            }
+        }
+        // continue, pass, raise, return etc. should unindent
+        if (shouldUnindent(line) && indent == -1) {
+            indent = qMax(0, m_document.firstVirtualColumn(line - 1) - indentWidth);
+        }
+        return indent;
+    }
+
+private:
+    static QString openings()
+    {
+        return QStringLiteral("([{");
+    }
+
+    static QString closings()
+    {
+        return QStringLiteral(")]}");
+    }
+
+    /**
+     * The given line without comments and leading or trailing whitespace.
+     */
+    QString getCode(int lineNr)
+    {
+        const QString line = m_document.line(lineNr);
+        QString code;
+        for (int position = 0; position < line.size(); ++position) {
+            if (m_document.isCode(lineNr, position)) {
+                code += line.at(position);
+            }
+        }
+        return trim(code);
+    }
+
+    /**
+     * Count the unmatched brackets of the line, from its end.
+     * @return column after the innermost unclosed opening bracket, or -1
+     */
+    int countBrackets(int lineNr, int (&countClosing)[3], bool stopAtOpening)
+    {
+        const QString line = m_document.line(lineNr);
+        for (int i = line.size() - 1; i >= 0; --i) {
+            if (m_document.isComment(lineNr, i) || m_document.isString(lineNr, i)) {
+                continue;
+            }
+            const QChar c = line.at(i);
+            const int closing = closings().indexOf(c);
+            if (closing > -1) {
+                ++countClosing[closing];
+            }
+            const int index = openings().indexOf(c);
+            if (index > -1) {
+                if (stopAtOpening && countClosing[index] == 0) {
+                    return i + 1;
+                }
+                --countClosing[index];
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * The indent if an opening bracket is not closed, the innermost opening bracket's position plus 1.
+     */
+    int calcOpeningIndent(int lineNr)
+    {
+        int countClosing[3] = {0, 0, 0};
+        return countBrackets(lineNr, countClosing, true);
+    }
+
+    /**
+     * The indent if a closing bracket is not opened, the indent of the line with the unmatched opening bracket.
+     */
+    int calcClosingIndent(int lineNr, int indentWidth)
+    {
+        int countClosing[3] = {0, 0, 0};
+        countBrackets(lineNr, countClosing, false);
+        if (countClosing[0] > 0 || countClosing[1] > 0 || countClosing[2] > 0) {
+            for (--lineNr; lineNr >= 0; --lineNr) {
+                if (calcOpeningIndent(lineNr) > -1) {
+                    const int indent = m_document.firstVirtualColumn(lineNr);
+                    if (shouldUnindent(lineNr + 1)) {
+                        return qMax(0, indent - indentWidth);
+                    }
+                    return indent;
+                }
+            }
+        }
+        return -1;
+    }
+
+    int calcBracketIndent(int lineNr, int indentWidth)
+    {
+        const int indent = calcOpeningIndent(lineNr - 1);
+        if (indent > -1) {
+            return indent;
+        }
+        return calcClosingIndent(lineNr - 1, indentWidth);
+    }
+
+    bool shouldUnindent(int lineNr)
+    {
+        static const QRegularExpression unindenters = jsRegExp("\\b(continue|pass|raise|return|break)\\b");
+
+        if (unindenters.match(getCode(lineNr - 1)).hasMatch()) {
+            return true;
+        }
+
+        // unindent if the last line was indented b/c of a backslash
+        if (lineNr >= 2 && getCode(lineNr - 2).endsWith(QLatin1Char('\\'))) {
+            return true;
+        }
+        return false;
+    }
+};
+// END KatePythonIndenter
+}
+
+// BEGIN KateNativeIndenter
+KateNativeIndenter::KateNativeIndenter()
+    : m_document(nullptr)
+{
+}
+
+KateNativeIndenter *KateNativeIndenter::create(KateIndentScript *script)
+{
+    // a copy of the script in the user's data directory may differ from ours
+    if (!script->url().startsWith(QLatin1String(":/ktexteditor/script/indentation/"))) {
+        return nullptr;
+    }
+
+    const QString name = script->indentHeader().baseName();
+    if (name == QLatin1String("cstyle")) {
+        return new KateCStyleIndenter();
+    }
+    if (name == QLatin1String("python")) {
+        return new KatePythonIndenter();
+    }
+    return nullptr;
+}
+
+QPair<int, int> KateNativeIndenter::indent(KTextEditor::ViewPrivate *view, const KTextEditor::Cursor &position, QChar typedCharacter, int indentWidth)
+{
+    m_view = view;
+    m_document.setDocument(view->doc());
+
+    // like a script returning a plain number, no alignment
+    return qMakePair(computeIndent(position.line(), indentWidth, typedCharacter), -2);
+}
+// END KateNativeIndenter
@@ -0,0 +1,89 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_NATIVE_INDENTER_H
+#define KATE_NATIVE_INDENTER_H
+
+#include "katescriptdocument.h"
+
+#include <QPair>
+#include <QString>
+
+#include <ktexteditor/cursor.h>
+
+namespace KTextEditor
+{
+class ViewPrivate;
+}
+class KateIndentScript;
+
+/**
+ * C++ implementation of one of the indentation scripts we ship.
+ *
+ * The scripts call back into KateScriptDocument for every character they look at,
+ * each call crossing the boundary of the JavaScript engine. A native indenter runs the
+ * same algorithm on the same KateScriptDocument helpers directly and yields the same
+ * results. It only replaces the shipped script, a script the user provided under the
+ * same name is still run by the engine.
+ */
+class KateNativeIndenter
+{
+public:
+    virtual ~KateNativeIndenter() = default;
+
+    /**
+     * Create the native replacement for the given indentation script.
+     * @param script script about to be used for indentation
+     * @return new indenter, or nullptr if the script has no native replacement
+     */
+    static KateNativeIndenter *create(KateIndentScript *script);
+
+    /**
+     * Characters beside '\n' that trigger the indenter, like the script's triggerCharacters.
+     */
+    virtual QString triggerCharacters() const = 0;
+
+    /**
+     * Same contract as KateIndentScript::indent().
+     * Returns a pair where the first value is the indent amount, and the second
+     * value is the alignment.
+     */
+    QPair<int, int> indent(KTextEditor::ViewPrivate *view, const KTextEditor::Cursor &position, QChar typedCharacter, int indentWidth);
+
+protected:
+    KateNativeIndenter();
+
+    /**
+     * The indent() function of the script.
+     * @param line line to indent
+     * @param indentWidth indentation width in spaces
+     * @param typedCharacter typed character, '\n' for a new line, null to only align the line
+     * @return indentation, -1 to keep the indentation of the previous line, -2 to change nothing
+     */
+    virtual int computeIndent(int line, int indentWidth, QChar typedCharacter) = 0;
+
+    /**
+     * The script's "document" and "view" objects.
+     */
+    KateScriptDocument m_document;
+    KTextEditor::ViewPrivate *m_view = nullptr;
+};
+
+#endif
@@ -25,7 +25,9 @@
 #include "katepartdebug.h"
 #include "katescriptdocument.h"
 #include "katescripteditor.h"
+#include "katescriptengine.h"
 #include "katescripthelpers.h"
+#include "katescriptmanager.h"
 #include "katescriptview.h"
 #include "kateview.h"
 
@@ -49,11 +51,11 @@ KateScript::KateScript(const QString &urlOrScript, enum InputType inputType)
 KateScript::~KateScript()
 {
     if (m_loadSuccessful) {
-        // remove data...
+        // remove data, the engine goes away with its last script
+        m_scriptEngine->release(this);
         delete m_editor;
         delete m_document;
         delete m_view;
-        delete m_engine;
     }
 }
 
@@ -92,6 +94,7 @@ QJSValue KateScript::global(const QString &name)
     if (!load()) {
         return QJSValue::UndefinedValue;
     }
+    m_scriptEngine->activate(this);
     return m_engine->globalObject().property(name);
 }
 
@@ -123,68 +126,25 @@ bool KateScript::load()
         source = m_script;
     }
 
-    // create script engine, register meta types
-    m_engine = new QJSEngine();
-
-    // export read & require function and add the require guard object
-    QJSValue functions = m_engine->newQObject(new Kate::ScriptHelper(m_engine));
-    m_engine->globalObject().setProperty(QStringLiteral("functions"), functions);
-    m_engine->globalObject().setProperty(QStringLiteral("read"), functions.property(QStringLiteral("read")));
-    m_engine->globalObject().setProperty(QStringLiteral("require"), functions.property(QStringLiteral("require")));
-    m_engine->globalObject().setProperty(QStringLiteral("require_guard"), m_engine->newObject());
-
-    // export debug function
-    m_engine->globalObject().setProperty(QStringLiteral("debug"), functions.property(QStringLiteral("debug")));
-
-    // export translation functions
-    m_engine->globalObject().setProperty(QStringLiteral("i18n"), functions.property(QStringLiteral("_i18n")));
-    m_engine->globalObject().setProperty(QStringLiteral("i18nc"), functions.property(QStringLiteral("_i18nc")));
-    m_engine->globalObject().setProperty(QStringLiteral("i18np"), functions.property(QStringLiteral("_i18np")));
-    m_engine->globalObject().setProperty(QStringLiteral("i18ncp"), functions.property(QStringLiteral("_i18ncp")));
-
-    // register default styles as ds* global properties
-    m_engine->globalObject().setProperty(QStringLiteral("dsNormal"), KTextEditor::dsNormal);
-    m_engine->globalObject().setProperty(QStringLiteral("dsKeyword"), KTextEditor::dsKeyword);
-    m_engine->globalObject().setProperty(QStringLiteral("dsFunction"), KTextEditor::dsFunction);
-    m_engine->globalObject().setProperty(QStringLiteral("dsVariable"), KTextEditor::dsVariable);
-    m_engine->globalObject().setProperty(QStringLiteral("dsControlFlow"), KTextEditor::dsControlFlow);
-    m_engine->globalObject().setProperty(QStringLiteral("dsOperator"), KTextEditor::dsOperator);
-    m_engine->globalObject().setProperty(QStringLiteral("dsBuiltIn"), KTextEditor::dsBuiltIn);
-    m_engine->globalObject().setProperty(QStringLiteral("dsExtension"), KTextEditor::dsExtension);
-    m_engine->globalObject().setProperty(QStringLiteral("dsPreprocessor"), KTextEditor::dsPreprocessor);
-    m_engine->globalObject().setProperty(QStringLiteral("dsAttribute"), KTextEditor::dsAttribute);
-    m_engine->globalObject().setProperty(QStringLiteral("dsChar"), KTextEditor::dsChar);
-    m_engine->globalObject().setProperty(QStringLiteral("dsSpecialChar"), KTextEditor::dsSpecialChar);
-    m_engine->globalObject().setProperty(QStringLiteral("dsString"), KTextEditor::dsString);
-    m_engine->globalObject().setProperty(QStringLiteral("dsVerbatimString"), KTextEditor::dsVerbatimString);
-    m_engine->globalObject().setProperty(QStringLiteral("dsSpecialString"), KTextEditor::dsSpecialString);
-    m_engine->globalObject().setProperty(QStringLiteral("dsImport"), KTextEditor::dsImport);
-    m_engine->globalObject().setProperty(QStringLiteral("dsDataType"), KTextEditor::dsDataType);
-    m_engine->globalObject().setProperty(QStringLiteral("dsDecVal"), KTextEditor::dsDecVal);
-    m_engine->globalObject().setProperty(QStringLiteral("dsBaseN"), KTextEditor::dsBaseN);
-    m_engine->globalObject().setProperty(QStringLiteral("dsFloat"), KTextEditor::dsFloat);
-    m_engine->globalObject().setProperty(QStringLiteral("dsConstant"), KTextEditor::dsConstant);
-    m_engine->globalObject().setProperty(QStringLiteral("dsComment"), KTextEditor::dsComment);
-    m_engine->globalObject().setProperty(QStringLiteral("dsDocumentation"), KTextEditor::dsDocumentation);
-    m_engine->globalObject().setProperty(QStringLiteral("dsAnnotation"), KTextEditor::dsAnnotation);
-    m_engine->globalObject().setProperty(QStringLiteral("dsCommentVar"), KTextEditor::dsCommentVar);
-    m_engine->globalObject().setProperty(QStringLiteral("dsRegionMarker"), KTextEditor::dsRegionMarker);
-    m_engine->globalObject().setProperty(QStringLiteral("dsInformation"), KTextEditor::dsInformation);
-    m_engine->globalObject().setProperty(QStringLiteral("dsWarning"), KTextEditor::dsWarning);
-    m_engine->globalObject().setProperty(QStringLiteral("dsAlert"), KTextEditor::dsAlert);
-    m_engine->globalObject().setProperty(QStringLiteral("dsOthers"), KTextEditor::dsOthers);
-    m_engine->globalObject().setProperty(QStringLiteral("dsError"), KTextEditor::dsError);
+    // load into an engine shared with other scripts, the helpers are already registered there
+    m_scriptEngine = KateScriptManager::self()->engine();
+    m_engine = m_scriptEngine->engine();
 
     // register scripts itself
-    QJSValue result = m_engine->evaluate(source, m_url);
+    QJSValue result = m_scriptEngine->load(this, source, m_url);
     if (hasException(result, m_url)) {
         return false;
     }
 
     // AFTER SCRIPT: set the view/document objects as necessary
-    m_engine->globalObject().setProperty(QStringLiteral("editor"), m_engine->newQObject(m_editor = new KateScriptEditor(m_engine)));
-    m_engine->globalObject().setProperty(QStringLiteral("document"), m_engine->newQObject(m_document = new KateScriptDocument(m_engine)));
-    m_engine->globalObject().setProperty(QStringLiteral("view"), m_engine->newQObject(m_view = new KateScriptView(m_engine)));
+    m_scriptEngine->setGlobal(this, QStringLiteral("editor"), m_engine->newQObject(m_editor = new KateScriptEditor(m_engine)));
+    m_scriptEngine->setGlobal(this, QStringLiteral("document"), m_engine->newQObject(m_document = new KateScriptDocument(m_engine)));
+    m_scriptEngine->setGlobal(this, QStringLiteral("view"), m_engine->newQObject(m_view = new KateScriptView(m_engine)));
+
+    // we delete the wrappers ourselves, the engine may outlive this script
+    QQmlEngine::setObjectOwnership(m_editor, QQmlEngine::CppOwnership);
+    QQmlEngine::setObjectOwnership(m_document, QQmlEngine::CppOwnership);
+    QQmlEngine::setObjectOwnership(m_view, QQmlEngine::CppOwnership);
 
     // yip yip!
     m_loadSuccessful = true;
@@ -209,7 +169,7 @@ QJSValue KateScript::evaluate(const QString &program, const FieldMap &env)
         args << it.value();
     }
 
-    QJSValue result = programFunction.call(args);
+    QJSValue result = call(programFunction, args);
     if (result.isError())
         qWarning() << "Error evaluating script: " << result.toString();
 
@@ -221,7 +181,8 @@ bool KateScript::hasException(const QJSValue &object, const QString &file)
     if (object.isError()) {
         displayBacktrace(object, i18n("Error loading script %1\n", file));
         m_errorMessage = i18n("Error loading script %1", file);
-        delete m_engine;
+        m_scriptEngine->release(this);
+        m_scriptEngine.reset();
         m_engine = nullptr;
         m_loadSuccessful = false;
         return true;
@@ -229,6 +190,22 @@ bool KateScript::hasException(const QJSValue &object, const QString &file)
     return false;
 }
 
+QJSValue KateScript::call(QJSValue function, const QJSValueList &arguments)
+{
+    if (!load()) {
+        return QJSValue();
+    }
+
+    // the function may run a command of another script of our engine, restore its globals afterwards
+    const KateScript *previous = m_scriptEngine->activeScript();
+    m_scriptEngine->activate(this);
+    const QJSValue result = function.call(arguments);
+    if (previous && previous != this) {
+        m_scriptEngine->activate(previous);
+    }
+    return result;
+}
+
 bool KateScript::setView(KTextEditor::ViewPrivate *view)
 {
     if (!load()) {
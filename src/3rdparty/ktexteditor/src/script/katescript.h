@@ -25,9 +25,11 @@
 
 #include <QJSValue>
 #include <QMap>
+#include <QSharedPointer>
 #include <QString>
 
 class QJSEngine;
+class KateScriptEngine;
 
 namespace KTextEditor
 {
@@ -177,6 +179,12 @@ public:
     /** Execute a piece of code **/
     QJSValue evaluate(const QString &program, const FieldMap &env = FieldMap());
 
+    /**
+     * Call a function of the script, e.g. one returned by function().
+     * Always use this instead of QJSValue::call(), the engine is shared with other scripts.
+     */
+    QJSValue call(QJSValue function, const QJSValueList &arguments = QJSValueList());
+
     /** Displays the backtrace when a script has errored out */
     void displayBacktrace(const QJSValue &error, const QString &header = QString());
 
@@ -206,9 +214,13 @@ private:
     QString m_errorMessage;
 
 protected:
-    /** The Qt interpreter for this script */
+    /** The Qt interpreter for this script, owned by m_scriptEngine */
     QJSEngine *m_engine = nullptr;
 
+private:
+    /** The engine shared with other scripts */
+    QSharedPointer<KateScriptEngine> m_scriptEngine;
+
 private:
     /** general header data */
     KateScriptHeader m_generalHeader;
@@ -429,6 +429,19 @@ QString KateScriptDocument::text(const QJSValue &jsrange)
     return text(range.start().line(), range.start().column(), range.end().line(), range.end().column());
 }
 
+QStringList KateScriptDocument::textLines(int fromLine, int toLine)
+{
+    fromLine = qMax(fromLine, 0);
+    toLine = qMin(toLine, m_document->lines() - 1);
+
+    QStringList lines;
+    lines.reserve(qMax(toLine - fromLine + 1, 0));
+    for (int line = fromLine; line <= toLine; ++line) {
+        lines.append(m_document->line(line));
+    }
+    return lines;
+}
+
 QString KateScriptDocument::line(int line)
 {
     return m_document->line(line);
@@ -584,6 +597,18 @@ bool KateScriptDocument::removeLine(int line)
     return m_document->removeLine(line);
 }
 
+bool KateScriptDocument::replaceLines(int fromLine, int toLine, const QJSValue &jslines)
+{
+    QStringList lines;
+    const int count = jslines.property(QStringLiteral("length")).toInt();
+    lines.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        lines.append(jslines.property(i).toString());
+    }
+
+    return m_document->replaceLines(fromLine, toLine, lines);
+}
+
 bool KateScriptDocument::wrapLine(int line, int column)
 {
     return m_document->editWrapLine(line, column);
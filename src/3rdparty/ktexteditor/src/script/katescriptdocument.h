@@ -68,6 +68,10 @@ public:
     Q_INVOKABLE QString text(const QJSValue &jsfrom, const QJSValue &jsto);
     Q_INVOKABLE QString text(const QJSValue &jsrange);
     Q_INVOKABLE QString line(int line);
+    /**
+     * Lines @p fromLine to @p toLine, both included, as one array.
+     */
+    Q_INVOKABLE QStringList textLines(int fromLine, int toLine);
     Q_INVOKABLE QString wordAt(int line, int column);
     Q_INVOKABLE QString wordAt(const QJSValue &jscursor);
     Q_INVOKABLE QJSValue wordRangeAt(int line, int column);
@@ -91,6 +95,11 @@ public:
     Q_INVOKABLE bool removeText(const QJSValue &jsfrom, const QJSValue &jsto);
     Q_INVOKABLE bool insertLine(int line, const QString &s);
     Q_INVOKABLE bool removeLine(int line);
+    /**
+     * Replace lines @p fromLine to @p toLine, both included, by the array @p lines in one
+     * editing transaction. Lines equal at the start and the end are left untouched.
+     */
+    Q_INVOKABLE bool replaceLines(int fromLine, int toLine, const QJSValue &lines);
     Q_INVOKABLE bool wrapLine(int line, int column);
     Q_INVOKABLE bool wrapLine(const QJSValue &cursor);
     Q_INVOKABLE void joinLines(int startLine, int endLine);
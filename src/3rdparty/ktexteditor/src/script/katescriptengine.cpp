@@ -0,0 +1,250 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "katescriptengine.h"
+#include "katescripthelpers.h"
+
+#include <ktexteditor/attribute.h>
+
+#include <QJSEngine>
+#include <QJSValueIterator>
+
+#include <cmath>
+
+namespace
+{
+/**
+ * Compare like ===, except that NaN is the same as NaN, as for Number.NaN.
+ */
+bool isSameValue(const QJSValue &a, const QJSValue &b)
+{
+    return a.strictlyEquals(b) || (a.isNumber() && b.isNumber() && std::isnan(a.toNumber()) && std::isnan(b.toNumber()));
+}
+}
+
+KateScriptEngine::KateScriptEngine()
+    : m_engine(new QJSEngine())
+{
+    QJSValue global = m_engine->globalObject();
+
+    // export read & require function
+    QJSValue functions = m_engine->newQObject(new Kate::ScriptHelper(m_engine));
+    global.setProperty(QStringLiteral("functions"), functions);
+    global.setProperty(QStringLiteral("read"), functions.property(QStringLiteral("read")));
+    global.setProperty(QStringLiteral("require"), functions.property(QStringLiteral("require")));
+
+    // export debug function
+    global.setProperty(QStringLiteral("debug"), functions.property(QStringLiteral("debug")));
+
+    // export translation functions
+    global.setProperty(QStringLiteral("i18n"), functions.property(QStringLiteral("_i18n")));
+    global.setProperty(QStringLiteral("i18nc"), functions.property(QStringLiteral("_i18nc")));
+    global.setProperty(QStringLiteral("i18np"), functions.property(QStringLiteral("_i18np")));
+    global.setProperty(QStringLiteral("i18ncp"), functions.property(QStringLiteral("_i18ncp")));
+
+    // register default styles as ds* global properties
+    global.setProperty(QStringLiteral("dsNormal"), KTextEditor::dsNormal);
+    global.setProperty(QStringLiteral("dsKeyword"), KTextEditor::dsKeyword);
+    global.setProperty(QStringLiteral("dsFunction"), KTextEditor::dsFunction);
+    global.setProperty(QStringLiteral("dsVariable"), KTextEditor::dsVariable);
+    global.setProperty(QStringLiteral("dsControlFlow"), KTextEditor::dsControlFlow);
+    global.setProperty(QStringLiteral("dsOperator"), KTextEditor::dsOperator);
+    global.setProperty(QStringLiteral("dsBuiltIn"), KTextEditor::dsBuiltIn);
+    global.setProperty(QStringLiteral("dsExtension"), KTextEditor::dsExtension);
+    global.setProperty(QStringLiteral("dsPreprocessor"), KTextEditor::dsPreprocessor);
+    global.setProperty(QStringLiteral("dsAttribute"), KTextEditor::dsAttribute);
+    global.setProperty(QStringLiteral("dsChar"), KTextEditor::dsChar);
+    global.setProperty(QStringLiteral("dsSpecialChar"), KTextEditor::dsSpecialChar);
+    global.setProperty(QStringLiteral("dsString"), KTextEditor::dsString);
+    global.setProperty(QStringLiteral("dsVerbatimString"), KTextEditor::dsVerbatimString);
+    global.setProperty(QStringLiteral("dsSpecialString"), KTextEditor::dsSpecialString);
+    global.setProperty(QStringLiteral("dsImport"), KTextEditor::dsImport);
+    global.setProperty(QStringLiteral("dsDataType"), KTextEditor::dsDataType);
+    global.setProperty(QStringLiteral("dsDecVal"), KTextEditor::dsDecVal);
+    global.setProperty(QStringLiteral("dsBaseN"), KTextEditor::dsBaseN);
+    global.setProperty(QStringLiteral("dsFloat"), KTextEditor::dsFloat);
+    global.setProperty(QStringLiteral("dsConstant"), KTextEditor::dsConstant);
+    global.setProperty(QStringLiteral("dsComment"), KTextEditor::dsComment);
+    global.setProperty(QStringLiteral("dsDocumentation"), KTextEditor::dsDocumentation);
+    global.setProperty(QStringLiteral("dsAnnotation"), KTextEditor::dsAnnotation);
+    global.setProperty(QStringLiteral("dsCommentVar"), KTextEditor::dsCommentVar);
+    global.setProperty(QStringLiteral("dsRegionMarker"), KTextEditor::dsRegionMarker);
+    global.setProperty(QStringLiteral("dsInformation"), KTextEditor::dsInformation);
+    global.setProperty(QStringLiteral("dsWarning"), KTextEditor::dsWarning);
+    global.setProperty(QStringLiteral("dsAlert"), KTextEditor::dsAlert);
+    global.setProperty(QStringLiteral("dsOthers"), KTextEditor::dsOthers);
+    global.setProperty(QStringLiteral("dsError"), KTextEditor::dsError);
+
+    // everything defined until now is shared by all scripts
+    m_sharedGlobals = globals();
+
+    // list the properties with the functions of this moment, scripts might replace them later on
+    m_propertiesFunction = m_engine->evaluate(
+        QStringLiteral("(function () {"
+                       "    var create = Object.create, names = Object.getOwnPropertyNames, descriptor = Object.getOwnPropertyDescriptor;"
+                       "    return function (object) {"
+                       "        var properties = create(null), list = names(object);"
+                       "        for (var i = 0; i < list.length; ++i) {"
+                       "            var d = descriptor(object, list[i]);"
+                       "            properties[list[i]] = ('get' in d) ? d.get : d.value;"
+                       "        }"
+                       "        return properties;"
+                       "    };"
+                       "})()"));
+
+    // remember the original built-in objects, e.g. haskell.js has its own String.prototype.startsWith
+    for (const char *name : {"Object", "Function", "Array", "String", "Number", "Boolean", "RegExp", "Date", "Error", "Math", "JSON"}) {
+        const QJSValue object = global.property(QLatin1String(name));
+        m_builtins.push_back({object, builtinProperties(object)});
+        const QJSValue prototype = object.property(QStringLiteral("prototype"));
+        if (prototype.isObject()) {
+            m_builtins.push_back({prototype, builtinProperties(prototype)});
+        }
+    }
+}
+
+KateScriptEngine::~KateScriptEngine()
+{
+    delete m_engine;
+}
+
+QJSValue KateScriptEngine::load(const KateScript *script, const QString &source, const QString &url)
+{
+    Q_ASSERT(!m_scripts.contains(script));
+
+    // start from the shared state only, everything the script and its libraries define or change belongs to it
+    activate(nullptr);
+    m_scripts.insert(script, ScriptState());
+    m_activeScript = script;
+
+    // own include guard, each script evaluates its libraries into its own globals
+    m_engine->globalObject().setProperty(QStringLiteral("require_guard"), m_engine->newObject());
+    return m_engine->evaluate(source, url);
+}
+
+void KateScriptEngine::setGlobal(const KateScript *script, const QString &name, const QJSValue &value)
+{
+    Q_ASSERT(m_scripts.contains(script));
+
+    m_scripts[script].globals.insert(name, value);
+    if (m_activeScript == script) {
+        m_engine->globalObject().setProperty(name, value);
+    }
+}
+
+void KateScriptEngine::activate(const KateScript *script)
+{
+    if (m_activeScript == script) {
+        return;
+    }
+
+    deactivate();
+
+    const auto next = m_scripts.constFind(script);
+    if (next == m_scripts.constEnd()) {
+        return;
+    }
+
+    QJSValue global = m_engine->globalObject();
+    for (auto it = next->globals.constBegin(); it != next->globals.constEnd(); ++it) {
+        global.setProperty(it.key(), it.value());
+    }
+    for (int i = 0; i < next->builtinProperties.size(); ++i) {
+        QJSValue object = m_builtins.at(i).object;
+        const QHash<QString, QJSValue> &properties = next->builtinProperties.at(i);
+        for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+            object.setProperty(it.key(), it.value());
+        }
+    }
+    m_activeScript = script;
+}
+
+void KateScriptEngine::deactivate()
+{
+    if (!m_activeScript) {
+        return;
+    }
+
+    ScriptState &state = m_scripts[m_activeScript];
+    m_activeScript = nullptr;
+
+    // keep the globals of the script, this includes ones it created at runtime by assigning to undeclared variables
+    QJSValue global = m_engine->globalObject();
+    const QHash<QString, QJSValue> currentGlobals = globals();
+    for (auto it = currentGlobals.constBegin(); it != currentGlobals.constEnd(); ++it) {
+        const QJSValue original = m_sharedGlobals.value(it.key());
+        if (!state.globals.contains(it.key()) && isSameValue(original, it.value())) {
+            continue;
+        }
+        state.globals.insert(it.key(), it.value());
+        global.setProperty(it.key(), original);
+    }
+
+    // keep the changed properties of the built-in objects and restore the original ones
+    state.builtinProperties.resize(m_builtins.size());
+    for (int i = 0; i < m_builtins.size(); ++i) {
+        const BuiltinObject &builtin = m_builtins.at(i);
+        QJSValue object = builtin.object;
+        QHash<QString, QJSValue> &changed = state.builtinProperties[i];
+        const QHash<QString, QJSValue> currentProperties = builtinProperties(object);
+        for (auto it = currentProperties.constBegin(); it != currentProperties.constEnd(); ++it) {
+            const auto original = builtin.properties.constFind(it.key());
+            if (original != builtin.properties.constEnd() && isSameValue(original.value(), it.value())) {
+                continue;
+            }
+            changed.insert(it.key(), it.value());
+            if (original != builtin.properties.constEnd()) {
+                object.setProperty(it.key(), original.value());
+            } else {
+                object.deleteProperty(it.key());
+            }
+        }
+    }
+}
+
+void KateScriptEngine::release(const KateScript *script)
+{
+    if (m_activeScript == script) {
+        activate(nullptr);
+    }
+    m_scripts.remove(script);
+}
+
+QHash<QString, QJSValue> KateScriptEngine::globals() const
+{
+    QHash<QString, QJSValue> values;
+    QJSValueIterator it(m_engine->globalObject());
+    while (it.hasNext()) {
+        it.next();
+        values.insert(it.name(), it.value());
+    }
+    return values;
+}
+
+QHash<QString, QJSValue> KateScriptEngine::builtinProperties(const QJSValue &object) const
+{
+    QHash<QString, QJSValue> properties;
+    QJSValueIterator it(QJSValue(m_propertiesFunction).call({object}));
+    while (it.hasNext()) {
+        it.next();
+        properties.insert(it.name(), it.value());
+    }
+    return properties;
+}
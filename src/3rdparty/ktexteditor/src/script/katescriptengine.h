@@ -0,0 +1,178 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_SCRIPT_ENGINE_H
+#define KATE_SCRIPT_ENGINE_H
+
+#include <QHash>
+#include <QJSValue>
+#include <QString>
+#include <QVector>
+
+class QJSEngine;
+class KateScript;
+
+/**
+ * A QJSEngine shared by several scripts, handed out by KateScriptManager::engine().
+ *
+ * The helper functions and the ds* constants are registered once per engine.
+ * All scripts run in the same global object and share the built-in objects,
+ * which would let them overwrite each other's functions, e.g. a String.prototype
+ * method. Therefore the engine remembers for each script the globals and built-in
+ * properties it defined or changed, while loading or later on, and only those of
+ * the active script are set. For all other scripts the globals are undefined and
+ * the built-in properties have their original values.
+ *
+ * Every script evaluates its require()d libraries itself, the include guard
+ * is one of its globals.
+ */
+class KateScriptEngine
+{
+public:
+    /**
+     * Number of scripts loaded into one engine, before the manager creates the next one.
+     */
+    static const int MaximalScriptCount = 8;
+
+    KateScriptEngine();
+    ~KateScriptEngine();
+
+    KateScriptEngine(const KateScriptEngine &) = delete;
+    KateScriptEngine &operator=(const KateScriptEngine &) = delete;
+
+    /**
+     * The engine all scripts are evaluated in.
+     */
+    QJSEngine *engine() const
+    {
+        return m_engine;
+    }
+
+    /**
+     * Number of scripts loaded into this engine.
+     */
+    int scriptCount() const
+    {
+        return m_scripts.size();
+    }
+
+    /**
+     * Evaluate the source of a script and make it the active one.
+     * @param script script the source belongs to
+     * @param source program to evaluate
+     * @param url file name used in error messages
+     * @return result of the evaluation, an error object on failure
+     */
+    QJSValue load(const KateScript *script, const QString &source, const QString &url);
+
+    /**
+     * Define one more global of a loaded script.
+     */
+    void setGlobal(const KateScript *script, const QString &name, const QJSValue &value);
+
+    /**
+     * Set the globals of the given script, must be done before running any of its code.
+     * The current values of the globals of the previously active script are kept for it.
+     * @param script script to activate, nullptr to only deactivate the current one
+     */
+    void activate(const KateScript *script);
+
+    /**
+     * The script whose globals are set, or nullptr.
+     */
+    const KateScript *activeScript() const
+    {
+        return m_activeScript;
+    }
+
+    /**
+     * Forget all globals of the given script.
+     */
+    void release(const KateScript *script);
+
+private:
+    /**
+     * Values a script set, to restore when it is activated again.
+     */
+    struct ScriptState {
+        /**
+         * globals of the script
+         */
+        QHash<QString, QJSValue> globals;
+
+        /**
+         * changed properties of the built-in objects, by index in m_builtins
+         */
+        QVector<QHash<QString, QJSValue>> builtinProperties;
+    };
+
+    /**
+     * A built-in object like String.prototype with the original values of its properties.
+     */
+    struct BuiltinObject {
+        QJSValue object;
+        QHash<QString, QJSValue> properties;
+    };
+
+    /**
+     * Take over what the active script defined or changed and restore the shared state.
+     */
+    void deactivate();
+
+    /**
+     * All enumerable properties of the global object.
+     */
+    QHash<QString, QJSValue> globals() const;
+
+    /**
+     * All own properties of a built-in object, getters of accessors instead of their values.
+     */
+    QHash<QString, QJSValue> builtinProperties(const QJSValue &object) const;
+
+private:
+    QJSEngine *const m_engine;
+
+    /**
+     * globals defined for all scripts, with their values
+     */
+    QHash<QString, QJSValue> m_sharedGlobals;
+
+    /**
+     * built-in objects scripts may extend
+     */
+    QVector<BuiltinObject> m_builtins;
+
+    /**
+     * function listing the own properties of an object, see builtinProperties()
+     */
+    QJSValue m_propertiesFunction;
+
+    /**
+     * loaded scripts with the values they set
+     */
+    QHash<const KateScript *, ScriptState> m_scripts;
+
+    /**
+     * script whose globals are set
+     */
+    const KateScript *m_activeScript = nullptr;
+};
+
+#endif
@@ -26,7 +26,9 @@
 
 #include <ktexteditor_version.h>
 
+#include <QCryptographicHash>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QJsonArray>
@@ -35,6 +37,8 @@
 #include <QJsonValue>
 #include <QMap>
 #include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QStringList>
 #include <QUuid>
 
@@ -45,6 +49,7 @@
 #include "katecmd.h"
 #include "kateglobal.h"
 #include "katepartdebug.h"
+#include "katescriptengine.h"
 
 KateScriptManager *KateScriptManager::m_instance = nullptr;
 
@@ -105,8 +110,78 @@ static QStringList jsonToStringList(const QJsonValue &value)
     return list;
 }
 
+/**
+ * Small helper: file caching the headers of all scripts
+ */
+static QString headerCacheFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/katepart5/script-headers.json");
+}
+
+/**
+ * Small helper: hash of the content of a file, empty if it can't be read
+ */
+static QString contentHash(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    QCryptographicHash crypto(QCryptographicHash::Sha1);
+    crypto.addData(&file);
+    return QString::fromLatin1(crypto.result().toHex());
+}
+
+bool KateScriptManager::readHeader(const QString &fileName, QJsonObject &header)
+{
+    /**
+     * open file or skip it
+     */
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCDebug(LOG_KTE) << "Script parse error: Cannot open file " << qPrintable(fileName) << '\n';
+        return false;
+    }
+
+    /**
+     * search json header or skip this file
+     */
+    QByteArray fileContent = file.readAll();
+    int startOfJson = fileContent.indexOf('{');
+    if (startOfJson < 0) {
+        qCDebug(LOG_KTE) << "Script parse error: Cannot find start of json header at start of file " << qPrintable(fileName) << '\n';
+        return false;
+    }
+
+    int endOfJson = fileContent.indexOf("\n};", startOfJson);
+    if (endOfJson < 0) { // as fallback, check also mac os line ending
+        endOfJson = fileContent.indexOf("\r};", startOfJson);
+    }
+    if (endOfJson < 0) {
+        qCDebug(LOG_KTE) << "Script parse error: Cannot find end of json header at start of file " << qPrintable(fileName) << '\n';
+        return false;
+    }
+    endOfJson += 2; // we want the end including the } but not the ;
+
+    /**
+     * parse json header or skip this file
+     */
+    QJsonParseError error;
+    const QJsonDocument metaInfo(QJsonDocument::fromJson(fileContent.mid(startOfJson, endOfJson - startOfJson), &error));
+    if (error.error || !metaInfo.isObject()) {
+        qCDebug(LOG_KTE) << "Script parse error: Cannot parse json header at start of file " << qPrintable(fileName) << error.errorString() << endOfJson << fileContent.mid(endOfJson - 25, 25).replace('\n', ' ');
+        return false;
+    }
+
+    header = metaInfo.object();
+    return true;
+}
+
 void KateScriptManager::collect()
 {
+    QElapsedTimer timer;
+    timer.start();
+
     // clear out the old scripts and reserve enough space
     qDeleteAll(m_indentationScripts);
     qDeleteAll(m_commandLineScripts);
@@ -116,6 +191,21 @@ void KateScriptManager::collect()
     m_languageToIndenters.clear();
     m_indentationScriptMap.clear();
 
+    /**
+     * headers cached by the last run, dropped if written by another version
+     */
+    QJsonObject cachedHeaders;
+    QFile cacheFile(headerCacheFileName());
+    if (cacheFile.open(QIODevice::ReadOnly)) {
+        const QJsonObject cache = QJsonDocument::fromJson(cacheFile.readAll()).object();
+        if (cache.value(QStringLiteral("version")).toString() == QLatin1String(KTEXTEDITOR_VERSION_STRING)) {
+            cachedHeaders = cache.value(QStringLiteral("scripts")).toObject();
+        }
+        cacheFile.close();
+    }
+    QJsonObject headers;
+    int cacheHits = 0;
+
     /**
      * now, we search all kinds of known scripts
      */
@@ -152,7 +242,8 @@ void KateScriptManager::collect()
             /**
              * get file basename
              */
-            const QString baseName = QFileInfo(fileName).baseName();
+            const QFileInfo fileInfo(fileName);
+            const QString baseName = fileInfo.baseName();
 
             /**
              * only load scripts once, even if multiple installed variants found!
@@ -166,43 +257,23 @@ void KateScriptManager::collect()
             unique.insert(baseName);
 
             /**
-             * open file or skip it
+             * take the header from the cache if the file did not change, else read it
+             * resources have no modification time, for them the content is part of the stamp
              */
-            QFile file(fileName);
-            if (!file.open(QIODevice::ReadOnly)) {
-                qCDebug(LOG_KTE) << "Script parse error: Cannot open file " << qPrintable(fileName) << '\n';
-                continue;
+            const QJsonObject cached = cachedHeaders.value(fileName).toObject();
+            QJsonObject fileStamp{{QStringLiteral("modified"), double(fileInfo.lastModified().isValid() ? fileInfo.lastModified().toMSecsSinceEpoch() : 0)},
+                                  {QStringLiteral("size"), double(fileInfo.size())}};
+            if (!fileInfo.lastModified().isValid()) {
+                fileStamp.insert(QStringLiteral("hash"), contentHash(fileName));
             }
-
-            /**
-             * search json header or skip this file
-             */
-            QByteArray fileContent = file.readAll();
-            int startOfJson = fileContent.indexOf('{');
-            if (startOfJson < 0) {
-                qCDebug(LOG_KTE) << "Script parse error: Cannot find start of json header at start of file " << qPrintable(fileName) << '\n';
-                continue;
-            }
-
-            int endOfJson = fileContent.indexOf("\n};", startOfJson);
-            if (endOfJson < 0) { // as fallback, check also mac os line ending
-                endOfJson = fileContent.indexOf("\r};", startOfJson);
-            }
-            if (endOfJson < 0) {
-                qCDebug(LOG_KTE) << "Script parse error: Cannot find end of json header at start of file " << qPrintable(fileName) << '\n';
-                continue;
-            }
-            endOfJson += 2; // we want the end including the } but not the ;
-
-            /**
-             * parse json header or skip this file
-             */
-            QJsonParseError error;
-            const QJsonDocument metaInfo(QJsonDocument::fromJson(fileContent.mid(startOfJson, endOfJson - startOfJson), &error));
-            if (error.error || !metaInfo.isObject()) {
-                qCDebug(LOG_KTE) << "Script parse error: Cannot parse json header at start of file " << qPrintable(fileName) << error.errorString() << endOfJson << fileContent.mid(endOfJson - 25, 25).replace('\n', ' ');
+            QJsonObject metaInfoObject;
+            if (!cached.isEmpty() && cached.value(QStringLiteral("stamp")).toObject() == fileStamp) {
+                metaInfoObject = cached.value(QStringLiteral("header")).toObject();
+                ++cacheHits;
+            } else if (!readHeader(fileName, metaInfoObject)) {
                 continue;
             }
+            headers.insert(fileName, QJsonObject{{QStringLiteral("stamp"), fileStamp}, {QStringLiteral("header"), metaInfoObject}});
 
             /**
              * remember type
@@ -217,7 +288,6 @@ void KateScriptManager::collect()
                 Q_ASSERT(false);
             }
 
-            const QJsonObject metaInfoObject = metaInfo.object();
             generalHeader.setLicense(metaInfoObject.value(QStringLiteral("license")).toString());
             generalHeader.setAuthor(metaInfoObject.value(QStringLiteral("author")).toString());
             generalHeader.setRevision(metaInfoObject.value(QStringLiteral("revision")).toInt());
@@ -281,6 +351,22 @@ void KateScriptManager::collect()
         }
     }
 
+    /**
+     * update the cache, if any script was added, removed or changed
+     */
+    if (headers != cachedHeaders) {
+        const QJsonObject cache{{QStringLiteral("version"), QStringLiteral(KTEXTEDITOR_VERSION_STRING)}, {QStringLiteral("scripts"), headers}};
+        QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+        QSaveFile saveFile(cacheFile.fileName());
+        if (saveFile.open(QIODevice::WriteOnly)) {
+            saveFile.write(QJsonDocument(cache).toJson(QJsonDocument::Compact));
+            saveFile.commit();
+        }
+    }
+
+    qCDebug(LOG_KTE) << "Collected" << m_indentationScripts.size() << "indentation and" << m_commandLineScripts.size() << "command line scripts in" << timer.elapsed()
+                     << "ms," << cacheHits << "headers from cache";
+
 #ifdef DEBUG_SCRIPTMANAGER
     // XX Test
     if (indenter("Python")) {
@@ -298,6 +384,27 @@ void KateScriptManager::collect()
 #endif
 }
 
+QSharedPointer<KateScriptEngine> KateScriptManager::engine()
+{
+    // forget engines without scripts, reuse the first one with room left
+    QSharedPointer<KateScriptEngine> engine;
+    for (int i = m_engines.size() - 1; i >= 0; --i) {
+        const QSharedPointer<KateScriptEngine> candidate = m_engines.at(i).toStrongRef();
+        if (!candidate) {
+            m_engines.remove(i);
+        } else if (candidate->scriptCount() < KateScriptEngine::MaximalScriptCount) {
+            engine = candidate;
+        }
+    }
+
+    if (!engine) {
+        engine.reset(new KateScriptEngine());
+        m_engines.append(engine);
+        qCDebug(LOG_KTE) << "Created script engine, now" << m_engines.size() << "engines";
+    }
+    return engine;
+}
+
 void KateScriptManager::reload()
 {
     collect();
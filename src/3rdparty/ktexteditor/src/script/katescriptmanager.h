@@ -26,13 +26,17 @@
 #include <KTextEditor/Command>
 #include <ktexteditor/cursor.h>
 
+#include <QJsonObject>
+#include <QSharedPointer>
 #include <QVector>
+#include <QWeakPointer>
 
 #include "katecommandlinescript.h"
 #include "kateindentscript.h"
 #include "katescript.h"
 
 class QString;
+class KateScriptEngine;
 
 /**
  * Manage the scripts on disks -- find them and query them.
@@ -98,9 +102,16 @@ public:
 public:
     /**
      * Collect all scripts.
+     * The headers are taken from a cache file as long as the script files did not change.
      */
     void collect();
 
+    /**
+     * Engine for a script to load into, scripts share a small number of engines.
+     * An engine is deleted together with the last script loaded into it.
+     */
+    QSharedPointer<KateScriptEngine> engine();
+
 public:
     KateIndentScript *indentationScript(const QString &scriptname)
     {
@@ -136,6 +147,18 @@ private:
 
     /** Map of language to indent scripts */
     QHash<QString, QVector<KateIndentScript *>> m_languageToIndenters;
+
+    /** engines with loaded scripts */
+    QVector<QWeakPointer<KateScriptEngine>> m_engines;
+
+private:
+    /**
+     * Read the json header of a script file.
+     * @param fileName script file
+     * @param header the parsed header
+     * @return success
+     */
+    static bool readHeader(const QString &fileName, QJsonObject &header);
 };
 
 #endif
@@ -21,8 +21,12 @@
 
 #include "ontheflycheck.h"
 
+#include <QElapsedTimer>
+#include <QTextBoundaryFinder>
 #include <QTimer>
 
+#include <algorithm>
+
 #include "katebuffer.h"
 #include "kateconfig.h"
 #include "kateglobal.h"
@@ -42,12 +46,65 @@ inline const QPair<KTextEditor::MovingRange *, QString> &invalidSpellCheckQueueI
     return item;
 }
 
+/**
+ * time in milliseconds spent on spell checking before returning to the event loop
+ */
+const int spellCheckTimeSlice = 10;
+
+/**
+ * Whether a chunk of text without spaces is an URL or e-mail address, like Sonnet's tokenizer checks them.
+ */
+bool isAddress(const QStringRef &chunk)
+{
+    if (chunk.contains(QLatin1String("://")) || chunk.startsWith(QLatin1String("www."), Qt::CaseInsensitive)) {
+        return true;
+    }
+    const int at = chunk.indexOf(QLatin1Char('@'));
+    return at > 0 && chunk.indexOf(QLatin1Char('.'), at + 2) > at + 1;
+}
+
+/**
+ * Call 'func' with start and length of every word in 'text' that needs to be checked.
+ * Like Sonnet, words not starting with a letter or being part of an URL or e-mail address
+ * are skipped, and all-uppercase words unless 'checkUppercase' is set.
+ */
+template<typename Func> void forEachSpellCheckWord(const QString &text, bool checkUppercase, Func func)
+{
+    QTextBoundaryFinder finder(QTextBoundaryFinder::Word, text);
+    int start = 0;
+    int chunkEnd = 0;
+    bool inAddress = false;
+    for (int end = finder.toNextBoundary(); end >= 0; end = finder.toNextBoundary()) {
+        if ((finder.boundaryReasons() & QTextBoundaryFinder::EndOfItem) && text.at(start).isLetter()) {
+            // classify the whitespace separated chunk the word is part of, once per chunk
+            if (start >= chunkEnd) {
+                int chunkStart = start;
+                while (chunkStart > 0 && !text.at(chunkStart - 1).isSpace()) {
+                    --chunkStart;
+                }
+                chunkEnd = end;
+                while (chunkEnd < text.size() && !text.at(chunkEnd).isSpace()) {
+                    ++chunkEnd;
+                }
+                inAddress = isAddress(text.midRef(chunkStart, chunkEnd - chunkStart));
+            }
+
+            bool hasLowercase = false;
+            for (int i = start; i < end && !hasLowercase; ++i) {
+                hasLowercase = text.at(i).isLower();
+            }
+            if (!inAddress && (checkUppercase || hasLowercase)) {
+                func(start, end - start);
+            }
+        }
+        start = end;
+    }
+}
 }
 
 KateOnTheFlyChecker::KateOnTheFlyChecker(KTextEditor::DocumentPrivate *document)
     : QObject(document)
     , m_document(document)
-    , m_backgroundChecker(nullptr)
     , m_currentlyCheckedItem(invalidSpellCheckQueueItem())
     , m_refreshView(nullptr)
 {
@@ -65,6 +122,10 @@ KateOnTheFlyChecker::KateOnTheFlyChecker(KTextEditor::DocumentPrivate *document)
 
     connect(document, &KTextEditor::Document::reloaded, this, [this](KTextEditor::Document *) { refreshSpellCheck(); });
 
+    KateSpellCheckManager *spellCheckManager = KTextEditor::EditorPrivate::self()->spellCheckManager();
+    connect(spellCheckManager, &KateSpellCheckManager::wordAddedToDictionary, this, &KateOnTheFlyChecker::addToDictionary);
+    connect(spellCheckManager, &KateSpellCheckManager::wordIgnored, this, &KateOnTheFlyChecker::addToSession);
+
     // load the settings for the speller
     updateConfig();
 
@@ -191,16 +252,16 @@ void KateOnTheFlyChecker::handleInsertedText(const KTextEditor::Range &range)
         if (spellCheckRange->contains(consideredRange)) {
             consideredRange = *spellCheckRange;
             ON_THE_FLY_DEBUG << "erasing range " << *i;
-            i = m_spellCheckQueue.erase(i);
+            i = eraseFromSpellCheckQueue(i);
             deleteMovingRangeQuickly(spellCheckRange);
         } else if (consideredRange.contains(*spellCheckRange)) {
             ON_THE_FLY_DEBUG << "erasing range " << *i;
-            i = m_spellCheckQueue.erase(i);
+            i = eraseFromSpellCheckQueue(i);
             deleteMovingRangeQuickly(spellCheckRange);
         } else if (consideredRange.overlaps(*spellCheckRange)) {
             consideredRange.expandToRange(*spellCheckRange);
             ON_THE_FLY_DEBUG << "erasing range " << *i;
-            i = m_spellCheckQueue.erase(i);
+            i = eraseFromSpellCheckQueue(i);
             deleteMovingRangeQuickly(spellCheckRange);
         } else {
             ++i;
@@ -268,7 +329,7 @@ void KateOnTheFlyChecker::handleRemovedText(const KTextEditor::Range &range)
                 rangesToReCheck.push_back(*spellCheckRange);
             }
             deleteMovingRangeQuickly(spellCheckRange);
-            i = m_spellCheckQueue.erase(i);
+            i = eraseFromSpellCheckQueue(i);
         } else {
             ++i;
         }
@@ -334,7 +395,7 @@ void KateOnTheFlyChecker::freeDocument()
         ON_THE_FLY_DEBUG << "erasing range " << *i;
         KTextEditor::MovingRange *movingRange = (*i).first;
         deleteMovingRangeQuickly(movingRange);
-        i = m_spellCheckQueue.erase(i);
+        i = eraseFromSpellCheckQueue(i);
     }
     if (m_currentlyCheckedItem != invalidSpellCheckQueueItem()) {
         KTextEditor::MovingRange *movingRange = m_currentlyCheckedItem.first;
@@ -360,52 +421,94 @@ void KateOnTheFlyChecker::performSpellCheck()
         ON_THE_FLY_DEBUG << "exited as there is nothing to do";
         return;
     }
-    m_currentlyCheckedItem = m_spellCheckQueue.takeFirst();
 
+    // check as many ranges as fit into one time slice, then give the event loop a chance
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_spellCheckQueue.isEmpty() && timer.elapsed() < spellCheckTimeSlice) {
+        m_currentlyCheckedItem = takeNextSpellCheckItem();
+        spellCheckCurrentItem();
+        spellCheckDone();
+    }
+
+    if (!m_spellCheckQueue.isEmpty()) {
+        QTimer::singleShot(0, this, SLOT(performSpellCheck()));
+    }
+}
+
+KateOnTheFlyChecker::SpellCheckItem KateOnTheFlyChecker::takeNextSpellCheckItem()
+{
+    if (m_displayedSpellCheckItems > 0) {
+        --m_displayedSpellCheckItems;
+    }
+    return m_spellCheckQueue.takeFirst();
+}
+
+QList<KateOnTheFlyChecker::SpellCheckItem>::iterator KateOnTheFlyChecker::eraseFromSpellCheckQueue(QList<SpellCheckItem>::iterator i)
+{
+    if (i - m_spellCheckQueue.begin() < m_displayedSpellCheckItems) {
+        --m_displayedSpellCheckItems;
+    }
+    return m_spellCheckQueue.erase(i);
+}
+
+bool KateOnTheFlyChecker::isDisplayed(const KTextEditor::Range &range) const
+{
+    for (const KTextEditor::Range &displayRange : m_displayRangeMap) {
+        if (range.overlaps(displayRange)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void KateOnTheFlyChecker::partitionSpellCheckQueue()
+{
+    const auto displayedEnd = std::stable_partition(m_spellCheckQueue.begin(), m_spellCheckQueue.end(), [this](const SpellCheckItem &item) {
+        return isDisplayed(*item.first);
+    });
+    m_displayedSpellCheckItems = displayedEnd - m_spellCheckQueue.begin();
+}
+
+void KateOnTheFlyChecker::spellCheckCurrentItem()
+{
     KTextEditor::MovingRange *spellCheckRange = m_currentlyCheckedItem.first;
     const QString &language = m_currentlyCheckedItem.second;
     ON_THE_FLY_DEBUG << "for the range " << *spellCheckRange;
-    // clear all the highlights that are currently present in the range that
-    // is supposed to be checked
-    const MovingRangeList highlightsList = installedMovingRanges(*spellCheckRange); // make a copy!
-    deleteMovingRanges(highlightsList);
+
+    // the highlights currently present in the range are moved to the new misspellings,
+    // only the ones left over at the end are deleted
+    MovingRangeList reusableRanges = installedMovingRanges(*spellCheckRange);
 
     m_currentDecToEncOffsetList.clear();
     KTextEditor::DocumentPrivate::OffsetList encToDecOffsetList;
-    QString text = m_document->decodeCharacters(*spellCheckRange, m_currentDecToEncOffsetList, encToDecOffsetList);
+    const QString text = m_document->decodeCharacters(*spellCheckRange, m_currentDecToEncOffsetList, encToDecOffsetList);
     ON_THE_FLY_DEBUG << "next spell checking" << text;
-    if (text.isEmpty()) { // passing an empty string to Sonnet can lead to a bad allocation exception
-        spellCheckDone(); // (bug 225867)
-        return;
-    }
-    if (m_speller.language() != language) {
-        m_speller.setLanguage(language);
-    }
-    if (!m_backgroundChecker) {
-        m_backgroundChecker = new Sonnet::BackgroundChecker(m_speller, this);
-        connect(m_backgroundChecker, SIGNAL(misspelling(QString, int)), this, SLOT(misspelling(QString, int)));
-        connect(m_backgroundChecker, SIGNAL(done()), this, SLOT(spellCheckDone()));
 
-        KateSpellCheckManager *m_spellCheckManager = KTextEditor::EditorPrivate::self()->spellCheckManager();
-        connect(m_spellCheckManager, &KateSpellCheckManager::wordAddedToDictionary, this, &KateOnTheFlyChecker::addToDictionary);
-        connect(m_spellCheckManager, &KateSpellCheckManager::wordIgnored, this, &KateOnTheFlyChecker::addToSession);
+    if (!text.isEmpty()) {
+        if (m_speller.language() != language) {
+            m_speller.setLanguage(language);
+        }
+
+        KateSpellCheckManager *spellCheckManager = KTextEditor::EditorPrivate::self()->spellCheckManager();
+        forEachSpellCheckWord(text, m_speller.testAttribute(Sonnet::Speller::CheckUppercase), [&](int start, int length) {
+            if (spellCheckManager->isMisspelled(m_speller, text.mid(start, length))) {
+                misspelling(start, length, reusableRanges);
+            }
+        });
     }
-    m_backgroundChecker->setSpeller(m_speller);
-    m_backgroundChecker->setText(text); // don't call 'start()' after this!
+
+    deleteMovingRanges(reusableRanges);
 }
 
 void KateOnTheFlyChecker::addToDictionary(const QString &word)
 {
-    if (m_backgroundChecker) {
-        m_backgroundChecker->addWordToPersonal(word);
-    }
+    m_speller.addToPersonal(word);
 }
 
 void KateOnTheFlyChecker::addToSession(const QString &word)
 {
-    if (m_backgroundChecker) {
-        m_backgroundChecker->addWordToSession(word);
-    }
+    m_speller.addToSession(word);
 }
 
 void KateOnTheFlyChecker::removeRangeFromEverything(KTextEditor::MovingRange *movingRange)
@@ -445,9 +548,6 @@ void KateOnTheFlyChecker::stopCurrentSpellCheck()
 {
     m_currentDecToEncOffsetList.clear();
     m_currentlyCheckedItem = invalidSpellCheckQueueItem();
-    if (m_backgroundChecker) {
-        m_backgroundChecker->stop();
-    }
 }
 
 bool KateOnTheFlyChecker::removeRangeFromSpellCheckQueue(KTextEditor::MovingRange *range)
@@ -461,7 +561,7 @@ bool KateOnTheFlyChecker::removeRangeFromSpellCheckQueue(KTextEditor::MovingRang
     bool found = false;
     for (QList<SpellCheckItem>::iterator i = m_spellCheckQueue.begin(); i != m_spellCheckQueue.end();) {
         if ((*i).first == range) {
-            i = m_spellCheckQueue.erase(i);
+            i = eraseFromSpellCheckQueue(i);
             found = true;
         } else {
             ++i;
@@ -575,24 +675,30 @@ KTextEditor::Range KateOnTheFlyChecker::findWordBoundaries(const KTextEditor::Cu
     return KTextEditor::Range(boundaryStart, boundaryEnd);
 }
 
-void KateOnTheFlyChecker::misspelling(const QString &word, int start)
+void KateOnTheFlyChecker::misspelling(int start, int length, MovingRangeList &reusableRanges)
 {
-    if (m_currentlyCheckedItem == invalidSpellCheckQueueItem()) {
-        ON_THE_FLY_DEBUG << "exited as no spell check is taking place";
-        return;
-    }
     int translatedStart = m_document->computePositionWrtOffsets(m_currentDecToEncOffsetList, start);
-    //   ON_THE_FLY_DEBUG << "misspelled " << word
-    //                                     << " at line "
-    //                                     << *m_currentlyCheckedItem.first
-    //                                     << " column " << start;
+    int translatedEnd = m_document->computePositionWrtOffsets(m_currentDecToEncOffsetList, start + length);
 
     KTextEditor::MovingRange *spellCheckRange = m_currentlyCheckedItem.first;
     int line = spellCheckRange->start().line();
     int rangeStart = spellCheckRange->start().column();
-    int translatedEnd = m_document->computePositionWrtOffsets(m_currentDecToEncOffsetList, start + word.length());
+    const KTextEditor::Range range(line, rangeStart + translatedStart, line, rangeStart + translatedEnd);
+
+    // update a highlight of the previous check in place, if any is left
+    if (!reusableRanges.isEmpty()) {
+        KTextEditor::MovingRange *movingRange = reusableRanges.takeFirst();
+        movingRange->setRange(range);
+        for (MisspelledItem &item : m_misspelledList) {
+            if (item.first == movingRange) {
+                item.second = m_currentlyCheckedItem.second;
+                break;
+            }
+        }
+        return;
+    }
 
-    KTextEditor::MovingRange *movingRange = m_document->newMovingRange(KTextEditor::Range(line, rangeStart + translatedStart, line, rangeStart + translatedEnd));
+    KTextEditor::MovingRange *movingRange = m_document->newMovingRange(range);
     movingRange->setFeedback(this);
     KTextEditor::Attribute *attribute = new KTextEditor::Attribute();
     attribute->setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
@@ -603,10 +709,6 @@ void KateOnTheFlyChecker::misspelling(const QString &word, int start)
 
     movingRange->setAttribute(KTextEditor::Attribute::Ptr(attribute));
     m_misspelledList.push_back(MisspelledItem(movingRange, m_currentlyCheckedItem.second));
-
-    if (m_backgroundChecker) {
-        m_backgroundChecker->continueChecking();
-    }
 }
 
 void KateOnTheFlyChecker::spellCheckDone()
@@ -618,10 +720,6 @@ void KateOnTheFlyChecker::spellCheckDone()
     KTextEditor::MovingRange *movingRange = m_currentlyCheckedItem.first;
     stopCurrentSpellCheck();
     deleteMovingRangeQuickly(movingRange);
-
-    if (!m_spellCheckQueue.empty()) {
-        QTimer::singleShot(0, this, SLOT(performSpellCheck()));
-    }
 }
 
 QList<KTextEditor::MovingRange *> KateOnTheFlyChecker::installedMovingRanges(const KTextEditor::Range &range)
@@ -638,6 +736,25 @@ QList<KTextEditor::MovingRange *> KateOnTheFlyChecker::installedMovingRanges(con
     return toReturn;
 }
 
+void KateOnTheFlyChecker::deleteMovingRangesOutside(const KTextEditor::Range &range, const QList<QPair<KTextEditor::Range, QString>> &spellCheckRanges)
+{
+    MovingRangeList toDelete;
+    const MovingRangeList highlightsList = installedMovingRanges(range);
+    for (KTextEditor::MovingRange *movingRange : highlightsList) {
+        bool rechecked = false;
+        for (const QPair<KTextEditor::Range, QString> &p : spellCheckRanges) {
+            if (p.first.contains(*movingRange)) {
+                rechecked = true;
+                break;
+            }
+        }
+        if (!rechecked) {
+            toDelete.push_back(movingRange);
+        }
+    }
+    deleteMovingRanges(toDelete);
+}
+
 void KateOnTheFlyChecker::updateConfig()
 {
     ON_THE_FLY_DEBUG;
@@ -669,12 +786,14 @@ void KateOnTheFlyChecker::viewDestroyed(QObject *obj)
     ON_THE_FLY_DEBUG;
     KTextEditor::View *view = static_cast<KTextEditor::View *>(obj);
     m_displayRangeMap.remove(view);
+    partitionSpellCheckQueue();
 }
 
 void KateOnTheFlyChecker::removeView(KTextEditor::View *view)
 {
     ON_THE_FLY_DEBUG;
     m_displayRangeMap.remove(view);
+    partitionSpellCheckQueue();
 }
 
 void KateOnTheFlyChecker::updateInstalledMovingRanges(KTextEditor::ViewPrivate *view)
@@ -706,6 +825,7 @@ void KateOnTheFlyChecker::updateInstalledMovingRanges(KTextEditor::ViewPrivate *
     }
     deleteMovingRanges(toDelete);
     m_displayRangeMap[view] = newDisplayRange;
+    partitionSpellCheckQueue();
     if (oldDisplayRange.isValid()) {
         bool emptyAtStart = m_spellCheckQueue.empty();
         for (int line = newDisplayRange.end().line(); line >= newDisplayRange.start().line(); --line) {
@@ -747,12 +867,10 @@ void KateOnTheFlyChecker::queueSpellCheckVisibleRange(KTextEditor::ViewPrivate *
         return;
     }
 
-    // clear all the highlights that are currently present in the range that
-    // is supposed to be checked, necessary due to highlighting
-    const MovingRangeList highlightsList = installedMovingRanges(intersection);
-    deleteMovingRanges(highlightsList);
-
     QList<QPair<KTextEditor::Range, QString>> spellCheckRanges = KTextEditor::EditorPrivate::self()->spellCheckManager()->spellCheckRanges(m_document, intersection, true);
+    // clear the highlights that won't be re-checked, necessary due to highlighting
+    deleteMovingRangesOutside(intersection, spellCheckRanges);
+
     // we queue them up in reverse
     QListIterator<QPair<KTextEditor::Range, QString>> i(spellCheckRanges);
     i.toBack();
@@ -765,13 +883,11 @@ void KateOnTheFlyChecker::queueSpellCheckVisibleRange(KTextEditor::ViewPrivate *
 void KateOnTheFlyChecker::queueLineSpellCheck(KTextEditor::DocumentPrivate *kateDocument, int line)
 {
     const KTextEditor::Range range = KTextEditor::Range(line, 0, line, kateDocument->lineLength(line));
-    // clear all the highlights that are currently present in the range that
-    // is supposed to be checked, necessary due to highlighting
-
-    const MovingRangeList highlightsList = installedMovingRanges(range);
-    deleteMovingRanges(highlightsList);
 
     QList<QPair<KTextEditor::Range, QString>> spellCheckRanges = KTextEditor::EditorPrivate::self()->spellCheckManager()->spellCheckRanges(kateDocument, range, true);
+    // clear the highlights that won't be re-checked, necessary due to highlighting
+    deleteMovingRangesOutside(range, spellCheckRanges);
+
     // we queue them up in reverse
     QListIterator<QPair<KTextEditor::Range, QString>> i(spellCheckRanges);
     i.toBack();
@@ -810,13 +926,18 @@ void KateOnTheFlyChecker::addToSpellCheckQueue(KTextEditor::MovingRange *range,
         KTextEditor::MovingRange *spellCheckRange = (*i).first;
         if (range->contains(*spellCheckRange)) {
             deleteMovingRangeQuickly(spellCheckRange);
-            i = m_spellCheckQueue.erase(i);
+            i = eraseFromSpellCheckQueue(i);
         } else {
             ++i;
         }
     }
-    // leave 'push_front' here as it is a LIFO queue, i.e. a stack
-    m_spellCheckQueue.push_front(SpellCheckItem(range, dictionary));
+    // leave 'push_front' here as it is a LIFO queue, i.e. a stack, displayed ranges stay in front of the others
+    if (isDisplayed(*range)) {
+        m_spellCheckQueue.push_front(SpellCheckItem(range, dictionary));
+        ++m_displayedSpellCheckItems;
+    } else {
+        m_spellCheckQueue.insert(m_displayedSpellCheckItems, SpellCheckItem(range, dictionary));
+    }
     ON_THE_FLY_DEBUG << "added" << *range << dictionary << "to the queue, which has a length of" << m_spellCheckQueue.size();
 }
 
@@ -33,11 +33,6 @@
 
 #include "katedocument.h"
 
-namespace Sonnet
-{
-class BackgroundChecker;
-}
-
 class KateOnTheFlyChecker : public QObject, private KTextEditor::MovingRangeFeedback
 {
     Q_OBJECT
@@ -74,7 +69,10 @@ protected:
     KTextEditor::DocumentPrivate *const m_document;
     Sonnet::Speller m_speller;
     QList<SpellCheckItem> m_spellCheckQueue;
-    Sonnet::BackgroundChecker *m_backgroundChecker;
+    /**
+     * the first m_displayedSpellCheckItems items of the queue overlap a displayed range
+     **/
+    int m_displayedSpellCheckItems = 0;
     SpellCheckItem m_currentlyCheckedItem;
     MisspelledList m_misspelledList;
     ModificationList m_modificationList;
@@ -84,6 +82,11 @@ protected:
     void freeDocument();
 
     MovingRangeList installedMovingRanges(const KTextEditor::Range &range);
+    /**
+     * delete the misspelled ranges in 'range' that are not inside one of 'spellCheckRanges',
+     * the others are kept until their re-check updates them
+     **/
+    void deleteMovingRangesOutside(const KTextEditor::Range &range, const QList<QPair<KTextEditor::Range, QString>> &spellCheckRanges);
 
     void queueLineSpellCheck(KTextEditor::DocumentPrivate *document, int line);
     /**
@@ -116,12 +119,24 @@ protected:
     void deleteMovingRangeQuickly(KTextEditor::MovingRange *range);
     void stopCurrentSpellCheck();
 
+    /**
+     * take the next item from the queue, ranges that are currently displayed come first
+     **/
+    SpellCheckItem takeNextSpellCheckItem();
+    QList<SpellCheckItem>::iterator eraseFromSpellCheckQueue(QList<SpellCheckItem>::iterator i);
+    bool isDisplayed(const KTextEditor::Range &range) const;
+    /**
+     * move the displayed ranges to the front of the queue again, after the displayed ranges changed
+     **/
+    void partitionSpellCheckQueue();
+    void spellCheckCurrentItem();
+    void misspelling(int start, int length, MovingRangeList &reusableRanges);
+    void spellCheckDone();
+
 protected Q_SLOTS:
     void performSpellCheck();
     void addToDictionary(const QString &word);
     void addToSession(const QString &word);
-    void misspelling(const QString &word, int start);
-    void spellCheckDone();
 
     void viewDestroyed(QObject *obj);
     void addView(KTextEditor::Document *document, KTextEditor::View *view);
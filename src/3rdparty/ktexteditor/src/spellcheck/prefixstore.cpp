@@ -40,25 +40,8 @@ void KatePrefixStore::addPrefix(const QString &prefix)
     if (m_prefixSet.contains(prefix)) {
         return;
     }
-    unsigned long long state = 0;
-    for (int i = 0; i < prefix.length(); ++i) {
-        QChar c = prefix.at(i);
-
-        CharToOccurrenceStateHash &hash = m_transitionFunction[state];
-        CharToOccurrenceStateHash::iterator it = hash.find(c.unicode());
-        if (it == hash.end()) {
-            state = nextFreeState();
-            hash[c.unicode()] = QPair<unsigned int, unsigned long long>(1, state);
-            continue;
-        }
-
-        ++(*it).first;
-        state = (*it).second;
-    }
-    // add the last state as accepting state
-    m_acceptingStates.insert(state);
-
     m_prefixSet.insert(prefix);
+    m_tableValid = false;
 
     if (prefix.length() > m_longestPrefixLength) {
         m_longestPrefixLength = prefix.length();
@@ -74,29 +57,7 @@ void KatePrefixStore::removePrefix(const QString &prefix)
         return;
     }
     m_prefixSet.remove(prefix);
-
-    unsigned long long state = 0;
-    for (int i = 0; i < prefix.length(); ++i) {
-        QChar c = prefix.at(i);
-
-        CharToOccurrenceStateHash &hash = m_transitionFunction[state];
-        CharToOccurrenceStateHash::iterator it = hash.find(c.unicode());
-        if (it == hash.end()) {
-            continue;
-        }
-
-        state = (*it).second;
-        if (m_acceptingStates.contains(state) && i == prefix.length() - 1) {
-            m_acceptingStates.remove(state);
-        }
-
-        if ((*it).first <= 1) {
-            hash.erase(it);
-            m_stateFreeList.push_back(state);
-        } else {
-            --(*it).first;
-        }
-    }
+    m_tableValid = false;
 
     if (prefix.length() == m_longestPrefixLength) {
         m_longestPrefixLength = computeLongestPrefixLength();
@@ -105,51 +66,96 @@ void KatePrefixStore::removePrefix(const QString &prefix)
 
 void KatePrefixStore::dump()
 {
-    for (unsigned long long i = 0; i < m_lastAssignedState; ++i) {
-        CharToOccurrenceStateHash &hash = m_transitionFunction[i];
-        for (CharToOccurrenceStateHash::iterator it = hash.begin(); it != hash.end(); ++it) {
-            qCDebug(LOG_KTE) << i << "x" << QChar(it.key()) << "->" << it.value().first << "x" << it.value().second;
+    buildTransitionTable();
+
+    const int states = m_transitionTable.size() / m_rowLength;
+    for (int state = 0; state < states; ++state) {
+        const unsigned int *row = m_transitionTable.constData() + state * m_rowLength;
+        for (int c = 0; c < m_characterClasses.size(); ++c) {
+            const unsigned short characterClass = m_characterClasses.at(c);
+            if (characterClass && row[characterClass]) {
+                qCDebug(LOG_KTE) << state << "x" << QChar(c) << "->" << row[characterClass] << (m_transitionTable.at(row[characterClass] * m_rowLength) ? "(accepting)" : "");
+            }
         }
     }
-    qCDebug(LOG_KTE) << "Accepting states" << m_acceptingStates;
 }
 
 QString KatePrefixStore::findPrefix(const QString &s, int start) const
 {
-    unsigned long long state = 0;
-    for (int i = start; i < s.length(); ++i) {
-        QChar c = s.at(i);
-        const CharToOccurrenceStateHash &hash = m_transitionFunction[state];
-        CharToOccurrenceStateHash::const_iterator it = hash.find(c.unicode());
-        if (it == hash.end()) {
-            return QString();
+    const int length = findPrefixLength(s.constData() + start, s.length() - start);
+    return length > 0 ? s.mid(start, length) : QString();
+}
+
+QString KatePrefixStore::findPrefix(const Kate::TextLine &line, int start) const
+{
+    const int length = findPrefixLength(line->string().constData() + start, line->length() - start);
+    return length > 0 ? line->string(start, length) : QString();
+}
+
+int KatePrefixStore::findPrefixLength(const QChar *s, int length) const
+{
+    buildTransitionTable();
+
+    const int characterCount = m_characterClasses.size();
+    const unsigned short *characterClasses = m_characterClasses.constData();
+    const unsigned int *table = m_transitionTable.constData();
+
+    unsigned int state = 0;
+    for (int i = 0; i < length; ++i) {
+        const ushort c = s[i].unicode();
+        if (c >= characterCount || !characterClasses[c]) {
+            return 0;
         }
 
-        state = (*it).second;
-        if (m_acceptingStates.contains(state)) {
-            return s.mid(start, i + 1 - start);
+        state = table[state * m_rowLength + characterClasses[c]];
+        if (!state) {
+            return 0;
+        }
+        if (table[state * m_rowLength]) {
+            return i + 1;
         }
     }
-    return QString();
+    return 0;
 }
 
-QString KatePrefixStore::findPrefix(const Kate::TextLine &line, int start) const
+void KatePrefixStore::buildTransitionTable() const
 {
-    unsigned long long state = 0;
-    for (int i = start; i < line->length(); ++i) {
-        QChar c = line->at(i);
-        const CharToOccurrenceStateHash &hash = m_transitionFunction[state];
-        CharToOccurrenceStateHash::const_iterator it = hash.find(c.unicode());
-        if (it == hash.end()) {
-            return QString();
+    if (m_tableValid) {
+        return;
+    }
+    m_tableValid = true;
+
+    // number the characters of the alphabet, the class 0 is reserved for the accepting flag
+    m_characterClasses.clear();
+    unsigned short classCount = 0;
+    for (const QString &prefix : m_prefixSet) {
+        for (const QChar c : prefix) {
+            if (c.unicode() >= m_characterClasses.size()) {
+                m_characterClasses.resize(c.unicode() + 1);
+            }
+            if (!m_characterClasses.at(c.unicode())) {
+                m_characterClasses[c.unicode()] = ++classCount;
+            }
         }
-
-        state = (*it).second;
-        if (m_acceptingStates.contains(state)) {
-            return line->string(start, i + 1 - start);
+    }
+    m_rowLength = classCount + 1;
+
+    // insert all prefixes into the trie, appending a new row for each new state
+    m_transitionTable.fill(0, m_rowLength);
+    for (const QString &prefix : m_prefixSet) {
+        unsigned int state = 0;
+        for (const QChar c : prefix) {
+            const int index = state * m_rowLength + m_characterClasses.at(c.unicode());
+            if (!m_transitionTable.at(index)) {
+                const unsigned int newState = m_transitionTable.size() / m_rowLength;
+                m_transitionTable[index] = newState;
+                m_transitionTable.resize(m_transitionTable.size() + m_rowLength);
+            }
+            state = m_transitionTable.at(index);
         }
+        // mark the last state as accepting state
+        m_transitionTable[state * m_rowLength] = 1;
     }
-    return QString();
 }
 
 int KatePrefixStore::longestPrefixLength() const
@@ -161,10 +167,10 @@ void KatePrefixStore::clear()
 {
     m_longestPrefixLength = 0;
     m_prefixSet.clear();
-    m_transitionFunction.clear();
-    m_acceptingStates.clear();
-    m_stateFreeList.clear();
-    m_lastAssignedState = 0;
+    m_characterClasses.clear();
+    m_transitionTable.clear();
+    m_rowLength = 1;
+    m_tableValid = true;
 }
 
 int KatePrefixStore::computeLongestPrefixLength()
@@ -176,11 +182,3 @@ int KatePrefixStore::computeLongestPrefixLength()
     }
     return toReturn;
 }
-
-unsigned long long KatePrefixStore::nextFreeState()
-{
-    if (!m_stateFreeList.isEmpty()) {
-        return m_stateFreeList.takeFirst();
-    }
-    return ++m_lastAssignedState;
-}
@@ -21,8 +21,6 @@
 #ifndef PREFIXSTORE_H
 #define PREFIXSTORE_H
 
-#include <QHash>
-#include <QList>
 #include <QPair>
 #include <QSet>
 #include <QString>
@@ -37,6 +35,10 @@
  * order to check whether a given string contains one of the strings that are being
  * searched for the constructed automaton has to applied on each position in the
  * given string.
+ *
+ * The automaton is stored as one flat transition table over the alphabet of the
+ * stored strings, so every character step is two array lookups. The table is
+ * rebuilt on the first search after the stored strings have changed.
  **/
 class KatePrefixStore
 {
@@ -71,16 +73,17 @@ protected:
     int m_longestPrefixLength = 0;
     QSet<QString> m_prefixSet;
 
-    // State x Char -> Nr. of char occurrences in prefixes x State
-    typedef QHash<unsigned short, QPair<unsigned int, unsigned long long>> CharToOccurrenceStateHash;
-    typedef QHash<unsigned long long, CharToOccurrenceStateHash> TransitionFunction;
-    TransitionFunction m_transitionFunction;
-    QSet<unsigned long long> m_acceptingStates;
-    QList<unsigned long long> m_stateFreeList;
-    unsigned long long m_lastAssignedState = 0;
+    // Unicode value -> character class, 0 for characters not occurring in any prefix
+    mutable QVector<unsigned short> m_characterClasses;
+    // State x (accepting flag, character class 1..n) -> State, one row per state,
+    // state 0 is the start state and doubles as "no transition"
+    mutable QVector<unsigned int> m_transitionTable;
+    mutable int m_rowLength = 1;
+    mutable bool m_tableValid = true;
 
     int computeLongestPrefixLength();
-    unsigned long long nextFreeState();
+    void buildTransitionTable() const;
+    int findPrefixLength(const QChar *s, int length) const;
     //     bool containsPrefixOfLengthEndingWith(int length, const QChar& c);
 };
 
@@ -31,6 +31,15 @@
 #include "katedocument.h"
 #include "katehighlight.h"
 
+namespace
+{
+/**
+ * maximal number of cached results per language, the cache of a language is
+ * simply flushed once it grows beyond that
+ */
+const int maximumCachedWords = 50000;
+}
+
 KateSpellCheckManager::KateSpellCheckManager(QObject *parent)
     : QObject(parent)
 {
@@ -52,6 +61,7 @@ void KateSpellCheckManager::ignoreWord(const QString &word, const QString &dicti
     Sonnet::Speller speller;
     speller.setLanguage(dictionary);
     speller.addToSession(word);
+    uncacheWord(word);
     emit wordIgnored(word);
 }
 
@@ -60,9 +70,34 @@ void KateSpellCheckManager::addToDictionary(const QString &word, const QString &
     Sonnet::Speller speller;
     speller.setLanguage(dictionary);
     speller.addToPersonal(word);
+    uncacheWord(word);
     emit wordAddedToDictionary(word);
 }
 
+bool KateSpellCheckManager::isMisspelled(Sonnet::Speller &speller, const QString &word)
+{
+    QHash<QString, bool> &cache = m_misspelledCache[speller.language()];
+    const auto it = cache.constFind(word);
+    if (it != cache.constEnd()) {
+        return it.value();
+    }
+
+    if (cache.size() >= maximumCachedWords) {
+        cache.clear();
+    }
+    const bool misspelled = speller.isMisspelled(word);
+    cache.insert(word, misspelled);
+    return misspelled;
+}
+
+void KateSpellCheckManager::uncacheWord(const QString &word)
+{
+    // the signals don't tell the dictionary, all checkers update their speller whatever its language is
+    for (auto it = m_misspelledCache.begin(); it != m_misspelledCache.end(); ++it) {
+        it.value().remove(word);
+    }
+}
+
 QList<KTextEditor::Range> KateSpellCheckManager::rangeDifference(const KTextEditor::Range &r1, const KTextEditor::Range &r2)
 {
     Q_ASSERT(r1.contains(r2));
@@ -21,6 +21,7 @@
 #ifndef SPELLCHECK_H
 #define SPELLCHECK_H
 
+#include <QHash>
 #include <QList>
 #include <QObject>
 #include <QPair>
@@ -50,6 +51,13 @@ public:
     void ignoreWord(const QString &word, const QString &dictionary);
     void addToDictionary(const QString &word, const QString &dictionary);
 
+    /**
+     * Check a single word with 'speller'. The results are cached per language, so repeated
+     * words are looked up only once; ignoring a word or adding it to the dictionary drops
+     * its cached results.
+     **/
+    bool isMisspelled(Sonnet::Speller &speller, const QString &word);
+
     /**
      * 'r2' is a subrange of 'r1', which is extracted from 'r1' and the remaining ranges are returned
      **/
@@ -58,7 +66,7 @@ public:
 Q_SIGNALS:
     /**
      * These signals are used to propagate the dictionary changes to the
-     * BackgroundChecker instance in other components (e.g. onTheFlyChecker).
+     * speller instances in other components (e.g. onTheFlyChecker).
      */
     void wordAddedToDictionary(const QString &word);
     void wordIgnored(const QString &word);
@@ -74,6 +82,12 @@ public:
 
 private:
     void trimRange(KTextEditor::DocumentPrivate *doc, KTextEditor::Range &r);
+    void uncacheWord(const QString &word);
+
+    /**
+     * word -> misspelled for each language, every table is bounded by maximumCachedWords
+     **/
+    QHash<QString, QHash<QString, bool>> m_misspelledCache;
 };
 
 #endif
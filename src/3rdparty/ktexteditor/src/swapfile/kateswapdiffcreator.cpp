@@ -20,6 +20,7 @@
 
 #include "kateswapdiffcreator.h"
 #include "katedocument.h"
+#include "katelinediff.h"
 #include "katepartdebug.h"
 #include "kateswapfile.h"
 
@@ -29,6 +30,8 @@
 #include <KIO/JobUiDelegate>
 
 #include <QDir>
+#include <QTemporaryFile>
+#include <QTextCodec>
 
 // BEGIN SwapDiffCreator
 SwapDiffCreator::SwapDiffCreator(Kate::SwapFile *swapFile)
@@ -54,108 +57,46 @@ void SwapDiffCreator::viewDiff()
         return;
     }
 
-    // create all needed tempfiles
-    m_originalFile.setFileTemplate(QDir::tempPath() + QLatin1String("/katepart_XXXXXX.original"));
-    m_recoveredFile.setFileTemplate(QDir::tempPath() + QLatin1String("/katepart_XXXXXX.recovered"));
-    m_diffFile.setFileTemplate(QDir::tempPath() + QLatin1String("/katepart_XXXXXX.diff"));
-
-    if (!m_originalFile.open() || !m_recoveredFile.open() || !m_diffFile.open()) {
-        qCWarning(LOG_KTE) << "Can't open temporary files needed for diffing";
-        return;
-    }
-
-    // truncate files, just in case
-    m_originalFile.resize(0);
-    m_recoveredFile.resize(0);
-    m_diffFile.resize(0);
-
     // create a document with the recovered data
     KTextEditor::DocumentPrivate recoverDoc;
     recoverDoc.setText(m_swapFile->document()->text());
 
-    // store original text in a file as utf-8 and close it
-    {
-        QTextStream stream(&m_originalFile);
-        stream.setCodec(QTextCodec::codecForName("UTF-8"));
-        stream << recoverDoc.text();
-    }
-    m_originalFile.close();
+    // remember the original lines, they share the text with the buffer
+    const QStringList originalLines = KateLineDiff::lines(recoverDoc.buffer());
 
     // recover data
     QDataStream stream(&swp);
     recoverDoc.swapFile()->recover(stream, false);
 
-    // store recovered text in a file as utf-8 and close it
-    {
-        QTextStream stream(&m_recoveredFile);
-        stream.setCodec(QTextCodec::codecForName("UTF-8"));
-        stream << recoverDoc.text();
-    }
-    m_recoveredFile.close();
-
-    // create a process for diff
-    m_proc.setProcessChannelMode(QProcess::MergedChannels);
+    // diff in-process, no temporary copies of both texts and no external diff(1)
+    const QStringList recoveredLines = KateLineDiff::lines(recoverDoc.buffer());
+    const QVector<KateLineDiff::Hunk> hunks = KateLineDiff::diff(originalLines, recoveredLines);
 
-    connect(&m_proc, SIGNAL(readyRead()), this, SLOT(slotDataAvailable()), Qt::UniqueConnection);
-    connect(&m_proc, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(slotDiffFinished()), Qt::UniqueConnection);
-
-    // try to start diff process, if we can't be started be done with error
-    m_proc.start(QStringLiteral("diff"), QStringList() << QStringLiteral("-u") << m_originalFile.fileName() << m_recoveredFile.fileName());
-    if (!m_proc.waitForStarted()) {
-        KMessageBox::sorry(nullptr,
-                           i18n("The diff command could not be started. Please make sure that "
-                                "diff(1) is installed and in your PATH."),
-                           i18n("Error Creating Diff"));
+    // sanity check: is there any diff content?
+    if (hunks.isEmpty()) {
+        KMessageBox::information(nullptr, i18n("The files are identical."), i18n("Diff Output"));
         deleteLater();
         return;
     }
 
-    // process is up and running, we can write data to it
-    QTextStream ts(&m_proc);
-    int lineCount = recoverDoc.lines();
-    for (int line = 0; line < lineCount; ++line) {
-        ts << recoverDoc.line(line) << '\n';
-    }
-    ts.flush();
-    m_proc.closeWriteChannel();
-}
-
-void SwapDiffCreator::slotDataAvailable()
-{
-    // collect diff output
-    m_diffFile.write(m_proc.readAll());
-}
-
-void SwapDiffCreator::slotDiffFinished()
-{
-    // collect last diff output, if any
-    m_diffFile.write(m_proc.readAll());
-
-    // get the exit status to check whether diff command run successfully
-    const QProcess::ExitStatus es = m_proc.exitStatus();
-
-    // check exit status
-    if (es != QProcess::NormalExit) {
-        KMessageBox::sorry(nullptr,
-                           i18n("The diff command failed. Please make sure that "
-                                "diff(1) is installed and in your PATH."),
-                           i18n("Error Creating Diff"));
+    QTemporaryFile diffFile(QDir::tempPath() + QLatin1String("/katepart_XXXXXX.diff"));
+    if (!diffFile.open()) {
+        qCWarning(LOG_KTE) << "Can't open temporary file needed for diffing";
         deleteLater();
         return;
     }
 
-    // sanity check: is there any diff content?
-    if (m_diffFile.size() == 0) {
-        KMessageBox::information(nullptr, i18n("The files are identical."), i18n("Diff Output"));
-        deleteLater();
-        return;
+    // store the diff in the file as utf-8 and close it, avoid removal, KIO::OpenUrlJob will do that later!
+    const QString name = m_swapFile->document()->url().fileName();
+    {
+        QTextStream stream(&diffFile);
+        stream.setCodec(QTextCodec::codecForName("UTF-8"));
+        stream << KateLineDiff::unifiedDiff(originalLines, recoveredLines, hunks, name + QLatin1String(".original"), name + QLatin1String(".recovered"));
     }
+    diffFile.close();
+    diffFile.setAutoRemove(false);
 
-    // close diffFile and avoid removal, KIO::OpenUrlJob will do that later!
-    m_diffFile.close();
-    m_diffFile.setAutoRemove(false);
-
-    KIO::OpenUrlJob *job = new KIO::OpenUrlJob(QUrl::fromLocalFile(m_diffFile.fileName()), QStringLiteral("text/x-patch"));
+    KIO::OpenUrlJob *job = new KIO::OpenUrlJob(QUrl::fromLocalFile(diffFile.fileName()), QStringLiteral("text/x-patch"));
     job->setUiDelegate(new KIO::JobUiDelegate(KJobUiDelegate::AutoHandlingEnabled, m_swapFile->document()->activeView()));
     job->setDeleteTemporaryFile(true); // delete the file, once the client exits
     job->start();
@@ -21,10 +21,7 @@
 #ifndef KATE_SWAP_DIFF_CREATOR_H
 #define KATE_SWAP_DIFF_CREATOR_H
 
-#include <QAction>
-#include <QByteArray>
-#include <QProcess>
-#include <QTemporaryFile>
+#include <QObject>
 
 namespace Kate
 {
@@ -44,16 +41,6 @@ public Q_SLOTS:
 
 private:
     Kate::SwapFile *const m_swapFile;
-
-protected Q_SLOTS:
-    void slotDataAvailable();
-    void slotDiffFinished();
-
-private:
-    QProcess m_proc;
-    QTemporaryFile m_originalFile;
-    QTemporaryFile m_recoveredFile;
-    QTemporaryFile m_diffFile;
 };
 
 #endif // KATE_SWAP_DIFF_CREATOR_H
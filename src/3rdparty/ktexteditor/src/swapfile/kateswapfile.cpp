@@ -19,12 +19,12 @@
     Boston, MA 02110-1301, USA.
 */
 
-#include "config.h"
-
 #include "kateconfig.h"
+#include "kateglobal.h"
 #include "katepartdebug.h"
 #include "kateswapdiffcreator.h"
 #include "kateswapfile.h"
+#include "kateswapfilewriter.h"
 #include "kateundomanager.h"
 
 #include <ktexteditor/view.h>
@@ -32,15 +32,10 @@
 #include <KLocalizedString>
 #include <KStandardGuiItem>
 
-#include <QApplication>
 #include <QCryptographicHash>
 #include <QDir>
 #include <QFileInfo>
 
-#ifndef Q_OS_WIN
-#include <unistd.h>
-#endif
-
 // swap file version header
 const static char swapFileVersionString[] = "Kate Swap File 2.0";
 
@@ -51,24 +46,22 @@ const static qint8 EA_WrapLine = 'W';
 const static qint8 EA_UnwrapLine = 'U';
 const static qint8 EA_InsertText = 'I';
 const static qint8 EA_RemoveText = 'R';
+const static qint8 EA_Checkpoint = 'C';
+
+// journal size below which the swap file is never compacted
+const static qint64 minimalCheckpointJournalSize = 4 * 1024 * 1024;
 
 namespace Kate
 {
-QTimer *SwapFile::s_timer = nullptr;
-
 SwapFile::SwapFile(KTextEditor::DocumentPrivate *document)
     : QObject(document)
     , m_document(document)
     , m_trackingEnabled(false)
     , m_recovered(false)
-    , m_needSync(false)
 {
     // fixed version of serialisation
     m_stream.setVersion(QDataStream::Qt_4_6);
 
-    // connect the timer
-    connect(syncTimer(), SIGNAL(timeout()), this, SLOT(writeFileToDisk()), Qt::DirectConnection);
-
     // connecting the signals
     connect(&m_document->buffer(), SIGNAL(saved(QString)), this, SLOT(fileSaved(QString)));
     connect(&m_document->buffer(), SIGNAL(loaded(QString, bool)), this, SLOT(fileLoaded(QString)));
@@ -139,6 +132,11 @@ KTextEditor::DocumentPrivate *SwapFile::document()
     return m_document;
 }
 
+SwapFileWriter *SwapFile::writer() const
+{
+    return KTextEditor::EditorPrivate::self()->swapFileWriter();
+}
+
 bool SwapFile::isValidSwapFile(QDataStream &stream, bool checkDigest) const
 {
     // read and check header
@@ -201,7 +199,6 @@ void SwapFile::fileLoaded(const QString &)
 void SwapFile::modifiedChanged()
 {
     if (!m_document->isModified() && !shouldRecover()) {
-        m_needSync = false;
         // the file is not modified and we are not in recover mode
         removeSwapFile();
     }
@@ -211,11 +208,11 @@ void SwapFile::recover()
 {
     m_document->setReadWrite(true);
 
-    // if isOpen() returns true, the swap file likely changed already (appended data)
+    // if the journal is open, the swap file likely changed already (appended data)
     // Example: The document was falsely marked as writable and the user changed
     // text even though the recover bar was visible. In this case, a replay of
     // the swap file across wrong document content would happen -> certainly wrong
-    if (m_swapfile.isOpen()) {
+    if (m_buffer.isOpen()) {
         qCWarning(LOG_KTE) << "Attempt to recover an already modified document. Aborting";
         removeSwapFile();
         return;
@@ -231,13 +228,13 @@ void SwapFile::recover()
     m_recovered = true;
 
     // open data stream
-    m_stream.setDevice(&m_swapfile);
+    QDataStream stream(&m_swapfile);
+    stream.setVersion(QDataStream::Qt_4_6);
 
     // replay the swap file
-    bool success = recover(m_stream);
+    bool success = recover(stream);
 
     // close swap file
-    m_stream.setDevice(nullptr);
     m_swapfile.close();
 
     if (!success) {
@@ -383,6 +380,20 @@ bool SwapFile::recover(QDataStream &stream, bool checkDigest)
 
             break;
         }
+        case EA_Checkpoint: {
+            if (editRunning) {
+                brokenSwapFile = true;
+                break;
+            }
+
+            // the snapshot replaces all edits before it, only the tail behind it is replayed
+            QByteArray text;
+            stream >> text;
+            m_document->setText(QString::fromUtf8(qUncompress(text)));
+            m_document->undoManager()->undoSafePoint();
+
+            break;
+        }
         default: {
             qCWarning(LOG_KTE) << "Unknown type:" << type;
         }
@@ -415,8 +426,6 @@ bool SwapFile::recover(QDataStream &stream, bool checkDigest)
 
 void SwapFile::fileSaved(const QString &)
 {
-    m_needSync = false;
-
     // remove old swap file (e.g. if a file A was "saved as" B)
     removeSwapFile();
 
@@ -431,28 +440,31 @@ void SwapFile::startEditing()
         return;
     }
 
-    // if swap file doesn't exists, open it in WriteOnly mode
+    // if swap file doesn't exists, let the writer open it in WriteOnly mode
     // if it does, append the data to the existing swap file,
     // in case you recover and start editing again
-    if (!m_swapfile.exists()) {
-        // create path if not there
-        if (KateDocumentConfig::global()->swapFileMode() == KateDocumentConfig::SwapFilePresetDirectory && !QDir(KateDocumentConfig::global()->swapDirectory()).exists()) {
-            QDir().mkpath(KateDocumentConfig::global()->swapDirectory());
-        }
+    if (m_stream.device() == nullptr) {
+        const bool append = m_swapfile.exists();
+        m_journalSize = append ? m_swapfile.size() : 0;
+        m_checkpointSize = 0;
+
+        m_buffer.open(QIODevice::WriteOnly);
+        m_stream.setDevice(&m_buffer);
+
+        if (!append) {
+            // create path if not there
+            if (KateDocumentConfig::global()->swapFileMode() == KateDocumentConfig::SwapFilePresetDirectory && !QDir(KateDocumentConfig::global()->swapDirectory()).exists()) {
+                QDir().mkpath(KateDocumentConfig::global()->swapDirectory());
+            }
 
-        m_swapfile.open(QIODevice::WriteOnly);
-        m_swapfile.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
-        m_stream.setDevice(&m_swapfile);
+            // write file header
+            m_stream << QByteArray(swapFileVersionString);
 
-        // write file header
-        m_stream << QByteArray(swapFileVersionString);
+            // write checksum
+            m_stream << m_document->checksum();
+        }
 
-        // write checksum
-        m_stream << m_document->checksum();
-    } else if (m_stream.device() == nullptr) {
-        m_swapfile.open(QIODevice::Append);
-        m_swapfile.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
-        m_stream.setDevice(&m_swapfile);
+        writer()->open(m_swapfile.fileName(), append);
     }
 
     // format: qint8
@@ -462,73 +474,87 @@ void SwapFile::startEditing()
 void SwapFile::finishEditing()
 {
     // skip if not open
-    if (!m_swapfile.isOpen()) {
+    if (!m_buffer.isOpen()) {
         return;
     }
 
-    // write the file to the disk every 15 seconds (default)
-    // skip this if we disabled that
-    if (m_document->config()->swapSyncInterval() != 0 && !syncTimer()->isActive()) {
-        // important: we store the interval as seconds, start wants milliseconds!
-        syncTimer()->start(m_document->config()->swapSyncInterval() * 1000);
-    }
-
     // format: qint8
     m_stream << EA_FinishEditing;
-    m_swapfile.flush();
+
+    // hand the transaction to the writer, it syncs the file to the disk
+    // every 15 seconds (default), or never if we disabled that
+    writer()->append(m_swapfile.fileName(), m_buffer.data(), m_document->config()->swapSyncInterval());
+    m_journalSize += m_buffer.size();
+    m_buffer.buffer().clear();
+    m_buffer.seek(0);
+
+    // compact the swap file once the journal outgrew the last checkpoint,
+    // this keeps both its size and the recovery time bounded
+    if (m_journalSize > qMax(minimalCheckpointJournalSize, 2 * m_checkpointSize)) {
+        writeCheckpoint();
+    }
+}
+
+void SwapFile::writeCheckpoint()
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    // same header as a new swap file
+    stream << QByteArray(swapFileVersionString);
+    stream << m_document->checksum();
+
+    // format: qint8, bytearray
+    stream << EA_Checkpoint << qCompress(m_document->text().toUtf8(), 1);
+
+    writer()->replace(m_swapfile.fileName(), data);
+    m_journalSize = m_checkpointSize = data.size();
 }
 
 void SwapFile::wrapLine(const KTextEditor::Cursor &position)
 {
     // skip if not open
-    if (!m_swapfile.isOpen()) {
+    if (!m_buffer.isOpen()) {
         return;
     }
 
     // format: qint8, int, int
     m_stream << EA_WrapLine << position.line() << position.column();
-
-    m_needSync = true;
 }
 
 void SwapFile::unwrapLine(int line)
 {
     // skip if not open
-    if (!m_swapfile.isOpen()) {
+    if (!m_buffer.isOpen()) {
         return;
     }
 
     // format: qint8, int
     m_stream << EA_UnwrapLine << line;
-
-    m_needSync = true;
 }
 
 void SwapFile::insertText(const KTextEditor::Cursor &position, const QString &text)
 {
     // skip if not open
-    if (!m_swapfile.isOpen()) {
+    if (!m_buffer.isOpen()) {
         return;
     }
 
     // format: qint8, int, int, bytearray
     m_stream << EA_InsertText << position.line() << position.column() << text.toUtf8();
-
-    m_needSync = true;
 }
 
 void SwapFile::removeText(const KTextEditor::Range &range)
 {
     // skip if not open
-    if (!m_swapfile.isOpen()) {
+    if (!m_buffer.isOpen()) {
         return;
     }
 
     // format: qint8, int, int, int
     Q_ASSERT(range.start().line() == range.end().line());
     m_stream << EA_RemoveText << range.start().line() << range.start().column() << range.end().column();
-
-    m_needSync = true;
 }
 
 bool SwapFile::shouldRecover() const
@@ -555,8 +581,16 @@ void SwapFile::discard()
 
 void SwapFile::removeSwapFile()
 {
-    if (!m_swapfile.fileName().isEmpty() && m_swapfile.exists()) {
+    // the writer closes and removes the file behind its pending writes, without blocking us on a sync
+    if (m_buffer.isOpen()) {
+        writer()->close(m_swapfile.fileName(), true);
         m_stream.setDevice(nullptr);
+        m_buffer.close();
+        m_buffer.setData(QByteArray());
+    }
+
+    // remove it right away anyway, where this fails for the still open file, the writer removes it
+    if (!m_swapfile.fileName().isEmpty() && m_swapfile.exists()) {
         m_swapfile.close();
         m_swapfile.remove();
     }
@@ -606,32 +640,6 @@ QString SwapFile::fileName()
     return path;
 }
 
-QTimer *SwapFile::syncTimer()
-{
-    if (s_timer == nullptr) {
-        s_timer = new QTimer(QApplication::instance());
-        s_timer->setSingleShot(true);
-    }
-
-    return s_timer;
-}
-
-void SwapFile::writeFileToDisk()
-{
-    if (m_needSync) {
-        m_needSync = false;
-
-#ifndef Q_OS_WIN
-        // ensure that the file is written to disk
-#if HAVE_FDATASYNC
-        fdatasync(m_swapfile.handle());
-#else
-        fsync(m_swapfile.handle());
-#endif
-#endif
-    }
-}
-
 void SwapFile::showSwapFileMessage()
 {
     m_swapMessage = new KTextEditor::Message(i18n("The file was not closed properly."), KTextEditor::Message::Warning);
@@ -22,10 +22,10 @@
 #ifndef KATE_SWAPFILE_H
 #define KATE_SWAPFILE_H
 
+#include <QBuffer>
 #include <QDataStream>
 #include <QFile>
 #include <QObject>
-#include <QTimer>
 
 #include "katebuffer.h"
 #include "katedocument.h"
@@ -41,6 +41,8 @@ class ViewPrivate;
 
 namespace Kate
 {
+class SwapFileWriter;
+
 /**
  * Class for tracking editing actions.
  * In case Kate crashes, this can be used to replay all edit actions to
@@ -65,6 +67,8 @@ private:
     void removeSwapFile();
     bool updateFileName();
     bool isValidSwapFile(QDataStream &stream, bool checkDigest) const;
+    SwapFileWriter *writer() const;
+    void writeCheckpoint();
 
 private:
     KTextEditor::DocumentPrivate *m_document;
@@ -90,17 +94,19 @@ public Q_SLOTS:
     void configChanged();
 
 private:
+    /**
+     * records of the running editing transaction, handed to the writer when it is finished
+     */
     QDataStream m_stream;
+    QBuffer m_buffer;
     QFile m_swapfile;
     bool m_recovered;
-    bool m_needSync;
-    static QTimer *s_timer;
-
-protected Q_SLOTS:
-    void writeFileToDisk();
 
-private:
-    QTimer *syncTimer();
+    /**
+     * bytes in the swap file and in its last checkpoint, decide when to compact it
+     */
+    qint64 m_journalSize = 0;
+    qint64 m_checkpointSize = 0;
 
 public Q_SLOTS:
     void showSwapFileMessage();
@@ -0,0 +1,246 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "config.h"
+
+#include "katepartdebug.h"
+#include "kateswapfilewriter.h"
+
+#include <QFile>
+#include <QSaveFile>
+
+#ifndef Q_OS_WIN
+#include <unistd.h>
+#endif
+
+namespace Kate
+{
+SwapFileWriter::SwapFileWriter()
+{
+    m_clock.start();
+    start(QThread::LowPriority);
+}
+
+SwapFileWriter::~SwapFileWriter()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_jobsQueued.wakeAll();
+    }
+    wait();
+}
+
+void SwapFileWriter::open(const QString &fileName, bool append)
+{
+    enqueue(Job{Job::Open, fileName, QByteArray(), append, 0});
+}
+
+void SwapFileWriter::append(const QString &fileName, const QByteArray &data, int syncInterval)
+{
+    enqueue(Job{Job::Append, fileName, data, false, syncInterval});
+}
+
+void SwapFileWriter::replace(const QString &fileName, const QByteArray &data)
+{
+    enqueue(Job{Job::Replace, fileName, data, false, 0});
+}
+
+void SwapFileWriter::close(const QString &fileName, bool remove)
+{
+    enqueue(Job{remove ? Job::Remove : Job::Close, fileName, QByteArray(), false, 0});
+}
+
+SwapFileWriter::Statistics SwapFileWriter::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_statistics;
+}
+
+void SwapFileWriter::enqueue(const Job &job)
+{
+    QMutexLocker locker(&m_mutex);
+    m_jobs.append(job);
+    m_statistics.queueDepth = m_jobs.size();
+    m_statistics.maximalQueueDepth = qMax(m_statistics.maximalQueueDepth, m_statistics.queueDepth);
+    m_jobsQueued.wakeOne();
+}
+
+void SwapFileWriter::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (true) {
+        // sleep until there is work or the next file must be synced
+        if (m_jobs.isEmpty() && !m_quit) {
+            const qint64 deadline = nextSyncDeadline();
+            if (deadline < 0) {
+                m_jobsQueued.wait(&m_mutex);
+            } else if (deadline > m_clock.elapsed()) {
+                m_jobsQueued.wait(&m_mutex, deadline - m_clock.elapsed());
+            }
+        }
+
+        // take the whole queue, everything in it is committed together
+        const QList<Job> jobs = m_jobs;
+        m_jobs.clear();
+        m_statistics.queueDepth = 0;
+        const bool quit = m_quit;
+        locker.unlock();
+
+        QList<QFile *> writtenFiles;
+        for (const Job &job : jobs) {
+            process(job, writtenFiles);
+        }
+        for (QFile *file : qAsConst(writtenFiles)) {
+            file->flush();
+        }
+        syncDueFiles();
+
+        locker.relock();
+        if (quit && m_jobs.isEmpty()) {
+            break;
+        }
+    }
+
+    qDeleteAll(m_files);
+    m_files.clear();
+    m_syncDeadlines.clear();
+}
+
+void SwapFileWriter::process(const Job &job, QList<QFile *> &writtenFiles)
+{
+    switch (job.type) {
+    case Job::Open: {
+        QFile *oldFile = m_files.take(job.fileName);
+        writtenFiles.removeAll(oldFile);
+        delete oldFile;
+
+        QFile *file = new QFile(job.fileName);
+        if (!file->open(job.append ? QIODevice::Append : QIODevice::WriteOnly)) {
+            qCWarning(LOG_KTE) << "Can't open swap file:" << job.fileName;
+            delete file;
+            m_syncDeadlines.remove(job.fileName);
+            break;
+        }
+        file->setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+        m_files.insert(job.fileName, file);
+        m_syncDeadlines.insert(job.fileName, -1);
+        break;
+    }
+    case Job::Append: {
+        QFile *file = m_files.value(job.fileName);
+        if (!file) {
+            break;
+        }
+
+        file->write(job.data);
+        if (!writtenFiles.contains(file)) {
+            writtenFiles.append(file);
+        }
+
+        // the first unsynced write starts the countdown, later ones join that sync
+        qint64 &deadline = m_syncDeadlines[job.fileName];
+        if (job.syncInterval > 0 && deadline < 0) {
+            // important: we store the interval as seconds, we need milliseconds!
+            deadline = m_clock.elapsed() + job.syncInterval * 1000;
+        }
+        break;
+    }
+    case Job::Replace: {
+        QFile *file = m_files.take(job.fileName);
+        if (!file) {
+            break;
+        }
+        writtenFiles.removeAll(file);
+        delete file;
+
+        // commit() syncs the new file to disk before renaming it
+        QSaveFile saveFile(job.fileName);
+        if (!saveFile.open(QIODevice::WriteOnly) || saveFile.write(job.data) != job.data.size() || !saveFile.commit()) {
+            qCWarning(LOG_KTE) << "Can't write checkpoint to swap file:" << job.fileName;
+        }
+        m_syncDeadlines[job.fileName] = -1;
+
+        // continue appending behind the new content
+        process(Job{Job::Open, job.fileName, QByteArray(), true, 0}, writtenFiles);
+        break;
+    }
+    case Job::Close:
+    case Job::Remove: {
+        QFile *file = m_files.take(job.fileName);
+        m_syncDeadlines.remove(job.fileName);
+        writtenFiles.removeAll(file);
+        delete file;
+
+        // later jobs might open the file anew, they are processed after this
+        if (job.type == Job::Remove) {
+            QFile::remove(job.fileName);
+        }
+        break;
+    }
+    }
+}
+
+void SwapFileWriter::syncDueFiles()
+{
+    const qint64 now = m_clock.elapsed();
+    for (auto it = m_syncDeadlines.begin(); it != m_syncDeadlines.end(); ++it) {
+        if (it.value() < 0 || it.value() > now) {
+            continue;
+        }
+        it.value() = -1;
+
+#ifndef Q_OS_WIN
+        QElapsedTimer timer;
+        timer.start();
+
+        // ensure that the file is written to disk, if it is still open
+        QFile *file = m_files.value(it.key());
+        if (!file) {
+            continue;
+        }
+        const int handle = file->handle();
+#if HAVE_FDATASYNC
+        fdatasync(handle);
+#else
+        fsync(handle);
+#endif
+
+        const qint64 latency = timer.nsecsElapsed() / 1000;
+        QMutexLocker locker(&m_mutex);
+        ++m_statistics.syncCount;
+        m_statistics.lastSyncLatency = latency;
+        m_statistics.maximalSyncLatency = qMax(m_statistics.maximalSyncLatency, latency);
+#endif
+    }
+}
+
+qint64 SwapFileWriter::nextSyncDeadline() const
+{
+    qint64 next = -1;
+    for (const qint64 deadline : m_syncDeadlines) {
+        if (deadline >= 0 && (next < 0 || deadline < next)) {
+            next = deadline;
+        }
+    }
+    return next;
+}
+
+}
@@ -0,0 +1,149 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_SWAPFILEWRITER_H
+#define KATE_SWAPFILEWRITER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+class QFile;
+
+namespace Kate
+{
+/**
+ * Writer thread shared by the swap files of all documents.
+ *
+ * A swap file serializes the records of an editing transaction into memory and
+ * hands them over here once the transaction is finished. Each round, the writer
+ * takes everything queued since the last round, writes it with one flush per file
+ * and syncs each file at most once per sync interval (group commit). Neither
+ * writing, fdatasync() nor closing a swap file blocks the GUI thread.
+ */
+class SwapFileWriter : public QThread
+{
+public:
+    /**
+     * Counters for monitoring the writer, latencies are in microseconds.
+     */
+    struct Statistics {
+        quint64 syncCount = 0;
+        qint64 lastSyncLatency = 0;
+        qint64 maximalSyncLatency = 0;
+        int queueDepth = 0;
+        int maximalQueueDepth = 0;
+    };
+
+    /**
+     * Construct the writer and start its thread.
+     */
+    SwapFileWriter();
+
+    /**
+     * Write all pending records, close all files and stop the thread.
+     */
+    ~SwapFileWriter() override;
+
+    /**
+     * Open a swap file for writing.
+     * @param fileName swap file
+     * @param append append to the existing file instead of truncating it
+     */
+    void open(const QString &fileName, bool append);
+
+    /**
+     * Queue records for a swap file opened before.
+     * @param fileName swap file
+     * @param data serialized records
+     * @param syncInterval seconds until the data must be synced to disk, 0 to never sync
+     */
+    void append(const QString &fileName, const QByteArray &data, int syncInterval);
+
+    /**
+     * Replace the content of a swap file opened before, e.g. by a checkpoint.
+     * The new content is written to a temporary file first and then renamed over
+     * the old one, so a crash leaves either the old or the new swap file behind.
+     * @param fileName swap file
+     * @param data complete new content
+     */
+    void replace(const QString &fileName, const QByteArray &data);
+
+    /**
+     * Close a swap file once the records queued before are written, without waiting for it.
+     * The file is not synced anymore.
+     * @param fileName swap file
+     * @param remove remove the file after closing it
+     */
+    void close(const QString &fileName, bool remove);
+
+    /**
+     * @return current counters
+     */
+    Statistics statistics() const;
+
+protected:
+    void run() override;
+
+private:
+    struct Job {
+        enum Type { Open, Append, Replace, Close, Remove } type;
+        QString fileName;
+        QByteArray data;
+        bool append;
+        int syncInterval;
+    };
+
+    /**
+     * Queue a job and wake the writer.
+     */
+    void enqueue(const Job &job);
+
+    // these run on the writer thread only
+    void process(const Job &job, QList<QFile *> &writtenFiles);
+    void syncDueFiles();
+    qint64 nextSyncDeadline() const;
+
+private:
+    /**
+     * protects everything up to m_statistics
+     */
+    mutable QMutex m_mutex;
+    QWaitCondition m_jobsQueued;
+    QList<Job> m_jobs;
+    bool m_quit = false;
+    Statistics m_statistics;
+
+    /**
+     * open swap files with the time their data must be synced at, -1 if synced
+     */
+    QHash<QString, QFile *> m_files;
+    QHash<QString, qint64> m_syncDeadlines;
+    QElapsedTimer m_clock;
+};
+
+}
+
+#endif // KATE_SWAPFILEWRITER_H
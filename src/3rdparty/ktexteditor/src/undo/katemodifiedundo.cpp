@@ -21,438 +21,247 @@
 #include "katemodifiedundo.h"
 
 #include "katedocument.h"
-#include "kateundomanager.h"
 
-#include <ktexteditor/cursor.h>
-#include <ktexteditor/view.h>
-
-KateModifiedInsertText::KateModifiedInsertText(KTextEditor::DocumentPrivate *document, int line, int col, const QString &text)
-    : KateEditInsertTextUndo(document, line, col, text)
+namespace
 {
-    setFlag(RedoLine1Modified);
-    Kate::TextLine tl = document->plainKateTextLine(line);
-    Q_ASSERT(tl);
-    if (tl->markedAsModified()) {
-        setFlag(UndoLine1Modified);
-    } else {
-        setFlag(UndoLine1Saved);
-    }
-}
-
-KateModifiedRemoveText::KateModifiedRemoveText(KTextEditor::DocumentPrivate *document, int line, int col, const QString &text)
-    : KateEditRemoveTextUndo(document, line, col, text)
+/**
+ * Set the modified and saved state of @p line from the given flags of @p item.
+ */
+void markLine(KTextEditor::DocumentPrivate *document, int line, const KateUndo &item, KateUndo::ModificationFlag modified, KateUndo::ModificationFlag saved)
 {
-    setFlag(RedoLine1Modified);
     Kate::TextLine tl = document->plainKateTextLine(line);
     Q_ASSERT(tl);
-    if (tl->markedAsModified()) {
-        setFlag(UndoLine1Modified);
-    } else {
-        setFlag(UndoLine1Saved);
-    }
+    tl->markAsModified(item.isFlagSet(modified));
+    tl->markAsSavedOnDisk(item.isFlagSet(saved));
 }
 
-KateModifiedWrapLine::KateModifiedWrapLine(KTextEditor::DocumentPrivate *document, int line, int col, int len, bool newLine)
-    : KateEditWrapLineUndo(document, line, col, len, newLine)
+/**
+ * Turn the @p modified flag of @p item into @p saved, if no later item already claimed @p line.
+ */
+void markSaved(KateUndo &item, QBitArray &lines, int line, KateUndo::ModificationFlag modified, KateUndo::ModificationFlag saved, bool onlyIfModified)
 {
-    Kate::TextLine tl = document->plainKateTextLine(line);
-    Q_ASSERT(tl);
-    if (len > 0 || tl->markedAsModified()) {
-        setFlag(RedoLine1Modified);
-    } else if (tl->markedAsSavedOnDisk()) {
-        setFlag(RedoLine1Saved);
+    if (line >= lines.size()) {
+        lines.resize(line + 1);
     }
 
-    if (col > 0 || len == 0 || tl->markedAsModified()) {
-        setFlag(RedoLine2Modified);
-    } else if (tl->markedAsSavedOnDisk()) {
-        setFlag(RedoLine2Saved);
-    }
+    if ((!onlyIfModified || item.isFlagSet(modified)) && !lines.testBit(line)) {
+        lines.setBit(line);
 
-    if (tl->markedAsModified()) {
-        setFlag(UndoLine1Modified);
-    } else if ((len > 0 && col > 0) || tl->markedAsSavedOnDisk()) {
-        setFlag(UndoLine1Saved);
+        item.unsetFlag(modified);
+        item.setFlag(saved);
     }
 }
+}
 
-KateModifiedUnWrapLine::KateModifiedUnWrapLine(KTextEditor::DocumentPrivate *document, int line, int col, int len, bool removeLine)
-    : KateEditUnWrapLineUndo(document, line, col, len, removeLine)
+void KateModifiedUndo::initFlags(KateUndo &item, KTextEditor::DocumentPrivate *document)
 {
-    Kate::TextLine tl = document->plainKateTextLine(line);
-    Kate::TextLine nextLine = document->plainKateTextLine(line + 1);
-    Q_ASSERT(tl);
-    Q_ASSERT(nextLine);
-
-    const int len1 = tl->length();
-    const int len2 = nextLine->length();
-
-    if (len1 > 0 && len2 > 0) {
-        setFlag(RedoLine1Modified);
-
-        if (tl->markedAsModified()) {
-            setFlag(UndoLine1Modified);
-        } else {
-            setFlag(UndoLine1Saved);
-        }
-
-        if (nextLine->markedAsModified()) {
-            setFlag(UndoLine2Modified);
-        } else {
-            setFlag(UndoLine2Saved);
-        }
-    } else if (len1 == 0) {
-        if (nextLine->markedAsModified()) {
-            setFlag(RedoLine1Modified);
-        } else if (nextLine->markedAsSavedOnDisk()) {
-            setFlag(RedoLine1Saved);
-        }
-
+    switch (item.type) {
+    case KateUndo::editInsertText:
+    case KateUndo::editRemoveText: {
+        item.setFlag(KateUndo::RedoLine1Modified);
+        Kate::TextLine tl = document->plainKateTextLine(item.line);
+        Q_ASSERT(tl);
         if (tl->markedAsModified()) {
-            setFlag(UndoLine1Modified);
+            item.setFlag(KateUndo::UndoLine1Modified);
         } else {
-            setFlag(UndoLine1Saved);
+            item.setFlag(KateUndo::UndoLine1Saved);
         }
+        break;
+    }
 
-        if (nextLine->markedAsModified()) {
-            setFlag(UndoLine2Modified);
-        } else if (nextLine->markedAsSavedOnDisk()) {
-            setFlag(UndoLine2Saved);
-        }
-    } else { // len2 == 0
-        if (nextLine->markedAsModified()) {
-            setFlag(RedoLine1Modified);
-        } else if (nextLine->markedAsSavedOnDisk()) {
-            setFlag(RedoLine1Saved);
+    case KateUndo::editWrapLine: {
+        const int col = item.col;
+        const int len = item.len;
+        Kate::TextLine tl = document->plainKateTextLine(item.line);
+        Q_ASSERT(tl);
+        if (len > 0 || tl->markedAsModified()) {
+            item.setFlag(KateUndo::RedoLine1Modified);
+        } else if (tl->markedAsSavedOnDisk()) {
+            item.setFlag(KateUndo::RedoLine1Saved);
         }
 
-        if (tl->markedAsModified()) {
-            setFlag(UndoLine1Modified);
+        if (col > 0 || len == 0 || tl->markedAsModified()) {
+            item.setFlag(KateUndo::RedoLine2Modified);
         } else if (tl->markedAsSavedOnDisk()) {
-            setFlag(UndoLine1Saved);
+            item.setFlag(KateUndo::RedoLine2Saved);
         }
 
-        if (nextLine->markedAsModified()) {
-            setFlag(UndoLine2Modified);
-        } else {
-            setFlag(UndoLine2Saved);
+        if (tl->markedAsModified()) {
+            item.setFlag(KateUndo::UndoLine1Modified);
+        } else if ((len > 0 && col > 0) || tl->markedAsSavedOnDisk()) {
+            item.setFlag(KateUndo::UndoLine1Saved);
         }
+        break;
     }
-}
-
-KateModifiedInsertLine::KateModifiedInsertLine(KTextEditor::DocumentPrivate *document, int line, const QString &text)
-    : KateEditInsertLineUndo(document, line, text)
-{
-    setFlag(RedoLine1Modified);
-}
-
-KateModifiedRemoveLine::KateModifiedRemoveLine(KTextEditor::DocumentPrivate *document, int line, const QString &text)
-    : KateEditRemoveLineUndo(document, line, text)
-{
-    Kate::TextLine tl = document->plainKateTextLine(line);
-    Q_ASSERT(tl);
-    if (tl->markedAsModified()) {
-        setFlag(UndoLine1Modified);
-    } else {
-        setFlag(UndoLine1Saved);
-    }
-}
-
-void KateModifiedInsertText::undo()
-{
-    KateEditInsertTextUndo::undo();
 
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(UndoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(UndoLine1Saved));
-}
-
-void KateModifiedRemoveText::undo()
-{
-    KateEditRemoveTextUndo::undo();
-
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(UndoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(UndoLine1Saved));
-}
-
-void KateModifiedWrapLine::undo()
-{
-    KateEditWrapLineUndo::undo();
-
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(UndoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(UndoLine1Saved));
-}
-
-void KateModifiedUnWrapLine::undo()
-{
-    KateEditUnWrapLineUndo::undo();
-
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(UndoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(UndoLine1Saved));
-
-    Kate::TextLine nextLine = doc->plainKateTextLine(line() + 1);
-    Q_ASSERT(nextLine);
-    nextLine->markAsModified(isFlagSet(UndoLine2Modified));
-    nextLine->markAsSavedOnDisk(isFlagSet(UndoLine2Saved));
-}
-
-void KateModifiedInsertLine::undo()
-{
-    KateEditInsertLineUndo::undo();
-
-    // no line modification needed, since the line is removed
-}
-
-void KateModifiedRemoveLine::undo()
-{
-    KateEditRemoveLineUndo::undo();
-
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(UndoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(UndoLine1Saved));
-}
-
-void KateModifiedRemoveText::redo()
-{
-    KateEditRemoveTextUndo::redo();
-
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(RedoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(RedoLine1Saved));
-}
-
-void KateModifiedInsertText::redo()
-{
-    KateEditInsertTextUndo::redo();
-
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(RedoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(RedoLine1Saved));
-}
-
-void KateModifiedUnWrapLine::redo()
-{
-    KateEditUnWrapLineUndo::redo();
-
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(RedoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(RedoLine1Saved));
-}
-
-void KateModifiedWrapLine::redo()
-{
-    KateEditWrapLineUndo::redo();
-
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(RedoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(RedoLine1Saved));
-
-    Kate::TextLine nextLine = doc->plainKateTextLine(line() + 1);
-    Q_ASSERT(nextLine);
-
-    nextLine->markAsModified(isFlagSet(RedoLine2Modified));
-    nextLine->markAsSavedOnDisk(isFlagSet(RedoLine2Saved));
-}
-
-void KateModifiedRemoveLine::redo()
-{
-    KateEditRemoveLineUndo::redo();
-
-    // no line modification needed, since the line is removed
-}
-
-void KateModifiedInsertLine::redo()
-{
-    KateEditInsertLineUndo::redo();
-
-    KTextEditor::DocumentPrivate *doc = document();
-    Kate::TextLine tl = doc->plainKateTextLine(line());
-    Q_ASSERT(tl);
-
-    tl->markAsModified(isFlagSet(RedoLine1Modified));
-    tl->markAsSavedOnDisk(isFlagSet(RedoLine1Saved));
-}
-
-void KateModifiedInsertText::updateRedoSavedOnDiskFlag(QBitArray &lines)
-{
-    if (line() >= lines.size()) {
-        lines.resize(line() + 1);
-    }
-
-    if (!lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(RedoLine1Modified);
-        setFlag(RedoLine1Saved);
-    }
-}
-
-void KateModifiedInsertText::updateUndoSavedOnDiskFlag(QBitArray &lines)
-{
-    if (line() >= lines.size()) {
-        lines.resize(line() + 1);
-    }
-
-    if (!lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(UndoLine1Modified);
-        setFlag(UndoLine1Saved);
-    }
-}
-
-void KateModifiedRemoveText::updateRedoSavedOnDiskFlag(QBitArray &lines)
-{
-    if (line() >= lines.size()) {
-        lines.resize(line() + 1);
-    }
-
-    if (!lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(RedoLine1Modified);
-        setFlag(RedoLine1Saved);
-    }
-}
-
-void KateModifiedRemoveText::updateUndoSavedOnDiskFlag(QBitArray &lines)
-{
-    if (line() >= lines.size()) {
-        lines.resize(line() + 1);
-    }
-
-    if (!lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(UndoLine1Modified);
-        setFlag(UndoLine1Saved);
-    }
-}
-
-void KateModifiedWrapLine::updateRedoSavedOnDiskFlag(QBitArray &lines)
-{
-    if (line() + 1 >= lines.size()) {
-        lines.resize(line() + 2);
-    }
-
-    if (isFlagSet(RedoLine1Modified) && !lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(RedoLine1Modified);
-        setFlag(RedoLine1Saved);
+    case KateUndo::editUnWrapLine: {
+        Kate::TextLine tl = document->plainKateTextLine(item.line);
+        Kate::TextLine nextLine = document->plainKateTextLine(item.line + 1);
+        Q_ASSERT(tl);
+        Q_ASSERT(nextLine);
+
+        const int len1 = tl->length();
+        const int len2 = nextLine->length();
+
+        if (len1 > 0 && len2 > 0) {
+            item.setFlag(KateUndo::RedoLine1Modified);
+
+            if (tl->markedAsModified()) {
+                item.setFlag(KateUndo::UndoLine1Modified);
+            } else {
+                item.setFlag(KateUndo::UndoLine1Saved);
+            }
+
+            if (nextLine->markedAsModified()) {
+                item.setFlag(KateUndo::UndoLine2Modified);
+            } else {
+                item.setFlag(KateUndo::UndoLine2Saved);
+            }
+        } else if (len1 == 0) {
+            if (nextLine->markedAsModified()) {
+                item.setFlag(KateUndo::RedoLine1Modified);
+            } else if (nextLine->markedAsSavedOnDisk()) {
+                item.setFlag(KateUndo::RedoLine1Saved);
+            }
+
+            if (tl->markedAsModified()) {
+                item.setFlag(KateUndo::UndoLine1Modified);
+            } else {
+                item.setFlag(KateUndo::UndoLine1Saved);
+            }
+
+            if (nextLine->markedAsModified()) {
+                item.setFlag(KateUndo::UndoLine2Modified);
+            } else if (nextLine->markedAsSavedOnDisk()) {
+                item.setFlag(KateUndo::UndoLine2Saved);
+            }
+        } else { // len2 == 0
+            if (nextLine->markedAsModified()) {
+                item.setFlag(KateUndo::RedoLine1Modified);
+            } else if (nextLine->markedAsSavedOnDisk()) {
+                item.setFlag(KateUndo::RedoLine1Saved);
+            }
+
+            if (tl->markedAsModified()) {
+                item.setFlag(KateUndo::UndoLine1Modified);
+            } else if (tl->markedAsSavedOnDisk()) {
+                item.setFlag(KateUndo::UndoLine1Saved);
+            }
+
+            if (nextLine->markedAsModified()) {
+                item.setFlag(KateUndo::UndoLine2Modified);
+            } else {
+                item.setFlag(KateUndo::UndoLine2Saved);
+            }
+        }
+        break;
     }
 
-    if (isFlagSet(RedoLine2Modified) && !lines.testBit(line() + 1)) {
-        lines.setBit(line() + 1);
-
-        unsetFlag(RedoLine2Modified);
-        setFlag(RedoLine2Saved);
-    }
-}
+    case KateUndo::editInsertLine:
+        item.setFlag(KateUndo::RedoLine1Modified);
+        break;
 
-void KateModifiedWrapLine::updateUndoSavedOnDiskFlag(QBitArray &lines)
-{
-    if (line() >= lines.size()) {
-        lines.resize(line() + 1);
+    case KateUndo::editRemoveLine: {
+        Kate::TextLine tl = document->plainKateTextLine(item.line);
+        Q_ASSERT(tl);
+        if (tl->markedAsModified()) {
+            item.setFlag(KateUndo::UndoLine1Modified);
+        } else {
+            item.setFlag(KateUndo::UndoLine1Saved);
+        }
+        break;
     }
 
-    if (isFlagSet(UndoLine1Modified) && !lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(UndoLine1Modified);
-        setFlag(UndoLine1Saved);
+    default:
+        // marking lines as auto-wrapped doesn't modify them
+        break;
     }
 }
 
-void KateModifiedUnWrapLine::updateRedoSavedOnDiskFlag(QBitArray &lines)
+void KateModifiedUndo::undone(const KateUndo &item, KTextEditor::DocumentPrivate *document)
 {
-    if (line() >= lines.size()) {
-        lines.resize(line() + 1);
-    }
-
-    if (isFlagSet(RedoLine1Modified) && !lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(RedoLine1Modified);
-        setFlag(RedoLine1Saved);
+    switch (item.type) {
+    case KateUndo::editInsertText:
+    case KateUndo::editRemoveText:
+    case KateUndo::editWrapLine:
+    case KateUndo::editRemoveLine:
+        markLine(document, item.line, item, KateUndo::UndoLine1Modified, KateUndo::UndoLine1Saved);
+        break;
+
+    case KateUndo::editUnWrapLine:
+        markLine(document, item.line, item, KateUndo::UndoLine1Modified, KateUndo::UndoLine1Saved);
+        markLine(document, item.line + 1, item, KateUndo::UndoLine2Modified, KateUndo::UndoLine2Saved);
+        break;
+
+    default:
+        // no line modification needed, inserted lines are removed again
+        break;
     }
 }
 
-void KateModifiedUnWrapLine::updateUndoSavedOnDiskFlag(QBitArray &lines)
+void KateModifiedUndo::redone(const KateUndo &item, KTextEditor::DocumentPrivate *document)
 {
-    if (line() + 1 >= lines.size()) {
-        lines.resize(line() + 2);
-    }
-
-    if (isFlagSet(UndoLine1Modified) && !lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(UndoLine1Modified);
-        setFlag(UndoLine1Saved);
-    }
-
-    if (isFlagSet(UndoLine2Modified) && !lines.testBit(line() + 1)) {
-        lines.setBit(line() + 1);
-
-        unsetFlag(UndoLine2Modified);
-        setFlag(UndoLine2Saved);
+    switch (item.type) {
+    case KateUndo::editInsertText:
+    case KateUndo::editRemoveText:
+    case KateUndo::editUnWrapLine:
+    case KateUndo::editInsertLine:
+        markLine(document, item.line, item, KateUndo::RedoLine1Modified, KateUndo::RedoLine1Saved);
+        break;
+
+    case KateUndo::editWrapLine:
+        markLine(document, item.line, item, KateUndo::RedoLine1Modified, KateUndo::RedoLine1Saved);
+        markLine(document, item.line + 1, item, KateUndo::RedoLine2Modified, KateUndo::RedoLine2Saved);
+        break;
+
+    default:
+        // no line modification needed, removed lines are removed again
+        break;
     }
 }
 
-void KateModifiedInsertLine::updateRedoSavedOnDiskFlag(QBitArray &lines)
+void KateModifiedUndo::updateRedoSavedOnDiskFlag(KateUndo &item, QBitArray &lines)
 {
-    if (line() >= lines.size()) {
-        lines.resize(line() + 1);
-    }
-
-    if (!lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(RedoLine1Modified);
-        setFlag(RedoLine1Saved);
+    switch (item.type) {
+    case KateUndo::editInsertText:
+    case KateUndo::editRemoveText:
+    case KateUndo::editInsertLine:
+        markSaved(item, lines, item.line, KateUndo::RedoLine1Modified, KateUndo::RedoLine1Saved, false);
+        break;
+
+    case KateUndo::editWrapLine:
+        markSaved(item, lines, item.line, KateUndo::RedoLine1Modified, KateUndo::RedoLine1Saved, true);
+        markSaved(item, lines, item.line + 1, KateUndo::RedoLine2Modified, KateUndo::RedoLine2Saved, true);
+        break;
+
+    case KateUndo::editUnWrapLine:
+        markSaved(item, lines, item.line, KateUndo::RedoLine1Modified, KateUndo::RedoLine1Saved, true);
+        break;
+
+    default:
+        break;
     }
 }
 
-void KateModifiedRemoveLine::updateUndoSavedOnDiskFlag(QBitArray &lines)
+void KateModifiedUndo::updateUndoSavedOnDiskFlag(KateUndo &item, QBitArray &lines)
 {
-    if (line() >= lines.size()) {
-        lines.resize(line() + 1);
-    }
-
-    if (!lines.testBit(line())) {
-        lines.setBit(line());
-
-        unsetFlag(UndoLine1Modified);
-        setFlag(UndoLine1Saved);
+    switch (item.type) {
+    case KateUndo::editInsertText:
+    case KateUndo::editRemoveText:
+    case KateUndo::editRemoveLine:
+        markSaved(item, lines, item.line, KateUndo::UndoLine1Modified, KateUndo::UndoLine1Saved, false);
+        break;
+
+    case KateUndo::editWrapLine:
+        markSaved(item, lines, item.line, KateUndo::UndoLine1Modified, KateUndo::UndoLine1Saved, true);
+        break;
+
+    case KateUndo::editUnWrapLine:
+        markSaved(item, lines, item.line, KateUndo::UndoLine1Modified, KateUndo::UndoLine1Saved, true);
+        markSaved(item, lines, item.line + 1, KateUndo::UndoLine2Modified, KateUndo::UndoLine2Saved, true);
+        break;
+
+    default:
+        break;
     }
 }
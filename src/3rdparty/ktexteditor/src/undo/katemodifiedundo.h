@@ -23,116 +23,32 @@
 
 #include "kateundo.h"
 
-class KateModifiedInsertText : public KateEditInsertTextUndo
+/**
+ * The line modification system of the undo items.
+ *
+ * Each item remembers, whether the lines it touches were modified or saved on disk
+ * before (Undo flags) and after (Redo flags) the edit, and restores these states
+ * when it is undone or redone.
+ */
+namespace KateModifiedUndo
 {
-public:
-    KateModifiedInsertText(KTextEditor::DocumentPrivate *document, int line, int col, const QString &text);
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    void updateUndoSavedOnDiskFlag(QBitArray &lines) override;
-    void updateRedoSavedOnDiskFlag(QBitArray &lines) override;
-};
-
-class KateModifiedRemoveText : public KateEditRemoveTextUndo
-{
-public:
-    KateModifiedRemoveText(KTextEditor::DocumentPrivate *document, int line, int col, const QString &text);
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    void updateUndoSavedOnDiskFlag(QBitArray &lines) override;
-    void updateRedoSavedOnDiskFlag(QBitArray &lines) override;
-};
-
-class KateModifiedWrapLine : public KateEditWrapLineUndo
-{
-public:
-    KateModifiedWrapLine(KTextEditor::DocumentPrivate *document, int line, int col, int len, bool newLine);
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    void updateUndoSavedOnDiskFlag(QBitArray &lines) override;
-    void updateRedoSavedOnDiskFlag(QBitArray &lines) override;
-};
-
-class KateModifiedUnWrapLine : public KateEditUnWrapLineUndo
-{
-public:
-    KateModifiedUnWrapLine(KTextEditor::DocumentPrivate *document, int line, int col, int len, bool removeLine);
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    void updateUndoSavedOnDiskFlag(QBitArray &lines) override;
-    void updateRedoSavedOnDiskFlag(QBitArray &lines) override;
-};
-
-class KateModifiedInsertLine : public KateEditInsertLineUndo
-{
-public:
-    KateModifiedInsertLine(KTextEditor::DocumentPrivate *document, int line, const QString &text);
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    void updateRedoSavedOnDiskFlag(QBitArray &lines) override;
-};
-
-class KateModifiedRemoveLine : public KateEditRemoveLineUndo
-{
-public:
-    KateModifiedRemoveLine(KTextEditor::DocumentPrivate *document, int line, const QString &text);
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    void updateUndoSavedOnDiskFlag(QBitArray &lines) override;
-};
+/**
+ * Initialize the line modification flags of @p item from the lines of @p document.
+ */
+void initFlags(KateUndo &item, KTextEditor::DocumentPrivate *document);
+
+/**
+ * Restore the line states of @p item after it was undone.
+ */
+void undone(const KateUndo &item, KTextEditor::DocumentPrivate *document);
+
+/**
+ * Restore the line states of @p item after it was redone.
+ */
+void redone(const KateUndo &item, KTextEditor::DocumentPrivate *document);
+
+void updateUndoSavedOnDiskFlag(KateUndo &item, QBitArray &lines);
+void updateRedoSavedOnDiskFlag(KateUndo &item, QBitArray &lines);
+}
 
 #endif // KATE_MODIFIED_UNDO_H
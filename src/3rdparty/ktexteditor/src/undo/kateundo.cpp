@@ -25,211 +25,24 @@
 #include "kateundo.h"
 
 #include "katedocument.h"
+#include "katemodifiedundo.h"
 #include "kateundomanager.h"
 
 #include <ktexteditor/cursor.h>
 #include <ktexteditor/view.h>
 
-KateUndo::KateUndo(KTextEditor::DocumentPrivate *document)
-    : m_document(document)
-{
-}
-
-KateUndo::~KateUndo()
-{
-}
-
-KateEditInsertTextUndo::KateEditInsertTextUndo(KTextEditor::DocumentPrivate *document, int line, int col, const QString &text)
-    : KateUndo(document)
-    , m_line(line)
-    , m_col(col)
-    , m_text(text)
-{
-}
-
-KateEditRemoveTextUndo::KateEditRemoveTextUndo(KTextEditor::DocumentPrivate *document, int line, int col, const QString &text)
-    : KateUndo(document)
-    , m_line(line)
-    , m_col(col)
-    , m_text(text)
-{
-}
-
-KateEditWrapLineUndo::KateEditWrapLineUndo(KTextEditor::DocumentPrivate *document, int line, int col, int len, bool newLine)
-    : KateUndo(document)
-    , m_line(line)
-    , m_col(col)
-    , m_len(len)
-    , m_newLine(newLine)
-{
-}
-
-KateEditUnWrapLineUndo::KateEditUnWrapLineUndo(KTextEditor::DocumentPrivate *document, int line, int col, int len, bool removeLine)
-    : KateUndo(document)
-    , m_line(line)
-    , m_col(col)
-    , m_len(len)
-    , m_removeLine(removeLine)
-{
-}
-
-KateEditInsertLineUndo::KateEditInsertLineUndo(KTextEditor::DocumentPrivate *document, int line, const QString &text)
-    : KateUndo(document)
-    , m_line(line)
-    , m_text(text)
-{
-}
-
-KateEditRemoveLineUndo::KateEditRemoveLineUndo(KTextEditor::DocumentPrivate *document, int line, const QString &text)
-    : KateUndo(document)
-    , m_line(line)
-    , m_text(text)
-{
-}
-
-bool KateUndo::isEmpty() const
-{
-    return false;
-}
-
-bool KateEditInsertTextUndo::isEmpty() const
-{
-    return len() == 0;
-}
-
-bool KateEditRemoveTextUndo::isEmpty() const
-{
-    return len() == 0;
-}
-
-bool KateUndo::mergeWith(const KateUndo * /*undo*/)
-{
-    return false;
-}
-
-bool KateEditInsertTextUndo::mergeWith(const KateUndo *undo)
-{
-    // we can do a hard cast, we ensure we are only called with the same types on the outside
-    Q_ASSERT(type() == undo->type());
-    const KateEditInsertTextUndo *u = static_cast<const KateEditInsertTextUndo *>(undo);
-    if (m_line == u->m_line && (m_col + len()) == u->m_col) {
-        m_text += u->m_text;
-        return true;
-    }
-
-    return false;
-}
-
-bool KateEditRemoveTextUndo::mergeWith(const KateUndo *undo)
-{
-    // we can do a hard cast, we ensure we are only called with the same types on the outside
-    Q_ASSERT(type() == undo->type());
-    const KateEditRemoveTextUndo *u = static_cast<const KateEditRemoveTextUndo *>(undo);
-    if (m_line == u->m_line && m_col == (u->m_col + u->len())) {
-        m_text.prepend(u->m_text);
-        m_col = u->m_col;
-        return true;
-    }
-
-    return false;
-}
-
-void KateEditInsertTextUndo::undo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editRemoveText(m_line, m_col, len());
-}
-
-void KateEditRemoveTextUndo::undo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editInsertText(m_line, m_col, m_text);
-}
-
-void KateEditWrapLineUndo::undo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editUnWrapLine(m_line, m_newLine, m_len);
-}
-
-void KateEditUnWrapLineUndo::undo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editWrapLine(m_line, m_col, m_removeLine);
-}
-
-void KateEditInsertLineUndo::undo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editRemoveLine(m_line);
-}
-
-void KateEditRemoveLineUndo::undo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editInsertLine(m_line, m_text);
-}
-
-void KateEditMarkLineAutoWrappedUndo::undo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editMarkLineAutoWrapped(m_line, m_autowrapped);
-}
-
-void KateEditRemoveTextUndo::redo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editRemoveText(m_line, m_col, len());
-}
-
-void KateEditInsertTextUndo::redo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editInsertText(m_line, m_col, m_text);
-}
-
-void KateEditUnWrapLineUndo::redo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
+#include <QDataStream>
 
-    doc->editUnWrapLine(m_line, m_removeLine, m_len);
-}
+#include <algorithm>
 
-void KateEditWrapLineUndo::redo()
+namespace
 {
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editWrapLine(m_line, m_col, m_newLine);
-}
-
-void KateEditRemoveLineUndo::redo()
+QString reversedText(const QString &text)
 {
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editRemoveLine(m_line);
+    QString result(text);
+    std::reverse(result.begin(), result.end());
+    return result;
 }
-
-void KateEditInsertLineUndo::redo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editInsertLine(m_line, m_text);
-}
-
-void KateEditMarkLineAutoWrappedUndo::redo()
-{
-    KTextEditor::DocumentPrivate *doc = document();
-
-    doc->editMarkLineAutoWrapped(m_line, m_autowrapped);
 }
 
 KateUndoGroup::KateUndoGroup(KateUndoManager *manager, const KTextEditor::Cursor &cursorPosition, const KTextEditor::Range &selectionRange)
@@ -241,21 +54,47 @@ KateUndoGroup::KateUndoGroup(KateUndoManager *manager, const KTextEditor::Cursor
 {
 }
 
-KateUndoGroup::~KateUndoGroup()
-{
-    qDeleteAll(m_items);
-}
-
 void KateUndoGroup::undo(KTextEditor::View *view)
 {
+    Q_ASSERT(!isPacked());
+
     if (m_items.isEmpty()) {
         return;
     }
 
     m_manager->startUndo();
 
+    KTextEditor::DocumentPrivate *doc = static_cast<KTextEditor::DocumentPrivate *>(document());
     for (int i = m_items.size() - 1; i >= 0; --i) {
-        m_items[i]->undo();
+        const KateUndo &item = m_items.at(i);
+        switch (item.type) {
+        case KateUndo::editInsertText:
+            doc->editRemoveText(item.line, item.col, item.len);
+            break;
+        case KateUndo::editRemoveText:
+            doc->editInsertText(item.line, item.col, text(item));
+            break;
+        case KateUndo::editWrapLine:
+            doc->editUnWrapLine(item.line, item.option, item.len);
+            break;
+        case KateUndo::editUnWrapLine:
+            doc->editWrapLine(item.line, item.col, item.option);
+            break;
+        case KateUndo::editInsertLine:
+            doc->editRemoveLine(item.line);
+            break;
+        case KateUndo::editRemoveLine:
+            doc->editInsertLine(item.line, text(item));
+            break;
+        case KateUndo::editMarkLineAutoWrapped:
+            doc->editMarkLineAutoWrapped(item.line, item.option);
+            break;
+        default:
+            Q_ASSERT(false);
+            break;
+        }
+
+        KateModifiedUndo::undone(item, doc);
     }
 
     if (view != nullptr) {
@@ -275,14 +114,45 @@ void KateUndoGroup::undo(KTextEditor::View *view)
 
 void KateUndoGroup::redo(KTextEditor::View *view)
 {
+    Q_ASSERT(!isPacked());
+
     if (m_items.isEmpty()) {
         return;
     }
 
     m_manager->startUndo();
 
+    KTextEditor::DocumentPrivate *doc = static_cast<KTextEditor::DocumentPrivate *>(document());
     for (int i = 0; i < m_items.size(); ++i) {
-        m_items[i]->redo();
+        const KateUndo &item = m_items.at(i);
+        switch (item.type) {
+        case KateUndo::editInsertText:
+            doc->editInsertText(item.line, item.col, text(item));
+            break;
+        case KateUndo::editRemoveText:
+            doc->editRemoveText(item.line, item.col, item.len);
+            break;
+        case KateUndo::editWrapLine:
+            doc->editWrapLine(item.line, item.col, item.option);
+            break;
+        case KateUndo::editUnWrapLine:
+            doc->editUnWrapLine(item.line, item.option, item.len);
+            break;
+        case KateUndo::editInsertLine:
+            doc->editInsertLine(item.line, text(item));
+            break;
+        case KateUndo::editRemoveLine:
+            doc->editRemoveLine(item.line);
+            break;
+        case KateUndo::editMarkLineAutoWrapped:
+            doc->editMarkLineAutoWrapped(item.line, item.option);
+            break;
+        default:
+            Q_ASSERT(false);
+            break;
+        }
+
+        KateModifiedUndo::redone(item, doc);
     }
 
     if (view != nullptr) {
@@ -306,37 +176,149 @@ void KateUndoGroup::editEnd(const KTextEditor::Cursor &cursorPosition, const KTe
     m_redoSelection = selectionRange;
 }
 
-void KateUndoGroup::addItem(KateUndo *u)
+QString KateUndoGroup::text(const KateUndo &item) const
 {
+    const QString text = m_text.mid(item.textOffset, item.len);
+    return item.reversed ? reversedText(text) : text;
+}
+
+void KateUndoGroup::addItem(KateUndo u, const QString &text)
+{
+    Q_ASSERT(!isPacked());
+
     // kill empty items
-    if (u->isEmpty()) {
-        delete u;
+    if ((u.type == KateUndo::editInsertText || u.type == KateUndo::editRemoveText) && text.isEmpty()) {
         return;
     }
 
-    // try to merge, do that only for equal types, inside mergeWith we do hard casts
-    if (!m_items.isEmpty() && m_items.last()->type() == u->type() && m_items.last()->mergeWith(u)) {
-        delete u;
+    // try to merge, do that only for equal types
+    if (!m_items.isEmpty() && m_items.last().type == u.type && mergeWithLast(u, text)) {
         return;
     }
 
-    // default: just add new item unchanged
+    // default: just add new item unchanged, its text goes to the end of the pool
+    if (u.hasText()) {
+        u.textOffset = m_text.size();
+        u.len = text.size();
+        m_text.append(text);
+    }
     m_items.append(u);
 }
 
+bool KateUndoGroup::mergeWithLast(const KateUndo &u, const QString &text)
+{
+    // the text of the last item is always at the end of the pool
+    KateUndo &last = m_items.last();
+    Q_ASSERT(!last.hasText() || last.textOffset + last.len == m_text.size());
+
+    if (last.line != u.line) {
+        return false;
+    }
+
+    // typing run
+    if (u.type == KateUndo::editInsertText && last.col + last.len == u.col) {
+        m_text.append(text);
+        last.len += text.size();
+        return true;
+    }
+
+    // backspace run, the new text goes in front
+    if (u.type == KateUndo::editRemoveText && last.col == u.col + text.size()) {
+        if (!last.reversed) {
+            std::reverse(m_text.begin() + last.textOffset, m_text.end());
+            last.reversed = true;
+        }
+        m_text.append(reversedText(text));
+        last.col = u.col;
+        last.len += text.size();
+        return true;
+    }
+
+    // delete run, the new text goes behind
+    if (u.type == KateUndo::editRemoveText && last.col == u.col) {
+        if (last.reversed) {
+            m_text.insert(last.textOffset, reversedText(text));
+        } else {
+            m_text.append(text);
+        }
+        last.len += text.size();
+        return true;
+    }
+
+    return false;
+}
+
+void KateUndoGroup::pack()
+{
+    Q_ASSERT(!isPacked() && !m_items.isEmpty());
+
+    // the items are plain records, they can be stored as they are
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << qint32(m_items.size()) << m_text;
+    stream.writeRawData(reinterpret_cast<const char *>(m_items.constData()), m_items.size() * int(sizeof(KateUndo)));
+
+    // old history is rarely needed again, favor speed over size
+    m_packedItems = qCompress(data, 1);
+
+    // saving changes the line modification flags, keep them at hand
+    m_packedLineStates.resize(m_items.size());
+    for (int i = 0; i < m_items.size(); ++i) {
+        const KateUndo &item = m_items.at(i);
+        m_packedLineStates[i] = PackedLineState{item.line, item.type, item.lineModFlags};
+    }
+
+    m_items = QVector<KateUndo>();
+    m_text = QString();
+}
+
+void KateUndoGroup::unpack()
+{
+    if (!isPacked()) {
+        return;
+    }
+
+    const QByteArray data = qUncompress(m_packedItems);
+    m_packedItems.clear();
+
+    QDataStream stream(data);
+    qint32 count = 0;
+    stream >> count >> m_text;
+
+    m_items.resize(count);
+    stream.readRawData(reinterpret_cast<char *>(m_items.data()), count * int(sizeof(KateUndo)));
+
+    Q_ASSERT(m_packedLineStates.size() == count);
+    for (int i = 0; i < count; ++i) {
+        m_items[i].lineModFlags = m_packedLineStates.at(i).lineModFlags;
+    }
+    m_packedLineStates = QVector<PackedLineState>();
+}
+
+qint64 KateUndoGroup::memoryUsage() const
+{
+    if (isPacked()) {
+        return m_packedItems.size() + m_packedLineStates.capacity() * qint64(sizeof(PackedLineState));
+    }
+
+    return m_items.capacity() * qint64(sizeof(KateUndo)) + m_text.capacity() * qint64(sizeof(QChar));
+}
+
 bool KateUndoGroup::merge(KateUndoGroup *newGroup, bool complex)
 {
     if (m_safePoint) {
         return false;
     }
 
-    if (newGroup->isOnlyType(singleType()) || complex) {
+    Q_ASSERT(!isPacked() && !newGroup->isPacked());
+
+    if (newGroup->isOnlyType(singleType()) || complex || (isTyping() && newGroup->isTyping())) {
         // Take all of its items first -> last
-        KateUndo *u = newGroup->m_items.isEmpty() ? nullptr : newGroup->m_items.takeFirst();
-        while (u) {
-            addItem(u);
-            u = newGroup->m_items.isEmpty() ? nullptr : newGroup->m_items.takeFirst();
+        for (const KateUndo &item : qAsConst(newGroup->m_items)) {
+            addItem(item, item.hasText() ? newGroup->text(item) : QString());
         }
+        newGroup->m_items.clear();
+        newGroup->m_text.clear();
 
         if (newGroup->m_safePoint) {
             safePoint();
@@ -356,45 +338,63 @@ void KateUndoGroup::safePoint(bool safePoint)
     m_safePoint = safePoint;
 }
 
+template<typename Function>
+void KateUndoGroup::updateLineStates(Function function)
+{
+    if (!isPacked()) {
+        for (int i = m_items.size() - 1; i >= 0; --i) {
+            function(m_items[i]);
+        }
+        return;
+    }
+
+    // the line modification system only looks at type, line and flags
+    for (int i = m_packedLineStates.size() - 1; i >= 0; --i) {
+        PackedLineState &state = m_packedLineStates[i];
+        KateUndo item(state.type, state.line, 0, 0, false);
+        item.lineModFlags = state.lineModFlags;
+        function(item);
+        state.lineModFlags = item.lineModFlags;
+    }
+}
+
 void KateUndoGroup::flagSavedAsModified()
 {
-    for (KateUndo *item : qAsConst(m_items)) {
-        if (item->isFlagSet(KateUndo::UndoLine1Saved)) {
-            item->unsetFlag(KateUndo::UndoLine1Saved);
-            item->setFlag(KateUndo::UndoLine1Modified);
+    updateLineStates([](KateUndo &item) {
+        if (item.isFlagSet(KateUndo::UndoLine1Saved)) {
+            item.unsetFlag(KateUndo::UndoLine1Saved);
+            item.setFlag(KateUndo::UndoLine1Modified);
         }
 
-        if (item->isFlagSet(KateUndo::UndoLine2Saved)) {
-            item->unsetFlag(KateUndo::UndoLine2Saved);
-            item->setFlag(KateUndo::UndoLine2Modified);
+        if (item.isFlagSet(KateUndo::UndoLine2Saved)) {
+            item.unsetFlag(KateUndo::UndoLine2Saved);
+            item.setFlag(KateUndo::UndoLine2Modified);
         }
 
-        if (item->isFlagSet(KateUndo::RedoLine1Saved)) {
-            item->unsetFlag(KateUndo::RedoLine1Saved);
-            item->setFlag(KateUndo::RedoLine1Modified);
+        if (item.isFlagSet(KateUndo::RedoLine1Saved)) {
+            item.unsetFlag(KateUndo::RedoLine1Saved);
+            item.setFlag(KateUndo::RedoLine1Modified);
         }
 
-        if (item->isFlagSet(KateUndo::RedoLine2Saved)) {
-            item->unsetFlag(KateUndo::RedoLine2Saved);
-            item->setFlag(KateUndo::RedoLine2Modified);
+        if (item.isFlagSet(KateUndo::RedoLine2Saved)) {
+            item.unsetFlag(KateUndo::RedoLine2Saved);
+            item.setFlag(KateUndo::RedoLine2Modified);
         }
-    }
+    });
 }
 
 void KateUndoGroup::markUndoAsSaved(QBitArray &lines)
 {
-    for (int i = m_items.size() - 1; i >= 0; --i) {
-        KateUndo *item = m_items[i];
-        item->updateUndoSavedOnDiskFlag(lines);
-    }
+    updateLineStates([&lines](KateUndo &item) {
+        KateModifiedUndo::updateUndoSavedOnDiskFlag(item, lines);
+    });
 }
 
 void KateUndoGroup::markRedoAsSaved(QBitArray &lines)
 {
-    for (int i = m_items.size() - 1; i >= 0; --i) {
-        KateUndo *item = m_items[i];
-        item->updateRedoSavedOnDiskFlag(lines);
-    }
+    updateLineStates([&lines](KateUndo &item) {
+        KateModifiedUndo::updateRedoSavedOnDiskFlag(item, lines);
+    });
 }
 
 KTextEditor::Document *KateUndoGroup::document()
@@ -406,10 +406,10 @@ KateUndo::UndoType KateUndoGroup::singleType() const
 {
     KateUndo::UndoType ret = KateUndo::editInvalid;
 
-    for (const KateUndo *item : m_items) {
+    for (const KateUndo &item : m_items) {
         if (ret == KateUndo::editInvalid) {
-            ret = item->type();
-        } else if (ret != item->type()) {
+            ret = item.type;
+        } else if (ret != item.type) {
             return KateUndo::editInvalid;
         }
     }
@@ -423,5 +423,13 @@ bool KateUndoGroup::isOnlyType(KateUndo::UndoType type) const
         return false;
     }
 
-    return std::all_of(m_items.begin(), m_items.end(), [type](const KateUndo *item) { return (item->type() == type); });
+    return std::all_of(m_items.begin(), m_items.end(), [type](const KateUndo &item) { return (item.type == type); });
+}
+
+bool KateUndoGroup::isTyping() const
+{
+    // typing a line break and going on shouldn't produce one undo step per line
+    return !m_items.isEmpty() && std::all_of(m_items.begin(), m_items.end(), [](const KateUndo &item) {
+        return item.type == KateUndo::editInsertText || item.type == KateUndo::editWrapLine;
+    });
 }
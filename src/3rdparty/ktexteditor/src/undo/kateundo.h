@@ -25,7 +25,9 @@
 #ifndef kate_undo_h
 #define kate_undo_h
 
-#include <QList>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
 
 #include <QBitArray>
 #include <ktexteditor/range.h>
@@ -42,381 +44,93 @@ class View;
 }
 
 /**
- * Base class for Kate undo commands.
+ * One Kate undo step.
+ *
+ * Undo steps are tagged plain records, stored by value in the array of their
+ * KateUndoGroup. Their text lives in the text pool of the group, thus a step
+ * needs no allocation of its own.
  */
-class KateUndo
-{
-public:
-    /**
-     * Constructor
-     * @param document the document the undo item belongs to
-     */
-    explicit KateUndo(KTextEditor::DocumentPrivate *document);
-
-    /**
-     * Destructor
-     */
-    virtual ~KateUndo();
-
-public:
+struct KateUndo {
     /**
      * Types for undo items
      */
-    enum UndoType { editInsertText, editRemoveText, editWrapLine, editUnWrapLine, editInsertLine, editRemoveLine, editMarkLineAutoWrapped, editInvalid };
-
-public:
-    /**
-     * Check whether the item is empty.
-     *
-     * @return whether the item is empty
-     */
-    virtual bool isEmpty() const;
-
-    /**
-     * merge an undo item
-     * Saves a bit of memory and potentially many calls when undo/redoing.
-     * Only called for equal types of this object and the passed one.
-     * @param undo undo item to merge
-     * @return success
-     */
-    virtual bool mergeWith(const KateUndo *undo);
-
-    /**
-     * undo this item
-     */
-    virtual void undo() = 0;
-
-    /**
-     * redo this item
-     */
-    virtual void redo() = 0;
-
-    /**
-     * type of item
-     * @return type
-     */
-    virtual KateUndo::UndoType type() const = 0;
-
-protected:
-    /**
-     * Return the document the undo item belongs to.
-     * @return the document the undo item belongs to
-     */
-    inline KTextEditor::DocumentPrivate *document()
-    {
-        return m_document;
-    }
-
-private:
-    /**
-     * the document the undo item belongs to
-     */
-    KTextEditor::DocumentPrivate *m_document;
+    enum UndoType : quint8 { editInsertText, editRemoveText, editWrapLine, editUnWrapLine, editInsertLine, editRemoveLine, editMarkLineAutoWrapped, editInvalid };
 
     //
     // Line modification system
     //
-public:
     enum ModificationFlag { UndoLine1Modified = 1, UndoLine2Modified = 2, UndoLine1Saved = 4, UndoLine2Saved = 8, RedoLine1Modified = 16, RedoLine2Modified = 32, RedoLine1Saved = 64, RedoLine2Saved = 128 };
 
-    inline void setFlag(ModificationFlag flag)
-    {
-        m_lineModFlags |= flag;
-    }
-
-    inline void unsetFlag(ModificationFlag flag)
-    {
-        m_lineModFlags &= (~flag);
-    }
-
-    inline bool isFlagSet(ModificationFlag flag) const
-    {
-        return m_lineModFlags & flag;
-    }
-
-    virtual void updateUndoSavedOnDiskFlag(QBitArray &lines)
-    {
-        Q_UNUSED(lines)
-    }
-    virtual void updateRedoSavedOnDiskFlag(QBitArray &lines)
-    {
-        Q_UNUSED(lines)
-    }
-
-private:
-    uchar m_lineModFlags = 0x0;
-};
-
-class KateEditInsertTextUndo : public KateUndo
-{
-public:
-    explicit KateEditInsertTextUndo(KTextEditor::DocumentPrivate *document, int line, int col, const QString &text);
-
-    /**
-     * @copydoc KateUndo::isEmpty()
-     */
-    bool isEmpty() const override;
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    /**
-     * @copydoc KateUndo::mergeWith(const KateUndo)
-     */
-    bool mergeWith(const KateUndo *undo) override;
-
-    /**
-     * @copydoc KateUndo::type()
-     */
-    KateUndo::UndoType type() const override
-    {
-        return KateUndo::editInsertText;
-    }
-
-protected:
-    inline int len() const
-    {
-        return m_text.length();
-    }
-    inline int line() const
-    {
-        return m_line;
-    }
-
-private:
-    const int m_line;
-    const int m_col;
-    QString m_text;
-};
-
-class KateEditRemoveTextUndo : public KateUndo
-{
-public:
-    explicit KateEditRemoveTextUndo(KTextEditor::DocumentPrivate *document, int line, int col, const QString &text);
-
-    /**
-     * @copydoc KateUndo::isEmpty()
-     */
-    bool isEmpty() const override;
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    /**
-     * @copydoc KateUndo::mergeWith(const KateUndo)
-     */
-    bool mergeWith(const KateUndo *undo) override;
+    KateUndo() = default;
 
     /**
-     * @copydoc KateUndo::type()
-     */
-    KateUndo::UndoType type() const override
+     * Constructor
+     * @param itemType type of the step
+     * @param itemLine line of the step
+     * @param itemCol column of the step, unused for whole lines
+     * @param itemLen length of the text of the step or of the moved text
+     * @param itemOption newLine for wraps, removeLine for unwraps, autowrapped for markings
+     */
+    KateUndo(UndoType itemType, int itemLine, int itemCol, int itemLen, bool itemOption)
+        : type(itemType)
+        , option(itemOption)
+        , line(itemLine)
+        , col(itemCol)
+        , len(itemLen)
     {
-        return KateUndo::editRemoveText;
     }
 
-protected:
-    inline int len() const
-    {
-        return m_text.length();
-    }
-    inline int line() const
+    inline void setFlag(ModificationFlag flag)
     {
-        return m_line;
+        lineModFlags |= flag;
     }
 
-private:
-    const int m_line;
-    int m_col;
-    QString m_text;
-};
-
-class KateEditMarkLineAutoWrappedUndo : public KateUndo
-{
-public:
-    explicit KateEditMarkLineAutoWrappedUndo(KTextEditor::DocumentPrivate *document, int line, bool autowrapped)
-        : KateUndo(document)
-        , m_line(line)
-        , m_autowrapped(autowrapped)
+    inline void unsetFlag(ModificationFlag flag)
     {
+        lineModFlags &= (~flag);
     }
 
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    /**
-     * @copydoc KateUndo::type()
-     */
-    KateUndo::UndoType type() const override
+    inline bool isFlagSet(ModificationFlag flag) const
     {
-        return KateUndo::editMarkLineAutoWrapped;
+        return lineModFlags & flag;
     }
 
-private:
-    const int m_line;
-    const bool m_autowrapped;
-};
-
-class KateEditWrapLineUndo : public KateUndo
-{
-public:
-    explicit KateEditWrapLineUndo(KTextEditor::DocumentPrivate *document, int line, int col, int len, bool newLine);
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
     /**
-     * @copydoc KateUndo::type()
+     * Does the step carry text in the pool of its group?
      */
-    KateUndo::UndoType type() const override
+    inline bool hasText() const
     {
-        return KateUndo::editWrapLine;
+        return type == editInsertText || type == editRemoveText || type == editInsertLine || type == editRemoveLine;
     }
 
-protected:
-    inline int line() const
-    {
-        return m_line;
-    }
-
-private:
-    const int m_line;
-    const int m_col;
-    const int m_len;
-    const bool m_newLine;
-};
-
-class KateEditUnWrapLineUndo : public KateUndo
-{
-public:
-    explicit KateEditUnWrapLineUndo(KTextEditor::DocumentPrivate *document, int line, int col, int len, bool removeLine);
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
+    UndoType type = editInvalid;
+    uchar lineModFlags = 0x0;
 
     /**
-     * @copydoc KateUndo::redo()
+     * newLine for wraps, removeLine for unwraps, autowrapped for markings
      */
-    void redo() override;
+    bool option = false;
 
     /**
-     * @copydoc KateUndo::type()
+     * the text is stored back to front, to extend backspace runs at the end of the pool
      */
-    KateUndo::UndoType type() const override
-    {
-        return KateUndo::editUnWrapLine;
-    }
-
-protected:
-    inline int line() const
-    {
-        return m_line;
-    }
-
-private:
-    const int m_line;
-    const int m_col;
-    const int m_len;
-    const bool m_removeLine;
-};
-
-class KateEditInsertLineUndo : public KateUndo
-{
-public:
-    explicit KateEditInsertLineUndo(KTextEditor::DocumentPrivate *document, int line, const QString &text);
+    bool reversed = false;
 
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
+    int line = 0;
+    int col = 0;
 
     /**
-     * @copydoc KateUndo::redo()
+     * length of the text or, for wraps and unwraps, of the moved text
      */
-    void redo() override;
+    int len = 0;
 
     /**
-     * @copydoc KateUndo::type()
+     * start of the text in the text pool of the group
      */
-    KateUndo::UndoType type() const override
-    {
-        return KateUndo::editInsertLine;
-    }
-
-protected:
-    inline int line() const
-    {
-        return m_line;
-    }
-
-private:
-    const int m_line;
-    const QString m_text;
+    int textOffset = 0;
 };
 
-class KateEditRemoveLineUndo : public KateUndo
-{
-public:
-    explicit KateEditRemoveLineUndo(KTextEditor::DocumentPrivate *document, int line, const QString &text);
-
-    /**
-     * @copydoc KateUndo::undo()
-     */
-    void undo() override;
-
-    /**
-     * @copydoc KateUndo::redo()
-     */
-    void redo() override;
-
-    /**
-     * @copydoc KateUndo::type()
-     */
-    KateUndo::UndoType type() const override
-    {
-        return KateUndo::editRemoveLine;
-    }
-
-protected:
-    inline int line() const
-    {
-        return m_line;
-    }
-
-private:
-    const int m_line;
-    const QString m_text;
-};
+Q_DECLARE_TYPEINFO(KateUndo, Q_MOVABLE_TYPE);
 
 /**
  * Class to manage a group of undo items
@@ -430,11 +144,6 @@ public:
      */
     explicit KateUndoGroup(KateUndoManager *manager, const KTextEditor::Cursor &cursorPosition, const KTextEditor::Range &selectionRange);
 
-    /**
-     * Destructor
-     */
-    ~KateUndoGroup();
-
     KateUndoGroup(const KateUndoGroup &) = delete;
     KateUndoGroup &operator=(const KateUndoGroup &) = delete;
 
@@ -469,9 +178,35 @@ public:
      */
     bool isEmpty() const
     {
-        return m_items.isEmpty();
+        return m_items.isEmpty() && m_packedItems.isEmpty();
+    }
+
+    /**
+     * Are the items of this group packed?
+     * A packed group must be unpacked before undo, redo or merge. Its line modification
+     * flags are kept uncompressed, they are updated without unpacking.
+     */
+    bool isPacked() const
+    {
+        return !m_packedItems.isEmpty();
     }
 
+    /**
+     * Compress all items and their text, freeing them.
+     * Must only be called for non-empty, unpacked groups.
+     */
+    void pack();
+
+    /**
+     * Restore the items of a packed group, does nothing for unpacked groups.
+     */
+    void unpack();
+
+    /**
+     * Approximate number of bytes the items of this group occupy, packed or not.
+     */
+    qint64 memoryUsage() const;
+
     /**
      * Change all LineSaved flags to LineModified of the line modification system.
      */
@@ -517,12 +252,35 @@ private:
      */
     bool isOnlyType(KateUndo::UndoType type) const;
 
+    /**
+     * do we contain only typed text and line breaks?
+     */
+    bool isTyping() const;
+
+    /**
+     * text of the given item
+     */
+    QString text(const KateUndo &item) const;
+
+    /**
+     * try to extend the last item by @p u
+     * @return success
+     */
+    bool mergeWithLast(const KateUndo &u, const QString &text);
+
+    /**
+     * call @p function for the line modification state of all items, from the last to the first
+     */
+    template<typename Function>
+    void updateLineStates(Function function);
+
 public:
     /**
-     * add an undo item
-     * @param u item to add
+     * add an undo item, merging it with the last one where possible
+     * @param u item to add, its text offset is set here
+     * @param text text of the item, if any
      */
-    void addItem(KateUndo *u);
+    void addItem(KateUndo u, const QString &text = QString());
 
 private:
     KateUndoManager *const m_manager;
@@ -530,7 +288,28 @@ private:
     /**
      * list of items contained
      */
-    QList<KateUndo *> m_items;
+    QVector<KateUndo> m_items;
+
+    /**
+     * text of all items, each item references its part
+     */
+    QString m_text;
+
+    /**
+     * compressed items and text, if the group is packed
+     */
+    QByteArray m_packedItems;
+
+    /**
+     * what the line modification system needs of the packed items, in their order,
+     * the flags in m_packedItems are outdated by these
+     */
+    struct PackedLineState {
+        int line;
+        KateUndo::UndoType type;
+        uchar lineModFlags;
+    };
+    QVector<PackedLineState> m_packedLineStates;
 
     /**
      * prohibit merging with the next group
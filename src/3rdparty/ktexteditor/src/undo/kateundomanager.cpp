@@ -22,6 +22,7 @@
 
 #include <ktexteditor/view.h>
 
+#include "kateconfig.h"
 #include "katedocument.h"
 #include "katemodifiedundo.h"
 #include "katepartdebug.h"
@@ -43,10 +44,8 @@ KateUndoManager::~KateUndoManager()
     delete m_editCurrentUndo;
 
     // cleanup the undo/redo items, very important, truee :/
-    qDeleteAll(undoItems);
-    undoItems.clear();
-    qDeleteAll(redoItems);
-    redoItems.clear();
+    deleteGroups(undoItems);
+    deleteGroups(redoItems);
 }
 
 KTextEditor::Document *KateUndoManager::document()
@@ -93,17 +92,27 @@ void KateUndoManager::editEnd()
 
     bool changedUndo = false;
 
+    // items can only be merged into an unpacked group
+    if (!m_editCurrentUndo->isEmpty() && !undoItems.isEmpty()) {
+        unpackGroup(undoItems.last());
+    }
+    const qint64 lastGroupUsage = undoItems.isEmpty() ? 0 : undoItems.last()->memoryUsage();
+
     if (m_editCurrentUndo->isEmpty()) {
         delete m_editCurrentUndo;
     } else if (!undoItems.isEmpty() && undoItems.last()->merge(m_editCurrentUndo, m_undoComplexMerge)) {
+        m_memoryUsage += undoItems.last()->memoryUsage() - lastGroupUsage;
         delete m_editCurrentUndo;
     } else {
+        m_memoryUsage += m_editCurrentUndo->memoryUsage();
         undoItems.append(m_editCurrentUndo);
         changedUndo = true;
     }
 
     m_editCurrentUndo = nullptr;
 
+    limitMemoryUsage();
+
     if (changedUndo) {
         emit undoChanged();
     }
@@ -123,6 +132,18 @@ void KateUndoManager::inputMethodEnd()
     setActive(true);
 }
 
+void KateUndoManager::reloadStart()
+{
+    setActive(false);
+    m_document->editStart();
+}
+
+void KateUndoManager::reloadEnd()
+{
+    m_document->editEnd();
+    setActive(true);
+}
+
 void KateUndoManager::startUndo()
 {
     setActive(false);
@@ -138,49 +159,49 @@ void KateUndoManager::endUndo()
 void KateUndoManager::slotTextInserted(int line, int col, const QString &s)
 {
     if (m_editCurrentUndo != nullptr) { // do we care about notifications?
-        addUndoItem(new KateModifiedInsertText(m_document, line, col, s));
+        addUndoItem(KateUndo(KateUndo::editInsertText, line, col, s.size(), false), s);
     }
 }
 
 void KateUndoManager::slotTextRemoved(int line, int col, const QString &s)
 {
     if (m_editCurrentUndo != nullptr) { // do we care about notifications?
-        addUndoItem(new KateModifiedRemoveText(m_document, line, col, s));
+        addUndoItem(KateUndo(KateUndo::editRemoveText, line, col, s.size(), false), s);
     }
 }
 
 void KateUndoManager::slotMarkLineAutoWrapped(int line, bool autowrapped)
 {
     if (m_editCurrentUndo != nullptr) { // do we care about notifications?
-        addUndoItem(new KateEditMarkLineAutoWrappedUndo(m_document, line, autowrapped));
+        addUndoItem(KateUndo(KateUndo::editMarkLineAutoWrapped, line, 0, 0, autowrapped));
     }
 }
 
 void KateUndoManager::slotLineWrapped(int line, int col, int length, bool newLine)
 {
     if (m_editCurrentUndo != nullptr) { // do we care about notifications?
-        addUndoItem(new KateModifiedWrapLine(m_document, line, col, length, newLine));
+        addUndoItem(KateUndo(KateUndo::editWrapLine, line, col, length, newLine));
     }
 }
 
 void KateUndoManager::slotLineUnWrapped(int line, int col, int length, bool lineRemoved)
 {
     if (m_editCurrentUndo != nullptr) { // do we care about notifications?
-        addUndoItem(new KateModifiedUnWrapLine(m_document, line, col, length, lineRemoved));
+        addUndoItem(KateUndo(KateUndo::editUnWrapLine, line, col, length, lineRemoved));
     }
 }
 
 void KateUndoManager::slotLineInserted(int line, const QString &s)
 {
     if (m_editCurrentUndo != nullptr) { // do we care about notifications?
-        addUndoItem(new KateModifiedInsertLine(m_document, line, s));
+        addUndoItem(KateUndo(KateUndo::editInsertLine, line, 0, s.size(), false), s);
     }
 }
 
 void KateUndoManager::slotLineRemoved(int line, const QString &s)
 {
     if (m_editCurrentUndo != nullptr) { // do we care about notifications?
-        addUndoItem(new KateModifiedRemoveLine(m_document, line, s));
+        addUndoItem(KateUndo(KateUndo::editRemoveLine, line, 0, s.size(), false), s);
     }
 }
 
@@ -209,16 +230,15 @@ void KateUndoManager::undoSafePoint()
     undoGroup->safePoint();
 }
 
-void KateUndoManager::addUndoItem(KateUndo *undo)
+void KateUndoManager::addUndoItem(KateUndo undo, const QString &text)
 {
-    Q_ASSERT(undo != nullptr);              // don't add null pointers to our history
     Q_ASSERT(m_editCurrentUndo != nullptr); // make sure there is an undo group for our item
 
-    m_editCurrentUndo->addItem(undo);
+    KateModifiedUndo::initFlags(undo, m_document);
+    m_editCurrentUndo->addItem(undo, text);
 
     // Clear redo buffer
-    qDeleteAll(redoItems);
-    redoItems.clear();
+    deleteGroups(redoItems);
 }
 
 void KateUndoManager::setActive(bool enabled)
@@ -248,10 +268,13 @@ void KateUndoManager::undo()
     if (!undoItems.isEmpty()) {
         emit undoStart(document());
 
+        unpackGroup(undoItems.last());
         undoItems.last()->undo(activeView());
         redoItems.append(undoItems.last());
         undoItems.removeLast();
+        m_packedUndoGroups = qMin(m_packedUndoGroups, qMax(0, undoItems.size() - 1));
         updateModified();
+        limitMemoryUsage();
 
         emit undoEnd(document());
     }
@@ -264,10 +287,13 @@ void KateUndoManager::redo()
     if (!redoItems.isEmpty()) {
         emit redoStart(document());
 
+        unpackGroup(redoItems.last());
         redoItems.last()->redo(activeView());
         undoItems.append(redoItems.last());
         redoItems.removeLast();
+        m_packedRedoGroups = qMin(m_packedRedoGroups, qMax(0, redoItems.size() - 1));
         updateModified();
+        limitMemoryUsage();
 
         emit redoEnd(document());
     }
@@ -354,8 +380,7 @@ void KateUndoManager::updateModified()
 
 void KateUndoManager::clearUndo()
 {
-    qDeleteAll(undoItems);
-    undoItems.clear();
+    deleteGroups(undoItems);
 
     lastUndoGroupWhenSaved = nullptr;
     docWasSavedWhenUndoWasEmpty = false;
@@ -365,8 +390,7 @@ void KateUndoManager::clearUndo()
 
 void KateUndoManager::clearRedo()
 {
-    qDeleteAll(redoItems);
-    redoItems.clear();
+    deleteGroups(redoItems);
 
     lastRedoGroupWhenSaved = nullptr;
     docWasSavedWhenRedoWasEmpty = false;
@@ -392,24 +416,21 @@ void KateUndoManager::setModified(bool modified)
 
 void KateUndoManager::updateLineModifications()
 {
-    // change LineSaved flag of all undo & redo items to LineModified
-    for (KateUndoGroup *undoGroup : qAsConst(undoItems)) {
-        undoGroup->flagSavedAsModified();
-    }
-
-    for (KateUndoGroup *undoGroup : qAsConst(redoItems)) {
-        undoGroup->flagSavedAsModified();
-    }
-
+    // change LineSaved flag of all undo & redo items to LineModified and
     // iterate all undo/redo items to find out, which item sets the flag LineSaved
+    // both only touch the items of one group, packed groups keep their flags uncompressed
     QBitArray lines(document()->lines(), false);
     for (int i = undoItems.size() - 1; i >= 0; --i) {
-        undoItems[i]->markRedoAsSaved(lines);
+        KateUndoGroup *undoGroup = undoItems[i];
+        undoGroup->flagSavedAsModified();
+        undoGroup->markRedoAsSaved(lines);
     }
 
     lines.fill(false);
     for (int i = redoItems.size() - 1; i >= 0; --i) {
-        redoItems[i]->markUndoAsSaved(lines);
+        KateUndoGroup *undoGroup = redoItems[i];
+        undoGroup->flagSavedAsModified();
+        undoGroup->markUndoAsSaved(lines);
     }
 }
 
@@ -435,6 +456,9 @@ KTextEditor::Cursor KateUndoManager::lastRedoCursor() const
 
 void KateUndoManager::updateConfig()
 {
+    m_memoryLimit = qint64(m_document->config()->undoMemoryLimit()) * 1024 * 1024;
+    limitMemoryUsage();
+
     emit undoChanged();
 }
 
@@ -447,3 +471,48 @@ KTextEditor::View *KateUndoManager::activeView()
 {
     return m_document->activeView();
 }
+
+void KateUndoManager::unpackGroup(KateUndoGroup *group)
+{
+    if (group->isPacked()) {
+        m_memoryUsage -= group->memoryUsage();
+        group->unpack();
+        m_memoryUsage += group->memoryUsage();
+    }
+}
+
+void KateUndoManager::deleteGroups(QList<KateUndoGroup *> &groups)
+{
+    for (KateUndoGroup *group : qAsConst(groups)) {
+        m_memoryUsage -= group->memoryUsage();
+    }
+
+    qDeleteAll(groups);
+    groups.clear();
+    packedGroups(groups) = 0;
+}
+
+int &KateUndoManager::packedGroups(const QList<KateUndoGroup *> &groups)
+{
+    Q_ASSERT(&groups == &undoItems || &groups == &redoItems);
+    return (&groups == &undoItems) ? m_packedUndoGroups : m_packedRedoGroups;
+}
+
+void KateUndoManager::limitMemoryUsage()
+{
+    if (m_memoryLimit <= 0 || m_memoryUsage <= m_memoryLimit) {
+        return;
+    }
+
+    // the first groups are the ones furthest away from the current state, continue behind the ones already packed
+    for (QList<KateUndoGroup *> *groups : {&undoItems, &redoItems}) {
+        for (int &i = packedGroups(*groups); i < groups->size() - 1 && m_memoryUsage > m_memoryLimit; ++i) {
+            KateUndoGroup *group = groups->at(i);
+            if (!group->isPacked() && !group->isEmpty()) {
+                m_memoryUsage -= group->memoryUsage();
+                group->pack();
+                m_memoryUsage += group->memoryUsage();
+            }
+        }
+    }
+}
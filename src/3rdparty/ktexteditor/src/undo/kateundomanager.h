@@ -31,7 +31,7 @@ namespace KTextEditor
 {
 class DocumentPrivate;
 }
-class KateUndo;
+struct KateUndo;
 class KateUndoGroup;
 
 namespace KTextEditor
@@ -151,6 +151,13 @@ public Q_SLOTS:
     void inputMethodStart();
     void inputMethodEnd();
 
+    /**
+     * Edits between reloadStart() and reloadEnd() bring the document in line with the
+     * file on disk, like loading it. They are neither recorded nor wrapped.
+     */
+    void reloadStart();
+    void reloadEnd();
+
     /**
      * Notify KateUndoManager that text was inserted.
      */
@@ -195,13 +202,6 @@ Q_SIGNALS:
     void isActiveChanged(bool enabled);
 
 private Q_SLOTS:
-    /**
-     * @short Add an undo item to the current undo group.
-     *
-     * @param undo undo item to be added, must be non-null
-     */
-    void addUndoItem(KateUndo *undo);
-
     void setActive(bool active);
 
     void updateModified();
@@ -212,6 +212,38 @@ private Q_SLOTS:
 private:
     KTextEditor::View *activeView();
 
+    /**
+     * @short Add an undo item to the current undo group.
+     *
+     * @param undo undo item to be added, its line modification flags are set here
+     * @param text text of the undo item, if any
+     */
+    void addUndoItem(KateUndo undo, const QString &text = QString());
+
+    /**
+     * Unpack @p group if it is packed, keeping track of the memory usage.
+     */
+    void unpackGroup(KateUndoGroup *group);
+
+    /**
+     * Delete all @p groups, keeping track of the memory usage.
+     */
+    void deleteGroups(QList<KateUndoGroup *> &groups);
+
+    /**
+     * Pack the undo and redo groups furthest away from the current state
+     * until the history fits into the configured memory limit again.
+     * The groups next to undo and redo are never packed.
+     */
+    void limitMemoryUsage();
+
+    /**
+     * Number of groups at the front of @p groups, undoItems or redoItems, that are
+     * known to be packed or empty. limitMemoryUsage() continues behind them.
+     * Never includes the last group, the only one that gets unpacked.
+     */
+    int &packedGroups(const QList<KateUndoGroup *> &groups);
+
 private:
     KTextEditor::DocumentPrivate *m_document = nullptr;
     bool m_undoComplexMerge = false;
@@ -225,6 +257,22 @@ private:
     KateUndoGroup *lastRedoGroupWhenSaved = nullptr;
     bool docWasSavedWhenUndoWasEmpty = true;
     bool docWasSavedWhenRedoWasEmpty = true;
+
+    /**
+     * memory limit of undoItems and redoItems in bytes, 0 means no limit
+     */
+    qint64 m_memoryLimit = 0;
+
+    /**
+     * memory used by undoItems and redoItems, packed or not
+     */
+    qint64 m_memoryUsage = 0;
+
+    /**
+     * see packedGroups()
+     */
+    int m_packedUndoGroups = 0;
+    int m_packedRedoGroups = 0;
 };
 
 #endif
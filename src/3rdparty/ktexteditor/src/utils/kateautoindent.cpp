@@ -26,6 +26,7 @@
 #include "kateglobal.h"
 #include "katehighlight.h"
 #include "kateindentscript.h"
+#include "katenativeindenter.h"
 #include "katepartdebug.h"
 #include "katescriptmanager.h"
 #include "kateview.h"
@@ -266,6 +267,7 @@ void KateAutoIndent::reloadScript()
 {
     // small trick to force reload
     m_script = nullptr; // prevent dangling pointer
+    m_nativeIndenter.reset();
     QString currentMode = m_mode;
     m_mode = QString();
     setMode(currentMode);
@@ -277,7 +279,7 @@ void KateAutoIndent::scriptIndent(KTextEditor::ViewPrivate *view, const KTextEdi
     doc->pushEditState();
     doc->editStart();
 
-    QPair<int, int> result = m_script->indent(view, position, typedChar, indentWidth);
+    QPair<int, int> result = m_nativeIndenter ? m_nativeIndenter->indent(view, position, typedChar, indentWidth) : m_script->indent(view, position, typedChar, indentWidth);
     int newIndentInChars = result.first;
 
     // handle negative values special
@@ -317,6 +319,7 @@ void KateAutoIndent::setMode(const QString &name)
 
     // cleanup
     m_script = nullptr;
+    m_nativeIndenter.reset();
 
     // first, catch easy stuff... normal mode and none, easy...
     if (name.isEmpty() || name == MODE_NONE()) {
@@ -334,6 +337,7 @@ void KateAutoIndent::setMode(const QString &name)
     if (script) {
         if (isStyleProvided(script, doc->highlight())) {
             m_script = script;
+            m_nativeIndenter.reset(KateNativeIndenter::create(script));
             m_mode = name;
             return;
         } else {
@@ -441,7 +445,8 @@ void KateAutoIndent::userTypedChar(KTextEditor::ViewPrivate *view, const KTextEd
     }
 
     // does the script allow this char as trigger?
-    if (typedChar != QLatin1Char('\n') && !m_script->triggerCharacters().contains(typedChar)) {
+    const QString triggerCharacters = m_nativeIndenter ? m_nativeIndenter->triggerCharacters() : m_script->triggerCharacters();
+    if (typedChar != QLatin1Char('\n') && !triggerCharacters.contains(typedChar)) {
         return;
     }
 
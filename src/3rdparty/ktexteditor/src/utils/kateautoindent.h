@@ -30,11 +30,14 @@
 #include <KActionMenu>
 #include <ktexteditor/cursor.h>
 
+#include <memory>
+
 namespace KTextEditor
 {
 class DocumentPrivate;
 }
 class KateIndentScript;
+class KateNativeIndenter;
 class KateHighlighting;
 
 /**
@@ -234,6 +237,7 @@ private:
     bool keepExtra;                    //!< Keep indentation that is not on indentation boundaries
     QString m_mode;
     KateIndentScript *m_script;
+    std::unique_ptr<KateNativeIndenter> m_nativeIndenter; //!< C++ replacement of m_script, if any
 };
 
 /**
@@ -32,8 +32,16 @@
 #include "kateview.h"
 
 #include <KLocalizedString>
+#include <KShell>
 
 #include <QRegularExpression>
+#include <QRunnable>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
 
 // BEGIN CoreCommands
 KateCommands::CoreCommands *KateCommands::CoreCommands::m_instance = nullptr;
@@ -609,3 +617,347 @@ bool KateCommands::Date::exec(KTextEditor::View *view, const QString &cmd, QStri
 }
 
 // END Date
+
+// BEGIN LineTools
+KateCommands::LineTools *KateCommands::LineTools::m_instance = nullptr;
+
+namespace
+{
+/**
+ * Minimal number of lines each thread sorts, for less the threads cost more than they save.
+ */
+const int MinimalLinesPerThread = 16384;
+
+/**
+ * Sorts one chunk of the lines in a thread of the pool.
+ */
+template<typename LessThan> class SortChunk : public QRunnable
+{
+public:
+    SortChunk(QStringList::iterator begin, QStringList::iterator end, LessThan lessThan)
+        : m_begin(begin)
+        , m_end(end)
+        , m_lessThan(lessThan)
+    {
+    }
+
+    void run() override
+    {
+        std::stable_sort(m_begin, m_end, m_lessThan);
+    }
+
+private:
+    const QStringList::iterator m_begin;
+    const QStringList::iterator m_end;
+    const LessThan m_lessThan;
+};
+
+/**
+ * Stable sort, large lists are split into one chunk per core which are sorted
+ * in parallel and then merged.
+ */
+template<typename LessThan> void sortLines(QStringList &lines, LessThan lessThan)
+{
+    const int chunks = qMin(QThread::idealThreadCount(), lines.size() / MinimalLinesPerThread);
+    if (chunks < 2) {
+        std::stable_sort(lines.begin(), lines.end(), lessThan);
+        return;
+    }
+
+    // chunk i is [bounds[i], bounds[i + 1]), begin() detaches before the threads see the list
+    QVector<QStringList::iterator> bounds;
+    const QStringList::iterator begin = lines.begin();
+    for (int i = 0; i <= chunks; ++i) {
+        bounds.append(begin + int(qint64(lines.size()) * i / chunks));
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(chunks);
+    for (int i = 0; i < chunks; ++i) {
+        pool.start(new SortChunk<LessThan>(bounds[i], bounds[i + 1], lessThan));
+    }
+    pool.waitForDone();
+
+    // merge neighbouring runs, the left one first keeps the sort stable
+    for (int width = 1; width < chunks; width *= 2) {
+        for (int i = 0; i + width < chunks; i += 2 * width) {
+            std::inplace_merge(bounds[i], bounds[i + width], bounds[qMin(i + 2 * width, chunks)], lessThan);
+        }
+    }
+}
+
+/*
+Natural order comparison, ported from natcompare.js which utils.js used before.
+
+natcompare.js -- Perform 'natural order' comparisons of strings in JavaScript.
+Copyright (C) 2005 by SCK-CEN (Belgian Nucleair Research Centre)
+Written by Kristof Coomans <kristof[dot]coomans[at]sckcen[dot]be>
+
+Based on the Java version by Pierre-Luc Paour, of which this is more or less a straight conversion.
+Copyright (C) 2003 by Pierre-Luc Paour <natorder@paour.com>
+
+The Java version was based on the C version by Martin Pool.
+Copyright (C) 2000 by Martin Pool <mbp@humbug.org.au>
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not
+claim that you wrote the original software. If you use this software
+in a product, an acknowledgment in the product documentation would be
+appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be
+misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+// characters are UTF-16 code units like for charAt(), -1 is past the end of the string
+int naturalCharAt(const QString &s, int i)
+{
+    return i < s.size() ? s.at(i).unicode() : -1;
+}
+
+bool isNaturalSpace(int c)
+{
+    return c >= 0 && c <= 32;
+}
+
+bool isNaturalDigit(int c)
+{
+    return c >= '0' && c <= '9';
+}
+
+int naturalCompareRight(const QString &a, int ia, const QString &b, int ib)
+{
+    // The longest run of digits wins. That aside, the greatest value wins, but we can't know
+    // that it will until we've scanned both numbers to know that they have the same magnitude,
+    // so we remember it in bias.
+    int bias = 0;
+    for (;; ++ia, ++ib) {
+        const int ca = naturalCharAt(a, ia);
+        const int cb = naturalCharAt(b, ib);
+        if (!isNaturalDigit(ca) && !isNaturalDigit(cb)) {
+            return bias;
+        } else if (!isNaturalDigit(ca)) {
+            return -1;
+        } else if (!isNaturalDigit(cb)) {
+            return +1;
+        } else if (ca < cb) {
+            if (bias == 0) {
+                bias = -1;
+            }
+        } else if (ca > cb) {
+            if (bias == 0) {
+                bias = +1;
+            }
+        }
+    }
+}
+
+int naturalCompare(const QString &a, const QString &b)
+{
+    int ia = 0;
+    int ib = 0;
+    while (true) {
+        // only count the number of zeroes leading the last number compared
+        int nza = 0;
+        int nzb = 0;
+        int ca = naturalCharAt(a, ia);
+        int cb = naturalCharAt(b, ib);
+
+        // skip over leading spaces or zeros, only count consecutive zeroes
+        while (isNaturalSpace(ca) || ca == '0') {
+            nza = (ca == '0') ? nza + 1 : 0;
+            ca = naturalCharAt(a, ++ia);
+        }
+        while (isNaturalSpace(cb) || cb == '0') {
+            nzb = (cb == '0') ? nzb + 1 : 0;
+            cb = naturalCharAt(b, ++ib);
+        }
+
+        // process run of digits
+        if (isNaturalDigit(ca) && isNaturalDigit(cb)) {
+            const int result = naturalCompareRight(a, ia, b, ib);
+            if (result != 0) {
+                return result;
+            }
+        }
+
+        if (ca < 0 && cb < 0) {
+            // the strings compare the same
+            return nza - nzb;
+        }
+
+        if (ca < cb) {
+            return -1;
+        } else if (ca > cb) {
+            return +1;
+        }
+
+        ++ia;
+        ++ib;
+    }
+}
+
+/**
+ * The characters \s matches in JavaScript, which the script versions trimmed.
+ */
+bool isScriptSpace(QChar c)
+{
+    switch (c.unicode()) {
+    case 0x09:
+    case 0x0A:
+    case 0x0B:
+    case 0x0C:
+    case 0x0D:
+    case 0x20:
+    case 0xA0:
+    case 0x1680:
+    case 0x2028:
+    case 0x2029:
+    case 0x202F:
+    case 0x205F:
+    case 0x3000:
+    case 0xFEFF:
+        return true;
+    default:
+        return c.unicode() >= 0x2000 && c.unicode() <= 0x200A;
+    }
+}
+
+QString trimmedLine(const QString &line, bool leading, bool trailing)
+{
+    int start = 0;
+    int end = line.size();
+    while (leading && start < end && isScriptSpace(line.at(start))) {
+        ++start;
+    }
+    while (trailing && end > start && isScriptSpace(line.at(end - 1))) {
+        --end;
+    }
+    return (start == 0 && end == line.size()) ? line : line.mid(start, end - start);
+}
+}
+
+bool KateCommands::LineTools::help(class KTextEditor::View *, const QString &cmd, QString &msg)
+{
+    const QString realcmd = cmd.trimmed();
+    if (realcmd == QLatin1String("sort")) {
+        msg = i18n("Sort the selected text or whole document.");
+    } else if (realcmd == QLatin1String("natsort")) {
+        msg = i18n(
+            "Sort the selected text or whole document in natural order.<br>Here is an example to show the difference to the normal sort "
+            "method:<br>sort(a10, a1, a2) => a1, a10, a2<br>natsort(a10, a1, a2) => a1, a2, a10");
+    } else if (realcmd == QLatin1String("uniq")) {
+        msg = i18n("Remove duplicate lines from the selected text or whole document.");
+    } else if (realcmd == QLatin1String("rtrim")) {
+        msg = i18n("Trims trailing whitespace from selection or whole document.");
+    } else if (realcmd == QLatin1String("ltrim")) {
+        msg = i18n("Trims leading whitespace from selection or whole document.");
+    } else if (realcmd == QLatin1String("trim")) {
+        msg = i18n("Trims leading and trailing whitespace from selection or whole document.");
+    } else if (realcmd == QLatin1String("rmblank")) {
+        msg = i18n("Removes empty lines from selection or whole document.");
+    } else if (realcmd == QLatin1String("join")) {
+        msg = i18n(
+            "Joins selected lines or whole document. Optionally pass a separator to put between each line:<br><code>join ', '</code> will e.g. join "
+            "lines and separate them by a comma.");
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool KateCommands::LineTools::exec(KTextEditor::View *view, const QString &_cmd, QString &errorMsg, const KTextEditor::Range &range)
+{
+    KTextEditor::ViewPrivate *v = static_cast<KTextEditor::ViewPrivate *>(view);
+    if (!v) {
+        errorMsg = i18n("Could not access view");
+        return false;
+    }
+    KTextEditor::DocumentPrivate *doc = v->doc();
+
+    // arguments are quoted like for the command line scripts, e.g. join ', '
+    KShell::Errors errorCode;
+    QStringList args(KShell::splitArgs(_cmd, KShell::NoOptions, &errorCode));
+    if (errorCode != KShell::NoError || args.isEmpty()) {
+        errorMsg = i18n("Bad quoting in call: %1. Please escape single quotes with a backslash.", _cmd);
+        return false;
+    }
+    const QString cmd = args.takeFirst();
+
+    if (!doc->isReadWrite()) {
+        errorMsg = i18n("The document is read-only.");
+        return false;
+    }
+
+    // whole lines of the range, the selection or the whole document
+    int fromLine = 0;
+    int toLine = doc->lastLine();
+    if (range.isValid()) {
+        fromLine = range.start().line();
+        toLine = range.end().line();
+    } else if (v->selection()) {
+        fromLine = v->selectionRange().start().line();
+        toLine = v->selectionRange().end().line();
+    }
+    fromLine = qMax(fromLine, 0);
+    toLine = qMin(toLine, doc->lastLine());
+
+    QStringList lines;
+    lines.reserve(qMax(toLine - fromLine + 1, 0));
+    for (int line = fromLine; line <= toLine; ++line) {
+        lines.append(doc->line(line));
+    }
+
+    if (cmd == QLatin1String("sort")) {
+        // code unit order, like the default sort of JavaScript arrays
+        sortLines(lines, [](const QString &a, const QString &b) {
+            return a < b;
+        });
+    } else if (cmd == QLatin1String("natsort")) {
+        sortLines(lines, [](const QString &a, const QString &b) {
+            return naturalCompare(a, b) < 0;
+        });
+    } else if (cmd == QLatin1String("uniq")) {
+        // keep the first occurrence
+        QSet<QString> seen;
+        seen.reserve(lines.size());
+        auto last = std::remove_if(lines.begin(), lines.end(), [&seen](const QString &line) {
+            if (seen.contains(line)) {
+                return true;
+            }
+            seen.insert(line);
+            return false;
+        });
+        lines.erase(last, lines.end());
+    } else if (cmd == QLatin1String("rtrim") || cmd == QLatin1String("ltrim") || cmd == QLatin1String("trim")) {
+        const bool leading = cmd != QLatin1String("rtrim");
+        const bool trailing = cmd != QLatin1String("ltrim");
+        for (QString &line : lines) {
+            line = trimmedLine(line, leading, trailing);
+        }
+    } else if (cmd == QLatin1String("rmblank")) {
+        lines.removeAll(QString());
+    } else if (cmd == QLatin1String("join")) {
+        lines = QStringList(lines.join(args.value(0)));
+    } else {
+        return false;
+    }
+
+    // one transaction, unchanged lines at both ends are not touched
+    if (!doc->replaceLines(fromLine, toLine, lines)) {
+        errorMsg = i18n("Could not replace the lines %1 to %2.", fromLine + 1, toLine + 1);
+        return false;
+    }
+
+    v->clearSelection();
+    return true;
+}
+
+// END LineTools
@@ -202,5 +202,60 @@ public:
     }
 };
 
+/**
+ * Line tools formerly provided by the utils.js command line script:
+ * sort, natsort, uniq, rtrim, ltrim, trim, rmblank and join.
+ * They work on the whole lines of the range, the selection or the whole document
+ * and replace them in one editing transaction.
+ */
+class LineTools : public KTextEditor::Command
+{
+    LineTools()
+        : KTextEditor::Command({QStringLiteral("sort"),
+                                QStringLiteral("natsort"),
+                                QStringLiteral("uniq"),
+                                QStringLiteral("rtrim"),
+                                QStringLiteral("ltrim"),
+                                QStringLiteral("trim"),
+                                QStringLiteral("rmblank"),
+                                QStringLiteral("join")})
+    {
+    }
+
+    static LineTools *m_instance;
+
+public:
+    ~LineTools() override
+    {
+        m_instance = nullptr;
+    }
+
+    /**
+     * execute command on given range
+     * @param view view to use for execution
+     * @param cmd cmd string
+     * @param errorMsg error to return if no success
+     * @param range range to execute command on
+     * @return success
+     */
+    bool exec(class KTextEditor::View *view, const QString &cmd, QString &errorMsg, const KTextEditor::Range &range = KTextEditor::Range(-1, -0, -1, 0)) override;
+
+    bool supportsRange(const QString &) override
+    {
+        return true;
+    }
+
+    /** @see KTextEditor::Command::help */
+    bool help(class KTextEditor::View *, const QString &, QString &) override;
+
+    static LineTools *self()
+    {
+        if (m_instance == nullptr) {
+            m_instance = new LineTools();
+        }
+        return m_instance;
+    }
+};
+
 } // namespace KateCommands
 #endif
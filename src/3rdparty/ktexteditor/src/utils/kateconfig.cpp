@@ -388,6 +388,9 @@ KateDocumentConfig::KateDocumentConfig()
     addConfigEntry(ConfigEntry(SwapFileDirectory, "Swap Directory", QString(), QString()));
     addConfigEntry(ConfigEntry(SwapFileSyncInterval, "Swap Sync Interval", QString(), 15));
     addConfigEntry(ConfigEntry(LineLengthLimit, "Line Length Limit", QString(), 10000));
+    addConfigEntry(ConfigEntry(FollowLineLimit, "Follow Line Limit", QStringLiteral("follow-line-limit"), 0, [](const QVariant &value) { return value.toInt() >= 0; }));
+    addConfigEntry(ConfigEntry(UndoMemoryLimit, "Undo Memory Limit", QStringLiteral("undo-memory-limit"), 128, [](const QVariant &value) { return value.toInt() >= 0; }));
+    addConfigEntry(ConfigEntry(IncrementalLoadLimit, "Incremental Load Limit", QStringLiteral("incremental-load-limit"), 16, [](const QVariant &value) { return value.toInt() >= 0; }));
 
     /**
      * finalize the entries, e.g. hashs them
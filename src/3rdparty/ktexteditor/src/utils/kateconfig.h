@@ -540,7 +540,22 @@ public:
         /**
          * Line length limit
          */
-        LineLengthLimit
+        LineLengthLimit,
+
+        /**
+         * Maximal number of lines kept when following a growing file
+         */
+        FollowLineLimit,
+
+        /**
+         * Memory limit of the undo history in MiB
+         */
+        UndoMemoryLimit,
+
+        /**
+         * File size in MiB from which on files are loaded incrementally
+         */
+        IncrementalLoadLimit
     };
 
 public:
@@ -910,6 +925,46 @@ public:
         setValue(LineLengthLimit, limit);
     }
 
+    /**
+     * When lines appended to the file on disk are followed, the oldest lines
+     * are dropped beyond this number of lines, 0 keeps all lines.
+     */
+    int followLineLimit() const
+    {
+        return value(FollowLineLimit).toInt();
+    }
+
+    void setFollowLineLimit(int limit)
+    {
+        setValue(FollowLineLimit, limit);
+    }
+
+    /**
+     * Beyond this number of MiB, the oldest undo groups are kept compressed, 0 means no limit.
+     */
+    int undoMemoryLimit() const
+    {
+        return value(UndoMemoryLimit).toInt();
+    }
+
+    void setUndoMemoryLimit(int limit)
+    {
+        setValue(UndoMemoryLimit, limit);
+    }
+
+    /**
+     * Files of at least this many MiB are shown while they are still loading, 0 means never.
+     */
+    int incrementalLoadLimit() const
+    {
+        return value(IncrementalLoadLimit).toInt();
+    }
+
+    void setIncrementalLoadLimit(int limit)
+    {
+        setValue(IncrementalLoadLimit, limit);
+    }
+
 private:
     static KateDocumentConfig *s_global;
     KTextEditor::DocumentPrivate *m_doc = nullptr;
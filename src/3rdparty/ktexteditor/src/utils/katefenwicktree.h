@@ -0,0 +1,189 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_FENWICKTREE_H
+#define KATE_FENWICKTREE_H
+
+#include <QVector>
+
+/**
+ * Fenwick tree (binary indexed tree) over a list of integers, e.g. one value per line.
+ *
+ * Changing a value and summing a range of values both take O(log n).
+ * Inserting or removing values shifts the ones behind them, the tree is then
+ * rebuilt in O(n) on its next use. That is still a plain pass over integers,
+ * far cheaper than whatever computed the values.
+ */
+class KateFenwickTree
+{
+public:
+    /**
+     * Number of values.
+     */
+    int size() const
+    {
+        return m_values.size();
+    }
+
+    /**
+     * Replace all values by @p count times @p value.
+     */
+    void fill(int value, int count)
+    {
+        m_values.fill(value, count);
+        m_valid = false;
+    }
+
+    /**
+     * Retrieve the value at @p index.
+     */
+    int value(int index) const
+    {
+        return m_values.at(index);
+    }
+
+    /**
+     * Set the value at @p index.
+     */
+    void setValue(int index, int value)
+    {
+        const int delta = value - m_values.at(index);
+        if (delta == 0) {
+            return;
+        }
+
+        m_values[index] = value;
+        if (!m_valid) {
+            return;
+        }
+        for (int i = index + 1; i <= m_tree.size(); i += i & -i) {
+            m_tree[i - 1] += delta;
+        }
+    }
+
+    /**
+     * Insert @p count times @p value in front of @p index.
+     */
+    void insert(int index, int count, int value)
+    {
+        m_values.insert(index, count, value);
+        m_valid = false;
+    }
+
+    /**
+     * Remove @p count values starting at @p index.
+     */
+    void remove(int index, int count)
+    {
+        m_values.remove(index, count);
+        m_valid = false;
+    }
+
+    /**
+     * Sum of the first @p count values.
+     */
+    qint64 prefixSum(int count) const
+    {
+        ensureValid();
+
+        qint64 sum = 0;
+        for (int i = qMin(count, m_tree.size()); i > 0; i -= i & -i) {
+            sum += m_tree.at(i - 1);
+        }
+        return sum;
+    }
+
+    /**
+     * Sum of the values from @p begin up to, but not including, @p end.
+     */
+    qint64 sum(int begin, int end) const
+    {
+        return (end > begin) ? prefixSum(end) - prefixSum(begin) : 0;
+    }
+
+    /**
+     * Sum of all values.
+     */
+    qint64 sum() const
+    {
+        return prefixSum(m_values.size());
+    }
+
+    /**
+     * Number of leading values whose sum does not exceed @p sum, in O(log n).
+     * With all values laid out one after the other, this is the index of the value
+     * covering the unit at offset @p sum. Needs non-negative values.
+     */
+    int findIndex(qint64 sum) const
+    {
+        ensureValid();
+
+        int step = 1;
+        while (2 * step <= m_tree.size()) {
+            step *= 2;
+        }
+
+        int index = 0;
+        for (; step > 0; step /= 2) {
+            if (index + step <= m_tree.size() && m_tree.at(index + step - 1) <= sum) {
+                index += step;
+                sum -= m_tree.at(index - 1);
+            }
+        }
+        return index;
+    }
+
+private:
+    /**
+     * Build the tree in O(n), every node adds itself to its parent.
+     */
+    void ensureValid() const
+    {
+        if (m_valid) {
+            return;
+        }
+
+        m_tree.resize(m_values.size());
+        for (int i = 0; i < m_values.size(); ++i) {
+            m_tree[i] = m_values.at(i);
+        }
+        for (int i = 1; i <= m_tree.size(); ++i) {
+            const int parent = i + (i & -i);
+            if (parent <= m_tree.size()) {
+                m_tree[parent - 1] += m_tree.at(i - 1);
+            }
+        }
+        m_valid = true;
+    }
+
+private:
+    /**
+     * the values
+     */
+    QVector<int> m_values;
+
+    /**
+     * partial sums, node i (1-based) holds the sum of the i & -i values ending at i
+     */
+    mutable QVector<qint64> m_tree;
+    mutable bool m_valid = true;
+};
+
+#endif
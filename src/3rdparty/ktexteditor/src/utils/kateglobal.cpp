@@ -39,9 +39,11 @@
 #include "kateschemaconfig.h"
 #include "katescriptmanager.h"
 #include "katesedcmd.h"
+#include "kateswapfilewriter.h"
 #include "katevariableexpansionmanager.h"
 #include "kateview.h"
 #include "katewordcompletion.h"
+#include "katewordindex.h"
 #include "spellcheck/spellcheck.h"
 
 #include "katenormalinputmodefactory.h"
@@ -226,15 +228,20 @@ KTextEditor::EditorPrivate::EditorPrivate(QPointer<KTextEditor::EditorPrivate> &
     m_cmds.push_back(KateCommands::CoreCommands::self());
     m_cmds.push_back(KateCommands::Character::self());
     m_cmds.push_back(KateCommands::Date::self());
+    m_cmds.push_back(KateCommands::LineTools::self());
     m_cmds.push_back(KateCommands::SedReplace::self());
     m_cmds.push_back(KateCommands::Highlighting::self());
 
-    // global word completion model
+    // global word completion model and its dictionary
+    m_wordDictionary = new KateWordDictionary();
     m_wordCompletionModel = new KateWordCompletionModel(this);
 
     // global keyword completion model
     m_keywordCompletionModel = new KateKeywordCompletionModel(this);
 
+    // swap files are written by their own thread
+    m_swapFileWriter = new Kate::SwapFileWriter();
+
     // tap to QApplication object for color palette changes
     qApp->installEventFilter(this);
 }
@@ -259,6 +266,10 @@ KTextEditor::EditorPrivate::~EditorPrivate()
 
     // cu model
     delete m_wordCompletionModel;
+    delete m_wordDictionary;
+
+    // write pending swap file data and stop the writer thread
+    delete m_swapFileWriter;
 
     // delete variable expansion manager
     delete m_variableExpansionManager;
@@ -65,6 +65,11 @@ class KateSpellCheckManager;
 class KateWordCompletionModel;
 class KateAbstractInputModeFactory;
 class KateKeywordCompletionModel;
+class KateWordDictionary;
+namespace Kate
+{
+class SwapFileWriter;
+}
 class KateDefaultColors;
 class KateVariableExpansionManager;
 
@@ -339,6 +344,24 @@ public:
         return m_wordCompletionModel;
     }
 
+    /**
+     * dictionary of the words of all open documents, used by the word completion
+     * @return global word dictionary
+     */
+    KateWordDictionary *wordDictionary()
+    {
+        return m_wordDictionary;
+    }
+
+    /**
+     * writer thread of the swap files of all documents
+     * @return global swap file writer
+     */
+    Kate::SwapFileWriter *swapFileWriter()
+    {
+        return m_swapFileWriter;
+    }
+
     /**
      * Global instance of the language-aware keyword completion model
      * @return global instance of the keyword completion model
@@ -532,6 +555,16 @@ private:
      */
     KateWordCompletionModel *m_wordCompletionModel;
 
+    /**
+     * dictionary of the words of all open documents
+     */
+    KateWordDictionary *m_wordDictionary;
+
+    /**
+     * writer thread of the swap files
+     */
+    Kate::SwapFileWriter *m_swapFileWriter;
+
     /**
      * global instance of the language-specific keyword completion model
      */
@@ -0,0 +1,329 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "katelinediff.h"
+#include "katetextbuffer.h"
+
+#include <QHash>
+
+#include <climits>
+#include <cmath>
+
+namespace
+{
+/**
+ * Myers' diff on two sequences of line ids, marking the lines that are not part
+ * of the longest common subsequence found.
+ */
+class MyersDiff
+{
+public:
+    MyersDiff(const QVector<int> &a, const QVector<int> &b)
+        : m_a(a)
+        , m_b(b)
+        , m_changedA(a.size(), false)
+        , m_changedB(b.size(), false)
+        , m_offset(b.size() + 1)
+        , m_forward(a.size() + b.size() + 3)
+        , m_backward(a.size() + b.size() + 3)
+    {
+        // give up searching for the optimal split after that many edits
+        m_maximalCost = qMax(256, int(std::sqrt(double(a.size() + b.size() + 3))));
+    }
+
+    void compare(int a0, int a1, int b0, int b1)
+    {
+        // strip common lines at both ends
+        while (a0 < a1 && b0 < b1 && m_a.at(a0) == m_b.at(b0)) {
+            ++a0;
+            ++b0;
+        }
+        while (a0 < a1 && b0 < b1 && m_a.at(a1 - 1) == m_b.at(b1 - 1)) {
+            --a1;
+            --b1;
+        }
+
+        if (a0 == a1) {
+            for (int i = b0; i < b1; ++i) {
+                m_changedB[i] = true;
+            }
+        } else if (b0 == b1) {
+            for (int i = a0; i < a1; ++i) {
+                m_changedA[i] = true;
+            }
+        } else {
+            int x = 0;
+            int y = 0;
+            split(a0, a1, b0, b1, x, y);
+            compare(a0, x, b0, y);
+            compare(x, a1, y, b1);
+        }
+    }
+
+    const QVector<bool> &changedA() const
+    {
+        return m_changedA;
+    }
+
+    const QVector<bool> &changedB() const
+    {
+        return m_changedB;
+    }
+
+private:
+    int &forward(int diagonal)
+    {
+        return m_forward[diagonal + m_offset];
+    }
+
+    int &backward(int diagonal)
+    {
+        return m_backward[diagonal + m_offset];
+    }
+
+    /**
+     * Find the middle snake of the edit graph, diagonals are numbered x - y.
+     * Both sequences are non-empty and differ in their first and last element.
+     */
+    void split(int a0, int a1, int b0, int b1, int &x, int &y)
+    {
+        const int minimalDiagonal = a0 - b1;
+        const int maximalDiagonal = a1 - b0;
+        const int forwardMid = a0 - b0;
+        const int backwardMid = a1 - b1;
+        const bool odd = (forwardMid - backwardMid) & 1;
+
+        int forwardMin = forwardMid;
+        int forwardMax = forwardMid;
+        int backwardMin = backwardMid;
+        int backwardMax = backwardMid;
+        forward(forwardMid) = a0;
+        backward(backwardMid) = a1;
+
+        for (int cost = 1;; ++cost) {
+            // extend the forward paths by one edit
+            if (forwardMin > minimalDiagonal) {
+                forward(--forwardMin - 1) = -1;
+            } else {
+                ++forwardMin;
+            }
+            if (forwardMax < maximalDiagonal) {
+                forward(++forwardMax + 1) = -1;
+            } else {
+                --forwardMax;
+            }
+            for (int d = forwardMax; d >= forwardMin; d -= 2) {
+                int i = forward(d - 1) >= forward(d + 1) ? forward(d - 1) + 1 : forward(d + 1);
+                int j = i - d;
+                while (i < a1 && j < b1 && m_a.at(i) == m_b.at(j)) {
+                    ++i;
+                    ++j;
+                }
+                forward(d) = i;
+                if (odd && backwardMin <= d && d <= backwardMax && backward(d) <= i) {
+                    x = i;
+                    y = j;
+                    return;
+                }
+            }
+
+            // extend the backward paths by one edit
+            if (backwardMin > minimalDiagonal) {
+                backward(--backwardMin - 1) = INT_MAX;
+            } else {
+                ++backwardMin;
+            }
+            if (backwardMax < maximalDiagonal) {
+                backward(++backwardMax + 1) = INT_MAX;
+            } else {
+                --backwardMax;
+            }
+            for (int d = backwardMax; d >= backwardMin; d -= 2) {
+                int i = backward(d - 1) < backward(d + 1) ? backward(d - 1) : backward(d + 1) - 1;
+                int j = i - d;
+                while (i > a0 && j > b0 && m_a.at(i - 1) == m_b.at(j - 1)) {
+                    --i;
+                    --j;
+                }
+                backward(d) = i;
+                if (!odd && forwardMin <= d && d <= forwardMax && i <= forward(d)) {
+                    x = i;
+                    y = j;
+                    return;
+                }
+            }
+
+            // too expensive, split at the forward path that got furthest
+            if (cost >= m_maximalCost) {
+                int best = -1;
+                for (int d = forwardMax; d >= forwardMin; d -= 2) {
+                    const int i = qMin(forward(d), a1);
+                    const int j = i - d;
+                    if (j >= b0 && j <= b1 && i + j > best) {
+                        best = i + j;
+                        x = i;
+                        y = j;
+                    }
+                }
+                if (best > a0 + b0 && best < a1 + b1) {
+                    return;
+                }
+            }
+        }
+    }
+
+private:
+    const QVector<int> &m_a;
+    const QVector<int> &m_b;
+    QVector<bool> m_changedA;
+    QVector<bool> m_changedB;
+    const int m_offset;
+    QVector<int> m_forward;
+    QVector<int> m_backward;
+    int m_maximalCost;
+};
+}
+
+QVector<KateLineDiff::Hunk> KateLineDiff::diff(const QStringList &oldLines, const QStringList &newLines)
+{
+    // common prefix and suffix don't need any ids
+    int prefix = 0;
+    const int maximalPrefix = qMin(oldLines.size(), newLines.size());
+    while (prefix < maximalPrefix && oldLines.at(prefix) == newLines.at(prefix)) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < maximalPrefix - prefix && oldLines.at(oldLines.size() - 1 - suffix) == newLines.at(newLines.size() - 1 - suffix)) {
+        ++suffix;
+    }
+
+    // map equal lines to equal ids
+    QHash<QString, int> ids;
+    const auto idsOf = [&ids, prefix, suffix](const QStringList &lines) {
+        QVector<int> result;
+        result.reserve(lines.size() - prefix - suffix);
+        for (int i = prefix; i < lines.size() - suffix; ++i) {
+            auto it = ids.find(lines.at(i));
+            if (it == ids.end()) {
+                it = ids.insert(lines.at(i), ids.size());
+            }
+            result.append(it.value());
+        }
+        return result;
+    };
+    const QVector<int> a = idsOf(oldLines);
+    const QVector<int> b = idsOf(newLines);
+
+    MyersDiff myers(a, b);
+    myers.compare(0, a.size(), 0, b.size());
+    const QVector<bool> &changedA = myers.changedA();
+    const QVector<bool> &changedB = myers.changedB();
+
+    // unchanged lines of both texts pair up in order, everything between them is a hunk
+    QVector<Hunk> hunks;
+    int i = 0;
+    int j = 0;
+    while (i < a.size() || j < b.size()) {
+        if (i < a.size() && j < b.size() && !changedA.at(i) && !changedB.at(j)) {
+            ++i;
+            ++j;
+            continue;
+        }
+
+        Hunk hunk = {prefix + i, 0, prefix + j, 0};
+        while (i < a.size() && changedA.at(i)) {
+            ++hunk.oldCount;
+            ++i;
+        }
+        while (j < b.size() && changedB.at(j)) {
+            ++hunk.newCount;
+            ++j;
+        }
+        hunks.append(hunk);
+    }
+    return hunks;
+}
+
+QString KateLineDiff::unifiedDiff(const QStringList &oldLines,
+                                  const QStringList &newLines,
+                                  const QVector<Hunk> &hunks,
+                                  const QString &oldName,
+                                  const QString &newName,
+                                  int context)
+{
+    if (hunks.isEmpty()) {
+        return QString();
+    }
+
+    QString result;
+    result += QLatin1String("--- ") + oldName + QLatin1Char('\n');
+    result += QLatin1String("+++ ") + newName + QLatin1Char('\n');
+
+    for (int first = 0; first < hunks.size();) {
+        // merge hunks whose context overlaps
+        int last = first;
+        while (last + 1 < hunks.size() && hunks.at(last + 1).oldStart - (hunks.at(last).oldStart + hunks.at(last).oldCount) <= 2 * context) {
+            ++last;
+        }
+
+        const int oldBegin = qMax(0, hunks.at(first).oldStart - context);
+        const int oldEnd = qMin(oldLines.size(), hunks.at(last).oldStart + hunks.at(last).oldCount + context);
+        const int newBegin = hunks.at(first).newStart - (hunks.at(first).oldStart - oldBegin);
+        const int newEnd = hunks.at(last).newStart + hunks.at(last).newCount + (oldEnd - hunks.at(last).oldStart - hunks.at(last).oldCount);
+
+        // like diff, an empty range is reported as starting at the line before it
+        result += QStringLiteral("@@ -%1,%2 +%3,%4 @@\n")
+                      .arg(oldEnd > oldBegin ? oldBegin + 1 : oldBegin)
+                      .arg(oldEnd - oldBegin)
+                      .arg(newEnd > newBegin ? newBegin + 1 : newBegin)
+                      .arg(newEnd - newBegin);
+
+        int oldLine = oldBegin;
+        for (int h = first; h <= last; ++h) {
+            const Hunk &hunk = hunks.at(h);
+            for (; oldLine < hunk.oldStart; ++oldLine) {
+                result += QLatin1Char(' ') + oldLines.at(oldLine) + QLatin1Char('\n');
+            }
+            for (int k = 0; k < hunk.oldCount; ++k) {
+                result += QLatin1Char('-') + oldLines.at(hunk.oldStart + k) + QLatin1Char('\n');
+            }
+            for (int k = 0; k < hunk.newCount; ++k) {
+                result += QLatin1Char('+') + newLines.at(hunk.newStart + k) + QLatin1Char('\n');
+            }
+            oldLine = hunk.oldStart + hunk.oldCount;
+        }
+        for (; oldLine < oldEnd; ++oldLine) {
+            result += QLatin1Char(' ') + oldLines.at(oldLine) + QLatin1Char('\n');
+        }
+
+        first = last + 1;
+    }
+    return result;
+}
+
+QStringList KateLineDiff::lines(const Kate::TextBuffer &buffer)
+{
+    QStringList lines;
+    lines.reserve(buffer.lines());
+    for (int line = 0; line < buffer.lines(); ++line) {
+        lines.append(buffer.line(line)->string());
+    }
+    return lines;
+}
@@ -0,0 +1,90 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_LINEDIFF_H
+#define KATE_LINEDIFF_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Kate
+{
+class TextBuffer;
+}
+
+/**
+ * Line based diff of two texts.
+ *
+ * Lines are hashed once and mapped to integers, so the comparison itself never
+ * touches the strings. Common leading and trailing lines are stripped, the rest is
+ * compared with Myers' O(ND) algorithm in its linear space divide and conquer form.
+ * For very different inputs the search for an optimal split is cut short, the
+ * result is then still a correct, but maybe not minimal, diff.
+ */
+class KateLineDiff
+{
+public:
+    /**
+     * Lines oldStart .. oldStart + oldCount - 1 of the old text are replaced by the
+     * lines newStart .. newStart + newCount - 1 of the new text. One of the counts
+     * may be 0 for pure insertions or removals.
+     */
+    struct Hunk {
+        int oldStart;
+        int oldCount;
+        int newStart;
+        int newCount;
+    };
+
+    /**
+     * Compute the differences between two texts.
+     * @param oldLines lines of the old text
+     * @param newLines lines of the new text
+     * @return hunks in ascending order, empty for equal texts
+     */
+    static QVector<Hunk> diff(const QStringList &oldLines, const QStringList &newLines);
+
+    /**
+     * Format hunks as unified diff, like "diff -u".
+     * @param oldLines lines of the old text
+     * @param newLines lines of the new text
+     * @param hunks result of diff() for these texts
+     * @param oldName name of the old text in the header
+     * @param newName name of the new text in the header
+     * @param context number of unchanged lines around each change
+     * @return the diff, empty if there are no hunks
+     */
+    static QString unifiedDiff(const QStringList &oldLines,
+                               const QStringList &newLines,
+                               const QVector<Hunk> &hunks,
+                               const QString &oldName,
+                               const QString &newName,
+                               int context = 3);
+
+    /**
+     * Lines of a buffer, shared with the buffer, the text is not copied.
+     * @param buffer text buffer
+     * @return all lines of the buffer
+     */
+    static QStringList lines(const Kate::TextBuffer &buffer);
+};
+
+#endif
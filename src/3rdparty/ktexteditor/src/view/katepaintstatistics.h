@@ -0,0 +1,60 @@
+/*  SPDX-License-Identifier: LGPL-2.0-or-later
+
+    Copyright (C) KDE Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_PAINTSTATISTICS_H
+#define KATE_PAINTSTATISTICS_H
+
+#include <QDebug>
+#include <QtGlobal>
+
+/**
+ * Counters for monitoring the paint events of one widget, times are in microseconds.
+ * The text area and the icon border keep their own, to tell their costs apart.
+ */
+struct KatePaintStatistics {
+    quint64 paintCount = 0;
+    quint64 rowsPainted = 0;
+    quint64 rowsRendered = 0;
+    qint64 lastPaintTime = 0;
+    qint64 maximalPaintTime = 0;
+    qint64 totalPaintTime = 0;
+
+    /**
+     * Account one paint event.
+     * @param time duration of the paint event
+     */
+    void addPaint(qint64 time)
+    {
+        ++paintCount;
+        lastPaintTime = time;
+        maximalPaintTime = qMax(maximalPaintTime, time);
+        totalPaintTime += time;
+    }
+};
+
+inline QDebug operator<<(QDebug debug, const KatePaintStatistics &statistics)
+{
+    QDebugStateSaver saver(debug);
+    debug.nospace() << "paints: " << statistics.paintCount << ", rows painted: " << statistics.rowsPainted << ", rows rendered: " << statistics.rowsRendered
+                    << ", last: " << statistics.lastPaintTime << "us, maximal: " << statistics.maximalPaintTime << "us, total: " << statistics.totalPaintTime << "us";
+    return debug;
+}
+
+#endif
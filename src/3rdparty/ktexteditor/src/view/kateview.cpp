@@ -232,10 +232,6 @@ KTextEditor::ViewPrivate::ViewPrivate(KTextEditor::DocumentPrivate *doc, QWidget
         }
     }
 
-    // folding restoration on reload
-    connect(m_doc, SIGNAL(aboutToReload(KTextEditor::Document *)), SLOT(saveFoldingState()));
-    connect(m_doc, SIGNAL(reloaded(KTextEditor::Document *)), SLOT(applyFoldingState()));
-
     connect(m_doc, &KTextEditor::DocumentPrivate::reloaded, this, &KTextEditor::ViewPrivate::slotDocumentReloaded);
     connect(m_doc, &KTextEditor::DocumentPrivate::aboutToReload, this, &KTextEditor::ViewPrivate::slotDocumentAboutToReload);
 
@@ -2567,6 +2563,11 @@ bool KTextEditor::ViewPrivate::tagLines(KTextEditor::Range range, bool realRange
     return tagLines(range.start(), range.end(), realRange);
 }
 
+void KTextEditor::ViewPrivate::invalidateDecorations(int startLine, int endLine)
+{
+    m_viewInternal->cache()->invalidateDecorations(startLine, endLine);
+}
+
 void KTextEditor::ViewPrivate::deactivateEditActions()
 {
     for (QAction *action : qAsConst(m_editActions)) {
@@ -2764,6 +2765,20 @@ QTextLayout *KTextEditor::ViewPrivate::textLayout(const KTextEditor::Cursor &pos
     return thisLine->isValid() ? thisLine->layout() : nullptr;
 }
 
+int KTextEditor::ViewPrivate::nextCursorPosition(const KTextEditor::Cursor &pos) const
+{
+    KateLineLayoutPtr thisLine = m_viewInternal->cache()->line(pos);
+
+    return thisLine->isValid() ? thisLine->nextCursorPosition(pos.column()) : pos.column() + 1;
+}
+
+int KTextEditor::ViewPrivate::previousCursorPosition(const KTextEditor::Cursor &pos) const
+{
+    KateLineLayoutPtr thisLine = m_viewInternal->cache()->line(pos);
+
+    return thisLine->isValid() ? thisLine->previousCursorPosition(pos.column()) : qMax(0, pos.column() - 1);
+}
+
 void KTextEditor::ViewPrivate::indent()
 {
     KTextEditor::Cursor c(cursorPosition().line(), 0);
@@ -3589,6 +3604,9 @@ void KTextEditor::ViewPrivate::slotDelayedUpdateOfView()
 
     // update view, if valid line range, else only feedback update wanted anyway
     if (m_lineToUpdateMin != -1 && m_lineToUpdateMax != -1) {
+        // attributes of ranges might have been changed in place, too
+        m_renderer->clearMergedFormats();
+        invalidateDecorations(m_lineToUpdateMin, m_lineToUpdateMax);
         tagLines(m_lineToUpdateMin, m_lineToUpdateMax, true);
         updateView(true);
     }
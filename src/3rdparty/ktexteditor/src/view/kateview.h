@@ -373,6 +373,12 @@ public:
     bool tagLines(KTextEditor::Cursor start, KTextEditor::Cursor end, bool realCursors = false);
     bool tagLines(KTextEditor::Range range, bool realRange = false);
 
+    /**
+     * Drop the cached decorations of the given real lines, e.g. after their highlighting changed.
+     * The lines still need to be tagged to be repainted.
+     */
+    void invalidateDecorations(int startLine, int endLine);
+
     void tagAll();
 
     void clear();
@@ -449,6 +455,13 @@ public:
     QTextLayout *textLayout(int line) const;
     QTextLayout *textLayout(const KTextEditor::Cursor &pos) const;
 
+    /**
+     * Columns of the cursor positions next to @p pos, like QTextLayout::nextCursorPosition()
+     * and QTextLayout::previousCursorPosition(), but right for long lines laid out in windows, too.
+     */
+    int nextCursorPosition(const KTextEditor::Cursor &pos) const;
+    int previousCursorPosition(const KTextEditor::Cursor &pos) const;
+
 public Q_SLOTS:
     void indent();
     void unIndent();
@@ -870,17 +883,18 @@ public:
 private:
     bool m_userContextMenuSet;
 
-private Q_SLOTS:
+public:
     /**
-     * save folding state before document reload
+     * save folding state before a full document reload
      */
     void saveFoldingState();
 
     /**
-     * restore folding state after document reload
+     * restore folding state after a full document reload
      */
     void applyFoldingState();
 
+private Q_SLOTS:
     void clearHighlights();
     void createHighlights();
 
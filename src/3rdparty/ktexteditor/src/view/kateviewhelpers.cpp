@@ -54,6 +54,7 @@
 #include <QActionGroup>
 #include <QBoxLayout>
 #include <QCursor>
+#include <QElapsedTimer>
 #include <QKeyEvent>
 #include <QLinearGradient>
 #include <QMenu>
@@ -71,6 +72,7 @@
 #include <QVariant>
 #include <QWhatsThis>
 #include <QtAlgorithms>
+#include <QtMath>
 
 #include <math.h>
 
@@ -1422,7 +1424,6 @@ KateIconBorder::KateIconBorder(KateViewInternal *internalView, QWidget *parent)
     , m_iconBorderOn(false)
     , m_lineNumbersOn(false)
     , m_relLineNumbersOn(false)
-    , m_updateRelLineNumbers(false)
     , m_foldingMarkersOn(false)
     , m_dynWrapIndicatorsOn(false)
     , m_annotationBorderOn(false)
@@ -1536,12 +1537,48 @@ void KateIconBorder::setRelLineNumbersOn(bool enable)
 
 void KateIconBorder::updateForCursorLineChange()
 {
-    if (m_relLineNumbersOn) {
-        m_updateRelLineNumbers = true;
+    // the cursor is not moved yet, compare the rows afterwards, e.g. for the current line color
+    if (!m_rowUpdatePending) {
+        m_rowUpdatePending = true;
+        QTimer::singleShot(0, this, &KateIconBorder::updateChangedRows);
     }
+}
 
-    // always do normal update, e.g. for different current line color!
-    update();
+void KateIconBorder::updateChangedRows()
+{
+    m_rowUpdatePending = false;
+
+    const int rows = m_viewInternal->cache()->viewCacheLineCount();
+    if (m_paintedRows.size() != rows) {
+        update();
+        return;
+    }
+
+    // only rows with a new number, color, mark or folding state, relative numbers change all of them
+    const int h = m_view->renderer()->lineHeight();
+    const int currentLine = m_view->cursorPosition().line();
+    for (int z = 0; z < rows; ++z) {
+        if (!(rowState(z, currentLine) == m_paintedRows.at(z))) {
+            update(0, z * h, width(), h);
+        }
+    }
+}
+
+void KateIconBorder::scrollRows(int viewLines)
+{
+    // the rows on screen move along with their pixels
+    const int rows = m_paintedRows.size();
+    if (viewLines > 0) {
+        for (int z = 0; z < rows; ++z) {
+            m_paintedRows[z] = (z + viewLines < rows) ? m_paintedRows.at(z + viewLines) : RowState();
+        }
+    } else if (viewLines < 0) {
+        for (int z = rows - 1; z >= 0; --z) {
+            m_paintedRows[z] = (z + viewLines >= 0) ? m_paintedRows.at(z + viewLines) : RowState();
+        }
+    }
+
+    scroll(0, -viewLines * static_cast<int>(m_view->renderer()->lineHeight()));
 }
 
 void KateIconBorder::setDynWrapIndicators(int state)
@@ -1594,8 +1631,12 @@ void KateIconBorder::updateFont()
     for (int i = 48; i < 58; i++) {
         const qreal charWidth = ceil(fm.boundingRect(QChar(i)).width());
         m_maxCharWidth = qMax(m_maxCharWidth, charWidth);
+        m_digitAdvances[i - 48] = fm.horizontalAdvance(QChar(i));
     }
 
+    // room for glyphs reaching beyond their advance
+    m_digitGlyphPadding = qCeil(m_maxCharWidth / 2);
+
     // NOTE/TODO(or not) Take size of m_dynWrapIndicatorChar into account.
     // It's a multi-char and it's reported size is, even with a mono-space font,
     // bigger than each digit, e.g. 10 vs 12. Currently it seems to work even with
@@ -1911,214 +1952,395 @@ void KateAnnotationGroupPositionState::nextLine(KTextEditor::StyleOptionAnnotati
 
 void KateIconBorder::paintBorder(int /*x*/, int y, int /*width*/, int height)
 {
+    QElapsedTimer timer;
+    timer.start();
+
     const uint h = m_view->renderer()->lineHeight();
     const uint startz = (y / h);
     const uint endz = qMin(startz + 1 + (height / h), static_cast<uint>(m_viewInternal->cache()->viewCacheLineCount()));
     const uint currentLine = m_view->cursorPosition().line();
 
-    // center the folding boxes
-    int m_px = (h - 11) / 2;
-    if (m_px < 0) {
-        m_px = 0;
-    }
-
     // Ensure we miss no change of the count of line number digits
     const int newNeededWidth = lineNumberWidth();
 
     if (m_updatePositionToArea || (newNeededWidth != m_lineNumberAreaWidth)) {
         m_lineNumberAreaWidth = newNeededWidth;
-        m_updatePositionToArea = true;
-        m_positionToArea.clear();
+        updatePositionToArea();
+    }
+
+    updateRowStyle();
+    if (m_paintedRows.size() != m_viewInternal->cache()->viewCacheLineCount()) {
+        m_paintedRows.fill(RowState(), m_viewInternal->cache()->viewCacheLineCount());
     }
 
     QPainter p(this);
     p.setRenderHints(QPainter::TextAntialiasing);
-    p.setFont(m_view->renderer()->currentFont()); // for line numbers
+    p.setFont(m_view->renderer()->currentFont()); // for annotations
 
     KTextEditor::AnnotationModel *model = m_view->annotationModel() ? m_view->annotationModel() : m_doc->annotationModel();
     KateAnnotationGroupPositionState annotationGroupPositionState(m_viewInternal, model, m_hoveredAnnotationGroupIdentifier, startz, m_annotationBorderOn);
+    const int annotationX = m_iconBorderOn ? m_iconAreaWidth + m_separatorWidth : 0;
 
-    // Fetch often used data only once, improve readability
-    const int w = width();
-    const QColor iconBarColor = m_view->renderer()->config()->iconBarColor(); // Effective our background
-    const QColor lineNumberColor = m_view->renderer()->config()->lineNumberColor();
-    const QColor backgroundColor = m_view->renderer()->config()->backgroundColor(); // Of the edit area
-
-    // Paint the border in chunks line by line
+    // Paint the border line by line, from the rendered rows
     for (uint z = startz; z < endz; z++) {
         // Painting coordinates, lineHeight * lineNumber
         const uint y = h * z;
-        // Paint the border in chunks left->right, remember used width
-        uint lnX = 0;
-
-        // Paint background over full width...
-        p.fillRect(lnX, y, w, h, iconBarColor);
-        // ...and overpaint again the end to simulate some margin to the edit area,
-        // so that the text not looks like stuck to the border
-        p.fillRect(w - m_separatorWidth, y, w, h, backgroundColor);
-
-        const KateTextLayout lineLayout = m_viewInternal->cache()->viewLine(z);
-        int realLine = lineLayout.line();
-        if (realLine < 0) {
-            // We have reached the end of the document, just paint background
-            continue;
-        }
 
-        // icon pane
-        if (m_iconBorderOn) {
-            p.setPen(m_view->renderer()->config()->separatorColor());
-            p.setBrush(m_view->renderer()->config()->separatorColor());
-            p.drawLine(lnX + m_iconAreaWidth, y, lnX + m_iconAreaWidth, y + h);
+        const RowState state = rowState(z, currentLine);
+        p.drawPixmap(0, y, rowPixmap(state));
+        m_paintedRows[z] = state;
+        ++m_paintStatistics.rowsPainted;
 
-            const uint mrk(m_doc->mark(realLine)); // call only once
-            if (mrk && lineLayout.startCol() == 0) {
-                for (uint bit = 0; bit < 32; bit++) {
-                    MarkInterface::MarkTypes markType = (MarkInterface::MarkTypes)(1 << bit);
-                    if (mrk & markType) {
-                        const QIcon markIcon = m_doc->markIcon(markType);
+        // the annotations are up to the delegate, painted on top of the row
+        if (m_annotationBorderOn && model && state.kind == RowState::Line) {
+            const int realLine = m_viewInternal->cache()->viewLine(z).line();
+            KTextEditor::StyleOptionAnnotationItem styleOption;
+            initStyleOption(&styleOption);
+            styleOption.rect.setRect(annotationX, y, m_annotationAreaWidth, h);
+            annotationGroupPositionState.nextLine(styleOption, z, realLine);
 
-                        if (!markIcon.isNull() && h > 0 && m_iconAreaWidth > 0) {
-                            const int s = qMin(m_iconAreaWidth, static_cast<int>(h)) - 2;
+            m_annotationItemDelegate->paint(&p, styleOption, model, realLine);
+        }
+    }
 
-                            // center the mark pixmap
-                            const int x_px = qMax(m_iconAreaWidth - s, 0) / 2;
-                            const int y_px = qMax(static_cast<int>(h) - s, 0) / 2;
+    m_paintStatistics.addPaint(timer.nsecsElapsed() / 1000);
+}
 
-                            markIcon.paint(&p, lnX + x_px, y + y_px, s, s);
-                        }
-                    }
-                }
-            }
+KateIconBorder::RowState KateIconBorder::rowState(int z, int currentLine) const
+{
+    RowState state;
+    state.kind = RowState::Empty;
 
-            lnX += m_iconAreaWidth + m_separatorWidth;
-            if (m_updatePositionToArea) {
-                m_positionToArea.append(AreaPosition(lnX, IconBorder));
-            }
-        }
+    if (z >= m_viewInternal->cache()->viewCacheLineCount()) {
+        return state;
+    }
 
-        // annotation information
-        if (m_annotationBorderOn) {
-            // Draw a border line between annotations and the line numbers
-            p.setPen(lineNumberColor);
-            p.setBrush(lineNumberColor);
+    const KateTextLayout lineLayout = m_viewInternal->cache()->viewLine(z);
+    const int realLine = lineLayout.line();
+    if (realLine < 0) {
+        // We have reached the end of the document, just paint background
+        return state;
+    }
 
-            const qreal borderX = lnX + m_annotationAreaWidth + 0.5;
-            p.drawLine(QPointF(borderX, y + 0.5), QPointF(borderX, y + h - 0.5));
+    state.kind = RowState::Line;
+    const bool lineStart = (lineLayout.startCol() == 0);
 
-            if (model) {
-                KTextEditor::StyleOptionAnnotationItem styleOption;
-                initStyleOption(&styleOption);
-                styleOption.rect.setRect(lnX, y, m_annotationAreaWidth, h);
-                annotationGroupPositionState.nextLine(styleOption, z, realLine);
+    // icon pane
+    if (m_iconBorderOn && lineStart) {
+        state.marks = m_doc->mark(realLine);
+    }
 
-                m_annotationItemDelegate->paint(&p, styleOption, model, realLine);
-            }
+    // line number
+    if (m_lineNumbersOn || m_dynWrapIndicatorsOn) {
+        const int distanceToCurrent = abs(realLine - currentLine);
+        state.currentLine = (distanceToCurrent == 0);
 
-            lnX += m_annotationAreaWidth + m_separatorWidth;
-            if (m_updatePositionToArea) {
-                m_positionToArea.append(AreaPosition(lnX, AnnotationBorder));
+        if (lineStart) {
+            if (m_relLineNumbersOn) {
+                state.number = state.currentLine ? realLine + 1 : distanceToCurrent;
+                state.alignLeft = state.currentLine;
+            } else if (m_lineNumbersOn) {
+                state.number = realLine + 1;
             }
+        } else if (m_dynWrapIndicatorsOn) {
+            state.wrapIndicator = true;
         }
+    }
 
-        // line number
-        if (m_lineNumbersOn || m_dynWrapIndicatorsOn) {
-            QColor usedLineNumberColor;
-            const int distanceToCurrent = abs(realLine - static_cast<int>(currentLine));
-            if (distanceToCurrent == 0) {
-                usedLineNumberColor = m_view->renderer()->config()->currentLineNumberColor();
-            } else {
-                usedLineNumberColor = lineNumberColor;
-            }
-            p.setPen(usedLineNumberColor);
-            p.setBrush(usedLineNumberColor);
+    // modified line system
+    if (m_view->config()->lineModification() && !m_doc->url().isEmpty()) {
+        const Kate::TextLine tl = m_doc->plainKateTextLine(realLine);
+        if (tl->markedAsModified()) {
+            state.modification = RowState::Modified;
+        } else if (tl->markedAsSavedOnDisk()) {
+            state.modification = RowState::Saved;
+        } else {
+            state.modification = RowState::Unmodified;
+        }
+    }
 
-            if (lineLayout.startCol() == 0) {
-                if (m_relLineNumbersOn) {
-                    if (distanceToCurrent == 0) {
-                        p.drawText(lnX + m_maxCharWidth / 2, y, m_lineNumberAreaWidth - m_maxCharWidth, h, Qt::TextDontClip | Qt::AlignLeft | Qt::AlignVCenter, QString::number(realLine + 1));
-                    } else {
-                        p.drawText(lnX + m_maxCharWidth / 2, y, m_lineNumberAreaWidth - m_maxCharWidth, h, Qt::TextDontClip | Qt::AlignRight | Qt::AlignVCenter, QString::number(distanceToCurrent));
-                    }
-                    if (m_updateRelLineNumbers) {
-                        m_updateRelLineNumbers = false;
-                        update();
-                    }
-                } else if (m_lineNumbersOn) {
-                    p.drawText(lnX + m_maxCharWidth / 2, y, m_lineNumberAreaWidth - m_maxCharWidth, h, Qt::TextDontClip | Qt::AlignRight | Qt::AlignVCenter, QString::number(realLine + 1));
+    // folding markers
+    if (m_foldingMarkersOn) {
+        // possible additional folding highlighting
+        state.foldingHighlight = m_foldingRange && m_foldingRange->overlapsLine(realLine);
+
+        if (lineStart) {
+            const QVector<QPair<qint64, Kate::TextFolding::FoldingRangeFlags>> startingRanges = m_view->textFolding().foldingRangesStartingOnLine(realLine);
+            bool anyFolded = false;
+            for (int i = 0; i < startingRanges.size(); ++i) {
+                if (startingRanges[i].second & Kate::TextFolding::Folded) {
+                    anyFolded = true;
                 }
-            } else if (m_dynWrapIndicatorsOn) {
-                p.drawText(lnX + m_maxCharWidth / 2, y, m_lineNumberAreaWidth - m_maxCharWidth, h, Qt::TextDontClip | Qt::AlignRight | Qt::AlignVCenter, m_dynWrapIndicatorChar);
             }
-
-            lnX += m_lineNumberAreaWidth + m_separatorWidth;
-            if (m_updatePositionToArea) {
-                m_positionToArea.append(AreaPosition(lnX, LineNumbers));
+            const Kate::TextLine tl = m_doc->kateTextLine(realLine);
+            if (!startingRanges.isEmpty() || tl->markedAsFoldingStart()) {
+                state.folding = anyFolded ? RowState::Folded : RowState::Unfolded;
             }
         }
+    }
 
-        // modified line system
-        if (m_view->config()->lineModification() && !m_doc->url().isEmpty()) {
-            const Kate::TextLine tl = m_doc->plainKateTextLine(realLine);
-            if (tl->markedAsModified()) {
-                p.fillRect(lnX, y, m_modAreaWidth, h, m_view->renderer()->config()->modifiedLineColor());
-            } else if (tl->markedAsSavedOnDisk()) {
-                p.fillRect(lnX, y, m_modAreaWidth, h, m_view->renderer()->config()->savedLineColor());
-            } else {
-                p.fillRect(lnX, y, m_modAreaWidth, h, iconBarColor);
-            }
+    return state;
+}
+
+void KateIconBorder::updateRowStyle()
+{
+    const KateRendererConfig *config = m_view->renderer()->config();
+
+    RowStyle style;
+    style.size = QSize(width(), m_view->renderer()->lineHeight());
+    style.devicePixelRatio = devicePixelRatioF();
+    style.font = m_view->renderer()->currentFont();
+    style.colors = {config->iconBarColor().rgba(),
+                    config->lineNumberColor().rgba(),
+                    config->currentLineNumberColor().rgba(),
+                    config->backgroundColor().rgba(),
+                    config->separatorColor().rgba(),
+                    config->modifiedLineColor().rgba(),
+                    config->savedLineColor().rgba(),
+                    config->foldingColor().rgba()};
+    style.metrics = {m_iconAreaWidth,
+                     m_annotationAreaWidth,
+                     m_lineNumberAreaWidth,
+                     m_foldingAreaWidth,
+                     qRound(m_maxCharWidth * 64),
+                     m_iconBorderOn,
+                     m_annotationBorderOn,
+                     m_lineNumbersOn,
+                     m_dynWrapIndicatorsOn,
+                     m_foldingMarkersOn};
+    style.markIconsRevision = m_doc->markIconsRevision();
+
+    if (style == m_rowStyle) {
+        return;
+    }
 
-            lnX += m_modAreaWidth; // No m_separatorWidth
-            if (m_updatePositionToArea) {
-                m_positionToArea.append(AreaPosition(lnX, None));
-            }
-        }
+    // everything rendered so far is outdated, on screen too
+    m_rowStyle = style;
+    m_rowCache.clear();
+    m_digitGlyphs.clear();
+    m_paintedRows.fill(RowState());
+    update();
+}
 
-        // folding markers
-        if (m_foldingMarkersOn) {
-            const QColor foldingColor(m_view->renderer()->config()->foldingColor());
-            // possible additional folding highlighting
-            if (m_foldingRange && m_foldingRange->overlapsLine(realLine)) {
-                p.fillRect(lnX, y, m_foldingAreaWidth, h, foldingColor);
-            }
+void KateIconBorder::updatePositionToArea()
+{
+    m_updatePositionToArea = false;
+    m_positionToArea.clear();
 
-            if (lineLayout.startCol() == 0) {
-                QVector<QPair<qint64, Kate::TextFolding::FoldingRangeFlags>> startingRanges = m_view->textFolding().foldingRangesStartingOnLine(realLine);
-                bool anyFolded = false;
-                for (int i = 0; i < startingRanges.size(); ++i) {
-                    if (startingRanges[i].second & Kate::TextFolding::Folded) {
-                        anyFolded = true;
-                    }
-                }
-                const Kate::TextLine tl = m_doc->kateTextLine(realLine);
-                if (!startingRanges.isEmpty() || tl->markedAsFoldingStart()) {
-                    if (anyFolded) {
-                        paintTriangle(p, foldingColor, lnX, y, m_foldingAreaWidth, h, false);
-                    } else {
-                        // Don't try to use currentLineNumberColor, the folded icon gets also not highligted
-                        paintTriangle(p, lineNumberColor, lnX, y, m_foldingAreaWidth, h, true);
+    // Sum up the areas left->right, like the rows are painted
+    int lnX = 0;
+    if (m_iconBorderOn) {
+        lnX += m_iconAreaWidth + m_separatorWidth;
+        m_positionToArea.append(AreaPosition(lnX, IconBorder));
+    }
+    if (m_annotationBorderOn) {
+        lnX += m_annotationAreaWidth + m_separatorWidth;
+        m_positionToArea.append(AreaPosition(lnX, AnnotationBorder));
+    }
+    if (m_lineNumbersOn || m_dynWrapIndicatorsOn) {
+        lnX += m_lineNumberAreaWidth + m_separatorWidth;
+        m_positionToArea.append(AreaPosition(lnX, LineNumbers));
+    }
+    if (m_view->config()->lineModification() && !m_doc->url().isEmpty()) {
+        lnX += m_modAreaWidth; // No m_separatorWidth
+        m_positionToArea.append(AreaPosition(lnX, None));
+    }
+    if (m_foldingMarkersOn) {
+        lnX += m_foldingAreaWidth;
+        m_positionToArea.append(AreaPosition(lnX, FoldingMarkers));
+    }
+
+    // Don't forget our "text-stuck-to-border" protector
+    lnX += m_separatorWidth;
+    m_positionToArea.append(AreaPosition(lnX, None));
+
+    // Now that we know our needed space, ensure we are painted properly
+    updateGeometry();
+    update();
+}
+
+const QPixmap &KateIconBorder::rowPixmap(const RowState &state)
+{
+    auto it = m_rowCache.constFind(state);
+    if (it != m_rowCache.constEnd()) {
+        return it.value();
+    }
+
+    // a few screens of rows, scrolling through a file renders each new number once
+    if (m_rowCache.size() > 4 * m_viewInternal->cache()->viewCacheLineCount() + 64) {
+        m_rowCache.clear();
+    }
+
+    const qreal dpr = devicePixelRatioF();
+    QPixmap pixmap(QSize(width(), m_view->renderer()->lineHeight()) * dpr);
+    pixmap.setDevicePixelRatio(dpr);
+    {
+        QPainter p(&pixmap);
+        p.setRenderHints(QPainter::TextAntialiasing);
+        p.setFont(m_view->renderer()->currentFont()); // for line numbers
+        renderRow(p, state);
+    }
+
+    ++m_paintStatistics.rowsRendered;
+    return m_rowCache.insert(state, pixmap).value();
+}
+
+void KateIconBorder::renderRow(QPainter &p, const RowState &state)
+{
+    const int h = m_view->renderer()->lineHeight();
+
+    // Fetch often used data only once, improve readability
+    const int w = width();
+    const QColor iconBarColor = m_view->renderer()->config()->iconBarColor(); // Effective our background
+    const QColor lineNumberColor = m_view->renderer()->config()->lineNumberColor();
+    const QColor backgroundColor = m_view->renderer()->config()->backgroundColor(); // Of the edit area
+
+    // Paint the border in chunks left->right, remember used width
+    int lnX = 0;
+
+    // Paint background over full width...
+    p.fillRect(lnX, 0, w, h, iconBarColor);
+    // ...and overpaint again the end to simulate some margin to the edit area,
+    // so that the text not looks like stuck to the border
+    p.fillRect(w - m_separatorWidth, 0, w, h, backgroundColor);
+
+    if (state.kind != RowState::Line) {
+        return;
+    }
+
+    // icon pane
+    if (m_iconBorderOn) {
+        p.setPen(m_view->renderer()->config()->separatorColor());
+        p.setBrush(m_view->renderer()->config()->separatorColor());
+        p.drawLine(lnX + m_iconAreaWidth, 0, lnX + m_iconAreaWidth, h);
+
+        if (state.marks) {
+            for (uint bit = 0; bit < 32; bit++) {
+                MarkInterface::MarkTypes markType = (MarkInterface::MarkTypes)(1 << bit);
+                if (state.marks & markType) {
+                    const QIcon markIcon = m_doc->markIcon(markType);
+
+                    if (!markIcon.isNull() && h > 0 && m_iconAreaWidth > 0) {
+                        const int s = qMin(m_iconAreaWidth, h) - 2;
+
+                        // center the mark pixmap
+                        const int x_px = qMax(m_iconAreaWidth - s, 0) / 2;
+                        const int y_px = qMax(h - s, 0) / 2;
+
+                        markIcon.paint(&p, lnX + x_px, y_px, s, s);
                     }
                 }
             }
+        }
 
-            lnX += m_foldingAreaWidth;
-            if (m_updatePositionToArea) {
-                m_positionToArea.append(AreaPosition(lnX, FoldingMarkers));
-            }
+        lnX += m_iconAreaWidth + m_separatorWidth;
+    }
+
+    // annotation information, the delegate paints the items on top
+    if (m_annotationBorderOn) {
+        // Draw a border line between annotations and the line numbers
+        p.setPen(lineNumberColor);
+        p.setBrush(lineNumberColor);
+
+        const qreal borderX = lnX + m_annotationAreaWidth + 0.5;
+        p.drawLine(QPointF(borderX, 0.5), QPointF(borderX, h - 0.5));
+
+        lnX += m_annotationAreaWidth + m_separatorWidth;
+    }
+
+    // line number
+    if (m_lineNumbersOn || m_dynWrapIndicatorsOn) {
+        const QColor usedLineNumberColor = state.currentLine ? m_view->renderer()->config()->currentLineNumberColor() : lineNumberColor;
+
+        if (state.number >= 0) {
+            drawNumber(p, state.number, usedLineNumberColor, state.alignLeft, lnX);
+        } else if (state.wrapIndicator) {
+            p.setPen(usedLineNumberColor);
+            p.setBrush(usedLineNumberColor);
+            p.drawText(lnX + m_maxCharWidth / 2, 0, m_lineNumberAreaWidth - m_maxCharWidth, h, Qt::TextDontClip | Qt::AlignRight | Qt::AlignVCenter, m_dynWrapIndicatorChar);
+        }
+
+        lnX += m_lineNumberAreaWidth + m_separatorWidth;
+    }
+
+    // modified line system
+    if (state.modification != RowState::NoModification) {
+        if (state.modification == RowState::Modified) {
+            p.fillRect(lnX, 0, m_modAreaWidth, h, m_view->renderer()->config()->modifiedLineColor());
+        } else if (state.modification == RowState::Saved) {
+            p.fillRect(lnX, 0, m_modAreaWidth, h, m_view->renderer()->config()->savedLineColor());
+        } else {
+            p.fillRect(lnX, 0, m_modAreaWidth, h, iconBarColor);
+        }
+
+        lnX += m_modAreaWidth; // No m_separatorWidth
+    }
+
+    // folding markers
+    if (m_foldingMarkersOn) {
+        const QColor foldingColor(m_view->renderer()->config()->foldingColor());
+        if (state.foldingHighlight) {
+            p.fillRect(lnX, 0, m_foldingAreaWidth, h, foldingColor);
         }
 
-        if (m_updatePositionToArea) {
-            m_updatePositionToArea = false;
-            // Don't forget our "text-stuck-to-border" protector
-            lnX += m_separatorWidth;
-            m_positionToArea.append(AreaPosition(lnX, None));
-            // Now that we know our needed space, ensure we are painted properly
-            updateGeometry();
-            update();
-            return;
+        if (state.folding == RowState::Folded) {
+            paintTriangle(p, foldingColor, lnX, 0, m_foldingAreaWidth, h, false);
+        } else if (state.folding == RowState::Unfolded) {
+            // Don't try to use currentLineNumberColor, the folded icon gets also not highligted
+            paintTriangle(p, lineNumberColor, lnX, 0, m_foldingAreaWidth, h, true);
         }
     }
 }
 
+void KateIconBorder::drawNumber(QPainter &p, int number, const QColor &color, bool alignLeft, int x)
+{
+    const QString digits = QString::number(number);
+
+    // same box as a drawText() of the number would use
+    const qreal left = x + m_maxCharWidth / 2;
+    qreal textWidth = 0;
+    for (const QChar digit : digits) {
+        textWidth += m_digitAdvances[digit.unicode() - '0'];
+    }
+    qreal pos = alignLeft ? left : left + (m_lineNumberAreaWidth - m_maxCharWidth) - textWidth;
+
+    const QVector<QPixmap> &glyphs = digitGlyphs(color);
+    for (const QChar digit : digits) {
+        const int value = digit.unicode() - '0';
+        p.drawPixmap(qRound(pos) - m_digitGlyphPadding, 0, glyphs.at(value));
+        pos += m_digitAdvances[value];
+    }
+}
+
+const QVector<QPixmap> &KateIconBorder::digitGlyphs(const QColor &color)
+{
+    auto it = m_digitGlyphs.find(color.rgba());
+    if (it != m_digitGlyphs.end()) {
+        return it.value();
+    }
+
+    // one glyph per digit, vertically placed like drawText() places it in the row
+    const int h = m_view->renderer()->lineHeight();
+    const qreal dpr = devicePixelRatioF();
+    const QSize size(qCeil(m_maxCharWidth) + 2 * m_digitGlyphPadding, h);
+
+    QVector<QPixmap> glyphs;
+    for (int i = 0; i < 10; ++i) {
+        QPixmap glyph(size * dpr);
+        glyph.setDevicePixelRatio(dpr);
+        glyph.fill(Qt::transparent);
+
+        QPainter p(&glyph);
+        p.setRenderHints(QPainter::TextAntialiasing);
+        p.setFont(m_view->renderer()->currentFont());
+        p.setPen(color);
+        p.drawText(QRectF(m_digitGlyphPadding, 0, m_maxCharWidth, h), Qt::TextDontClip | Qt::AlignLeft | Qt::AlignVCenter, QString(QChar('0' + i)));
+        glyphs.append(glyph);
+    }
+
+    return m_digitGlyphs.insert(color.rgba(), glyphs).value();
+}
+
 KateIconBorder::BorderArea KateIconBorder::positionToArea(const QPoint &p) const
 {
     for (int i = 0; i < m_positionToArea.size(); ++i) {
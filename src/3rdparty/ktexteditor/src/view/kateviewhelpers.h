@@ -27,6 +27,7 @@
 #include <KSelectAction>
 
 #include <QColor>
+#include <QFont>
 #include <QHash>
 #include <QLayout>
 #include <QMap>
@@ -36,7 +37,9 @@
 #include <QStackedWidget>
 #include <QTextLayout>
 #include <QTimer>
+#include <QVector>
 
+#include "katepaintstatistics.h"
 #include "katetextline.h"
 #include <ktexteditor/cursor.h>
 #include <ktexteditor/message.h>
@@ -67,6 +70,7 @@ class AbstractAnnotationItemDelegate;
 class StyleOptionAnnotationItem;
 }
 
+class QPainter;
 class QTimer;
 class QVBoxLayout;
 
@@ -298,6 +302,20 @@ public:
 
     void updateForCursorLineChange();
 
+    /**
+     * Scroll the border along with the text area.
+     * @param viewLines number of view lines scrolled, positive if the content moves up
+     */
+    void scrollRows(int viewLines);
+
+    /**
+     * Counters of the paint events of the border.
+     */
+    const KatePaintStatistics &paintStatistics() const
+    {
+        return m_paintStatistics;
+    }
+
     enum BorderArea { None, LineNumbers, IconBorder, FoldingMarkers, AnnotationBorder, ModificationBorder };
     BorderArea positionToArea(const QPoint &) const;
 
@@ -325,6 +343,65 @@ private:
     void paintEvent(QPaintEvent *) override;
     void paintBorder(int x, int y, int width, int height);
 
+    /**
+     * Everything painted into one row of the border, except the annotations painted by the delegate.
+     * Equal states render to equal pixmaps, the state is the key of the row cache.
+     */
+    struct RowState {
+        enum Kind : char { Unknown, Empty, Line };
+        enum Modification : char { NoModification, Unmodified, Modified, Saved };
+        enum Folding : char { NoFolding, Unfolded, Folded };
+
+        Kind kind = Unknown;
+        Modification modification = NoModification;
+        Folding folding = NoFolding;
+        bool foldingHighlight = false;
+        bool currentLine = false;
+        bool alignLeft = false;
+        bool wrapIndicator = false;
+        int number = -1;
+        uint marks = 0;
+
+        bool operator==(const RowState &other) const
+        {
+            return kind == other.kind && modification == other.modification && folding == other.folding && foldingHighlight == other.foldingHighlight && currentLine == other.currentLine &&
+                alignLeft == other.alignLeft && wrapIndicator == other.wrapIndicator && number == other.number && marks == other.marks;
+        }
+
+        friend uint qHash(const RowState &state, uint seed = 0)
+        {
+            const uint flags = uint(state.kind) | uint(state.modification) << 2 | uint(state.folding) << 4 | uint(state.foldingHighlight) << 6 | uint(state.currentLine) << 7 |
+                uint(state.alignLeft) << 8 | uint(state.wrapIndicator) << 9;
+            return ::qHash(state.number, seed) ^ ::qHash(state.marks, flags);
+        }
+    };
+
+    /**
+     * Everything besides the row state the rendered rows depend on.
+     */
+    struct RowStyle {
+        QSize size;
+        qreal devicePixelRatio = 0;
+        QFont font;
+        QVector<QRgb> colors;
+        QVector<int> metrics;
+        uint markIconsRevision = 0;
+
+        bool operator==(const RowStyle &other) const
+        {
+            return size == other.size && devicePixelRatio == other.devicePixelRatio && font == other.font && colors == other.colors && metrics == other.metrics &&
+                markIconsRevision == other.markIconsRevision;
+        }
+    };
+
+    RowState rowState(int z, int currentLine) const;
+    void updateRowStyle();
+    void updatePositionToArea();
+    const QPixmap &rowPixmap(const RowState &state);
+    void renderRow(QPainter &p, const RowState &state);
+    void drawNumber(QPainter &p, int number, const QColor &color, bool alignLeft, int x);
+    const QVector<QPixmap> &digitGlyphs(const QColor &color);
+
     void mousePressEvent(QMouseEvent *) override;
     void mouseMoveEvent(QMouseEvent *) override;
     void mouseReleaseEvent(QMouseEvent *) override;
@@ -351,7 +428,6 @@ private:
     bool m_iconBorderOn : 1;
     bool m_lineNumbersOn : 1;
     bool m_relLineNumbersOn : 1;
-    bool m_updateRelLineNumbers : 1;
     bool m_foldingMarkersOn : 1;
     bool m_dynWrapIndicatorsOn : 1;
     bool m_annotationBorderOn : 1;
@@ -379,12 +455,34 @@ private:
     KTextEditor::MovingRange *m_foldingRange = nullptr;
     int m_currentLine = -1;
     QTimer m_antiFlickerTimer;
+
+    /**
+     * rendered rows by their state, valid for m_rowStyle
+     */
+    QHash<RowState, QPixmap> m_rowCache;
+    RowStyle m_rowStyle;
+
+    /**
+     * glyphs of the digits 0-9 by color and their advances, for drawing line numbers
+     */
+    QHash<QRgb, QVector<QPixmap>> m_digitGlyphs;
+    qreal m_digitAdvances[10] = {};
+    int m_digitGlyphPadding = 0;
+
+    /**
+     * state of each row as it is on screen, to update only the rows that changed
+     */
+    QVector<RowState> m_paintedRows;
+    bool m_rowUpdatePending = false;
+
+    KatePaintStatistics m_paintStatistics;
     void highlightFoldingDelayed(int line);
     void hideFolding();
 
 private Q_SLOTS:
     void highlightFolding();
     void handleDestroyedAnnotationItemDelegate();
+    void updateChangedRows();
 
 private:
     QString m_hoveredAnnotationGroupIdentifier;
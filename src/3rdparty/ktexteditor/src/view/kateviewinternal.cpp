@@ -546,7 +546,7 @@ void KateViewInternal::scrollPos(KTextEditor::Cursor &c, bool force, bool called
 
             // scroll excluding child widgets (floating notifications)
             scroll(0, scrollHeight, rect());
-            m_leftBorder->scroll(0, scrollHeight);
+            m_leftBorder->scrollRows(viewLinesScrolled);
 
             if (emitSignals) {
                 emit view()->verticalScrollPositionChanged(m_view, c);
@@ -582,7 +582,10 @@ void KateViewInternal::scrollColumns(int x)
     int dx = startX() - x;
     m_startX = x;
 
-    if (qAbs(dx) < width()) {
+    // long lines only laid out around the old position are laid out again, paint them all
+    const bool relayouted = cache()->setStartX(x);
+
+    if (!relayouted && qAbs(dx) < width()) {
         // scroll excluding child widgets (floating notifications)
         scroll(dx, 0, rect());
     } else {
@@ -837,7 +840,7 @@ QPoint KateViewInternal::cursorToCoordinate(const KTextEditor::Cursor &cursor, b
 
     // only set x value if we have a valid layout (bug #171027)
     if (layout.isValid()) {
-        x = (int)layout.lineLayout().cursorToX(cursor.column());
+        x = (int)layout.cursorToX(cursor.column());
     }
     //  else
     //    qCDebug(LOG_KTE) << "Invalid Layout";
@@ -1057,7 +1060,7 @@ public:
                     }
 
                 } else {
-                    m_cursor.setColumn(thisLine->layout()->nextCursorPosition(column()));
+                    m_cursor.setColumn(thisLine->nextCursorPosition(column()));
                 }
             }
         } else {
@@ -1067,7 +1070,7 @@ public:
                 } else if (column() == 0) {
                     break;
                 } else {
-                    m_cursor.setColumn(thisLine->layout()->previousCursorPosition(column()));
+                    m_cursor.setColumn(thisLine->previousCursorPosition(column()));
                 }
             }
         }
@@ -1129,7 +1132,7 @@ public:
                     continue;
                 }
 
-                m_cursor.setColumn(thisLine->layout()->nextCursorPosition(column()));
+                m_cursor.setColumn(thisLine->nextCursorPosition(column()));
             }
 
         } else {
@@ -1159,7 +1162,7 @@ public:
                 if (column() > thisLine->length()) {
                     m_cursor.setColumn(column() - 1);
                 } else {
-                    m_cursor.setColumn(thisLine->layout()->previousCursorPosition(column()));
+                    m_cursor.setColumn(thisLine->previousCursorPosition(column()));
                 }
             }
         }
@@ -1417,7 +1420,9 @@ KTextEditor::Cursor KateViewInternal::viewLineOffset(const KTextEditor::Cursor &
     int cursorViewLine = cache()->viewLine(realCursor);
 
     int currentOffset = 0;
-    int virtualLine = 0;
+
+    // view line to reach, counted from the first view line of the cursor line
+    const int targetViewLine = cursorViewLine + offset;
 
     bool forwards = (offset > 0) ? true : false;
 
@@ -1430,8 +1435,6 @@ KTextEditor::Cursor KateViewInternal::viewLineOffset(const KTextEditor::Cursor &
             return KTextEditor::Cursor(virtualCursor.line(), thisLine.startCol());
         }
 
-        virtualLine = virtualCursor.line() + 1;
-
     } else {
         offset = -offset;
         currentOffset = cursorViewLine;
@@ -1441,53 +1444,26 @@ KTextEditor::Cursor KateViewInternal::viewLineOffset(const KTextEditor::Cursor &
             Q_ASSERT(thisLine.virtualLine() == (int)view()->textFolding().lineToVisibleLine(virtualCursor.line()));
             return KTextEditor::Cursor(virtualCursor.line(), thisLine.startCol());
         }
-
-        virtualLine = virtualCursor.line() - 1;
     }
 
-    currentOffset++;
-
-    while (virtualLine >= 0 && virtualLine < (int)view()->textFolding().visibleLines()) {
-        int realLine = view()->textFolding().visibleLineToLine(virtualLine);
+    // find the target line through the view line counts instead of laying out all lines on the way
+    int viewLine = 0;
+    const int realLine = cache()->moveViewLines(realCursor.line(), targetViewLine, viewLine);
+    if (realLine >= 0) {
+        const int virtualLine = view()->textFolding().lineToVisibleLine(realLine);
         KateLineLayoutPtr thisLine = cache()->line(realLine, virtualLine);
-        if (!thisLine) {
-            break;
-        }
-
-        for (int i = 0; i < thisLine->viewLineCount(); ++i) {
-            if (offset == currentOffset) {
-                KateTextLayout thisViewLine = thisLine->viewLine(i);
-
-                if (!forwards) {
-                    // We actually want it the other way around
-                    int requiredViewLine = cache()->lastViewLine(realLine) - thisViewLine.viewLine();
-                    if (requiredViewLine != thisViewLine.viewLine()) {
-                        thisViewLine = thisLine->viewLine(requiredViewLine);
-                    }
-                }
+        if (thisLine) {
+            KateTextLayout thisViewLine = thisLine->viewLine(qMin(viewLine, thisLine->viewLineCount() - 1));
 
-                KTextEditor::Cursor ret(virtualLine, thisViewLine.startCol());
+            KTextEditor::Cursor ret(virtualLine, thisViewLine.startCol());
 
-                // keep column position
-                if (keepX) {
-                    KTextEditor::Cursor realCursor = toRealCursor(virtualCursor);
-                    KateTextLayout t = cache()->textLayout(realCursor);
-                    // renderer()->cursorToX(t, realCursor, !view()->wrapCursor());
-
-                    realCursor = renderer()->xToCursor(thisViewLine, m_preservedX, !view()->wrapCursor());
-                    ret.setColumn(realCursor.column());
-                }
-
-                return ret;
+            // keep column position
+            if (keepX) {
+                realCursor = renderer()->xToCursor(thisViewLine, m_preservedX, !view()->wrapCursor());
+                ret.setColumn(realCursor.column());
             }
 
-            currentOffset++;
-        }
-
-        if (forwards) {
-            virtualLine++;
-        } else {
-            virtualLine--;
+            return ret;
         }
     }
 
@@ -3001,6 +2977,9 @@ void KateViewInternal::paintEvent(QPaintEvent *e)
         qCDebug(LOG_KTE) << "GOT PAINT EVENT: Region" << e->region();
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
     const QRect &unionRect = e->rect();
 
     int xStart = startX() + unionRect.x();
@@ -3074,6 +3053,7 @@ void KateViewInternal::paintEvent(QPaintEvent *e)
                 paint.setClipRect(lineRect);
                 renderer()->paintTextLine(paint, thisLine.kateLineLayout(), xStart, xEnd, &pos);
                 paint.restore();
+                ++m_paintStatistics.rowsRendered;
 
                 /**
                  * line painted, reset and state + mark line as non-dirty
@@ -3086,6 +3066,7 @@ void KateViewInternal::paintEvent(QPaintEvent *e)
          * translate to next line
          */
         paint.translate(0, h);
+        ++m_paintStatistics.rowsPainted;
     }
 
     paint.restore();
@@ -3093,6 +3074,12 @@ void KateViewInternal::paintEvent(QPaintEvent *e)
     if (m_textAnimation) {
         m_textAnimation->draw(paint);
     }
+
+    m_paintStatistics.addPaint(timer.nsecsElapsed() / 1000);
+    if (debugPainting) {
+        qCDebug(LOG_KTE) << "text area:" << m_paintStatistics;
+        qCDebug(LOG_KTE) << "icon border:" << m_leftBorder->paintStatistics();
+    }
 }
 
 void KateViewInternal::resizeEvent(QResizeEvent *e)
@@ -3542,7 +3529,10 @@ void KateViewInternal::editEnd(int editTagLineStart, int editTagLineEnd, bool ta
     m_startPos.setPosition(startLine(), col);
 
     if (tagFrom && (editTagLineStart <= int(view()->textFolding().visibleLineToLine(startLine())))) {
-        tagAll();
+        // like tagAll(), but the view line counts of the untouched lines stay valid
+        cache()->clearLayouts();
+        m_leftBorder->updateFont();
+        m_leftBorder->update();
     } else {
         tagLines(editTagLineStart, tagFrom ? qMax(doc()->lastLine() + 1, editTagLineEnd) : editTagLineEnd, true);
     }
@@ -32,6 +32,7 @@
 
 #include "inlinenotedata.h"
 #include "katedocument.h"
+#include "katepaintstatistics.h"
 #include "katerenderer.h"
 #include "katetextcursor.h"
 #include "katetextline.h"
@@ -220,6 +221,14 @@ public:
         return m_leftBorder;
     }
 
+    /**
+     * Counters of the paint events of the text area, the icon border has its own.
+     */
+    const KatePaintStatistics &paintStatistics() const
+    {
+        return m_paintStatistics;
+    }
+
     // EVENT HANDLING STUFF - IMPORTANT
 private:
     void fixDropEvent(QDropEvent *event);
@@ -309,6 +318,8 @@ private:
     bool m_completionItemExpanded;
     QElapsedTimer m_altDownTime;
 
+    KatePaintStatistics m_paintStatistics;
+
     // Bracket mark and corresponding decorative ranges
     KTextEditor::MovingRange *m_bm, *m_bmStart, *m_bmEnd;
     KTextEditor::MovingCursor *m_bmLastFlashPos;
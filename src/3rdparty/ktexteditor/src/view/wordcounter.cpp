@@ -19,21 +19,56 @@
 */
 
 #include "wordcounter.h"
+#include "katebuffer.h"
 #include "katedocument.h"
 #include "kateview.h"
 
+#include <QThreadPool>
+#include <QtAlgorithms>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace
 {
+/**
+ * More dirty lines than this are counted in the background.
+ */
 const int MaximumLinesToRecalculate = 100;
 }
 
+// BEGIN WordCountJob
+WordCountJob::WordCountJob(const Kate::TextSnapshot &snapshot, const QVector<int> &lines)
+    : m_snapshot(snapshot)
+    , m_lines(lines)
+{
+    // the receiver may be gone, the job cleans up after itself
+    setAutoDelete(false);
+}
+
+void WordCountJob::run()
+{
+    QVector<int> words(m_lines.size());
+    QVector<int> chars(m_lines.size());
+    for (int i = 0; i < m_lines.size(); ++i) {
+        const QString text = m_snapshot.line(m_lines.at(i));
+        words[i] = WordCounter::countWords(text);
+        chars[i] = text.size();
+    }
+
+    emit finished(words, chars);
+    deleteLater();
+}
+// END WordCountJob
+
+// BEGIN WordCounter
 WordCounter::WordCounter(KTextEditor::ViewPrivate *view)
     : QObject(view)
-    , m_wordsInDocument(0)
+    , m_jobRunning(false)
     , m_wordsInSelection(0)
-    , m_charsInDocument(0)
     , m_charsInSelection(0)
-    , m_startRecalculationFrom(0)
+    , m_view(view)
     , m_document(view->document())
 {
     connect(view->doc(), &KTextEditor::DocumentPrivate::textInserted, this, &WordCounter::textInserted);
@@ -54,15 +89,17 @@ void WordCounter::textInserted(KTextEditor::Document *, const KTextEditor::Range
     const int endLine = range.end().line();
     int newLines = endLine - startLine;
 
-    if (m_countByLine.count() == 0) { // was empty document before insert
+    if (m_lineStates.count() == 0) { // was empty document before insert
         newLines++;
     }
 
     if (newLines > 0) {
-        m_countByLine.insert(startLine, newLines, -1);
+        m_lineStates.insert(startLine, newLines, Dirty);
+        m_wordsByLine.insert(startLine, newLines, 0);
+        m_charsByLine.insert(startLine, newLines, 0);
     }
 
-    m_countByLine[endLine] = -1;
+    markDirty(startLine, endLine);
     m_timer.start();
 }
 
@@ -73,11 +110,13 @@ void WordCounter::textRemoved(KTextEditor::Document *, const KTextEditor::Range
     const int removedLines = endLine - startLine;
 
     if (removedLines > 0) {
-        m_countByLine.remove(startLine, removedLines);
+        m_lineStates.remove(startLine, removedLines);
+        m_wordsByLine.remove(startLine, removedLines);
+        m_charsByLine.remove(startLine, removedLines);
     }
 
-    if (!m_countByLine.isEmpty()) {
-        m_countByLine[startLine] = -1;
+    if (!m_lineStates.isEmpty()) {
+        markDirty(startLine, startLine);
         m_timer.start();
     } else {
         emit changed(0, 0, 0, 0);
@@ -86,103 +125,153 @@ void WordCounter::textRemoved(KTextEditor::Document *, const KTextEditor::Range
 
 void WordCounter::recalculate(KTextEditor::Document *)
 {
-    m_countByLine = QVector<int>(m_document->lines(), -1);
+    // results of a running job are dropped, no line waits for them anymore
+    const int lines = m_document->lines();
+    m_lineStates.fill(Dirty, lines);
+    m_wordsByLine.fill(0, lines);
+    m_charsByLine.fill(0, lines);
     m_timer.start();
 }
 
-void WordCounter::selectionChanged(KTextEditor::View *view)
+void WordCounter::markDirty(int startLine, int endLine)
 {
-    if (view->selectionRange().isEmpty()) {
-        m_wordsInSelection = m_charsInSelection = 0;
-        emit changed(m_wordsInDocument, 0, m_charsInDocument, 0);
-        return;
+    for (int line = startLine; line <= endLine && line < m_lineStates.size(); ++line) {
+        m_lineStates[line] = Dirty;
     }
+}
 
-    const int firstLine = view->selectionRange().start().line();
-    const int lastLine = view->selectionRange().end().line();
-
-    if (firstLine == lastLine || view->blockSelection()) {
-        const QString text = view->selectionText();
-        m_wordsInSelection = countWords(text);
-        m_charsInSelection = text.size();
-    } else {
-        m_wordsInSelection = m_charsInSelection = 0;
+void WordCounter::selectionChanged(KTextEditor::View *view)
+{
+    m_wordsInSelection = m_charsInSelection = 0;
 
-        const KTextEditor::Range firstLineRange(view->selectionRange().start(), firstLine, view->document()->lineLength(firstLine));
-        const QString firstLineText = view->document()->text(firstLineRange);
-        m_wordsInSelection += countWords(firstLineText);
-        m_charsInSelection += firstLineText.size();
+    if (!view->selectionRange().isEmpty()) {
+        const int firstLine = view->selectionRange().start().line();
+        const int lastLine = view->selectionRange().end().line();
 
-        // whole lines
-        for (int i = firstLine + 1; i < lastLine; i++) {
-            m_wordsInSelection += m_countByLine[i];
-            m_charsInSelection += m_document->lineLength(i);
+        if (firstLine == lastLine || view->blockSelection()) {
+            const QString text = view->selectionText();
+            m_wordsInSelection = countWords(text);
+            m_charsInSelection = text.size();
+        } else {
+            const KTextEditor::Range firstLineRange(view->selectionRange().start(), firstLine, view->document()->lineLength(firstLine));
+            const QString firstLineText = view->document()->text(firstLineRange);
+            m_wordsInSelection += countWords(firstLineText);
+            m_charsInSelection += firstLineText.size();
+
+            // whole lines
+            m_wordsInSelection += int(m_wordsByLine.sum(firstLine + 1, lastLine));
+            m_charsInSelection += int(m_charsByLine.sum(firstLine + 1, lastLine));
+
+            const KTextEditor::Range lastLineRange(KTextEditor::Cursor(lastLine, 0), view->selectionRange().end());
+            const QString lastLineText = view->document()->text(lastLineRange);
+            m_wordsInSelection += countWords(lastLineText);
+            m_charsInSelection += lastLineText.size();
         }
-
-        const KTextEditor::Range lastLineRange(KTextEditor::Cursor(lastLine, 0), view->selectionRange().end());
-        const QString lastLineText = view->document()->text(lastLineRange);
-        m_wordsInSelection += countWords(lastLineText);
-        m_charsInSelection += lastLineText.size();
     }
 
-    emit changed(m_wordsInDocument, m_wordsInSelection, m_charsInDocument, m_charsInSelection);
+    emit changed(int(m_wordsByLine.sum()), m_wordsInSelection, int(m_charsByLine.sum()), m_charsInSelection);
 }
 
 void WordCounter::recalculateLines()
 {
-    if (m_startRecalculationFrom >= m_countByLine.size()) {
-        m_startRecalculationFrom = 0;
+    // one job at a time, its result triggers the next round
+    if (m_jobRunning) {
+        return;
     }
 
-    int wordsCount = 0, charsCount = 0;
-    int calculated = 0;
-    int i = m_startRecalculationFrom;
-
-    // stay in bounds, vector might be empty, even 0 is too large then
-    while (i < m_countByLine.size()) {
-        if (m_countByLine[i] == -1) {
-            m_countByLine[i] = countWords(m_document->line(i));
-            if (++calculated > MaximumLinesToRecalculate) {
-                m_startRecalculationFrom = i;
-                m_timer.start();
-                return;
-            }
+    QVector<int> dirtyLines;
+    for (int line = 0; line < m_lineStates.size(); ++line) {
+        if (m_lineStates.at(line) == Dirty) {
+            dirtyLines.append(line);
         }
+    }
 
-        wordsCount += m_countByLine[i];
-        charsCount += m_document->lineLength(i);
-
-        if (++i == m_countByLine.size()) { // array cycle
-            i = 0;
+    if (dirtyLines.size() > MaximumLinesToRecalculate) {
+        // lines edited meanwhile become dirty again and ignore their result
+        for (int i = 0; i < dirtyLines.size(); ++i) {
+            m_lineStates[dirtyLines.at(i)] = i;
         }
 
-        if (i == m_startRecalculationFrom) {
-            break;
+        WordCountJob *job = new WordCountJob(m_view->doc()->buffer().snapshot(), dirtyLines);
+        connect(job, &WordCountJob::finished, this, &WordCounter::linesCounted);
+        m_jobRunning = true;
+        QThreadPool::globalInstance()->start(job);
+        return;
+    }
+
+    for (int line : qAsConst(dirtyLines)) {
+        const QString text = m_document->line(line);
+        m_wordsByLine.setValue(line, countWords(text));
+        m_charsByLine.setValue(line, text.size());
+        m_lineStates[line] = Clean;
+    }
+
+    selectionChanged(m_view);
+}
+
+void WordCounter::linesCounted(const QVector<int> &words, const QVector<int> &chars)
+{
+    m_jobRunning = false;
+
+    bool dirty = false;
+    for (int line = 0; line < m_lineStates.size(); ++line) {
+        const int index = m_lineStates.at(line);
+        if (index >= 0) {
+            m_wordsByLine.setValue(line, words.at(index));
+            m_charsByLine.setValue(line, chars.at(index));
+            m_lineStates[line] = Clean;
+        } else if (index == Dirty) {
+            dirty = true;
         }
     }
 
-    m_wordsInDocument = wordsCount;
-    m_charsInDocument = charsCount;
-    emit changed(m_wordsInDocument, m_wordsInSelection, m_charsInDocument, m_charsInSelection);
+    if (dirty) {
+        m_timer.start();
+    }
+
+    selectionChanged(m_view);
 }
 
-int WordCounter::countWords(const QString &text) const
+int WordCounter::countWords(const QString &text)
 {
+    const ushort *units = text.utf16();
+    const ushort *const end = units + text.size();
     int count = 0;
     bool inWord = false;
 
-    for (const QChar &c : text) {
-        if (c.isLetterOrNumber()) {
-            if (!inWord) {
-                inWord = true;
-            }
-        } else {
-            if (inWord) {
-                inWord = false;
-                count++;
+#ifdef __SSE2__
+    // eight ASCII code units at once: mask the letters and digits, count the starts of their runs
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i nonAscii = _mm_set1_epi16(short(0xFF80));
+    const __m128i lowerCase = _mm_set1_epi16(0x20);
+    while (end - units >= 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(units));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(chunk, nonAscii), zero)) != 0xFFFF) {
+            for (const ushort *const chunkEnd = units + 8; units < chunkEnd; ++units) {
+                const bool wordChar = QChar(*units).isLetterOrNumber();
+                count += (wordChar && !inWord) ? 1 : 0;
+                inWord = wordChar;
             }
+            continue;
         }
+
+        const __m128i digits = _mm_and_si128(_mm_cmpgt_epi16(chunk, _mm_set1_epi16('0' - 1)), _mm_cmplt_epi16(chunk, _mm_set1_epi16('9' + 1)));
+        const __m128i folded = _mm_or_si128(chunk, lowerCase);
+        const __m128i letters = _mm_and_si128(_mm_cmpgt_epi16(folded, _mm_set1_epi16('a' - 1)), _mm_cmplt_epi16(folded, _mm_set1_epi16('z' + 1)));
+        const int mask = _mm_movemask_epi8(_mm_packs_epi16(_mm_or_si128(digits, letters), zero));
+        const int starts = mask & ~((mask << 1) | (inWord ? 1 : 0));
+        count += qPopulationCount(quint32(starts));
+        inWord = mask & 0x80;
+        units += 8;
+    }
+#endif
+
+    for (; units < end; ++units) {
+        const bool wordChar = QChar(*units).isLetterOrNumber();
+        count += (wordChar && !inWord) ? 1 : 0;
+        inWord = wordChar;
     }
 
-    return (inWord) ? count + 1 : count;
+    return count;
 }
+// END WordCounter
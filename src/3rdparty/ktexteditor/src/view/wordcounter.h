@@ -21,7 +21,11 @@
 #ifndef WORDCOUNTER_H
 #define WORDCOUNTER_H
 
+#include "katefenwicktree.h"
+#include "katetextsnapshot.h"
+
 #include <QObject>
+#include <QRunnable>
 #include <QString>
 #include <QTimer>
 #include <QVector>
@@ -35,6 +39,30 @@ class ViewPrivate;
 class Range;
 }
 
+/**
+ * Counts the words and characters of some lines of a text snapshot in a thread of the global pool.
+ * Deletes itself once it delivered the result.
+ */
+class WordCountJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    WordCountJob(const Kate::TextSnapshot &snapshot, const QVector<int> &lines);
+
+    void run() override;
+
+Q_SIGNALS:
+    /**
+     * Emitted from the worker thread, words and chars hold the counts of each requested line.
+     */
+    void finished(const QVector<int> &words, const QVector<int> &chars);
+
+private:
+    const Kate::TextSnapshot m_snapshot;
+    const QVector<int> m_lines;
+};
+
 class WordCounter : public QObject
 {
     Q_OBJECT
@@ -42,6 +70,11 @@ class WordCounter : public QObject
 public:
     explicit WordCounter(KTextEditor::ViewPrivate *view);
 
+    /**
+     * Number of words in the text, words are runs of letters and numbers.
+     */
+    static int countWords(const QString &text);
+
 Q_SIGNALS:
     void changed(int wordsInDocument, int wordsInSelection, int charsInDocument, int charsInSelection);
 
@@ -51,16 +84,28 @@ private Q_SLOTS:
     void recalculate(KTextEditor::Document *document);
     void selectionChanged(KTextEditor::View *view);
     void recalculateLines();
+    void linesCounted(const QVector<int> &words, const QVector<int> &chars);
 
 private:
-    int countWords(const QString &text) const;
+    void markDirty(int startLine, int endLine);
 
 private:
-    QVector<int> m_countByLine;
-    int m_wordsInDocument, m_wordsInSelection;
-    int m_charsInDocument, m_charsInSelection;
+    /**
+     * words and characters per line, dirty lines keep their last count until recounted
+     */
+    KateFenwickTree m_wordsByLine;
+    KateFenwickTree m_charsByLine;
+
+    /**
+     * per line: Clean, Dirty or the index of the line in the running job
+     */
+    QVector<int> m_lineStates;
+    enum LineState { Dirty = -1, Clean = -2 };
+
+    bool m_jobRunning;
+    int m_wordsInSelection, m_charsInSelection;
     QTimer m_timer;
-    int m_startRecalculationFrom;
+    KTextEditor::ViewPrivate *m_view;
     KTextEditor::Document *m_document;
 };
 
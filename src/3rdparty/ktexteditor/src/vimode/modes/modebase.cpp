@@ -969,7 +969,7 @@ Range ModeBase::goVisualLineUpDown(int lines)
     const bool isWrappedContinuation = (cache->textLayout(finishRealLine, finishVisualLine).lineLayout().lineNumber() != 0);
     const int numInvisibleIndentChars = isWrappedContinuation ? endLine->toVirtualColumn(cache->line(finishRealLine)->textLine()->nextNonSpaceChar(0), tabstop) : 0;
     if (m_stickyColumn == (unsigned int)KateVi::EOL) {
-        const int visualEndColumn = cache->textLayout(finishRealLine, finishVisualLine).lineLayout().textLength() - 1;
+        const int visualEndColumn = cache->textLayout(finishRealLine, finishVisualLine).length() - 1;
         r.endColumn = endLine->fromVirtualColumn(visualEndColumn + realLineStartColumn - numInvisibleIndentChars, tabstop);
     } else {
         // Algorithm: find the "real" column corresponding to the start of the line.  Offset from that
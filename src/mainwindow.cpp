@@ -15,6 +15,7 @@
 #include <QGuiApplication>
 #include <QMessageBox>
 #include <QSaveFile>
+#include <QStatusBar>
 #include <QTextStream>
 
 MainWindow::MainWindow()
@@ -25,6 +26,9 @@ MainWindow::MainWindow()
     doc = editor->createDocument(this);
     view = doc->createView(this);
 
+    // large files are shown while they load, report how far they are
+    connect(doc, SIGNAL(loadingProgress(KTextEditor::Document *, int)), this, SLOT(loadingProgress(KTextEditor::Document *, int)));
+
     setCentralWidget(view);
     setupActions();
     createShellGUI(true);
@@ -44,3 +48,11 @@ void MainWindow::openFile()
 {
     view->document()->openUrl(QFileDialog::getOpenFileUrl());
 }
+
+void MainWindow::loadingProgress(KTextEditor::Document *document, int percent)
+{
+    Q_UNUSED(document);
+
+    // progress is reported while loading only, let the message vanish afterwards
+    statusBar()->showMessage(tr("Loading... %1%").arg(percent), 1000);
+}
@@ -29,6 +29,7 @@ class MainWindow : public KParts::MainWindow
 
    private slots:
     void openFile();
+    void loadingProgress(KTextEditor::Document *document, int percent);
 
    private:
     void setupActions();